@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "iostream"
+#include "fstream"
+#include "discimg.h"
+#include "cpputil.h"
+
+
+
+bool VerifyImage(const DiscImage &input,const DiscImage &output)
+{
+	if(input.GetNumSectors()!=output.GetNumSectors() ||
+	   input.GetNumTracks()!=output.GetNumTracks() ||
+	   input.binaries.size()!=output.binaries.size())
+	{
+		std::cout << "Number of sectors, tracks, or binaries does not match." << std::endl;
+		return false;
+	}
+	for(unsigned int t=0; t<input.GetNumTracks(); ++t)
+	{
+		auto &inTrk=input.GetTracks()[t];
+		auto &outTrk=output.GetTracks()[t];
+		if(inTrk.trackType!=outTrk.trackType ||
+		   inTrk.sectorLength!=outTrk.sectorLength ||
+		   inTrk.locationInFile!=outTrk.locationInFile ||
+		   inTrk.start!=outTrk.start ||
+		   inTrk.end!=outTrk.end)
+		{
+			std::cout << "Track " << t+1 << " does not match." << std::endl;
+			return false;
+		}
+	}
+
+	// Raw bytes of the binaries, one sector at a time.
+	for(unsigned int i=0; i<input.binaries.size(); ++i)
+	{
+		DiscImage::BinaryReader inReader,outReader;
+		inReader.Open(input,i);
+		outReader.Open(output,i);
+		if(true!=inReader.IsOpen() || true!=outReader.IsOpen() || inReader.GetSize()!=outReader.GetSize())
+		{
+			std::cout << "Binary " << i << " size does not match." << std::endl;
+			return false;
+		}
+
+		auto size=inReader.GetSize();
+		std::vector <unsigned char> inSec,outSec;
+		inReader.Seek(0);
+		outReader.Seek(0);
+		for(uint64_t pos=0; pos<size; pos+=DiscImage::AUDIO_SECTOR_SIZE)
+		{
+			auto len=std::min<uint64_t>(DiscImage::AUDIO_SECTOR_SIZE,size-pos);
+			inSec.resize(len);
+			outSec.resize(len);
+			inReader.Read(inSec.data(),len);
+			outReader.Read(outSec.data(),len);
+			if(inSec!=outSec)
+			{
+				std::cout << "Binary " << i << " sector " << pos/DiscImage::AUDIO_SECTOR_SIZE << " does not match." << std::endl;
+				return false;
+			}
+		}
+	}
+
+	// Sectors as the emulator reads them.
+	for(unsigned int t=0; t<input.GetNumTracks(); ++t)
+	{
+		auto &trk=input.GetTracks()[t];
+		for(auto HSG=trk.start.ToHSG(); HSG<=trk.end.ToHSG(); ++HSG)
+		{
+			if(0==t && (DiscImage::TRACK_MODE1_DATA==trk.trackType || DiscImage::TRACK_MODE2_DATA==trk.trackType))
+			{
+				if(input.ReadSectorMODE1(HSG,1)!=output.ReadSectorMODE1(HSG,1))
+				{
+					std::cout << "Data sector " << HSG << " does not match." << std::endl;
+					return false;
+				}
+			}
+			else if(DiscImage::TRACK_AUDIO==trk.trackType)
+			{
+				auto from=DiscImage::HSGtoMSF(HSG);
+				auto to=DiscImage::HSGtoMSF(HSG+1);
+				if(input.GetWave(from,to)!=output.GetWave(from,to))
+				{
+					std::cout << "Audio sector " << HSG << " does not match." << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+int main(int ac,char *av[])
+{
+	bool verifyOnly=false;
+	if(4==ac && std::string("-verify")==av[1])
+	{
+		verifyOnly=true;
+		++av;
+		--ac;
+	}
+	if(3!=ac)
+	{
+		fprintf(stderr,"COMPRESSDISC\n");
+		fprintf(stderr,"Convert a disc image (.CUE, .MDS, .ISO) to a compressed disc image (.TCD).\n");
+		fprintf(stderr,"Every sector is compared against the input after conversion.\n");
+		fprintf(stderr,"Usage:\n");
+		fprintf(stderr,"  compressdisc input.CUE output.TCD\n");
+		fprintf(stderr,"  compressdisc -verify input.CUE output.TCD\n");
+		fprintf(stderr,"    Only compare an existing .TCD against the input.\n");
+		return 1;
+	}
+
+	DiscImage input;
+	auto err=input.Open(av[1]);
+	if(DiscImage::ERROR_NOERROR!=err)
+	{
+		std::cout << "Cannot open input: " << DiscImage::ErrorCodeToText(err) << std::endl;
+		return 1;
+	}
+
+	std::cout << "Input:  " << input.fName << std::endl;
+	std::cout << "Output: " << av[2] << std::endl;
+
+	if(true!=verifyOnly)
+	{
+		err=input.SaveTCD(av[2]);
+		if(DiscImage::ERROR_NOERROR!=err)
+		{
+			std::cout << "Cannot write output: " << DiscImage::ErrorCodeToText(err) << std::endl;
+			return 1;
+		}
+	}
+
+	DiscImage output;
+	err=output.OpenTCD(av[2]);
+	if(DiscImage::ERROR_NOERROR!=err)
+	{
+		std::cout << "Cannot open output: " << DiscImage::ErrorCodeToText(err) << std::endl;
+		return 1;
+	}
+
+	uint64_t compressedSize=0;
+	unsigned int numHunks[4]={0,0,0,0};
+	for(auto &h : output.compressedImage->hunks)
+	{
+		compressedSize+=h.compressedSize;
+		if(h.codec<4)
+		{
+			++numHunks[h.codec];
+		}
+	}
+	std::cout << "Binary Size:     " << output.compressedImage->totalLength << std::endl;
+	std::cout << "Compressed Size: " << compressedSize << std::endl;
+	std::cout << "Hunks (Store/Fill/LZ/Audio): " << numHunks[0] << "/" << numHunks[1] << "/" << numHunks[2] << "/" << numHunks[3] << std::endl;
+
+	if(true!=VerifyImage(input,output))
+	{
+		std::cout << "Verification failed." << std::endl;
+		return 1;
+	}
+	std::cout << "Verified." << std::endl;
+	return 0;
+}
@@ -0,0 +1,178 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+	#include <sys/mman.h>
+	#define ANONMEM_USE_MMAP
+#endif
+
+#include "anonmem.h"
+
+
+
+/* static */ unsigned char *cpputil::AnonymousMemory::Map(size_t mappedLen)
+{
+#if defined(_WIN32)
+	return (unsigned char *)VirtualAlloc(nullptr,mappedLen,MEM_RESERVE|MEM_COMMIT,PAGE_READWRITE);
+#elif defined(ANONMEM_USE_MMAP)
+	auto mapped=mmap(nullptr,mappedLen,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+	return (MAP_FAILED!=mapped ? (unsigned char *)mapped : nullptr);
+#else
+	return (unsigned char *)calloc(mappedLen,1);
+#endif
+}
+/* static */ void cpputil::AnonymousMemory::Unmap(unsigned char *ptr,size_t mappedLen)
+{
+	if(nullptr!=ptr)
+	{
+	#if defined(_WIN32)
+		VirtualFree(ptr,0,MEM_RELEASE);
+	#elif defined(ANONMEM_USE_MMAP)
+		munmap(ptr,mappedLen);
+	#else
+		free(ptr);
+	#endif
+	}
+}
+void cpputil::AnonymousMemory::CopyNonZeroPages(const unsigned char src[],size_t copyLen)
+{
+	// Copying zero pages would commit them for nothing.
+	for(size_t offset=0; offset<copyLen; offset+=PAGE_SIZE)
+	{
+		auto pageLen=std::min<size_t>(PAGE_SIZE,copyLen-offset);
+		if(pageLen!=(size_t)std::count(src+offset,src+offset+pageLen,0))
+		{
+			memcpy(ptr+offset,src+offset,pageLen);
+		}
+	}
+}
+
+cpputil::AnonymousMemory::AnonymousMemory()
+{
+}
+cpputil::AnonymousMemory::AnonymousMemory(const AnonymousMemory &incoming)
+{
+	*this=incoming;
+}
+cpputil::AnonymousMemory &cpputil::AnonymousMemory::operator=(const AnonymousMemory &incoming)
+{
+	if(this!=&incoming)
+	{
+		if(len!=incoming.len)
+		{
+			Unmap(ptr,mappedLen);
+			ptr=nullptr;
+			len=0;
+			mappedLen=0;
+			resize(incoming.len);
+		}
+		else
+		{
+			Discard();
+		}
+		CopyNonZeroPages(incoming.ptr,std::min(len,incoming.len));
+	}
+	return *this;
+}
+cpputil::AnonymousMemory::~AnonymousMemory()
+{
+	Unmap(ptr,mappedLen);
+}
+
+void cpputil::AnonymousMemory::resize(size_t newLen)
+{
+	if(newLen==len)
+	{
+		return;
+	}
+
+	unsigned char *newPtr=nullptr;
+	size_t newMappedLen=(newLen+PAGE_SIZE-1)/PAGE_SIZE*PAGE_SIZE;
+	if(0<newMappedLen)
+	{
+		newPtr=Map(newMappedLen);
+		if(nullptr==newPtr)
+		{
+			newMappedLen=0;
+			newLen=0;
+		}
+	}
+
+	auto prevPtr=ptr;
+	auto prevLen=len;
+	auto prevMappedLen=mappedLen;
+	ptr=newPtr;
+	len=newLen;
+	mappedLen=newMappedLen;
+	if(nullptr!=prevPtr)
+	{
+		CopyNonZeroPages(prevPtr,std::min(prevLen,len));
+		Unmap(prevPtr,prevMappedLen);
+	}
+}
+
+size_t cpputil::AnonymousMemory::size(void) const
+{
+	return len;
+}
+unsigned char *cpputil::AnonymousMemory::data(void)
+{
+	return ptr;
+}
+const unsigned char *cpputil::AnonymousMemory::data(void) const
+{
+	return ptr;
+}
+
+void cpputil::AnonymousMemory::Discard(void)
+{
+	if(nullptr==ptr)
+	{
+		return;
+	}
+#if defined(_WIN32)
+	VirtualFree(ptr,mappedLen,MEM_DECOMMIT);
+	VirtualAlloc(ptr,mappedLen,MEM_COMMIT,PAGE_READWRITE);
+#elif defined(ANONMEM_USE_MMAP)
+	// Mapping a new anonymous memory over the same range replaces the pages with the zero pages.
+	if(MAP_FAILED==mmap(ptr,mappedLen,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED,-1,0))
+	{
+		memset(ptr,0,len);
+	}
+#else
+	memset(ptr,0,len);
+#endif
+}
+
+size_t cpputil::AnonymousMemory::GetNumPages(void) const
+{
+	return (len+PAGE_SIZE-1)/PAGE_SIZE;
+}
+
+bool cpputil::AnonymousMemory::IsZeroPage(size_t page) const
+{
+	auto offset=page*PAGE_SIZE;
+	if(len<=offset)
+	{
+		return true;
+	}
+	auto pageLen=std::min<size_t>(PAGE_SIZE,len-offset);
+	return pageLen==(size_t)std::count(ptr+offset,ptr+offset+pageLen,0);
+}
@@ -0,0 +1,86 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#ifndef ANONMEM_IS_INCLUDED
+#define ANONMEM_IS_INCLUDED
+/* { */
+
+#include <stddef.h>
+
+namespace cpputil
+{
+
+/*! Memory block backed by an anonymous memory mapping.
+    The operating system commits a page on the first write.  Pages never written read zero without using physical memory.
+    Falls back to calloc where memory mapping is not available.
+    size, data, and resize are named after std::vector so that it can replace std::vector <unsigned char>.
+    It also converts to a pointer so that it can replace a fixed-size array.
+*/
+class AnonymousMemory
+{
+public:
+	enum
+	{
+		PAGE_SIZE=4096
+	};
+private:
+	unsigned char *ptr=nullptr;
+	size_t len=0,mappedLen=0;
+
+	static unsigned char *Map(size_t mappedLen);
+	static void Unmap(unsigned char *ptr,size_t mappedLen);
+	void CopyNonZeroPages(const unsigned char src[],size_t len);
+
+public:
+	AnonymousMemory();
+	AnonymousMemory(const AnonymousMemory &incoming);
+	AnonymousMemory &operator=(const AnonymousMemory &incoming);
+	~AnonymousMemory();
+
+	/*! Resizes the block.  Contents up to the smaller of the old and new sizes are preserved.
+	    Newly added bytes are zero.
+	    Pointers to the old block become invalid if the size changes.
+	*/
+	void resize(size_t newLen);
+
+	size_t size(void) const;
+	unsigned char *data(void);
+	const unsigned char *data(void) const;
+	inline operator unsigned char *()
+	{
+		return ptr;
+	}
+	inline operator const unsigned char *() const
+	{
+		return ptr;
+	}
+
+	/*! Makes all bytes zero by giving the pages back to the operating system.
+	    Unlike resize, pointers to the block stay valid.
+	*/
+	void Discard(void);
+
+	/*! Returns the number of pages including the last partial page.
+	*/
+	size_t GetNumPages(void) const;
+
+	/*! Returns true if all bytes in the page are zero.  Pages never written are always zero.
+	*/
+	bool IsZeroPage(size_t page) const;
+};
+
+}
+
+/* } */
+#endif
@@ -13,8 +13,10 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 << LICENSE */
 #include <fstream>
+#include <stdio.h>
 
 #ifdef _WIN32
+	#include <windows.h>
 	#include <direct.h>
 	#define getcwd _getcwd
 #else
@@ -861,6 +863,16 @@ long long int cpputil::FileSize(const std::string &fName)
 	return 0;
 }
 
+bool cpputil::RenameReplacing(const std::string &fromFName,const std::string &toFName)
+{
+#ifdef _WIN32
+	// rename of the C runtime fails if the destination exists.
+	return 0!=MoveFileExA(fromFName.c_str(),toFName.c_str(),MOVEFILE_REPLACE_EXISTING);
+#else
+	return 0==rename(fromFName.c_str(),toFName.c_str());
+#endif
+}
+
 char BoolToChar(bool f)
 {
 	return (true==f ? '1' : '0');
@@ -79,6 +79,10 @@ void SimplifyPath(std::string &path);
 
 long long int FileSize(const std::string &fName);
 
+/*! Renames a file.  Replaces toFName if it exists, also on Windows.
+*/
+bool RenameReplacing(const std::string &fromFName,const std::string &toFName);
+
 
 char BoolToChar(bool f);
 
@@ -0,0 +1,95 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <thread>
+#include <stdint.h>
+
+#include "spscringbuffer.h"
+
+int main(void)
+{
+	cpputil::SPSCRingBuffer <uint32_t> ring(100);
+	if(127!=ring.Capacity())
+	{
+		std::cout << "Unexpected capacity " << ring.Capacity() << std::endl;
+		return 1;
+	}
+
+	const uint32_t N=200000;
+	std::thread producer([&]
+	{
+		uint32_t block[37];
+		uint32_t i=0;
+		while(i<N)
+		{
+			if(0==i%3)
+			{
+				if(true==ring.Push(i))
+				{
+					++i;
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+			else
+			{
+				uint32_t n=0;
+				while(n<37 && i+n<N)
+				{
+					block[n]=i+n;
+					++n;
+				}
+				auto pushed=ring.Push(block,n);
+				if(0==pushed)
+				{
+					std::this_thread::yield();
+				}
+				i+=(uint32_t)pushed;
+			}
+		}
+	});
+
+	uint32_t expect=0;
+	bool error=false;
+	while(expect<N && true!=error)
+	{
+		uint32_t block[16];
+		auto n=ring.Pop(block,16);
+		if(0==n)
+		{
+			std::this_thread::yield();
+		}
+		for(size_t i=0; i<n; ++i)
+		{
+			if(block[i]!=expect)
+			{
+				std::cout << "Expected " << expect << " but got " << block[i] << std::endl;
+				error=true;
+				break;
+			}
+			++expect;
+		}
+	}
+	producer.join();
+
+	if(true==error || true!=ring.Empty())
+	{
+		return 1;
+	}
+	std::cout << "SPSC ring buffer test passed." << std::endl;
+	return 0;
+}
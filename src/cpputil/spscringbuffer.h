@@ -0,0 +1,180 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#ifndef SPSCRINGBUFFER_IS_INCLUDED
+#define SPSCRINGBUFFER_IS_INCLUDED
+/* { */
+
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <stddef.h>
+
+namespace cpputil
+{
+
+/*! Lock-free ring buffer for one producer thread and one consumer thread.
+    Push and Pop must be called from the producer and the consumer respectively.
+    Resize and Clear are not thread-safe.  Call them only when neither thread is using the buffer.
+    One slot is always kept empty, and the capacity is rounded up to a power of two minus one.
+*/
+template <class T>
+class SPSCRingBuffer
+{
+private:
+	std::vector <T> buf;
+	size_t mask=0;
+	std::atomic <size_t> head{0};  // Next slot to be written.  Modified only by the producer.
+	std::atomic <size_t> tail{0};  // Next slot to be read.  Modified only by the consumer.
+
+public:
+	SPSCRingBuffer(){}
+	explicit SPSCRingBuffer(size_t capacity)
+	{
+		Resize(capacity);
+	}
+
+	void Resize(size_t capacity)
+	{
+		size_t size=2;
+		while(size<capacity+1)
+		{
+			size<<=1;
+		}
+		buf.clear();
+		buf.resize(size);
+		mask=size-1;
+		head=0;
+		tail=0;
+	}
+	void Clear(void)
+	{
+		head=0;
+		tail=0;
+	}
+	size_t Capacity(void) const
+	{
+		return mask;
+	}
+	size_t Size(void) const
+	{
+		return (head.load(std::memory_order_acquire)-tail.load(std::memory_order_acquire))&mask;
+	}
+	bool Empty(void) const
+	{
+		return head.load(std::memory_order_acquire)==tail.load(std::memory_order_acquire);
+	}
+
+	/*! Producer side.  Returns false if the buffer is full.
+	*/
+	bool Push(const T &incoming)
+	{
+		auto h=head.load(std::memory_order_relaxed);
+		auto next=(h+1)&mask;
+		if(next==tail.load(std::memory_order_acquire) || 0==mask)
+		{
+			return false;
+		}
+		buf[h]=incoming;
+		head.store(next,std::memory_order_release);
+		return true;
+	}
+	bool Push(T &&incoming)
+	{
+		auto h=head.load(std::memory_order_relaxed);
+		auto next=(h+1)&mask;
+		if(next==tail.load(std::memory_order_acquire) || 0==mask)
+		{
+			return false;
+		}
+		buf[h]=std::move(incoming);
+		head.store(next,std::memory_order_release);
+		return true;
+	}
+	/*! Producer side.  Pushes as many as possible, and returns the number of items pushed.
+	*/
+	size_t Push(const T incoming[],size_t n)
+	{
+		auto h=head.load(std::memory_order_relaxed);
+		auto t=tail.load(std::memory_order_acquire);
+		size_t room=(t-h-1)&mask;
+		if(room<n)
+		{
+			n=room;
+		}
+		for(size_t i=0; i<n; ++i)
+		{
+			buf[(h+i)&mask]=incoming[i];
+		}
+		head.store((h+n)&mask,std::memory_order_release);
+		return n;
+	}
+
+	/*! Consumer side.  Returns false if the buffer is empty.
+	*/
+	bool Pop(T &outgoing)
+	{
+		auto t=tail.load(std::memory_order_relaxed);
+		if(t==head.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		outgoing=std::move(buf[t]);
+		tail.store((t+1)&mask,std::memory_order_release);
+		return true;
+	}
+	/*! Consumer side.  Pops up to n items, and returns the number of items popped.
+	*/
+	size_t Pop(T outgoing[],size_t n)
+	{
+		auto t=tail.load(std::memory_order_relaxed);
+		auto h=head.load(std::memory_order_acquire);
+		size_t avail=(h-t)&mask;
+		if(avail<n)
+		{
+			n=avail;
+		}
+		for(size_t i=0; i<n; ++i)
+		{
+			outgoing[i]=std::move(buf[(t+i)&mask]);
+		}
+		tail.store((t+n)&mask,std::memory_order_release);
+		return n;
+	}
+	/*! Consumer side.  Returns the pointer to the item to be popped next, or nullptr if empty.
+	*/
+	T *Front(void)
+	{
+		auto t=tail.load(std::memory_order_relaxed);
+		if(t==head.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+		return &buf[t];
+	}
+	const T *Front(void) const
+	{
+		auto t=tail.load(std::memory_order_relaxed);
+		if(t==head.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+		return &buf[t];
+	}
+};
+
+}
+
+/* } */
+#endif
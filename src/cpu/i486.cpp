@@ -891,6 +891,71 @@ std::vector <std::string> i486DXCommon::GetTESTText(void) const
 	return text;
 }
 
+void i486DXCommon::MemoryWindowStatistics::Clear(void)
+{
+	*this=MemoryWindowStatistics();
+}
+
+i486DXCommon::MemoryWindowStatistics i486DXCommon::MemoryWindowStatistics::Since(const MemoryWindowStatistics &before) const
+{
+	MemoryWindowStatistics diff;
+	diff.CSEIPFetch=CSEIPFetch-before.CSEIPFetch;
+	diff.CSEIPRefill=CSEIPRefill-before.CSEIPRefill;
+	diff.CSEIPRefillFromEmpty=CSEIPRefillFromEmpty-before.CSEIPRefillFromEmpty;
+	diff.CSEIPNoWindow=CSEIPNoWindow-before.CSEIPNoWindow;
+	diff.CSEIPPageCross=CSEIPPageCross-before.CSEIPPageCross;
+	diff.stackAccess=stackAccess-before.stackAccess;
+	diff.stackRefill=stackRefill-before.stackRefill;
+	diff.stackRefillFromEmpty=stackRefillFromEmpty-before.stackRefillFromEmpty;
+	diff.stackNoWindow=stackNoWindow-before.stackNoWindow;
+	diff.stackPageCross=stackPageCross-before.stackPageCross;
+	diff.pageTableCacheHit=pageTableCacheHit-before.pageTableCacheHit;
+	diff.pageTableCacheMiss=pageTableCacheMiss-before.pageTableCacheMiss;
+	return diff;
+}
+
+static std::string MemoryWindowStatisticsRatio(uint64_t count,uint64_t total)
+{
+	std::string str=std::to_string(count);
+	if(0<total)
+	{
+		auto percent=(unsigned int)((count*1000+total/2)/total);
+		str+=" (";
+		str+=cpputil::Uitoa(percent/10);
+		str+=".";
+		str+=cpputil::Uitoa(percent%10);
+		str+="%)";
+	}
+	return str;
+}
+
+std::vector <std::string> i486DXCommon::MemoryWindowStatistics::GetStatusText(void) const
+{
+	std::vector <std::string> text;
+
+	text.push_back("CS:EIP Window");
+	text.push_back("  Fetch:            "+MemoryWindowStatisticsRatio(CSEIPFetch,0));
+	text.push_back("  Hit:              "+MemoryWindowStatisticsRatio(CSEIPFetch-CSEIPRefill,CSEIPFetch));
+	text.push_back("  Refill:           "+MemoryWindowStatisticsRatio(CSEIPRefill,CSEIPFetch));
+	text.push_back("    From Empty:     "+MemoryWindowStatisticsRatio(CSEIPRefillFromEmpty,CSEIPFetch));
+	text.push_back("    No Window:      "+MemoryWindowStatisticsRatio(CSEIPNoWindow,CSEIPFetch));
+	text.push_back("  4KB Border:       "+MemoryWindowStatisticsRatio(CSEIPPageCross,CSEIPFetch));
+
+	text.push_back("SS:ESP Window (Push/Pop)");
+	text.push_back("  Access:           "+MemoryWindowStatisticsRatio(stackAccess,0));
+	text.push_back("  Hit:              "+MemoryWindowStatisticsRatio(stackAccess-stackRefill-stackPageCross,stackAccess));
+	text.push_back("  Refill:           "+MemoryWindowStatisticsRatio(stackRefill,stackAccess));
+	text.push_back("    From Empty:     "+MemoryWindowStatisticsRatio(stackRefillFromEmpty,stackAccess));
+	text.push_back("    No Window:      "+MemoryWindowStatisticsRatio(stackNoWindow,stackAccess));
+	text.push_back("  4KB Border:       "+MemoryWindowStatisticsRatio(stackPageCross,stackAccess));
+
+	text.push_back("Page Table Cache");
+	text.push_back("  Hit:              "+MemoryWindowStatisticsRatio(pageTableCacheHit,pageTableCacheHit+pageTableCacheMiss));
+	text.push_back("  Miss:             "+MemoryWindowStatisticsRatio(pageTableCacheMiss,pageTableCacheHit+pageTableCacheMiss));
+
+	return text;
+}
+
 void i486DXCommon::PrintState(void) const
 {
 	for(auto &str : GetStateText())
@@ -2303,6 +2368,11 @@ void i486DXCommon::PopCallStack(unsigned int CS,unsigned int EIP)
 		{
 			nPop=0;
 		}
+		else if(nullptr!=int21HInterceptorPtr && 0x21==callStack[callStack.size()-nPop].INTNum)
+		{
+			auto &stk=callStack[callStack.size()-nPop];
+			int21HInterceptorPtr->InterceptINT21HReturn(stk.fromCS,stk.fromEIP);
+		}
 		while(0<nPop)
 		{
 			callStack.pop_back();
@@ -2399,6 +2469,138 @@ unsigned int i486DXCommon::DebugFetchByteWordOrDword(unsigned int operandSize,un
 	return DebugFetchWordOrDword(operandSize,addressSize,seg,offset,mem);
 }
 
+/*! Reads page by page.  Stops at the first page that raises a page fault.
+*/
+unsigned int i486DXCommon::ReadLinearBlock(unsigned int linearAddr,unsigned int len,unsigned char buf[],Memory &mem)
+{
+	unsigned int copied=0;
+	while(copied<len)
+	{
+		unsigned int inPage=MemoryAccess::MEMORY_WINDOW_SIZE-(linearAddr&(MemoryAccess::MEMORY_WINDOW_SIZE-1));
+		inPage=std::min(inPage,len-copied);
+
+		unsigned int physAddr=linearAddr;
+		if(true==PagingEnabled())
+		{
+			auto exceptionBefore=state.exception;
+			physAddr=RedirectLinearAddressToPhysicalAddressRead(linearAddr,mem);
+			if(true!=exceptionBefore && true==state.exception)
+			{
+				break;
+			}
+		}
+
+		auto memWin=mem.GetConstMemoryWindow(physAddr);
+		if(nullptr!=memWin.ptr)
+		{
+			memcpy(buf+copied,memWin.ptr+(physAddr&(MemoryAccess::MEMORY_WINDOW_SIZE-1)),inPage);
+		}
+		else
+		{
+			for(unsigned int i=0; i<inPage; ++i)
+			{
+				buf[copied+i]=mem.FetchByte(physAddr+i);
+			}
+		}
+
+		linearAddr+=inPage;
+		copied+=inPage;
+	}
+	return copied;
+}
+
+/*! Writes page by page.  Stops at the first page that raises a page fault.
+*/
+unsigned int i486DXCommon::WriteLinearBlock(unsigned int linearAddr,unsigned int len,const unsigned char data[],Memory &mem)
+{
+	unsigned int copied=0;
+	while(copied<len)
+	{
+		unsigned int inPage=MemoryAccess::MEMORY_WINDOW_SIZE-(linearAddr&(MemoryAccess::MEMORY_WINDOW_SIZE-1));
+		inPage=std::min(inPage,len-copied);
+
+		unsigned int physAddr=linearAddr;
+		if(true==PagingEnabled())
+		{
+			auto exceptionBefore=state.exception;
+			physAddr=RedirectLinearAddressToPhysicalAddressWrite(linearAddr,mem);
+			if(true!=exceptionBefore && true==state.exception)
+			{
+				break;
+			}
+		}
+
+		auto memWin=mem.GetMemoryWindow(physAddr);
+		if(nullptr!=memWin.ptr)
+		{
+			memcpy(memWin.ptr+(physAddr&(MemoryAccess::MEMORY_WINDOW_SIZE-1)),data+copied,inPage);
+		}
+		else
+		{
+			for(unsigned int i=0; i<inPage; ++i)
+			{
+				mem.StoreByte(physAddr+i,data[copied+i]);
+			}
+		}
+
+		linearAddr+=inPage;
+		copied+=inPage;
+	}
+	return copied;
+}
+
+/*! Scans page by page.  Stops at the NUL, maxLen, or the first page that raises a page fault.
+*/
+bool i486DXCommon::ReadLinearCString(std::string &str,unsigned int linearAddr,unsigned int maxLen,Memory &mem)
+{
+	unsigned int scanned=0;
+	while(scanned<maxLen)
+	{
+		unsigned int inPage=MemoryAccess::MEMORY_WINDOW_SIZE-(linearAddr&(MemoryAccess::MEMORY_WINDOW_SIZE-1));
+		inPage=std::min(inPage,maxLen-scanned);
+
+		unsigned int physAddr=linearAddr;
+		if(true==PagingEnabled())
+		{
+			auto exceptionBefore=state.exception;
+			physAddr=RedirectLinearAddressToPhysicalAddressRead(linearAddr,mem);
+			if(true!=exceptionBefore && true==state.exception)
+			{
+				return false;
+			}
+		}
+
+		auto memWin=mem.GetConstMemoryWindow(physAddr);
+		if(nullptr!=memWin.ptr)
+		{
+			auto ptr=(const char *)memWin.ptr+(physAddr&(MemoryAccess::MEMORY_WINDOW_SIZE-1));
+			auto nulPtr=(const char *)memchr(ptr,0,inPage);
+			if(nullptr!=nulPtr)
+			{
+				str.append(ptr,nulPtr-ptr);
+				return true;
+			}
+			str.append(ptr,inPage);
+		}
+		else
+		{
+			for(unsigned int i=0; i<inPage; ++i)
+			{
+				auto c=mem.FetchByte(physAddr+i);
+				if(0==c)
+				{
+					return true;
+				}
+				str.push_back((char)c);
+			}
+		}
+
+		linearAddr+=inPage;
+		scanned+=inPage;
+	}
+	return false;
+}
+
 /*! Fetch a byte by linear address for debugging.  It won't change exception status.
 */
 unsigned int i486DXCommon::DebugFetchByteByLinearAddress(const Memory &mem,unsigned int linearAddr) const
@@ -879,6 +879,7 @@ public:
 
 		MemoryAccess::ConstMemoryWindow CSEIPWindow;   // This must be cleared on state-load.
 		MemoryAccess::MemoryWindow SSESPWindow;         // This must be cleared on state-load.
+		uint32_t memWindowGeneration=0;                 // Memory::GetWindowGeneration() when the two windows above were last checked.
 	public:
 		unsigned int DR[8];
 		unsigned int TEST[8];
@@ -1253,11 +1254,20 @@ public:
 
 	/*! INT21HInterceptor will intercept DOS function calls (INT 21H) when call stack is enabled.
 	    For AH=3DH (fopen) and AH=4BH (load or exec), the file name will be given.
+
+	    HostINT21H is called by the INT 21H instruction before the interrupt is dispatched, regardless of
+	    the call stack.  If it returns true, the host has done the service, and the CPU moves on to the
+	    next instruction without entering DOS.  It is not called in VM86 mode.
+
+	    InterceptINT21HReturn is called when the call stack is enabled, and the INT 21H that was issued
+	    at fromCS:fromEIP returns.  Registers and memory hold the result of the DOS call.
 	*/
 	class INT21HInterceptor
 	{
 	public:
 		virtual void InterceptINT21H(unsigned int AX,const std::string fName)=0;
+		virtual bool HostINT21H(void)=0;
+		virtual void InterceptINT21HReturn(unsigned int fromCS,unsigned int fromEIP)=0;
 	};
 	INT21HInterceptor *int21HInterceptorPtr=nullptr;
 
@@ -1598,6 +1608,54 @@ public:
 
 	State state;
 
+	/*! Hit/miss counters of CSEIPWindow, SSESPWindow, and the page-table cache.
+	    Not part of the state.  Counted always since the cost is one increment per event.
+	*/
+	class MemoryWindowStatistics
+	{
+	public:
+		uint64_t CSEIPFetch=0;           // Number of instructions fetched.
+		uint64_t CSEIPRefill=0;          // CSEIPWindow did not cover CS:EIP.
+		uint64_t CSEIPRefillFromEmpty=0; // CSEIPWindow was empty (invalidated, or no window in the last page).
+		uint64_t CSEIPNoWindow=0;        // No window for CS:EIP.  Instruction was fetched byte by byte through the memory-access object.
+		uint64_t CSEIPPageCross=0;       // Instruction may cross the 4KB border.  Fetched with the length check.
+
+		uint64_t stackAccess=0;          // Push and pop.
+		uint64_t stackRefill=0;
+		uint64_t stackRefillFromEmpty=0;
+		uint64_t stackNoWindow=0;        // No window for SS:ESP.
+		uint64_t stackPageCross=0;       // Push or pop crossing the 4KB border.
+
+		uint64_t pageTableCacheHit=0;
+		uint64_t pageTableCacheMiss=0;
+
+		void Clear(void);
+
+		/*! Returns counts since before.
+		*/
+		MemoryWindowStatistics Since(const MemoryWindowStatistics &before) const;
+
+		std::vector <std::string> GetStatusText(void) const;
+	};
+	MemoryWindowStatistics memWinStats;
+
+	/*! Host block operation for REP MOVS and REP STOS.
+	    Block moves and VRAM fills of TBIOS and DOS spend most of the time in these instructions.
+	    When enabled, the elements that follow in the same pages are moved or filled by one memcpy/memset
+	    on the memory windows, instead of one memory access per element.
+	    The result, registers, and clocks are the same as running one element at a time.
+	*/
+	enum
+	{
+		BLOCKOP_OFF,
+		BLOCKOP_ON,
+		BLOCKOP_VERIFY, // Runs one element at a time, and compares the memory with the result of the host block operation.  Mismatch is logged and counted, and the interpreted result stays.
+	};
+	unsigned int blockOpMode=BLOCKOP_OFF;
+	uint64_t blockOpCount=0;     // Number of host block operations.
+	uint64_t blockOpElements=0;  // Number of elements moved or filled by the host block operations.
+	uint64_t blockOpMismatch=0;  // Number of host block operations that did not match in BLOCKOP_VERIFY mode.
+
 #ifdef YS_LITTLE_ENDIAN
 	#define INT_LOW_WORD(i) (*((uint16_t *)&(i)))
 	#define INT_LOW_BYTE(i) (((unsigned char *)&(i))[0])
@@ -2637,6 +2695,19 @@ public:
 	void ClearPageTableCache(void);
 	void InvalidatePageTableCache(void);
 
+	/*! Clears CSEIPWindow and SSESPWindow if memory-access objects have been re-assigned since the windows were taken.
+	    For example, a VRAM window must not be used for writing after the VRAM mask is turned on.
+	*/
+	inline void CheckMemoryWindowGeneration(const Memory &mem)
+	{
+		if(state.memWindowGeneration!=mem.GetWindowGeneration())
+		{
+			state.CSEIPWindow.CleanUp();
+			state.SSESPWindow.CleanUp();
+			state.memWindowGeneration=mem.GetWindowGeneration();
+		}
+	}
+
 	void ClearDescriptorCache(void);
 	void InvalidateDescriptorCache(void);
 
@@ -2931,6 +3002,25 @@ public:
 	*/
 	virtual void RedirectStoreDword(Memory &mem,int addressSize,const SegmentRegister &seg,unsigned int offset,unsigned int data)=0;
 
+	/*! Copies len bytes from the linear address to buf.  For device helpers that move a block of data.
+	    The address is translated once per 4KB page, and the page is copied through the memory window
+	    if it is available.  If the translation raises a page fault, the exception is raised as
+	    RedirectFetchByte would, and the copy stops there.
+	    Returns the number of bytes copied.
+	*/
+	unsigned int ReadLinearBlock(unsigned int linearAddr,unsigned int len,unsigned char buf[],Memory &mem);
+
+	/*! Copies len bytes from data to the linear address.  See ReadLinearBlock.
+	*/
+	unsigned int WriteLinearBlock(unsigned int linearAddr,unsigned int len,const unsigned char data[],Memory &mem);
+
+	/*! Appends a NUL-terminated string at the linear address to str, reading at most maxLen bytes.
+	    Memory after the NUL is not read.  A page with a memory window is scanned directly, and other
+	    pages are read byte by byte.  Stops at a page fault as ReadLinearBlock does.
+	    Returns true if the NUL was found.
+	*/
+	bool ReadLinearCString(std::string &str,unsigned int linearAddr,unsigned int maxLen,Memory &mem);
+
 
 	/*! Fetch a byte for debugger.  It won't change exception status.
 	*/
@@ -3517,6 +3607,25 @@ protected:
 	// If not, it returns nullptr.
 	inline unsigned char *GetStackAccessPointer(Memory &mem,uint32_t linearAddr,unsigned int numBytes);
 
+	/*! Helper for REPMOVSBlock and REPSTOSBlock.
+	    Returns the number of elements, up to count, from offset that stay in the 4KB page of linearAddr and in the offset range of the address size.
+	    Returns zero if the previous element is not in the same page, or the offset wrapped around after it.
+	*/
+	static inline unsigned int BlockOpElementsInPage(unsigned int addressSize,uint32_t offset,uint32_t linearAddr,unsigned int elemSize,unsigned int count);
+
+	/*! Host block operation for REP MOVS.  See blockOpMode.
+	    It must be called after an element has been moved one by one, and then it moves the elements that follow
+	    while the source and the destination stay in the pages of the element just moved.
+	    Since the previous element has been moved in the same pages, there can be no exception.
+	    It returns the number of elements moved, up to maxCount.  CX/ECX, SI/ESI, DI/EDI, and clocksPassed are updated.
+	    It returns zero if the elements need to be moved one by one (no memory window, overlap, segment limit, DF=1, etc.)
+	*/
+	unsigned int REPMOVSBlock(Memory &mem,unsigned int addressSize,const SegmentRegister &seg,unsigned int elemSize,unsigned int maxCount,unsigned int &clocksPassed);
+
+	/*! Host block operation for REP STOS.  See REPMOVSBlock.
+	*/
+	unsigned int REPSTOSBlock(Memory &mem,unsigned int addressSize,unsigned int elemSize,unsigned int maxCount,unsigned int &clocksPassed);
+
 public:
 	/*! Push a value.
 	*/
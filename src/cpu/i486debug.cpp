@@ -13,6 +13,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 << LICENSE */
 #include <iostream>
+#include <algorithm>
 #include <fstream>
 #include <stdint.h>
 
@@ -107,6 +108,7 @@ i486Debugger::i486Debugger()
 	{
 		CS=false;
 	}
+	breakPointPageFilter.resize(BRKPNT_NUM_PAGES/64);
 	MakeVxDLabelTable();
 	CleanUp();
 }
@@ -136,6 +138,7 @@ const std::map <unsigned int,std::string> &i486Debugger::GetIOTable(void) const
 void i486Debugger::CleanUp(void)
 {
 	breakPoints.clear();
+	UpdateBreakPointPageFilter();
 	stop=false;
 	ClearBreakOnINT();
 	monitorIO=false;
@@ -171,6 +174,8 @@ void i486Debugger::AddBreakPoint(CS_EIP bp,BreakPointInfo info)
 	else
 	{
 		breakPoints[bp]=info;
+		auto page=(bp.OFFSET>>BRKPNT_PAGE_SHIFT);
+		breakPointPageFilter[page>>6]|=(1ULL<<(page&63));
 	}
 }
 void i486Debugger::RemoveBreakPoint(CS_EIP bp)
@@ -185,12 +190,38 @@ void i486Debugger::RemoveBreakPoint(CS_EIP bp)
 		if(breakPoints.end()!=iter)
 		{
 			breakPoints.erase(iter);
+			UnmarkBreakPointPage(bp.OFFSET);
 		}
 	}
 }
+void i486Debugger::UnmarkBreakPointPage(uint32_t EIP)
+{
+	auto page=(EIP>>BRKPNT_PAGE_SHIFT);
+	for(auto &bp : breakPoints)
+	{
+		if(page==(bp.first.OFFSET>>BRKPNT_PAGE_SHIFT))
+		{
+			return;
+		}
+	}
+	breakPointPageFilter[page>>6]&=~(1ULL<<(page&63));
+}
+void i486Debugger::UpdateBreakPointPageFilter(void)
+{
+	for(auto &bits : breakPointPageFilter)
+	{
+		bits=0;
+	}
+	for(auto &bp : breakPoints)
+	{
+		auto page=(bp.first.OFFSET>>BRKPNT_PAGE_SHIFT);
+		breakPointPageFilter[page>>6]|=(1ULL<<(page&63));
+	}
+}
 void i486Debugger::ClearBreakPoints(void)
 {
 	breakPoints.clear();
+	UpdateBreakPointPageFilter();
 	oneTimeBreakPoint.Nullify();
 	ClearCSBreakPoints();
 }
@@ -210,6 +241,7 @@ std::vector <i486Debugger::CS_EIP> i486Debugger::GetBreakPoints(void) const
 	{
 		list.push_back(bp.first);
 	}
+	std::sort(list.begin(),list.end());
 	return list;
 }
 
@@ -220,6 +252,7 @@ std::vector <std::pair <i486Debugger::CS_EIP,i486Debugger::BreakPointInfo> > i48
 	{
 		list.push_back(bp);
 	}
+	std::sort(list.begin(),list.end(),[](const std::pair<CS_EIP,BreakPointInfo> &a,const std::pair<CS_EIP,BreakPointInfo> &b){return a.first<b.first;});
 	return list;
 }
 
@@ -526,6 +559,7 @@ void i486Debugger::CheckForBreakPoints(i486DXCommon &cpu)
 	cseip.SEG=cpu.state.CS().value;
 	cseip.OFFSET=cpu.state.EIP;
 
+	if(true==BreakPointMayExistAt(cseip.OFFSET))
 	{
 		auto found=breakPoints.find(cseip);
 		if(found!=breakPoints.end())
@@ -545,6 +579,7 @@ void i486Debugger::CheckForBreakPoints(i486DXCommon &cpu)
 			if(0!=(found->second.flags&BRKPNT_FLAG_ONE_TIME))
 			{
 				breakPoints.erase(found);
+				UnmarkBreakPointPage(cseip.OFFSET);
 			}
 		}
 	}
@@ -637,6 +672,21 @@ std::vector <std::string> i486Debugger::GetCallStackText(const i486DXCommon &cpu
 			str+=symbolPtr->Format();
 			str+="}";
 		}
+		else if(nullptr==symbolPtr)
+		{
+			i486DXCommon::FarPointer procPtr,symPtr;
+			procPtr.SEG=s.procCS;
+			procPtr.OFFSET=s.procEIP;
+			symbolPtr=symTable.FindNearest(procPtr,symPtr);
+			if(nullptr!=symbolPtr)
+			{
+				str+="{";
+				str+=symbolPtr->Format(false,true,false);
+				str+="+";
+				str+=cpputil::Uitox(s.procEIP-symPtr.OFFSET);
+				str+="H}";
+			}
+		}
 		if(s.INTNum<0x100)
 		{
 			str+="  (INT ";
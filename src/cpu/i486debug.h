@@ -20,12 +20,24 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include <string>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <fstream>
 #include <string.h> // for memcpy
 #include "i486.h"
 
 
 
+template <>
+struct std::hash <i486DXCommon::FarPointer>
+{
+	std::size_t operator()(const i486DXCommon::FarPointer &bp) const noexcept
+	{
+		size_t high=bp.SEG;
+		size_t low=bp.OFFSET;
+		return (high<<32)|low;
+	}
+};
+
 class i486Debugger
 {
 public:
@@ -129,7 +141,19 @@ public:
 
 	typedef i486DXCommon::FarPointer CS_EIP;
 
-	std::map <CS_EIP,BreakPointInfo> breakPoints;
+	enum
+	{
+		BRKPNT_PAGE_SHIFT=12,
+		BRKPNT_NUM_PAGES=0x100000,
+	};
+
+	/*! Break points are checked after every instruction.
+	    breakPointPageFilter has one bit per 4KB page of EIP, set if at least one break point has EIP in the page.
+	    Only if the bit is set, breakPoints needs to be looked up.
+	    breakPoints must be modified through AddBreakPoint, RemoveBreakPoint, and ClearBreakPoints to keep the filter up to date.
+	*/
+	std::unordered_map <CS_EIP,BreakPointInfo> breakPoints;
+	std::vector <uint64_t> breakPointPageFilter;
 	BreakPointInfo lastBreakPointInfo;
 	bool breakOnCS[65536];
 	std::vector <bool> breakOnIORead,breakOnIOWrite;
@@ -231,6 +255,17 @@ public:
 	~i486Debugger();
 	void CleanUp(void);
 
+	inline bool BreakPointMayExistAt(uint32_t EIP) const
+	{
+		auto page=(EIP>>BRKPNT_PAGE_SHIFT);
+		return 0!=(breakPointPageFilter[page>>6]&(1ULL<<(page&63)));
+	}
+	void UpdateBreakPointPageFilter(void);
+	/*! Clears the filter bit of the page of EIP unless another break point remains in the page.
+	    Call after erasing a break point from breakPoints.
+	*/
+	void UnmarkBreakPointPage(uint32_t EIP);
+
 	void AddBreakPoint(CS_EIP bp,BreakPointInfo info);
 	void RemoveBreakPoint(CS_EIP bp);
 	void ClearBreakPoints(void);
@@ -422,16 +457,5 @@ public:
 	void WriteLogFile(std::string str);
 };
 
-template <>
-struct std::hash <i486Debugger::CS_EIP>
-{
-	std::size_t operator()(const i486Debugger::CS_EIP &bp) const noexcept
-	{
-		size_t high=bp.SEG;
-		size_t low=bp.OFFSET;
-		return (high<<32)|low;
-	}
-};
-
 /* } */
 #endif
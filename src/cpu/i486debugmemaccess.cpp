@@ -13,6 +13,8 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 << LICENSE */
 
+#include <algorithm>
+
 #include "i486debugmemaccess.h"
 #include "cpputil.h"
 
@@ -26,6 +28,7 @@ i486DebugMemoryAccess::i486DebugMemoryAccess(i486Debugger &debugger,unsigned int
 	{
 		breakOnRead[i]=false;
 		breakOnWrite[i]=false;
+		breakOnChange[i]=false;
 		breakOnWriteMin[i]=0;
 		breakOnWriteMax[i]=0xFF;
 	}
@@ -36,6 +39,7 @@ void i486DebugMemoryAccess::SetBreakOnRead(unsigned int physAddr)
 	if(0<=physAddr && physAddr<Memory::MEMORY_ACCESS_SLOT_SIZE)
 	{
 		breakOnRead[physAddr]=true;
+		readWatched=true;
 	}
 }
 void i486DebugMemoryAccess::SetBreakOnWrite(unsigned int physAddr)
@@ -52,6 +56,7 @@ void i486DebugMemoryAccess::SetBreakOnWrite(unsigned int physAddr)
 			breakOnWriteData.erase(found);
 		}
 	}
+	UpdateWatchFlags();
 }
 void i486DebugMemoryAccess::SetBreakOnWrite(unsigned int physAddr,unsigned char minValue,unsigned char maxValue)
 {
@@ -67,6 +72,7 @@ void i486DebugMemoryAccess::SetBreakOnWrite(unsigned int physAddr,unsigned char
 			breakOnWriteData.erase(found);
 		}
 	}
+	UpdateWatchFlags();
 }
 void i486DebugMemoryAccess::SetBreakOnWrite(uint32_t physAddr,unsigned char data)
 {
@@ -76,6 +82,44 @@ void i486DebugMemoryAccess::SetBreakOnWrite(uint32_t physAddr,unsigned char data
 		breakOnWrite[physAddr]=true;
 		breakOnWriteData[physAddr]=data;
 	}
+	UpdateWatchFlags();
+}
+void i486DebugMemoryAccess::SetBreakOnChange(unsigned int physAddr)
+{
+	physAddr-=physAddrTop;
+	if(0<=physAddr && physAddr<Memory::MEMORY_ACCESS_SLOT_SIZE)
+	{
+		breakOnChange[physAddr]=true;
+		writeWatched=true;
+	}
+}
+void i486DebugMemoryAccess::SetBreakOnRead(unsigned int physAddr0,unsigned int physAddr1)
+{
+	auto physAddrBottom=physAddrTop+(Memory::MEMORY_ACCESS_SLOT_SIZE-1);
+	if(physAddr0<=physAddrBottom && physAddrTop<=physAddr1)
+	{
+		auto i0=std::max(physAddr0,physAddrTop)-physAddrTop;
+		auto i1=std::min(physAddr1,physAddrBottom)-physAddrTop;
+		for(auto i=i0; i<=i1; ++i)
+		{
+			breakOnRead[i]=true;
+		}
+		readWatched=true;
+	}
+}
+void i486DebugMemoryAccess::SetBreakOnChange(unsigned int physAddr0,unsigned int physAddr1)
+{
+	auto physAddrBottom=physAddrTop+(Memory::MEMORY_ACCESS_SLOT_SIZE-1);
+	if(physAddr0<=physAddrBottom && physAddrTop<=physAddr1)
+	{
+		auto i0=std::max(physAddr0,physAddrTop)-physAddrTop;
+		auto i1=std::min(physAddr1,physAddrBottom)-physAddrTop;
+		for(auto i=i0; i<=i1; ++i)
+		{
+			breakOnChange[i]=true;
+		}
+		writeWatched=true;
+	}
 }
 void i486DebugMemoryAccess::ClearBreakOnRead(void)
 {
@@ -83,6 +127,7 @@ void i486DebugMemoryAccess::ClearBreakOnRead(void)
 	{
 		breakOnRead[i]=false;
 	}
+	UpdateWatchFlags();
 }
 void i486DebugMemoryAccess::ClearBreakOnWrite(void)
 {
@@ -91,6 +136,15 @@ void i486DebugMemoryAccess::ClearBreakOnWrite(void)
 		breakOnWrite[i]=false;
 	}
 	breakOnWriteData.clear();
+	UpdateWatchFlags();
+}
+void i486DebugMemoryAccess::ClearBreakOnChange(void)
+{
+	for(unsigned int i=0; i<Memory::MEMORY_ACCESS_SLOT_SIZE; ++i)
+	{
+		breakOnChange[i]=false;
+	}
+	UpdateWatchFlags();
 }
 void i486DebugMemoryAccess::ClearBreakOnReadWrite(void)
 {
@@ -99,6 +153,8 @@ void i486DebugMemoryAccess::ClearBreakOnReadWrite(void)
 		breakOnRead[i]=false;
 		breakOnWrite[i]=false;
 	}
+	breakOnWriteData.clear();
+	UpdateWatchFlags();
 }
 void i486DebugMemoryAccess::ClearBreakOnRead(unsigned int physAddr)
 {
@@ -107,25 +163,50 @@ void i486DebugMemoryAccess::ClearBreakOnRead(unsigned int physAddr)
 	{
 		breakOnRead[physAddr]=false;
 	}
+	UpdateWatchFlags();
 }
 void i486DebugMemoryAccess::ClearBreakOnWrite(unsigned int physAddr)
 {
 	physAddr-=physAddrTop;
 	if(0<=physAddr && physAddr<Memory::MEMORY_ACCESS_SLOT_SIZE)
 	{
-		breakOnRead[physAddr]=false;
+		breakOnWrite[physAddr]=false;
 		auto found=breakOnWriteData.find(physAddr);
 		if(breakOnWriteData.end()!=found)
 		{
 			breakOnWriteData.erase(found);
 		}
 	}
+	UpdateWatchFlags();
+}
+void i486DebugMemoryAccess::ClearBreakOnChange(unsigned int physAddr)
+{
+	physAddr-=physAddrTop;
+	if(0<=physAddr && physAddr<Memory::MEMORY_ACCESS_SLOT_SIZE)
+	{
+		breakOnChange[physAddr]=false;
+	}
+	UpdateWatchFlags();
+}
+void i486DebugMemoryAccess::UpdateWatchFlags(void)
+{
+	readWatched=breakOnReadAll;
+	writeWatched=breakOnWriteAll;
+	for(unsigned int i=0; i<Memory::MEMORY_ACCESS_SLOT_SIZE; ++i)
+	{
+		readWatched=(readWatched || breakOnRead[i]);
+		writeWatched=(writeWatched || breakOnWrite[i] || breakOnChange[i]);
+	}
+}
+bool i486DebugMemoryAccess::Unused(void) const
+{
+	return true!=readWatched && true!=writeWatched;
 }
 
 /* virtual */ unsigned int i486DebugMemoryAccess::FetchByte(unsigned int physAddr) const
 {
 	auto data=memAccessChain->FetchByte(physAddr);
-	if(true==breakOnRead[physAddr-physAddrTop])
+	if(true==readWatched && true==IsReadWatched(physAddr))
 	{
 		std::string msg;
 		msg="Memory Read BYTE PTR PHYS:[";
@@ -140,8 +221,9 @@ void i486DebugMemoryAccess::ClearBreakOnWrite(unsigned int physAddr)
 /* virtual */ unsigned int i486DebugMemoryAccess::FetchWord(unsigned int physAddr) const
 {
 	auto data=memAccessChain->FetchWord(physAddr);
-	if(true==breakOnRead[physAddr-physAddrTop] ||
-	   true==breakOnRead[physAddr+1-physAddrTop])
+	if(true==readWatched &&
+	   (true==IsReadWatched(physAddr) ||
+	    true==IsReadWatched(physAddr+1)))
 	{
 		std::string msg;
 		msg="Memory Read WORD PTR PHYS:[";
@@ -156,10 +238,11 @@ void i486DebugMemoryAccess::ClearBreakOnWrite(unsigned int physAddr)
 /* virtual */ unsigned int i486DebugMemoryAccess::FetchDword(unsigned int physAddr) const
 {
 	auto data=memAccessChain->FetchDword(physAddr);
-	if(true==breakOnRead[physAddr-physAddrTop] ||
-	   true==breakOnRead[physAddr+1-physAddrTop] ||
-	   true==breakOnRead[physAddr+2-physAddrTop] ||
-	   true==breakOnRead[physAddr+3-physAddrTop])
+	if(true==readWatched &&
+	   (true==IsReadWatched(physAddr) ||
+	    true==IsReadWatched(physAddr+1) ||
+	    true==IsReadWatched(physAddr+2) ||
+	    true==IsReadWatched(physAddr+3)))
 	{
 		std::string msg;
 		msg="Memory Read DWORD PTR PHYS:[";
@@ -175,7 +258,7 @@ void i486DebugMemoryAccess::ClearBreakOnWrite(unsigned int physAddr)
 /* virtual */ unsigned int i486DebugMemoryAccess::FetchByteDMA(unsigned int physAddr) const
 {
 	auto data=memAccessChain->FetchByte(physAddr);
-	if(true==breakOnRead[physAddr-physAddrTop])
+	if(true==readWatched && true==IsReadWatched(physAddr))
 	{
 		std::string msg;
 		msg="Memory Read BYTE PTR PHYS:[";
@@ -188,9 +271,23 @@ void i486DebugMemoryAccess::ClearBreakOnWrite(unsigned int physAddr)
 	return data;
 }
 
+/* virtual */ MemoryAccess::ConstMemoryWindow i486DebugMemoryAccess::GetConstMemoryWindow(unsigned int physAddr) const
+{
+	if(true!=readWatched)
+	{
+		// Reads do not need to be trapped.  Writes still come through StoreByte/Word/Dword since GetMemoryWindow is not forwarded.
+		return memAccessChain->GetConstMemoryWindow(physAddr);
+	}
+	return MemoryAccess::GetConstMemoryWindow(physAddr);
+}
+
 inline bool i486DebugMemoryAccess::CheckBreakOnWriteCondition(uint32_t physAddr,unsigned int data) const
 {
 	auto offset=physAddr-physAddrTop;
+	if(true==breakOnWriteAll)
+	{
+		return true;
+	}
 	if(true==breakOnWrite[offset])
 	{
 		auto found=breakOnWriteData.find(offset);
@@ -206,68 +303,92 @@ inline bool i486DebugMemoryAccess::CheckBreakOnWriteCondition(uint32_t physAddr,
 	return false;
 }
 
-/* virtual */ void i486DebugMemoryAccess::StoreByte(unsigned int physAddr,unsigned char data)
+inline bool i486DebugMemoryAccess::CheckBreakOnChangeCondition(uint32_t physAddr,unsigned int data) const
 {
-	if(true==CheckBreakOnWriteCondition(physAddr,data))
+	return true==breakOnChange[physAddr-physAddrTop] && memAccessChain->FetchByte(physAddr)!=data;
+}
+
+void i486DebugMemoryAccess::BreakOnStore(const char ptrType[],uint32_t physAddr,unsigned int data,unsigned int numBytes,const char suffix[])
+{
+	std::string msg;
+	msg="Memory Write ";
+	msg+=ptrType;
+	msg+=" PTR PHYS:[";
+	msg+=cpputil::Uitox(physAddr);
+	msg+="] (";
+	switch(numBytes)
 	{
-		std::string msg;
-		msg="Memory Write BYTE PTR PHYS:[";
-		msg+=cpputil::Uitox(physAddr);
-		msg+="] (";
+	case 1:
 		msg+=cpputil::Ubtox(data);
-		msg+=")";
-		debuggerPtr->ExternalBreak(msg);
+		break;
+	case 2:
+		msg+=cpputil::Ustox(data);
+		break;
+	default:
+		msg+=cpputil::Uitox(data);
+		break;
+	}
+	msg+=")";
+	msg+=suffix;
+	debuggerPtr->ExternalBreak(msg);
+}
+
+/* virtual */ void i486DebugMemoryAccess::StoreByte(unsigned int physAddr,unsigned char data)
+{
+	if(true==writeWatched &&
+	   (true==CheckBreakOnWriteCondition(physAddr,data) ||
+	    true==CheckBreakOnChangeCondition(physAddr,data)))
+	{
+		BreakOnStore("BYTE",physAddr,data,1,"");
 	}
 	memAccessChain->StoreByte(physAddr,data);
 }
 /* virtual */ void i486DebugMemoryAccess::StoreWord(unsigned int physAddr,unsigned int data)
 {
-	if(true==CheckBreakOnWriteCondition(physAddr  ,data&0xFF) ||
-	   true==CheckBreakOnWriteCondition(physAddr+1,(data>>8)&0xFF))
+	if(true==writeWatched)
 	{
-		std::string msg;
-		msg="Memory Write WORD PTR PHYS:[";
-		msg+=cpputil::Uitox(physAddr);
-		msg+="] (";
-		msg+=cpputil::Ustox(data);
-		msg+=")";
-		debuggerPtr->ExternalBreak(msg);
+		for(unsigned int i=0; i<2; ++i)
+		{
+			auto byteData=(data>>(i*8))&0xFF;
+			if(true==CheckBreakOnWriteCondition(physAddr+i,byteData) ||
+			   true==CheckBreakOnChangeCondition(physAddr+i,byteData))
+			{
+				BreakOnStore("WORD",physAddr,data,2,"");
+				break;
+			}
+		}
 	}
 	memAccessChain->StoreWord(physAddr,data);
 }
 /* virtual */ void i486DebugMemoryAccess::StoreDword(unsigned int physAddr,unsigned int data)
 {
-	if(true==CheckBreakOnWriteCondition(physAddr  ,data&0xFF) ||
-	   true==CheckBreakOnWriteCondition(physAddr+1,(data>>8)&0xFF) ||
-	   true==CheckBreakOnWriteCondition(physAddr+2,(data>>16)&0xFF) ||
-	   true==CheckBreakOnWriteCondition(physAddr+3,(data>>24)&0xFF))
+	if(true==writeWatched)
 	{
-		std::string msg;
-		msg="Memory Write DWORD PTR PHYS:[";
-		msg+=cpputil::Uitox(physAddr);
-		msg+="] (";
-		msg+=cpputil::Uitox(data);
-		msg+=")";
-		debuggerPtr->ExternalBreak(msg);
+		for(unsigned int i=0; i<4; ++i)
+		{
+			auto byteData=(data>>(i*8))&0xFF;
+			if(true==CheckBreakOnWriteCondition(physAddr+i,byteData) ||
+			   true==CheckBreakOnChangeCondition(physAddr+i,byteData))
+			{
+				BreakOnStore("DWORD",physAddr,data,4,"");
+				break;
+			}
+		}
 	}
 	memAccessChain->StoreDword(physAddr,data);
 }
 /* virtual */ void i486DebugMemoryAccess::StoreByteDMA(unsigned int physAddr,unsigned char data)
 {
-	if(true==CheckBreakOnWriteCondition(physAddr,data))
+	if(true==writeWatched &&
+	   (true==CheckBreakOnWriteCondition(physAddr,data) ||
+	    true==CheckBreakOnChangeCondition(physAddr,data)))
 	{
-		std::string msg;
-		msg="Memory Write BYTE PTR PHYS:[";
-		msg+=cpputil::Uitox(physAddr);
-		msg+="] (";
-		msg+=cpputil::Ubtox(data);
-		msg+=") **DMA**";
-		debuggerPtr->ExternalBreak(msg);
+		BreakOnStore("BYTE",physAddr,data,1," **DMA**");
 	}
 	memAccessChain->StoreByte(physAddr,data);
 }
 
-/* static */ void i486DebugMemoryAccess::SetBreakOnMemRead(Memory &mem,i486Debugger &debugger,unsigned int physAddr)
+/* static */ i486DebugMemoryAccess *i486DebugMemoryAccess::InsertDebugMemoryAccess(Memory &mem,i486Debugger &debugger,unsigned int physAddr)
 {
 	auto *curMemAccess=mem.GetAccessObject(physAddr);
 	i486DebugMemoryAccess *debugMemAccess=dynamic_cast <i486DebugMemoryAccess *>(curMemAccess);
@@ -275,9 +396,31 @@ inline bool i486DebugMemoryAccess::CheckBreakOnWriteCondition(uint32_t physAddr,
 	{
 		debugMemAccess=new i486DebugMemoryAccess(debugger,physAddr);
 		debugMemAccess->memAccessChain=curMemAccess;
+		mem.SetAccessObject(debugMemAccess,physAddr);
+	}
+	return debugMemAccess;
+}
+/* static */ void i486DebugMemoryAccess::RemoveDebugMemoryAccessIfUnused(Memory &mem,unsigned int physAddr)
+{
+	auto *curMemAccess=mem.GetAccessObject(physAddr);
+	i486DebugMemoryAccess *debugMemAccess=dynamic_cast <i486DebugMemoryAccess *>(curMemAccess);
+	if(nullptr!=debugMemAccess && true==debugMemAccess->Unused())
+	{
+		mem.SetAccessObject(debugMemAccess->memAccessChain,physAddr);
+		delete debugMemAccess;
+	}
+}
+
+/* static */ void i486DebugMemoryAccess::SetBreakOnMemRead(Memory &mem,i486Debugger &debugger,unsigned int physAddr)
+{
+	InsertDebugMemoryAccess(mem,debugger,physAddr)->SetBreakOnRead(physAddr);
+}
+/* static */ void i486DebugMemoryAccess::SetBreakOnMemReadRange(Memory &mem,i486Debugger &debugger,unsigned int physAddr0,unsigned int physAddr1)
+{
+	for(unsigned long long slotTop=(physAddr0&~(Memory::MEMORY_ACCESS_SLOT_SIZE-1)); slotTop<=physAddr1; slotTop+=Memory::MEMORY_ACCESS_SLOT_SIZE)
+	{
+		InsertDebugMemoryAccess(mem,debugger,(unsigned int)slotTop)->SetBreakOnRead(physAddr0,physAddr1);
 	}
-	debugMemAccess->SetBreakOnRead(physAddr);
-	mem.SetAccessObject(debugMemAccess,physAddr);
 }
 /* static */ void i486DebugMemoryAccess::ClearBreakOnMemRead(Memory &mem,unsigned int physAddr)
 {
@@ -286,6 +429,7 @@ inline bool i486DebugMemoryAccess::CheckBreakOnWriteCondition(uint32_t physAddr,
 	if(nullptr!=debugMemAccess)
 	{
 		debugMemAccess->ClearBreakOnRead(physAddr);
+		RemoveDebugMemoryAccessIfUnused(mem,physAddr);
 	}
 }
 /* static */ void i486DebugMemoryAccess::ClearBreakOnMemRead(Memory &mem)
@@ -297,55 +441,67 @@ inline bool i486DebugMemoryAccess::CheckBreakOnWriteCondition(uint32_t physAddr,
 		if(nullptr!=debugMemAccessPtr)
 		{
 			debugMemAccessPtr->ClearBreakOnRead();
+			RemoveDebugMemoryAccessIfUnused(mem,(unsigned int)physAddr);
 		}
 	}
 }
 /* static */ void i486DebugMemoryAccess::SetBreakOnMemWrite(Memory &mem,i486Debugger &debugger,unsigned int physAddr)
+{
+	InsertDebugMemoryAccess(mem,debugger,physAddr)->SetBreakOnWrite(physAddr);
+}
+/* static */ void i486DebugMemoryAccess::SetBreakOnMemWrite(Memory &mem,i486Debugger &debugger,unsigned int physAddr,unsigned char data)
+{
+	InsertDebugMemoryAccess(mem,debugger,physAddr)->SetBreakOnWrite(physAddr,data);
+}
+/* static */ void i486DebugMemoryAccess::SetBreakOnMemWrite(Memory &mem,i486Debugger &debugger,unsigned int physAddr,unsigned char minValue,unsigned char maxValue)
+{
+	InsertDebugMemoryAccess(mem,debugger,physAddr)->SetBreakOnWrite(physAddr,minValue,maxValue);
+}
+/* static */ void i486DebugMemoryAccess::ClearBreakOnMemWrite(Memory &mem,unsigned int physAddr)
 {
 	auto *curMemAccess=mem.GetAccessObject(physAddr);
 	i486DebugMemoryAccess *debugMemAccess=dynamic_cast <i486DebugMemoryAccess *>(curMemAccess);
-	if(nullptr==debugMemAccess)
+	if(nullptr!=debugMemAccess)
 	{
-		debugMemAccess=new i486DebugMemoryAccess(debugger,physAddr);
-		debugMemAccess->memAccessChain=curMemAccess;
+		debugMemAccess->ClearBreakOnWrite(physAddr);
+		RemoveDebugMemoryAccessIfUnused(mem,physAddr);
 	}
-	debugMemAccess->SetBreakOnWrite(physAddr);
-	mem.SetAccessObject(debugMemAccess,physAddr);
 }
-/* static */ void i486DebugMemoryAccess::SetBreakOnMemWrite(Memory &mem,i486Debugger &debugger,unsigned int physAddr,unsigned char data)
+/* static */ void i486DebugMemoryAccess::ClearBreakOnMemWrite(Memory &mem)
 {
-	auto *curMemAccess=mem.GetAccessObject(physAddr);
-	i486DebugMemoryAccess *debugMemAccess=dynamic_cast <i486DebugMemoryAccess *>(curMemAccess);
-	if(nullptr==debugMemAccess)
+	for(unsigned long long physAddr=0; physAddr<0x100000000LL; physAddr+=Memory::MEMORY_ACCESS_SLOT_SIZE)
 	{
-		debugMemAccess=new i486DebugMemoryAccess(debugger,physAddr);
-		debugMemAccess->memAccessChain=curMemAccess;
+		auto memAccessPtr=mem.GetAccessObject((unsigned int)physAddr);
+		auto debugMemAccessPtr=dynamic_cast <i486DebugMemoryAccess *>(memAccessPtr);
+		if(nullptr!=debugMemAccessPtr)
+		{
+			debugMemAccessPtr->ClearBreakOnWrite();
+			RemoveDebugMemoryAccessIfUnused(mem,(unsigned int)physAddr);
+		}
 	}
-	debugMemAccess->SetBreakOnWrite(physAddr,data);
-	mem.SetAccessObject(debugMemAccess,physAddr);
 }
-/* static */ void i486DebugMemoryAccess::SetBreakOnMemWrite(Memory &mem,i486Debugger &debugger,unsigned int physAddr,unsigned char minValue,unsigned char maxValue)
+/* static */ void i486DebugMemoryAccess::SetBreakOnMemChange(Memory &mem,i486Debugger &debugger,unsigned int physAddr)
 {
-	auto *curMemAccess=mem.GetAccessObject(physAddr);
-	i486DebugMemoryAccess *debugMemAccess=dynamic_cast <i486DebugMemoryAccess *>(curMemAccess);
-	if(nullptr==debugMemAccess)
+	InsertDebugMemoryAccess(mem,debugger,physAddr)->SetBreakOnChange(physAddr);
+}
+/* static */ void i486DebugMemoryAccess::SetBreakOnMemChangeRange(Memory &mem,i486Debugger &debugger,unsigned int physAddr0,unsigned int physAddr1)
+{
+	for(unsigned long long slotTop=(physAddr0&~(Memory::MEMORY_ACCESS_SLOT_SIZE-1)); slotTop<=physAddr1; slotTop+=Memory::MEMORY_ACCESS_SLOT_SIZE)
 	{
-		debugMemAccess=new i486DebugMemoryAccess(debugger,physAddr);
-		debugMemAccess->memAccessChain=curMemAccess;
+		InsertDebugMemoryAccess(mem,debugger,(unsigned int)slotTop)->SetBreakOnChange(physAddr0,physAddr1);
 	}
-	debugMemAccess->SetBreakOnWrite(physAddr,minValue,maxValue);
-	mem.SetAccessObject(debugMemAccess,physAddr);
 }
-/* static */ void i486DebugMemoryAccess::ClearBreakOnMemWrite(Memory &mem,unsigned int physAddr)
+/* static */ void i486DebugMemoryAccess::ClearBreakOnMemChange(Memory &mem,unsigned int physAddr)
 {
 	auto *curMemAccess=mem.GetAccessObject(physAddr);
 	i486DebugMemoryAccess *debugMemAccess=dynamic_cast <i486DebugMemoryAccess *>(curMemAccess);
 	if(nullptr!=debugMemAccess)
 	{
-		debugMemAccess->ClearBreakOnWrite(physAddr);
+		debugMemAccess->ClearBreakOnChange(physAddr);
+		RemoveDebugMemoryAccessIfUnused(mem,physAddr);
 	}
 }
-/* static */ void i486DebugMemoryAccess::ClearBreakOnMemWrite(Memory &mem)
+/* static */ void i486DebugMemoryAccess::ClearBreakOnMemChange(Memory &mem)
 {
 	for(unsigned long long physAddr=0; physAddr<0x100000000LL; physAddr+=Memory::MEMORY_ACCESS_SLOT_SIZE)
 	{
@@ -353,7 +509,32 @@ inline bool i486DebugMemoryAccess::CheckBreakOnWriteCondition(uint32_t physAddr,
 		auto debugMemAccessPtr=dynamic_cast <i486DebugMemoryAccess *>(memAccessPtr);
 		if(nullptr!=debugMemAccessPtr)
 		{
-			debugMemAccessPtr->ClearBreakOnWrite();
+			debugMemAccessPtr->ClearBreakOnChange();
+			RemoveDebugMemoryAccessIfUnused(mem,(unsigned int)physAddr);
+		}
+	}
+}
+/* static */ void i486DebugMemoryAccess::SetBreakOnMemSlotAccess(Memory &mem,i486Debugger &debugger,unsigned int physAddrLow,unsigned int physAddrHigh,bool breakOnRead,bool breakOnWrite)
+{
+	for(unsigned long long physAddr=physAddrLow; physAddr<=physAddrHigh; physAddr+=Memory::MEMORY_ACCESS_SLOT_SIZE)
+	{
+		if(true==breakOnRead || true==breakOnWrite)
+		{
+			auto debugMemAccess=InsertDebugMemoryAccess(mem,debugger,(unsigned int)physAddr);
+			debugMemAccess->breakOnReadAll=breakOnRead;
+			debugMemAccess->breakOnWriteAll=breakOnWrite;
+			debugMemAccess->UpdateWatchFlags();
+		}
+		else
+		{
+			auto debugMemAccess=dynamic_cast <i486DebugMemoryAccess *>(mem.GetAccessObject((unsigned int)physAddr));
+			if(nullptr!=debugMemAccess)
+			{
+				debugMemAccess->breakOnReadAll=false;
+				debugMemAccess->breakOnWriteAll=false;
+				debugMemAccess->UpdateWatchFlags();
+				RemoveDebugMemoryAccessIfUnused(mem,(unsigned int)physAddr);
+			}
 		}
 	}
 }
@@ -23,6 +23,12 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "i486.h"
 #include "i486debug.h"
 
+/*! Debug memory-access object inserted in a 4KB Memory slot that has a watched address.
+    It checks if the accessed address is watched, and then forwards the access to the original
+    memory-access object (memAccessChain).
+    Only slots that have a watched address have this object.  Once the last watch in the slot is
+    cleared, the object is removed so that the slot runs at full speed again.
+*/
 class i486DebugMemoryAccess : public MemoryAccess
 {
 public:
@@ -32,20 +38,39 @@ public:
 
 	bool breakOnRead[Memory::MEMORY_ACCESS_SLOT_SIZE];
 	bool breakOnWrite[Memory::MEMORY_ACCESS_SLOT_SIZE];
+	bool breakOnChange[Memory::MEMORY_ACCESS_SLOT_SIZE];
 	unsigned char breakOnWriteMin[Memory::MEMORY_ACCESS_SLOT_SIZE];
 	unsigned char breakOnWriteMax[Memory::MEMORY_ACCESS_SLOT_SIZE];
 	std::map <uint32_t,unsigned char> breakOnWriteData;
 
+	/*! If true, any read or write in the slot breaks.  Used for break on VRAM read/write.
+	*/
+	bool breakOnReadAll=false,breakOnWriteAll=false;
+
+	/*! Quick check.  Updated by UpdateWatchFlags after the watch is changed.
+	    If no address is watched for read, reads can also go through the memory window of memAccessChain.
+	*/
+	bool readWatched=false,writeWatched=false;
+
 	i486DebugMemoryAccess(i486Debugger &debugger,unsigned int physAddrTop);
 	void SetBreakOnRead(unsigned int physAddr);
 	void SetBreakOnWrite(unsigned int physAddr);
 	void SetBreakOnWrite(unsigned int physAddr,unsigned char minValue,unsigned char maxValue);
 	void SetBreakOnWrite(uint32_t physAddr,unsigned char data);
+	void SetBreakOnChange(unsigned int physAddr);
+	/*! Watches physAddr0 to physAddr1 (inclusive) within this slot.  Addresses outside the slot are ignored.
+	*/
+	void SetBreakOnRead(unsigned int physAddr0,unsigned int physAddr1);
+	void SetBreakOnChange(unsigned int physAddr0,unsigned int physAddr1);
 	void ClearBreakOnRead(void);
 	void ClearBreakOnWrite(void);
+	void ClearBreakOnChange(void);
 	void ClearBreakOnReadWrite(void);
 	void ClearBreakOnRead(unsigned int physAddr);
 	void ClearBreakOnWrite(unsigned int physAddr);
+	void ClearBreakOnChange(unsigned int physAddr);
+	void UpdateWatchFlags(void);
+	bool Unused(void) const;
 
 	virtual unsigned int FetchByte(unsigned int physAddr) const;
 	virtual unsigned int FetchWord(unsigned int physAddr) const;
@@ -57,9 +82,27 @@ public:
 	virtual unsigned int FetchByteDMA(unsigned int physAddr) const override;
 	virtual void StoreByteDMA(unsigned int physAddr,unsigned char data) override;
 
+	virtual ConstMemoryWindow GetConstMemoryWindow(unsigned int physAddr) const override;
+
+	inline bool IsReadWatched(uint32_t physAddr) const
+	{
+		return true==breakOnReadAll || true==breakOnRead[physAddr-physAddrTop];
+	}
 	inline bool CheckBreakOnWriteCondition(uint32_t physAddr,unsigned int data) const;
+	inline bool CheckBreakOnChangeCondition(uint32_t physAddr,unsigned int data) const;
+	void BreakOnStore(const char ptrType[],uint32_t physAddr,unsigned int data,unsigned int numBytes,const char suffix[]);
+
+	/*! Returns the debug memory-access object of the slot.  Inserts one if the slot does not have it yet.
+	*/
+	static i486DebugMemoryAccess *InsertDebugMemoryAccess(Memory &mem,i486Debugger &debugger,unsigned int physAddr);
+	/*! Removes the debug memory-access object from the slot if nothing is watched in the slot.
+	*/
+	static void RemoveDebugMemoryAccessIfUnused(Memory &mem,unsigned int physAddr);
 
 	static void SetBreakOnMemRead(Memory &mem,i486Debugger &debugger,unsigned int physAddr);
+	/*! Break on read from physAddr0 to physAddr1 (inclusive).  Each slot is updated once.
+	*/
+	static void SetBreakOnMemReadRange(Memory &mem,i486Debugger &debugger,unsigned int physAddr0,unsigned int physAddr1);
 	static void ClearBreakOnMemRead(Memory &mem,unsigned int physAddr);
 	static void ClearBreakOnMemRead(Memory &mem);
 	static void SetBreakOnMemWrite(Memory &mem,i486Debugger &debugger,unsigned int physAddr);
@@ -67,6 +110,21 @@ public:
 	static void SetBreakOnMemWrite(Memory &mem,i486Debugger &debugger,unsigned int physAddr,unsigned char minValue,unsigned char maxValue);
 	static void ClearBreakOnMemWrite(Memory &mem,unsigned int physAddr);
 	static void ClearBreakOnMemWrite(Memory &mem);
+
+	/*! Break when a byte in the address is written with a value different from the current value.
+	*/
+	static void SetBreakOnMemChange(Memory &mem,i486Debugger &debugger,unsigned int physAddr);
+	/*! Break on change from physAddr0 to physAddr1 (inclusive).  Each slot is updated once.
+	*/
+	static void SetBreakOnMemChangeRange(Memory &mem,i486Debugger &debugger,unsigned int physAddr0,unsigned int physAddr1);
+	static void ClearBreakOnMemChange(Memory &mem,unsigned int physAddr);
+	static void ClearBreakOnMemChange(Memory &mem);
+
+	/*! Break on any read and/or write from physAddrLow to physAddrHigh.
+	    Both need to be on the 4KB boundary like Memory::AddAccess.
+	    If both breakOnRead and breakOnWrite are false, it clears break on all read/write in the range.
+	*/
+	static void SetBreakOnMemSlotAccess(Memory &mem,i486Debugger &debugger,unsigned int physAddrLow,unsigned int physAddrHigh,bool breakOnRead,bool breakOnWrite);
 };
 
 /* } */
@@ -56,6 +56,10 @@ public:
 
 	constexpr bool SegmentReadException(class i486DXCommon &cpu,const i486DXCommon::SegmentRegister &seg,uint32_t offset,uint32_t bytes) const{return false;}
 
+	// Returns true if SegmentReadException/SegmentWriteException raises no exception for any byte from offset to offset+bytes-1.
+	// It does not raise an exception.  For REP MOVS/STOS host block operation.
+	constexpr bool SegmentCoversBlock(const class i486DXCommon &cpu,const i486DXCommon::SegmentRegister &seg,uint32_t offset,uint32_t bytes,bool write) const{return true;}
+
 	constexpr bool LockNotAllowed(class i486DXCommon &cpu,Memory &mem,const i486DXCommon::Instruction &inst,const i486DXCommon::Operand &op1) const{return false;}
 
 	// This is not performance critical, but unless it returns true, state-file saved in the older version Tsugaru
@@ -124,6 +128,10 @@ public:
 		}
 		return false;
 	}
+	static inline bool SegmentCoversBlock(const class i486DXCommon &cpu,const i486DXCommon::SegmentRegister &seg,uint32_t offset,uint32_t bytes,bool write)
+	{
+		return true==write || offset+bytes-1<=seg.limit;
+	}
 
 	// Default fidelity level does not consider Protected Mode && IOPL<CPL since no known Towns native app uses 0<CPL protected mode.
 	static inline bool TakeIOReadException(i486DXFidelityLayer<THISCLASS> &cpu,unsigned int ioport,unsigned int accessSize,Memory &mem,unsigned int numInstBytes)
@@ -493,6 +501,34 @@ public:
 		return false;
 	}
 
+	static inline bool SegmentCoversBlock(const class i486DXCommon &cpu,const i486DXCommon::SegmentRegister &seg,uint32_t offset,uint32_t bytes,bool write)
+	{
+		// Conservative.  Types that may raise an exception in SegmentReadException/SegmentWriteException are left to the one-by-one path.
+		uint32_t type=seg.GetType();
+		if(i486DXCommon::SEGTYPE_DATA_EXPAND_DOWN_RW==type ||
+		   i486DXCommon::SEGTYPE_DATA_EXPAND_DOWN_READONLY==type)
+		{
+			return false;
+		}
+		if(true!=cpu.IsInRealMode() && true!=cpu.GetVM())
+		{
+			if(0==(seg.value&0xFFFC))
+			{
+				return false;
+			}
+			if(true==write && i486DXCommon::SEGTYPE_DATA_NORMAL_RW!=type)
+			{
+				return false;
+			}
+			if(true!=write &&
+			   (i486DXCommon::SEGTYPE_CODE_NONCONFORMING_EXECONLY==type || i486DXCommon::SEGTYPE_CODE_CONFORMING_EXECONLY==type))
+			{
+				return false;
+			}
+		}
+		return offset+bytes-1<=seg.limit;
+	}
+
 	static inline bool LockNotAllowed(i486DXFidelityLayer<THISCLASS> &cpu,Memory &mem,const i486DXCommon::Instruction &inst,const i486DXCommon::Operand &op1)
 	{
 		if(i486DXCommon::INST_PREFIX_LOCK==inst.instPrefix)
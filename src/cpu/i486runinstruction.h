@@ -2143,6 +2143,7 @@ unsigned int i486DXFidelityLayer<FIDELITY>::RunOneInstruction(Memory &mem,InOut
 	const auto &inst=instOp.inst;
 	const auto &op1=instOp.op1;
 	const auto &op2=instOp.op2;
+	CheckMemoryWindowGeneration(mem);
 	FetchInstruction(state.CSEIPWindow,instOp,state.CS(),state.EIP,mem);
 	if(true==fidelity.HandleExceptionIfAny(*this,mem,inst.numBytes))
 	{
@@ -5371,7 +5372,18 @@ unsigned int i486DXFidelityLayer<FIDELITY>::RunOneInstruction(Memory &mem,InOut
 		// 	EIPIncrement=0;
 		// 	break;
 		// }
-		Interrupt(inst.EvalUimm8(),mem,2,2,true);
+		{
+			auto INTNum=inst.EvalUimm8();
+			if(0x21==INTNum &&
+			   nullptr!=int21HInterceptorPtr &&
+			   true!=GetVM() &&
+			   true==int21HInterceptorPtr->HostINT21H())
+			{
+				// Serviced by the host.  EIPIncrement stays inst.numBytes.
+				break;
+			}
+			Interrupt(INTNum,mem,2,2,true);
+		}
 		EIPIncrement=0;
 		break;
 	case I486_RENUMBER_INTO://       0xCE,
@@ -6593,6 +6605,10 @@ unsigned int i486DXFidelityLayer<FIDELITY>::RunOneInstruction(Memory &mem,InOut
 						if(INST_PREFIX_REP==prefix)\
 						{\
 							EIPIncrement=0;\
+							if(BLOCKOP_OFF!=blockOpMode)\
+							{\
+								ctr+=REPMOVSBlock(mem,addrSize,seg,1,MAX_REP_BUNDLE_COUNT-1-ctr,clocksPassed);\
+							}\
 						}\
 						else\
 						{\
@@ -6636,6 +6652,10 @@ unsigned int i486DXFidelityLayer<FIDELITY>::RunOneInstruction(Memory &mem,InOut
 						if(INST_PREFIX_REP==prefix) \
 						{ \
 							EIPIncrement=0; \
+							if(BLOCKOP_OFF!=blockOpMode) \
+							{ \
+								ctr+=REPMOVSBlock(mem,(addrSize),seg,inst.operandSize/8,MAX_REP_BUNDLE_COUNT-1-ctr,clocksPassed); \
+							} \
 						} \
 						else \
 						{ \
@@ -8203,6 +8223,10 @@ unsigned int i486DXFidelityLayer<FIDELITY>::RunOneInstruction(Memory &mem,InOut
 						if(INST_PREFIX_REP==prefix)\
 						{\
 							EIPIncrement=0;\
+							if(BLOCKOP_OFF!=blockOpMode)\
+							{\
+								ctr+=REPSTOSBlock(mem,addrSize,1,MAX_REP_BUNDLE_COUNT-1-ctr,clocksPassed);\
+							}\
 						}\
 						else\
 						{\
@@ -8247,6 +8271,10 @@ unsigned int i486DXFidelityLayer<FIDELITY>::RunOneInstruction(Memory &mem,InOut
 						if(INST_PREFIX_REP==prefix) \
 						{ \
 							EIPIncrement=0; \
+							if(BLOCKOP_OFF!=blockOpMode) \
+							{ \
+								ctr+=REPSTOSBlock(mem,(addrSize),inst.operandSize/8,MAX_REP_BUNDLE_COUNT-1-ctr,clocksPassed); \
+							} \
 						} \
 						else \
 						{ \
@@ -14,6 +14,8 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 << LICENSE */
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <algorithm>
 
 #include "i486symtable.h"
 #include "cpputil.h"
@@ -77,18 +79,43 @@ std::string i486Symbol::Format(bool returnType,bool label,bool param) const
 ////////////////////////////////////////////////////////////
 
 
+const char *const i486SymbolTable::CACHE_SIGNATURE="TSUGARU_SYMCACHE";
+const char *const i486SymbolTable::CACHE_EXTENSION=".cache";
+
 bool i486SymbolTable::Load(const char fName[])
 {
-	std::ifstream ifp(fName);
-	if(ifp.is_open() && Load(ifp))
+	if(true!=cpputil::FileExists(fName))
 	{
-		this->fName=fName;
-		return true;
+		return false;
 	}
-	return false;
+
+	auto text=cpputil::ReadBinaryFile(fName);
+
+	i486SymbolTable loaded;
+	auto cache=cpputil::ReadBinaryFile(GetCacheFileName(fName));
+	if(true!=loaded.DecodeCache(cache,text))
+	{
+		std::istringstream ifp(std::string(text.begin(),text.end()));
+		if(true!=loaded.Load(ifp))
+		{
+			return false;
+		}
+		cache=loaded.EncodeCache(text);
+		cpputil::WriteBinaryFile(GetCacheFileName(fName),cache.size(),cache.data()); // Failing to write the cache is not an error.
+	}
+
+	for(auto &ptrAndSym : loaded.symTable)
+	{
+		symTable[ptrAndSym.first]=ptrAndSym.second;
+	}
+	InvalidateIndex();
+	this->fName=fName;
+	return true;
 }
 bool i486SymbolTable::Load(std::istream &ifp)
 {
+	InvalidateIndex();
+
 	const int STATE_OUTSIDE=0,STATE_INSIDE=1;
 	int state=STATE_OUTSIDE;
 	i486DXCommon::FarPointer curPtr;
@@ -113,6 +140,10 @@ bool i486SymbolTable::Load(std::istream &ifp)
 	{
 		std::string str;
 		std::getline(ifp,str);
+		if(0<str.size() && '\r'==str.back())
+		{
+			str.pop_back();
+		}
 
 		if(STATE_OUTSIDE==state)
 		{
@@ -200,6 +231,8 @@ bool i486SymbolTable::Save(const char fName[]) const
 	std::ofstream ofp(fName);
 	if(ofp.is_open() && Save(ofp))
 	{
+		ofp.close();
+		SaveCache(fName);
 		this->fName=fName;
 		return true;
 	}
@@ -241,6 +274,252 @@ bool i486SymbolTable::AutoSave(void) const
 	return Save(fName.c_str());
 }
 
+std::string i486SymbolTable::GetCacheFileName(const char fName[])
+{
+	std::string cacheFName=fName;
+	cacheFName+=CACHE_EXTENSION;
+	return cacheFName;
+}
+bool i486SymbolTable::LoadCache(const char fName[])
+{
+	auto text=cpputil::ReadBinaryFile(fName);
+	auto cache=cpputil::ReadBinaryFile(GetCacheFileName(fName));
+	i486SymbolTable loaded;
+	if(true==loaded.DecodeCache(cache,text))
+	{
+		for(auto &ptrAndSym : loaded.symTable)
+		{
+			symTable[ptrAndSym.first]=ptrAndSym.second;
+		}
+		InvalidateIndex();
+		return true;
+	}
+	return false;
+}
+bool i486SymbolTable::SaveCache(const char fName[]) const
+{
+	if(true!=cpputil::FileExists(fName))
+	{
+		return false;
+	}
+	auto text=cpputil::ReadBinaryFile(fName);
+	auto cache=EncodeCache(text);
+	return cpputil::WriteBinaryFile(GetCacheFileName(fName),cache.size(),cache.data());
+}
+
+/* static */ unsigned long long i486SymbolTable::HashText(const std::vector <unsigned char> &text)
+{
+	// FNV-1a
+	unsigned long long hash=0xCBF29CE484222325ULL;
+	for(auto c : text)
+	{
+		hash^=c;
+		hash*=0x100000001B3ULL;
+	}
+	return hash;
+}
+
+// Cache format (all numbers are little endian):
+//   Signature (16 bytes)
+//   Version, Text size low, Text size high, Text hash low, Text hash high, Number of symbols (dword each)
+//   For each symbol:
+//     SEG, OFFSET, symType, rawDataBytes, flags (dword each)
+//     return_type, label, inLineComment, param, imported (dword length followed by the string)
+//     Number of info (dword), followed by info strings
+enum
+{
+	SYMCACHE_FLAG_IMM_IS_IOADDR=1,
+	SYMCACHE_FLAG_IMM_IS_SYMBOL=2,
+	SYMCACHE_FLAG_IMM_IS_ASCII=4,
+	SYMCACHE_FLAG_OFFSET_IS_SYMBOL=8,
+
+	SYMCACHE_SIGNATURE_LENGTH=16,
+	SYMCACHE_HEADER_LENGTH=SYMCACHE_SIGNATURE_LENGTH+24,
+};
+
+static void SymCachePutDword(std::vector <unsigned char> &cache,uint32_t data)
+{
+	unsigned char buf[4];
+	cpputil::PutDword(buf,data);
+	cache.insert(cache.end(),buf,buf+4);
+}
+static void SymCachePutString(std::vector <unsigned char> &cache,const std::string &str)
+{
+	SymCachePutDword(cache,(uint32_t)str.size());
+	cache.insert(cache.end(),str.begin(),str.end());
+}
+static bool SymCacheGetDword(const std::vector <unsigned char> &cache,size_t &ptr,uint32_t &data)
+{
+	if(cache.size()<ptr+4)
+	{
+		return false;
+	}
+	data=cpputil::GetDword(cache.data()+ptr);
+	ptr+=4;
+	return true;
+}
+static bool SymCacheGetString(const std::vector <unsigned char> &cache,size_t &ptr,std::string &str)
+{
+	uint32_t len;
+	if(true!=SymCacheGetDword(cache,ptr,len) || cache.size()-ptr<len)
+	{
+		return false;
+	}
+	str.assign((const char *)cache.data()+ptr,len);
+	ptr+=len;
+	return true;
+}
+
+std::vector <unsigned char> i486SymbolTable::EncodeCache(const std::vector <unsigned char> &text) const
+{
+	std::vector <unsigned char> cache;
+	auto hash=HashText(text);
+	unsigned long long size=text.size();
+
+	unsigned int numSym=0;
+	for(auto &ptrAndSym : symTable)
+	{
+		if(true!=ptrAndSym.second.temporary)
+		{
+			++numSym;
+		}
+	}
+
+	cache.insert(cache.end(),CACHE_SIGNATURE,CACHE_SIGNATURE+SYMCACHE_SIGNATURE_LENGTH);
+	SymCachePutDword(cache,CACHE_VERSION);
+	SymCachePutDword(cache,(uint32_t)size);
+	SymCachePutDword(cache,(uint32_t)(size>>32));
+	SymCachePutDword(cache,(uint32_t)hash);
+	SymCachePutDword(cache,(uint32_t)(hash>>32));
+	SymCachePutDword(cache,numSym);
+
+	for(auto &ptrAndSym : symTable)
+	{
+		auto &ptr=ptrAndSym.first;
+		auto &sym=ptrAndSym.second;
+		if(true==sym.temporary)
+		{
+			continue;
+		}
+
+		uint32_t flags=0;
+		flags|=(true==sym.immIsIOAddr ? SYMCACHE_FLAG_IMM_IS_IOADDR : 0);
+		flags|=(true==sym.immIsSymbol ? SYMCACHE_FLAG_IMM_IS_SYMBOL : 0);
+		flags|=(true==sym.immIsASCII ? SYMCACHE_FLAG_IMM_IS_ASCII : 0);
+		flags|=(true==sym.offsetIsSymbol ? SYMCACHE_FLAG_OFFSET_IS_SYMBOL : 0);
+
+		SymCachePutDword(cache,ptr.SEG);
+		SymCachePutDword(cache,ptr.OFFSET);
+		SymCachePutDword(cache,sym.symType);
+		SymCachePutDword(cache,sym.rawDataBytes);
+		SymCachePutDword(cache,flags);
+		SymCachePutString(cache,sym.return_type);
+		SymCachePutString(cache,sym.label);
+		SymCachePutString(cache,sym.inLineComment);
+		SymCachePutString(cache,sym.param);
+		SymCachePutString(cache,sym.imported);
+		SymCachePutDword(cache,(uint32_t)sym.info.size());
+		for(auto &i : sym.info)
+		{
+			SymCachePutString(cache,i);
+		}
+	}
+	return cache;
+}
+
+bool i486SymbolTable::DecodeCache(const std::vector <unsigned char> &cache,const std::vector <unsigned char> &text)
+{
+	if(cache.size()<SYMCACHE_HEADER_LENGTH ||
+	   true!=std::equal(CACHE_SIGNATURE,CACHE_SIGNATURE+SYMCACHE_SIGNATURE_LENGTH,cache.begin()))
+	{
+		return false;
+	}
+
+	size_t ptr=SYMCACHE_SIGNATURE_LENGTH;
+	uint32_t version,sizeLow,sizeHigh,hashLow,hashHigh,numSym;
+	SymCacheGetDword(cache,ptr,version);
+	SymCacheGetDword(cache,ptr,sizeLow);
+	SymCacheGetDword(cache,ptr,sizeHigh);
+	SymCacheGetDword(cache,ptr,hashLow);
+	SymCacheGetDword(cache,ptr,hashHigh);
+	SymCacheGetDword(cache,ptr,numSym);
+
+	auto hash=HashText(text);
+	unsigned long long size=text.size();
+	if(CACHE_VERSION!=version ||
+	   (uint32_t)size!=sizeLow || (uint32_t)(size>>32)!=sizeHigh ||
+	   (uint32_t)hash!=hashLow || (uint32_t)(hash>>32)!=hashHigh)
+	{
+		return false;
+	}
+
+	std::map <i486DXCommon::FarPointer,i486Symbol> decoded;
+	for(uint32_t i=0; i<numSym; ++i)
+	{
+		i486DXCommon::FarPointer symPtr;
+		i486Symbol sym;
+		uint32_t flags,numInfo;
+		if(true!=SymCacheGetDword(cache,ptr,symPtr.SEG) ||
+		   true!=SymCacheGetDword(cache,ptr,symPtr.OFFSET) ||
+		   true!=SymCacheGetDword(cache,ptr,sym.symType) ||
+		   true!=SymCacheGetDword(cache,ptr,sym.rawDataBytes) ||
+		   true!=SymCacheGetDword(cache,ptr,flags) ||
+		   true!=SymCacheGetString(cache,ptr,sym.return_type) ||
+		   true!=SymCacheGetString(cache,ptr,sym.label) ||
+		   true!=SymCacheGetString(cache,ptr,sym.inLineComment) ||
+		   true!=SymCacheGetString(cache,ptr,sym.param) ||
+		   true!=SymCacheGetString(cache,ptr,sym.imported) ||
+		   true!=SymCacheGetDword(cache,ptr,numInfo))
+		{
+			return false;
+		}
+		sym.immIsIOAddr=(0!=(flags&SYMCACHE_FLAG_IMM_IS_IOADDR));
+		sym.immIsSymbol=(0!=(flags&SYMCACHE_FLAG_IMM_IS_SYMBOL));
+		sym.immIsASCII=(0!=(flags&SYMCACHE_FLAG_IMM_IS_ASCII));
+		sym.offsetIsSymbol=(0!=(flags&SYMCACHE_FLAG_OFFSET_IS_SYMBOL));
+		for(uint32_t j=0; j<numInfo; ++j)
+		{
+			sym.info.push_back("");
+			if(true!=SymCacheGetString(cache,ptr,sym.info.back()))
+			{
+				return false;
+			}
+		}
+		// Symbols are stored in ascending order.  Inserting at the end is constant time.
+		decoded.emplace_hint(decoded.end(),symPtr,std::move(sym));
+	}
+
+	for(auto &ptrAndSym : decoded)
+	{
+		symTable[ptrAndSym.first]=std::move(ptrAndSym.second);
+	}
+	InvalidateIndex();
+	return true;
+}
+
+void i486SymbolTable::MakeIndex(void) const
+{
+	addrIndex.clear();
+	addrIndexSym.clear();
+	offsetIndex.clear();
+	addrIndex.reserve(symTable.size());
+	addrIndexSym.reserve(symTable.size());
+	offsetIndex.reserve(symTable.size());
+	for(auto &ptrAndSym : symTable)
+	{
+		addrIndex.push_back(ptrAndSym.first.Combine());
+		addrIndexSym.push_back(&ptrAndSym.second);
+		offsetIndex.push_back(std::pair <uint32_t,const i486Symbol *>(ptrAndSym.first.OFFSET,&ptrAndSym.second));
+	}
+	std::stable_sort(
+	    offsetIndex.begin(),offsetIndex.end(),
+	    [](const std::pair <uint32_t,const i486Symbol *> &a,const std::pair <uint32_t,const i486Symbol *> &b)
+	    {
+	        return a.first<b.first;
+	    });
+	indexValid=true;
+}
+
 const i486Symbol *i486SymbolTable::Find(unsigned int SEG,unsigned int OFFSET) const
 {
 	i486DXCommon::FarPointer ptr;
@@ -250,20 +529,57 @@ const i486Symbol *i486SymbolTable::Find(unsigned int SEG,unsigned int OFFSET) co
 }
 const i486Symbol *i486SymbolTable::Find(i486DXCommon::FarPointer ptr) const
 {
-	auto iter=symTable.find(ptr);
-	if(symTable.end()!=iter)
+	if(true!=indexValid)
+	{
+		MakeIndex();
+	}
+	auto key=ptr.Combine();
+	auto found=std::lower_bound(addrIndex.begin(),addrIndex.end(),key);
+	if(addrIndex.end()!=found && *found==key)
 	{
-		return &iter->second;
+		return addrIndexSym[found-addrIndex.begin()];
 	}
 	return nullptr;
 }
 const i486Symbol *i486SymbolTable::FindFromOffset(uint32_t OFFSET) const
 {
-	for(auto &addrAndSym : symTable)
+	if(true!=indexValid)
 	{
-		if(addrAndSym.first.OFFSET==OFFSET)
+		MakeIndex();
+	}
+	auto found=std::lower_bound(
+	    offsetIndex.begin(),offsetIndex.end(),OFFSET,
+	    [](const std::pair <uint32_t,const i486Symbol *> &a,uint32_t b)
+	    {
+	        return a.first<b;
+	    });
+	if(offsetIndex.end()!=found && found->first==OFFSET)
+	{
+		return found->second;
+	}
+	return nullptr;
+}
+const i486Symbol *i486SymbolTable::FindNearest(i486DXCommon::FarPointer ptr,i486DXCommon::FarPointer &symPtr) const
+{
+	if(true!=indexValid)
+	{
+		MakeIndex();
+	}
+	auto found=std::upper_bound(addrIndex.begin(),addrIndex.end(),ptr.Combine());
+	while(addrIndex.begin()!=found)
+	{
+		--found;
+		auto SEG=(unsigned int)((*found)>>32);
+		if(SEG!=ptr.SEG)
+		{
+			break;
+		}
+		auto sym=addrIndexSym[found-addrIndex.begin()];
+		if(0<sym->label.size() || 0<sym->imported.size())
 		{
-			return &addrAndSym.second;
+			symPtr.SEG=SEG;
+			symPtr.OFFSET=(unsigned int)(*found);
+			return sym;
 		}
 	}
 	return nullptr;
@@ -282,30 +598,35 @@ std::pair <i486DXCommon::FarPointer,i486Symbol> i486SymbolTable::FindSymbolFromL
 }
 i486Symbol *i486SymbolTable::Update(i486DXCommon::FarPointer ptr,const std::string &label)
 {
+	InvalidateIndex();
 	auto &symbol=symTable[ptr];
 	symbol.label=label;
 	return &symbol;
 }
 i486Symbol *i486SymbolTable::SetComment(i486DXCommon::FarPointer ptr,const std::string &inLineComment)
 {
+	InvalidateIndex();
 	auto &symbol=symTable[ptr];
 	symbol.inLineComment=inLineComment;
 	return &symbol;
 }
 i486Symbol *i486SymbolTable::SetImmIsIOPort(i486DXCommon::FarPointer ptr)
 {
+	InvalidateIndex();
 	auto &symbol=symTable[ptr];
 	symbol.immIsIOAddr=true;
 	return &symbol;
 }
 i486Symbol *i486SymbolTable::SetImmIsASCII(i486DXCommon::FarPointer ptr)
 {
+	InvalidateIndex();
 	auto &symbol=symTable[ptr];
 	symbol.immIsASCII=true;
 	return &symbol;
 }
 i486Symbol *i486SymbolTable::SetImportedLabel(i486DXCommon::FarPointer ptr,const std::string &label)
 {
+	InvalidateIndex();
 	bool makeItProcedure=false; // It can be a data, it can be a procedure, but temporarily make it a procedure, if not in the database yet.
 	auto found=symTable.find(ptr);
 	if(found==symTable.end())
@@ -322,12 +643,14 @@ i486Symbol *i486SymbolTable::SetImportedLabel(i486DXCommon::FarPointer ptr,const
 }
 i486Symbol *i486SymbolTable::SetImmIsSymbol(i486DXCommon::FarPointer ptr)
 {
+	InvalidateIndex();
 	auto &symbol=symTable[ptr];
 	symbol.immIsSymbol=true;
 	return &symbol;
 }
 i486Symbol *i486SymbolTable::SetOffsetIsSymbol(i486DXCommon::FarPointer ptr)
 {
+	InvalidateIndex();
 	auto &symbol=symTable[ptr];
 	symbol.offsetIsSymbol=true;
 	return &symbol;
@@ -338,6 +661,7 @@ bool i486SymbolTable::Delete(i486DXCommon::FarPointer ptr)
 	if(symTable.end()!=iter)
 	{
 		symTable.erase(iter);
+		InvalidateIndex();
 		return true;
 	}
 	return false;
@@ -92,7 +92,34 @@ private:
 	std::map <unsigned int,i486INT> INTLabel;
 	std::map <unsigned int,i486INTFunc> INTFunc[256];
 	std::map <unsigned int,i486DXCommon::FarPointer> windowsAPIEntry;
+
+	/*! Flat address index of symTable, built on the first look-up after symTable is changed.
+	    addrIndex is FarPointer::Combine() of the symbols in ascending order, and addrIndexSym[i] is the symbol for addrIndex[i].
+	    offsetIndex is sorted by OFFSET for FindFromOffset.  Symbols with the same OFFSET stay in the order of symTable.
+	*/
+	mutable bool indexValid=false;
+	mutable std::vector <unsigned long long> addrIndex;
+	mutable std::vector <const i486Symbol *> addrIndexSym;
+	mutable std::vector <std::pair <uint32_t,const i486Symbol *> > offsetIndex;
+
+	inline void InvalidateIndex(void)
+	{
+		indexValid=false;
+	}
+	void MakeIndex(void) const;
+
+	static unsigned long long HashText(const std::vector <unsigned char> &text);
+	bool DecodeCache(const std::vector <unsigned char> &cache,const std::vector <unsigned char> &text);
+	std::vector <unsigned char> EncodeCache(const std::vector <unsigned char> &text) const;
+
 public:
+	enum
+	{
+		CACHE_VERSION=1,
+	};
+	static const char *const CACHE_SIGNATURE;
+	static const char *const CACHE_EXTENSION;
+
 	mutable std::string fName;
 
 	/*! Open the given file name.  
@@ -103,6 +130,16 @@ public:
 	bool Load(const char fName[]);
 	bool Load(std::istream &ifp);
 
+	/*! Binary cache of a text symbol-table file.
+	    The cache file is the text file name plus CACHE_EXTENSION, and is tied to the text file by the size and the hash of the text.
+	    Load(const char fName[]) uses the cache if it matches the text file, or parses the text and re-writes the cache.
+	    Save(const char fName[]) also re-writes the cache.
+	    LoadCache returns false if the cache does not exist or does not match the text file.
+	*/
+	bool LoadCache(const char fName[]);
+	bool SaveCache(const char fName[]) const;
+	static std::string GetCacheFileName(const char fName[]);
+
 	/*! Save to the given file name.
 	    It updates data member fName to the given file name if successful.
 	*/
@@ -122,6 +159,11 @@ public:
 	const i486Symbol *Find(unsigned int SEG,unsigned int OFFSET) const;
 	const i486Symbol *Find(i486DXCommon::FarPointer ptr) const;
 	const i486Symbol *FindFromOffset(uint32_t OFFSET) const;
+
+	/*! Find the symbol at or before the given address in the same segment.
+	    Returns nullptr if there is no such symbol.  symPtr is set to the address of the found symbol.
+	*/
+	const i486Symbol *FindNearest(i486DXCommon::FarPointer ptr,i486DXCommon::FarPointer &symPtr) const;
 	i486Symbol *Update(i486DXCommon::FarPointer ptr,const std::string &label);
 	i486Symbol *SetComment(i486DXCommon::FarPointer ptr,const std::string &inLineComment);
 	i486Symbol *SetImportedLabel(i486DXCommon::FarPointer ptr,const std::string &label);
@@ -475,10 +475,17 @@ void i486DXFidelityLayer <FIDELITY>::StoreOperandValue(
 template <class FIDELITY>
 inline unsigned char *i486DXFidelityLayer<FIDELITY>::GetStackAccessPointer(Memory &mem,uint32_t linearAddr,const unsigned int numBytes)
 {
+	CheckMemoryWindowGeneration(mem); // Push/Pop may come from an interrupt outside of RunOneInstruction.
+	++memWinStats.stackAccess;
 	if((linearAddr&(MemoryAccess::MEMORY_WINDOW_SIZE-1))<=(MemoryAccess::MEMORY_WINDOW_SIZE-numBytes))
 	{
 		if(nullptr==state.SSESPWindow.ptr || true!=state.SSESPWindow.IsLinearAddressInRange(linearAddr))
 		{
+			++memWinStats.stackRefill;
+			if(nullptr==state.SSESPWindow.ptr)
+			{
+				++memWinStats.stackRefillFromEmpty;
+			}
 			auto physAddr=linearAddr;
 			if(true==PagingEnabled())
 			{
@@ -492,10 +499,257 @@ inline unsigned char *i486DXFidelityLayer<FIDELITY>::GetStackAccessPointer(Memor
 		{
 			return state.SSESPWindow.ptr+(linearAddr&(MemoryAccess::MEMORY_WINDOW_SIZE-1));
 		}
+		++memWinStats.stackNoWindow;
+	}
+	else
+	{
+		++memWinStats.stackPageCross;
 	}
 	return nullptr;
 }
 
+template <class FIDELITY>
+inline unsigned int i486DXFidelityLayer<FIDELITY>::BlockOpElementsInPage(unsigned int addressSize,uint32_t offset,uint32_t linearAddr,unsigned int elemSize,unsigned int count)
+{
+	const unsigned int inPage=(linearAddr&(MemoryAccess::MEMORY_WINDOW_SIZE-1));
+	if(inPage<elemSize || offset<elemSize)
+	{
+		// Previous element was in the previous page, or 16-bit SI/DI wrapped around after it.
+		return 0;
+	}
+	count=std::min<unsigned int>(count,(MemoryAccess::MEMORY_WINDOW_SIZE-inPage)/elemSize);
+
+	const uint64_t offsetRange=(16==addressSize ? 0x10000 : 0x100000000);
+	count=(unsigned int)std::min<uint64_t>(count,(offsetRange-offset)/elemSize);
+	return count;
+}
+
+template <class FIDELITY>
+unsigned int i486DXFidelityLayer<FIDELITY>::REPMOVSBlock(Memory &mem,unsigned int addressSize,const SegmentRegister &seg,unsigned int elemSize,unsigned int maxCount,unsigned int &clocksPassed)
+{
+	if(true==GetDF())
+	{
+		return 0;
+	}
+
+	unsigned int count=(16==addressSize ? GetCX() : state.ECX());
+	count=std::min(count,maxCount);
+
+	uint32_t srcOffset=state.ESI();
+	uint32_t dstOffset=state.EDI();
+	AddressMask(srcOffset,(unsigned char)addressSize);
+	AddressMask(dstOffset,(unsigned char)addressSize);
+	const uint32_t srcLinear=seg.baseLinearAddr+srcOffset;
+	const uint32_t dstLinear=state.ES().baseLinearAddr+dstOffset;
+
+	count=BlockOpElementsInPage(addressSize,srcOffset,srcLinear,elemSize,count);
+	count=BlockOpElementsInPage(addressSize,dstOffset,dstLinear,elemSize,count);
+	if(0==count)
+	{
+		return 0;
+	}
+	const unsigned int bytes=count*elemSize;
+
+	FIDELITY fidelity;
+	if(true!=fidelity.SegmentCoversBlock(*this,seg,srcOffset,bytes,false) ||
+	   true!=fidelity.SegmentCoversBlock(*this,state.ES(),dstOffset,bytes,true))
+	{
+		return 0;
+	}
+
+	uint32_t srcPhys=srcLinear,dstPhys=dstLinear;
+	if(true==PagingEnabled())
+	{
+		srcPhys=LinearAddressToPhysicalAddressRead(srcLinear,mem);
+		dstPhys=LinearAddressToPhysicalAddressWrite(dstLinear,mem);
+		if(true==state.exception)
+		{
+			// Let the element-by-element path raise it at the right element.
+			state.exception=false;
+			return 0;
+		}
+	}
+	auto srcWin=mem.GetConstMemoryWindow(srcPhys);
+	auto dstWin=mem.GetMemoryWindow(dstPhys);
+	if(nullptr==srcWin.ptr || nullptr==dstWin.ptr)
+	{
+		return 0;
+	}
+	auto src=srcWin.ptr+(srcPhys&(MemoryAccess::MEMORY_WINDOW_SIZE-1));
+	auto dst=dstWin.ptr+(dstPhys&(MemoryAccess::MEMORY_WINDOW_SIZE-1));
+	if(src<dst+bytes && dst<src+bytes)
+	{
+		// Overlapping REP MOVS repeats a pattern element by element, which memcpy does not.
+		return 0;
+	}
+
+	if(BLOCKOP_VERIFY==blockOpMode)
+	{
+		std::vector <unsigned char> hostResult(src,src+bytes);
+		for(unsigned int i=0; i<count; ++i)
+		{
+			const unsigned int d=i*elemSize;
+			switch(elemSize)
+			{
+			case 1:
+				StoreByte(mem,addressSize,state.ES(),dstOffset+d,FetchByte(addressSize,seg,srcOffset+d,mem));
+				break;
+			case 2:
+				StoreWord(mem,addressSize,state.ES(),dstOffset+d,FetchWord(addressSize,seg,srcOffset+d,mem));
+				break;
+			default:
+				StoreDword(mem,addressSize,state.ES(),dstOffset+d,FetchDword(addressSize,seg,srcOffset+d,mem));
+				break;
+			}
+		}
+		if(0!=memcmp(hostResult.data(),dst,bytes))
+		{
+			// Memory already has the interpreted result.  Report and keep going.
+			++blockOpMismatch;
+			std::cout << "REP MOVS host block operation does not match at " << cpputil::Ustox(state.CS().value) << ":" << cpputil::Uitox(state.EIP) << std::endl;
+		}
+	}
+	else
+	{
+		memcpy(dst,src,bytes);
+	}
+
+	if(16==addressSize)
+	{
+		SetCX(GetCX()-count);
+		SetSI(srcOffset+bytes);
+		SetDI(dstOffset+bytes);
+	}
+	else
+	{
+		state.ECX()-=count;
+		state.ESI()=srcOffset+bytes;
+		state.EDI()=dstOffset+bytes;
+	}
+	clocksPassed+=3*count; // Same as REPCheck for each element.
+
+	++blockOpCount;
+	blockOpElements+=count;
+	return count;
+}
+
+template <class FIDELITY>
+unsigned int i486DXFidelityLayer<FIDELITY>::REPSTOSBlock(Memory &mem,unsigned int addressSize,unsigned int elemSize,unsigned int maxCount,unsigned int &clocksPassed)
+{
+	if(true==GetDF())
+	{
+		return 0;
+	}
+
+	unsigned int count=(16==addressSize ? GetCX() : state.ECX());
+	count=std::min(count,maxCount);
+
+	uint32_t dstOffset=state.EDI();
+	AddressMask(dstOffset,(unsigned char)addressSize);
+	const uint32_t dstLinear=state.ES().baseLinearAddr+dstOffset;
+
+	count=BlockOpElementsInPage(addressSize,dstOffset,dstLinear,elemSize,count);
+	if(0==count)
+	{
+		return 0;
+	}
+	const unsigned int bytes=count*elemSize;
+
+	FIDELITY fidelity;
+	if(true!=fidelity.SegmentCoversBlock(*this,state.ES(),dstOffset,bytes,true))
+	{
+		return 0;
+	}
+
+	uint32_t dstPhys=dstLinear;
+	if(true==PagingEnabled())
+	{
+		dstPhys=LinearAddressToPhysicalAddressWrite(dstLinear,mem);
+		if(true==state.exception)
+		{
+			state.exception=false;
+			return 0;
+		}
+	}
+	auto dstWin=mem.GetMemoryWindow(dstPhys);
+	if(nullptr==dstWin.ptr)
+	{
+		return 0;
+	}
+	auto dst=dstWin.ptr+(dstPhys&(MemoryAccess::MEMORY_WINDOW_SIZE-1));
+
+	const uint32_t EAX=state.EAX();
+	auto fill=[&](unsigned char buf[])
+	{
+		switch(elemSize)
+		{
+		case 1:
+			memset(buf,EAX&0xFF,bytes);
+			break;
+		case 2:
+			for(unsigned int i=0; i<bytes; i+=2)
+			{
+				cpputil::PutWord(buf+i,EAX&0xFFFF);
+			}
+			break;
+		default:
+			for(unsigned int i=0; i<bytes; i+=4)
+			{
+				cpputil::PutDword(buf+i,EAX);
+			}
+			break;
+		}
+	};
+
+	if(BLOCKOP_VERIFY==blockOpMode)
+	{
+		unsigned char hostResult[MemoryAccess::MEMORY_WINDOW_SIZE];
+		fill(hostResult);
+		for(unsigned int i=0; i<count; ++i)
+		{
+			const unsigned int d=i*elemSize;
+			switch(elemSize)
+			{
+			case 1:
+				StoreByte(mem,addressSize,state.ES(),dstOffset+d,EAX&0xFF);
+				break;
+			case 2:
+				StoreWord(mem,addressSize,state.ES(),dstOffset+d,EAX&0xFFFF);
+				break;
+			default:
+				StoreDword(mem,addressSize,state.ES(),dstOffset+d,EAX);
+				break;
+			}
+		}
+		if(0!=memcmp(hostResult,dst,bytes))
+		{
+			// Memory already has the interpreted result.  Report and keep going.
+			++blockOpMismatch;
+			std::cout << "REP STOS host block operation does not match at " << cpputil::Ustox(state.CS().value) << ":" << cpputil::Uitox(state.EIP) << std::endl;
+		}
+	}
+	else
+	{
+		fill(dst);
+	}
+
+	if(16==addressSize)
+	{
+		SetCX(GetCX()-count);
+		SetDI(dstOffset+bytes);
+	}
+	else
+	{
+		state.ECX()-=count;
+		state.EDI()=dstOffset+bytes;
+	}
+	clocksPassed+=4*count; // Same as REPCheck and STOS for each element.
+
+	++blockOpCount;
+	blockOpElements+=count;
+	return count;
+}
+
 template <class FIDELITY>
 void i486DXFidelityLayer <FIDELITY>::Push16(Memory &mem,unsigned int value)
 {
@@ -830,6 +1084,7 @@ inline unsigned long i486DXFidelityLayer<FIDELITY>::LinearAddressToPhysicalAddre
 	PageTableEntry pageInfo;
 	if(state.pageTableCache[pageIndex].valid<state.pageTableCacheValidCounter)
 	{
+		++memWinStats.pageTableCacheMiss;
 		pageInfo=ReadPageInfo(linearAddr,mem);
 		if(0==(pageInfo.table&PAGEINFO_FLAG_PRESENT))
 		{
@@ -851,6 +1106,7 @@ inline unsigned long i486DXFidelityLayer<FIDELITY>::LinearAddressToPhysicalAddre
 	}
 	else
 	{
+		++memWinStats.pageTableCacheHit;
 		pageInfo=state.pageTableCache[pageIndex].info;
 		if(true==fidelity.PageLevelException(*this,false,linearAddr,pageInfo.dir,pageInfo.table))
 		{
@@ -874,6 +1130,7 @@ inline unsigned long i486DXFidelityLayer<FIDELITY>::LinearAddressToPhysicalAddre
 	PageTableEntry pageInfo;
 	if(state.pageTableCache[pageIndex].valid<state.pageTableCacheValidCounter)
 	{
+		++memWinStats.pageTableCacheMiss;
 		pageInfo=ReadPageInfo(linearAddr,mem);
 		if(0==(pageInfo.table&PAGEINFO_FLAG_PRESENT))
 		{
@@ -895,6 +1152,7 @@ inline unsigned long i486DXFidelityLayer<FIDELITY>::LinearAddressToPhysicalAddre
 	}
 	else
 	{
+		++memWinStats.pageTableCacheHit;
 		pageInfo=state.pageTableCache[pageIndex].info;
 		if(true==fidelity.PageLevelException(*this,true,linearAddr,pageInfo.dir,pageInfo.table))
 		{
@@ -1245,8 +1503,28 @@ void i486DXFidelityLayer<FIDELITY>::FetchInstruction(
    InstructionAndOperand &instOp,
    const SegmentRegister &CS,unsigned int offset,Memory &mem,unsigned int defOperSize,unsigned int defAddrSize)
 {
+	auto CSEIPLinear=CS.baseLinearAddr+offset;
+	++memWinStats.CSEIPFetch;
+	if(true!=memWin.IsLinearAddressInRange(CSEIPLinear))
+	{
+		++memWinStats.CSEIPRefill;
+		if(nullptr==memWin.ptr)
+		{
+			++memWinStats.CSEIPRefillFromEmpty;
+		}
+	}
+
 	FetchInstructionClass<i486DXFidelityLayer<FIDELITY>,Memory,RealFetchInstructionFunctions,BurstModeFetchInstructionFunctions>::FetchInstruction(
 	    *this,memWin,instOp,CS,offset,mem,defOperSize,defAddrSize);
+
+	if(nullptr==memWin.ptr)
+	{
+		++memWinStats.CSEIPNoWindow;
+	}
+	else if(MemoryAccess::MEMORY_WINDOW_SIZE-MAX_INSTRUCTION_LENGTH<(CSEIPLinear&(MemoryAccess::MEMORY_WINDOW_SIZE-1)))
+	{
+		++memWinStats.CSEIPPageCross;
+	}
 }
 
 template <class FIDELITY>
@@ -93,6 +93,9 @@ public:
 	const unsigned int deviceIdLength=32;
 	std::vector <unsigned char> Serialize(std::string stateFName) const;
 	bool Deserialize(const std::vector <unsigned char> &dat,std::string stateFName);
+	/*! Returns the version that Serialize writes.
+	*/
+	uint32_t GetSerializeVersion(void) const{return SerializeVersion();}
 protected:
 	/*! Version used for serialization.
 	*/
@@ -23,9 +23,6 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "cpputil.h"
 
 
-static char skipBuf[4096];
-
-
 // Uncomment for verbose output.
 // #define DEBUG_DISCIMG
 
@@ -123,6 +120,14 @@ DiscImage::DiscImage()
 		return "MDF Binary File Size does not make sense.";
 	case ERROR_MDS_UNEXPECTED_NUMBER:
 		return "MDS Unexpected Number.";
+	case ERROR_MDS_BINARY_TOO_SHORT:
+		return "MDF Binary Too Short.";
+	case ERROR_TCD_BROKEN:
+		return "TCD Compressed Image Broken.";
+	case ERROR_TCD_VERSION:
+		return "TCD Compressed Image Version Unsupported.";
+	case ERROR_CANNOT_WRITE:
+		return "Cannot Write File.";
 	}
 	return "Undefined error.";
 }
@@ -136,6 +141,7 @@ void DiscImage::CleanUp(void)
 	tracks.clear();
 	layout.clear();
 	binaryCache.clear();
+	compressedImage.reset();
 }
 unsigned int DiscImage::Open(const std::string &fName)
 {
@@ -172,6 +178,10 @@ unsigned int DiscImage::Open(const std::string &fName)
 	{
 		return OpenMDS(fName);
 	}
+	if(".TCD"==ext)
+	{
+		return OpenTCD(fName);
+	}
 	if(".MDF"==ext)
 	{
 		auto withoutExt=cpputil::RemoveExtension(fName.c_str());
@@ -907,17 +917,20 @@ bool DiscImage::CacheBinary(void)
 {
 	if(0<binaries.size())
 	{
-		std::ifstream ifp;
-		ifp.open(binaries[0].fName,std::ios::binary);
-		if(true==ifp.is_open())
+		BinaryReader ifp;
+		ifp.Open(*this,0);
+		if(true==ifp.IsOpen())
 		{
-			ifp.seekg(0,std::ios::end);
-			auto fSize=ifp.tellg();
+			auto fSize=ifp.GetSize();
 
-			ifp.seekg(0,std::ios::beg);
+			ifp.Seek(0);
 			binaryCache.resize(fSize);
 
-			ifp.read((char *)binaryCache.data(),fSize);
+			if(fSize!=ifp.Read(binaryCache.data(),fSize))
+			{
+				binaryCache.clear();
+				return false;
+			}
 
 			return true;
 		}
@@ -968,29 +981,29 @@ std::vector <unsigned char> DiscImage::ReadSectorMODE1(unsigned int HSG,unsigned
 	{
 		if(0==binaryCache.size())
 		{
-			std::ifstream ifp;
-			ifp.open(binaries[0].fName,std::ios::binary);
-			if(true==ifp.is_open() && 0<tracks.size() && (tracks[0].trackType==TRACK_MODE1_DATA || tracks[0].trackType==TRACK_MODE2_DATA))
+			BinaryReader ifp;
+			ifp.Open(*this,0);
+			if(true==ifp.IsOpen() && 0<tracks.size() && (tracks[0].trackType==TRACK_MODE1_DATA || tracks[0].trackType==TRACK_MODE2_DATA))
 			{
 				if(HSG+numSec<=tracks[0].end.ToHSG()+1)
 				{
 					auto sectorIntoTrack=HSG-tracks[0].start.ToHSG();
 					auto locationInTrack=sectorIntoTrack*tracks[0].sectorLength;
 
-					ifp.seekg(tracks[0].locationInFile+locationInTrack,std::ios::beg);
+					ifp.Seek(tracks[0].locationInFile+locationInTrack);
 					data.resize(numSec*MODE1_BYTES_PER_SECTOR);
 					if(MODE1_BYTES_PER_SECTOR==tracks[0].sectorLength)
 					{
-						ifp.read((char *)data.data(),MODE1_BYTES_PER_SECTOR*numSec);
+						ifp.Read(data.data(),MODE1_BYTES_PER_SECTOR*numSec);
 					}
 					else
 					{
 						unsigned int dataPointer=0;
 						for(int i=0; i<(int)numSec; ++i)
 						{
-							ifp.read(skipBuf,16);
-							ifp.read((char *)data.data()+dataPointer,MODE1_BYTES_PER_SECTOR);
-							ifp.read(skipBuf,tracks[0].sectorLength-MODE1_BYTES_PER_SECTOR-16);
+							ifp.Skip(16);
+							ifp.Read(data.data()+dataPointer,MODE1_BYTES_PER_SECTOR);
+							ifp.Skip(tracks[0].sectorLength-MODE1_BYTES_PER_SECTOR-16);
 							dataPointer+=MODE1_BYTES_PER_SECTOR;
 						}
 					}
@@ -1038,16 +1051,16 @@ std::vector <unsigned char> DiscImage::ReadSectorRAW(unsigned int HSG,unsigned i
 
 	if(0<binaries.size())
 	{
-		std::ifstream ifp;
-		ifp.open(binaries[0].fName,std::ios::binary);
-		if(true==ifp.is_open() && 0<tracks.size() && (tracks[0].trackType==TRACK_MODE1_DATA || tracks[0].trackType==TRACK_MODE2_DATA))
+		BinaryReader ifp;
+		ifp.Open(*this,0);
+		if(true==ifp.IsOpen() && 0<tracks.size() && (tracks[0].trackType==TRACK_MODE1_DATA || tracks[0].trackType==TRACK_MODE2_DATA))
 		{
 			if(HSG+numSec<=tracks[0].end.ToHSG()+1)
 			{
 				auto sectorIntoTrack=HSG-tracks[0].start.ToHSG();
 				auto locationInTrack=sectorIntoTrack*tracks[0].sectorLength;
 
-				ifp.seekg(tracks[0].locationInFile+locationInTrack,std::ios::beg);
+				ifp.Seek(tracks[0].locationInFile+locationInTrack);
 				data.resize(numSec*RAW_BYTES_PER_SECTOR);
 				if(MODE1_BYTES_PER_SECTOR==tracks[0].sectorLength)
 				{
@@ -1058,7 +1071,7 @@ std::vector <unsigned char> DiscImage::ReadSectorRAW(unsigned int HSG,unsigned i
 					unsigned int dataPointer=0;
 					for(int i=0; i<(int)numSec; ++i)
 					{
-						ifp.read((char *)data.data()+4+dataPointer,MODE1_BYTES_PER_SECTOR);
+						ifp.Read(data.data()+4+dataPointer,MODE1_BYTES_PER_SECTOR);
 						dataPointer+=RAW_BYTES_PER_SECTOR;
 					}
 				}
@@ -1067,9 +1080,9 @@ std::vector <unsigned char> DiscImage::ReadSectorRAW(unsigned int HSG,unsigned i
 					unsigned int dataPointer=0;
 					for(int i=0; i<(int)numSec; ++i)
 					{
-						ifp.read(skipBuf,12);
-						ifp.read((char *)data.data()+dataPointer,RAW_BYTES_PER_SECTOR);
-						ifp.read(skipBuf,tracks[0].sectorLength-RAW_BYTES_PER_SECTOR-12);
+						ifp.Skip(12);
+						ifp.Read(data.data()+dataPointer,RAW_BYTES_PER_SECTOR);
+						ifp.Skip(tracks[0].sectorLength-RAW_BYTES_PER_SECTOR-12);
 						dataPointer+=RAW_BYTES_PER_SECTOR;
 					}
 				}
@@ -1092,16 +1105,16 @@ std::vector <unsigned char> DiscImage::ReadSectorMODE2(unsigned int HSG,unsigned
 
 	if(0<binaries.size())
 	{
-		std::ifstream ifp;
-		ifp.open(binaries[0].fName,std::ios::binary);
-		if(true==ifp.is_open() && 0<tracks.size() && (tracks[0].trackType==TRACK_MODE1_DATA || tracks[0].trackType==TRACK_MODE2_DATA))
+		BinaryReader ifp;
+		ifp.Open(*this,0);
+		if(true==ifp.IsOpen() && 0<tracks.size() && (tracks[0].trackType==TRACK_MODE1_DATA || tracks[0].trackType==TRACK_MODE2_DATA))
 		{
 			if(HSG+numSec<=tracks[0].end.ToHSG()+1)
 			{
 				auto sectorIntoTrack=HSG-tracks[0].start.ToHSG();
 				auto locationInTrack=sectorIntoTrack*tracks[0].sectorLength;
 
-				ifp.seekg(tracks[0].locationInFile+locationInTrack,std::ios::beg);
+				ifp.Seek(tracks[0].locationInFile+locationInTrack);
 				data.resize(numSec*RAW_BYTES_PER_SECTOR);
 				if(MODE1_BYTES_PER_SECTOR==tracks[0].sectorLength)
 				{
@@ -1112,7 +1125,7 @@ std::vector <unsigned char> DiscImage::ReadSectorMODE2(unsigned int HSG,unsigned
 					unsigned int dataPointer=0;
 					for(int i=0; i<(int)numSec; ++i)
 					{
-						ifp.read((char *)data.data()+4+dataPointer,MODE2_BYTES_PER_SECTOR);
+						ifp.Read(data.data()+4+dataPointer,MODE2_BYTES_PER_SECTOR);
 						dataPointer+=RAW_BYTES_PER_SECTOR;
 					}
 				}
@@ -1121,9 +1134,9 @@ std::vector <unsigned char> DiscImage::ReadSectorMODE2(unsigned int HSG,unsigned
 					unsigned int dataPointer=0;
 					for(int i=0; i<(int)numSec; ++i)
 					{
-						ifp.read(skipBuf,16);
-						ifp.read((char *)data.data()+dataPointer,MODE2_BYTES_PER_SECTOR);
-						ifp.read(skipBuf,tracks[0].sectorLength-MODE2_BYTES_PER_SECTOR-16);
+						ifp.Skip(16);
+						ifp.Read(data.data()+dataPointer,MODE2_BYTES_PER_SECTOR);
+						ifp.Skip(tracks[0].sectorLength-MODE2_BYTES_PER_SECTOR-16);
 						dataPointer+=RAW_BYTES_PER_SECTOR;
 					}
 				}
@@ -1166,9 +1179,9 @@ int DiscImage::GetTrackFromMSF(MinSecFrm MSF) const
 	return -1;
 }
 
-std::vector <unsigned char> DiscImage::GetWave(MinSecFrm startMSF,MinSecFrm endMSF) const
+std::vector <DiscImage::WaveSpan> DiscImage::GetWaveSpans(MinSecFrm startMSF,MinSecFrm endMSF) const
 {
-	std::vector <unsigned char> wave;
+	std::vector <WaveSpan> spans;
 
 	if(0<tracks.size() && startMSF<endMSF)
 	{
@@ -1181,105 +1194,102 @@ std::vector <unsigned char> DiscImage::GetWave(MinSecFrm startMSF,MinSecFrm endM
 
 		for(int i=0; i+1<layout.size(); ++i)  // Condition i<layout.size()-1 will crash when layout.size()==0 because it is unsigned.
 		{
-			unsigned long long int readFrom=0,readTo=0;
-			const auto layoutType=layout[i].layoutType;
+			WaveSpan span;
+			span.layoutType=layout[i].layoutType;
+			span.sectorLength=layout[i].sectorLength;
+			span.indexToBinary=layout[i].indexToBinary;
 
 			if(startHSG<=layout[i].startHSG)
 			{
 				if(LAYOUT_DATA==layout[i].layoutType) // I have a feeling that this condition does nothing....
 				{
-					wave.clear();
-					return wave;
+					spans.clear();
+					return spans;
 				}
-				readFrom=layout[i].locationInFile;
+				span.readFrom=layout[i].locationInFile;
 			}
 			else if(startHSG<layout[i+1].startHSG)
 			{
-				readFrom=layout[i].locationInFile+layout[i].sectorLength*(startHSG-layout[i].startHSG);
+				span.readFrom=layout[i].locationInFile+layout[i].sectorLength*(startHSG-layout[i].startHSG);
 			}
 			else
 			{
 				continue;
 			}
 
-			auto &bin=binaries[layout[i].indexToBinary]; // Do it before (*1)
-			auto layoutSectorLength=layout[i].sectorLength; // Do it before (*1)
-
 			if(layout[i+1].startHSG<=endHSG)
 			{
-				readTo=layout[i+1].locationInFile;
+				span.readTo=layout[i+1].locationInFile;
 			}
 			else
 			{
-				readTo=layout[i].locationInFile+layout[i].sectorLength*(endHSG-layout[i].startHSG);
-				i=layout.size(); // Let it loop-out. (*1)
+				span.readTo=layout[i].locationInFile+layout[i].sectorLength*(endHSG-layout[i].startHSG);
+				i=layout.size(); // Let it loop-out.
 			}
 
-			if(readFrom<readTo)
+			if(span.readFrom<span.readTo)
 			{
-				if(layoutSectorLength<=AUDIO_SECTOR_SIZE)
+				if(span.sectorLength<=AUDIO_SECTOR_SIZE)
 				{
-					auto readSize=(readTo-readFrom)&(~3);
-
-				#ifdef DEBUG_DISCIMG
-					std::cout << readFrom << " " << readTo << " " << readSize << " " << std::endl;
-				#endif
-
-					auto curSize=wave.size();
-					wave.resize(wave.size()+readSize);
-					for(auto i=curSize; i<wave.size(); ++i)
-					{
-						wave[i]=0;
-					}
-
-					// I thought DATA track is excluded by the above condition, but it looks to be wrong.
-					// To prevent noise from the data track, it needs to be checked here.
-					if(LAYOUT_AUDIO==layoutType)
-					{
-						std::ifstream ifp;
-						ifp.open(bin.fName,std::ios::binary);
-						if(ifp.is_open())
-						{
-							ifp.seekg(readFrom-bin.byteOffsetInDisc+bin.bytesToSkip,std::ios::beg);
-							ifp.read((char *)(wave.data()+curSize),readSize);
-							ifp.close();
-						}
-					}
+					span.waveSize=(span.readTo-span.readFrom)&(~3);
 				}
 				else
 				{
-					auto readSize=readTo-readFrom;
-					readSize/=layoutSectorLength;
-					readSize*=AUDIO_SECTOR_SIZE;
-					readSize&=(~3);
-
-					auto curPos=wave.size();
-					wave.resize(wave.size()+readSize);
-					for(auto i=curPos; i<wave.size(); ++i)
-					{
-						wave[i]=0;
-					}
+					span.waveSize=span.readTo-span.readFrom;
+					span.waveSize/=span.sectorLength;
+					span.waveSize*=AUDIO_SECTOR_SIZE;
+					span.waveSize&=(~3);
+				}
+				spans.push_back(span);
+			}
+		}
+	}
 
-					if(LAYOUT_AUDIO==layoutType)
-					{
-						std::ifstream ifp;
-						ifp.open(bin.fName,std::ios::binary);
-						if(ifp.is_open())
-						{
-							ifp.seekg(readFrom-bin.byteOffsetInDisc+bin.bytesToSkip,std::ios::beg);
-							for(auto filePos=readFrom; filePos<readTo; filePos+=layoutSectorLength)
-							{
-								ifp.read((char *)(wave.data()+curPos),AUDIO_SECTOR_SIZE);
-								if(AUDIO_SECTOR_SIZE<layoutSectorLength)
-								{
-									ifp.read(skipBuf,layoutSectorLength-AUDIO_SECTOR_SIZE);
-								}
-								curPos+=AUDIO_SECTOR_SIZE;
-							}
-							ifp.close();
-						}
-					}
+	return spans;
+}
+
+std::vector <unsigned char> DiscImage::GetWave(MinSecFrm startMSF,MinSecFrm endMSF) const
+{
+	std::vector <unsigned char> wave;
+
+	for(auto &span : GetWaveSpans(startMSF,endMSF))
+	{
+		auto &bin=binaries[span.indexToBinary];
+		auto curPos=wave.size();
+		wave.resize(wave.size()+span.waveSize,0);
+
+	#ifdef DEBUG_DISCIMG
+		std::cout << span.readFrom << " " << span.readTo << " " << span.waveSize << " " << std::endl;
+	#endif
+
+		// I thought DATA track is excluded by the above condition, but it looks to be wrong.
+		// To prevent noise from the data track, it needs to be checked here.
+		if(LAYOUT_AUDIO!=span.layoutType)
+		{
+			continue;
+		}
+
+		BinaryReader ifp;
+		ifp.Open(*this,span.indexToBinary);
+		if(true!=ifp.IsOpen())
+		{
+			continue;
+		}
+		ifp.Seek(span.readFrom-bin.byteOffsetInDisc+bin.bytesToSkip);
+		if(span.sectorLength<=AUDIO_SECTOR_SIZE)
+		{
+			ifp.Read(wave.data()+curPos,span.waveSize);
+		}
+		else
+		{
+			for(auto filePos=span.readFrom; filePos+span.sectorLength<=span.readTo; filePos+=span.sectorLength)
+			{
+				ifp.Read(wave.data()+curPos,AUDIO_SECTOR_SIZE);
+				if(AUDIO_SECTOR_SIZE<span.sectorLength)
+				{
+					ifp.Skip(span.sectorLength-AUDIO_SECTOR_SIZE);
 				}
+				curPos+=AUDIO_SECTOR_SIZE;
 			}
 		}
 	}
@@ -1287,6 +1297,16 @@ std::vector <unsigned char> DiscImage::GetWave(MinSecFrm startMSF,MinSecFrm endM
 	return wave;
 }
 
+unsigned long long int DiscImage::GetWaveLength(MinSecFrm startMSF,MinSecFrm endMSF) const
+{
+	unsigned long long int length=0;
+	for(auto &span : GetWaveSpans(startMSF,endMSF))
+	{
+		length+=span.waveSize;
+	}
+	return length;
+}
+
 DiscImage::TrackTime DiscImage::DiscTimeToTrackTime(MinSecFrm discMSF) const
 {
 	TrackTime trackTime;
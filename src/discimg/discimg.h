@@ -19,6 +19,10 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 // MDS/MDF implementation is based on:
 //   https://problemkaputt.de/psx-spx.htm#cdromdiskimagesmdsmdfalcohol120
@@ -51,6 +55,9 @@ public:
 		ERROR_MDS_FILE_SIZE_DOES_NOT_MAKE_SENSE,
 		ERROR_MDS_UNEXPECTED_NUMBER,
 		ERROR_MDS_BINARY_TOO_SHORT,
+		ERROR_TCD_BROKEN,
+		ERROR_TCD_VERSION,
+		ERROR_CANNOT_WRITE,
 	};
 	enum
 	{
@@ -66,7 +73,8 @@ public:
 		FILETYPE_NONE,
 		FILETYPE_ISO,
 		FILETYPE_CUE,
-		FILETYPE_MDS
+		FILETYPE_MDS,
+		FILETYPE_TCD,
 	};
 	enum
 	{
@@ -290,6 +298,98 @@ public:
 		/*!
 		*/
 		uint64_t byteOffsetInDisc=0;
+
+		/*! Location and length of this binary in the concatenated stream of the compressed image (.TCD).
+		    Not used for other formats.
+		*/
+		uint64_t locationInContainer=0,lengthInContainer=0;
+	};
+
+	/*! Compressed disc image (.TCD).
+	    All binary files are concatenated and cut into fixed-size hunks, and each hunk is compressed independently.
+	    The hunk index at the end of the file gives the location of any hunk directly, therefore
+	    reading a sector only needs to decompress one or two hunks.
+	    Recently-used hunks are kept decompressed in a small cache.
+	*/
+	class CompressedImage
+	{
+	public:
+		enum
+		{
+			HUNK_NUM_SECTORS=8,
+			HUNK_SIZE=AUDIO_SECTOR_SIZE*HUNK_NUM_SECTORS,
+			CACHE_NUM_HUNKS=32,
+		};
+		enum
+		{
+			CODEC_STORE,
+			CODEC_FILL,   // Entire hunk is one byte value.  Silence and padding.
+			CODEC_LZ,     // Data sectors.
+			CODEC_AUDIO,  // 16-bit stereo samples.  Delta per channel, split in low and high bytes, then LZ.
+		};
+		class Hunk
+		{
+		public:
+			uint64_t locationInFile=0;
+			uint32_t compressedSize=0;
+			unsigned int codec=CODEC_STORE;
+		};
+
+		std::string fName;
+		uint64_t totalLength=0;
+		std::vector <Hunk> hunks;
+
+		/*! Reads len bytes from pos of the concatenated stream.
+		    Returns the number of bytes read, which is less than len if it goes beyond the end.
+		    Can be called from multiple threads.
+		*/
+		uint64_t Read(unsigned char buf[],uint64_t pos,uint64_t len);
+
+		/*! Compresses one hunk.  If audio is true, the audio codec is also tried.
+		*/
+		static std::vector <unsigned char> Compress(unsigned int &codec,const unsigned char hunk[],unsigned int len,bool audio);
+
+		/*! Decompresses one hunk.  Returns false if the compressed data is broken.
+		*/
+		static bool Decompress(unsigned char hunk[],unsigned int len,unsigned int codec,const unsigned char compressed[],unsigned int compressedLen);
+
+	private:
+		class CachedHunk
+		{
+		public:
+			uint64_t hunkIndex=~(uint64_t)0;
+			uint64_t lastUsed=0;
+			std::vector <unsigned char> data;
+		};
+		std::mutex lock;
+		std::ifstream ifp;
+		uint64_t useCount=0;
+		std::vector <CachedHunk> cache;
+		std::unordered_map <uint64_t,unsigned int> hunkToCache;
+
+		const CachedHunk *GetHunk(uint64_t hunkIndex);
+	};
+
+	/*! Reads a binary file of the disc image.
+	    It reads directly from the file, or from the compressed image if the image is .TCD.
+	*/
+	class BinaryReader
+	{
+	private:
+		std::ifstream ifp;
+		std::shared_ptr <CompressedImage> compressedImage;
+		uint64_t base=0,length=0,pos=0;
+	public:
+		bool Open(const DiscImage &img,unsigned int indexToBinary);
+		bool IsOpen(void) const;
+		uint64_t GetSize(void);
+		void Seek(uint64_t pos);
+		void Skip(uint64_t len);
+
+		/*! Bytes beyond the end of the binary are not written to buf.
+		    Returns the number of bytes actually read, which is less than len on a short read.
+		*/
+		uint64_t Read(unsigned char buf[],uint64_t len);
 	};
 
 	unsigned int fileType=FILETYPE_NONE;
@@ -300,6 +400,7 @@ public:
 	std::vector <Track> tracks;
 	std::vector <DiscLayout> layout;
 	std::vector <unsigned char> binaryCache;
+	std::shared_ptr <CompressedImage> compressedImage;
 
 	class TrackTime
 	{
@@ -327,6 +428,15 @@ public:
 	unsigned int OpenMDS(const std::string &fName);
 
 
+	/*! Opens a compressed disc image (.TCD).
+	*/
+	unsigned int OpenTCD(const std::string &fName);
+
+	/*! Writes the currently-open disc image as a compressed disc image (.TCD).
+	*/
+	unsigned int SaveTCD(const std::string &fName) const;
+
+
 	/*! Cache binary file.  It may take large memory.
 	    If it is the multi-binary image, it only reads the first binary.
 	*/
@@ -370,12 +480,36 @@ public:
 	int GetTrackFromMSF(MinSecFrm MSF) const;
 
 
+private:
+	/*! Part of the binary that GetWave reads for one layout.
+	    waveSize is the number of bytes it adds to the wave.
+	*/
+	class WaveSpan
+	{
+	public:
+		int layoutType;
+		unsigned int sectorLength;
+		unsigned int indexToBinary;
+		uint64_t readFrom,readTo;
+		uint64_t waveSize;
+	};
+	/*! Returns the spans GetWave reads for the MSFs.  Shared by GetWave and GetWaveLength.
+	*/
+	std::vector <WaveSpan> GetWaveSpans(MinSecFrm startMSF,MinSecFrm endMSF) const;
+
+public:
 	/*! Returns the 44KHz wave from start and end MSFs.
 	    Can be as large as 700MB.
 	*/
 	std::vector <unsigned char> GetWave(MinSecFrm startMSF,MinSecFrm endMSF) const;
 
 
+	/*! Returns the number of bytes GetWave would return for the same MSFs without reading the image.
+	    Used for streaming CDDA in small pieces.
+	*/
+	unsigned long long int GetWaveLength(MinSecFrm startMSF,MinSecFrm endMSF) const;
+
+
 	/*! Returns track and in-track time from disc-time.
 	*/
 	TrackTime DiscTimeToTrackTime(MinSecFrm discMSF) const;
@@ -0,0 +1,833 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <stdint.h>
+
+#include "discimg.h"
+#include "cpputil.h"
+
+
+// .TCD compressed disc image.
+//
+// Header (TCD_HEADER_LENGTH bytes)
+//   +0   Signature "TSUGARU_TCDIMAGE"
+//   +16  Version
+//   +20  Hunk size
+//   +24  Number of hunks
+//   +28  Length of the meta data
+//   +32  Total length of the concatenated binaries (QWORD)
+//   +40  Location of the hunk index (QWORD)
+// Meta data (tracks, layout, binaries) follows the header.
+// Compressed hunks follow the meta data.
+// Hunk index is at the end.  16 bytes per hunk: location (QWORD), compressed size, codec.
+
+static const unsigned char TCD_SIGNATURE[]="TSUGARU_TCDIMAGE";
+enum
+{
+	TCD_VERSION=1,
+	TCD_SIGNATURE_LENGTH=16,
+	TCD_HEADER_LENGTH=64,
+	TCD_INDEX_BYTES_PER_HUNK=16,
+
+	LZ_MIN_MATCH=3,
+	LZ_MAX_MATCH=130,
+	LZ_MAX_LITERAL=128,
+	LZ_HASH_BITS=12,
+	LZ_HASH_SIZE=(1<<LZ_HASH_BITS),
+};
+
+static void TCDPutDword(std::vector <unsigned char> &buf,uint32_t data)
+{
+	unsigned char dw[4];
+	cpputil::PutDword(dw,data);
+	buf.insert(buf.end(),dw,dw+4);
+}
+static void TCDPutQword(std::vector <unsigned char> &buf,uint64_t data)
+{
+	TCDPutDword(buf,cpputil::LowDword(data));
+	TCDPutDword(buf,cpputil::HighDword(data));
+}
+static void TCDPutMSF(std::vector <unsigned char> &buf,DiscImage::MinSecFrm msf)
+{
+	TCDPutDword(buf,(uint32_t)msf.min);
+	TCDPutDword(buf,(uint32_t)msf.sec);
+	TCDPutDword(buf,(uint32_t)msf.frm);
+}
+static bool TCDGetDword(const std::vector <unsigned char> &buf,size_t &ptr,uint32_t &data)
+{
+	if(buf.size()<ptr+4)
+	{
+		return false;
+	}
+	data=cpputil::GetDword(buf.data()+ptr);
+	ptr+=4;
+	return true;
+}
+static bool TCDGetQword(const std::vector <unsigned char> &buf,size_t &ptr,uint64_t &data)
+{
+	uint32_t low,high;
+	if(true!=TCDGetDword(buf,ptr,low) || true!=TCDGetDword(buf,ptr,high))
+	{
+		return false;
+	}
+	data=cpputil::DwordPairToUnsigned64(low,high);
+	return true;
+}
+static bool TCDGetMSF(const std::vector <unsigned char> &buf,size_t &ptr,DiscImage::MinSecFrm &msf)
+{
+	uint32_t min,sec,frm;
+	if(true!=TCDGetDword(buf,ptr,min) || true!=TCDGetDword(buf,ptr,sec) || true!=TCDGetDword(buf,ptr,frm))
+	{
+		return false;
+	}
+	msf.Set((short)min,(short)sec,(short)frm);
+	return true;
+}
+
+
+////////////////////////////////////////////////////////////
+
+
+static unsigned int LZHash(const unsigned char ptr[])
+{
+	uint32_t threeBytes=ptr[0]|(ptr[1]<<8)|(ptr[2]<<16);
+	return (threeBytes*2654435761u)>>(32-LZ_HASH_BITS);
+}
+
+/*! Byte-oriented LZ77.
+    0x00-0x7F: Followed by (n+1) literal bytes.
+    0x80-0xFF: Copy ((n&0x7F)+LZ_MIN_MATCH) bytes from 16-bit offset that follows.  Offset 1 makes a run.
+*/
+static void LZCompress(std::vector <unsigned char> &out,const unsigned char in[],unsigned int len)
+{
+	std::vector <int> hashTable;
+	hashTable.resize(LZ_HASH_SIZE);
+	for(auto &h : hashTable)
+	{
+		h=-1;
+	}
+
+	unsigned int literalStart=0,i=0;
+	auto flushLiteral=[&](unsigned int literalEnd)
+	{
+		while(literalStart<literalEnd)
+		{
+			auto n=std::min<unsigned int>(literalEnd-literalStart,LZ_MAX_LITERAL);
+			out.push_back((unsigned char)(n-1));
+			out.insert(out.end(),in+literalStart,in+literalStart+n);
+			literalStart+=n;
+		}
+	};
+	auto matchLength=[&](unsigned int from)
+	{
+		unsigned int n=0;
+		while(i+n<len && n<LZ_MAX_MATCH && in[from+n]==in[i+n])
+		{
+			++n;
+		}
+		return n;
+	};
+
+	while(i+LZ_MIN_MATCH<=len)
+	{
+		auto h=LZHash(in+i);
+		auto candidate=hashTable[h];
+		hashTable[h]=i;
+
+		unsigned int bestLen=0,bestOffset=0;
+		if(0<=candidate && i-candidate<=0xFFFF)
+		{
+			bestLen=matchLength(candidate);
+			bestOffset=i-candidate;
+		}
+		if(0<i && bestLen<LZ_MAX_MATCH)
+		{
+			auto runLen=matchLength(i-1);
+			if(bestLen<runLen)
+			{
+				bestLen=runLen;
+				bestOffset=1;
+			}
+		}
+
+		if(LZ_MIN_MATCH<=bestLen)
+		{
+			flushLiteral(i);
+			out.push_back((unsigned char)(0x80|(bestLen-LZ_MIN_MATCH)));
+			out.push_back((unsigned char)(bestOffset&255));
+			out.push_back((unsigned char)(bestOffset>>8));
+			for(unsigned int j=1; j<bestLen && i+j+LZ_MIN_MATCH<=len; ++j)
+			{
+				hashTable[LZHash(in+i+j)]=i+j;
+			}
+			i+=bestLen;
+			literalStart=i;
+		}
+		else
+		{
+			++i;
+		}
+	}
+	flushLiteral(len);
+}
+static bool LZDecompress(unsigned char out[],unsigned int len,const unsigned char in[],unsigned int inLen)
+{
+	unsigned int outPtr=0,inPtr=0;
+	while(inPtr<inLen)
+	{
+		auto c=in[inPtr++];
+		if(0==(c&0x80))
+		{
+			unsigned int n=c+1;
+			if(inLen<inPtr+n || len<outPtr+n)
+			{
+				return false;
+			}
+			memcpy(out+outPtr,in+inPtr,n);
+			inPtr+=n;
+			outPtr+=n;
+		}
+		else
+		{
+			unsigned int n=(c&0x7F)+LZ_MIN_MATCH;
+			if(inLen<inPtr+2)
+			{
+				return false;
+			}
+			unsigned int offset=in[inPtr]|(in[inPtr+1]<<8);
+			inPtr+=2;
+			if(0==offset || outPtr<offset || len<outPtr+n)
+			{
+				return false;
+			}
+			for(unsigned int i=0; i<n; ++i) // May overlap.  Cannot use memcpy.
+			{
+				out[outPtr]=out[outPtr-offset];
+				++outPtr;
+			}
+		}
+	}
+	return outPtr==len;
+}
+
+/*! CD-DA is 16-bit little-endian stereo.  Taking the difference from the previous sample of the same channel
+    makes quiet passages small numbers, and separating low and high bytes makes long runs of 00h or FFh in the high bytes.
+*/
+static void AudioToPlanes(std::vector <unsigned char> &planes,const unsigned char in[],unsigned int len)
+{
+	auto numWords=len/2;
+	planes.resize(len);
+	for(unsigned int i=0; i<numWords; ++i)
+	{
+		unsigned int prev=(2<=i ? cpputil::GetWord(in+(i-2)*2) : 0);
+		unsigned int diff=(cpputil::GetWord(in+i*2)-prev)&0xFFFF;
+		planes[i]=(unsigned char)(diff&255);
+		planes[numWords+i]=(unsigned char)(diff>>8);
+	}
+	if(0!=(len&1))
+	{
+		planes[len-1]=in[len-1];
+	}
+}
+static void PlanesToAudio(unsigned char out[],const unsigned char planes[],unsigned int len)
+{
+	auto numWords=len/2;
+	for(unsigned int i=0; i<numWords; ++i)
+	{
+		unsigned int prev=(2<=i ? cpputil::GetWord(out+(i-2)*2) : 0);
+		unsigned int diff=planes[i]|(planes[numWords+i]<<8);
+		cpputil::PutWord(out+i*2,(unsigned short)((prev+diff)&0xFFFF));
+	}
+	if(0!=(len&1))
+	{
+		out[len-1]=planes[len-1];
+	}
+}
+
+/* static */ std::vector <unsigned char> DiscImage::CompressedImage::Compress(unsigned int &codec,const unsigned char hunk[],unsigned int len,bool audio)
+{
+	std::vector <unsigned char> best;
+
+	if(0<len && std::all_of(hunk,hunk+len,[&](unsigned char c){return c==hunk[0];}))
+	{
+		codec=CODEC_FILL;
+		best.push_back(hunk[0]);
+		return best;
+	}
+
+	codec=CODEC_LZ;
+	LZCompress(best,hunk,len);
+
+	if(true==audio)
+	{
+		std::vector <unsigned char> planes,compressed;
+		AudioToPlanes(planes,hunk,len);
+		LZCompress(compressed,planes.data(),len);
+		if(compressed.size()<best.size())
+		{
+			codec=CODEC_AUDIO;
+			best.swap(compressed);
+		}
+	}
+
+	if(len<=best.size())
+	{
+		codec=CODEC_STORE;
+		best.assign(hunk,hunk+len);
+	}
+	return best;
+}
+
+/* static */ bool DiscImage::CompressedImage::Decompress(unsigned char hunk[],unsigned int len,unsigned int codec,const unsigned char compressed[],unsigned int compressedLen)
+{
+	switch(codec)
+	{
+	case CODEC_STORE:
+		if(compressedLen==len)
+		{
+			memcpy(hunk,compressed,len);
+			return true;
+		}
+		break;
+	case CODEC_FILL:
+		if(1==compressedLen)
+		{
+			memset(hunk,compressed[0],len);
+			return true;
+		}
+		break;
+	case CODEC_LZ:
+		return LZDecompress(hunk,len,compressed,compressedLen);
+	case CODEC_AUDIO:
+		{
+			std::vector <unsigned char> planes;
+			planes.resize(len);
+			if(true==LZDecompress(planes.data(),len,compressed,compressedLen))
+			{
+				PlanesToAudio(hunk,planes.data(),len);
+				return true;
+			}
+		}
+		break;
+	}
+	return false;
+}
+
+uint64_t DiscImage::CompressedImage::Read(unsigned char buf[],uint64_t pos,uint64_t len)
+{
+	std::lock_guard <std::mutex> guard(lock);
+
+	uint64_t nRead=0;
+	while(nRead<len && pos<totalLength)
+	{
+		auto hunkPtr=GetHunk(pos/HUNK_SIZE);
+		auto offsetInHunk=pos%HUNK_SIZE;
+		if(nullptr==hunkPtr || hunkPtr->data.size()<=offsetInHunk)
+		{
+			break;
+		}
+
+		auto copyLen=std::min<uint64_t>(len-nRead,hunkPtr->data.size()-offsetInHunk);
+		memcpy(buf+nRead,hunkPtr->data.data()+offsetInHunk,copyLen);
+		nRead+=copyLen;
+		pos+=copyLen;
+	}
+	return nRead;
+}
+
+const DiscImage::CompressedImage::CachedHunk *DiscImage::CompressedImage::GetHunk(uint64_t hunkIndex)
+{
+	auto found=hunkToCache.find(hunkIndex);
+	if(hunkToCache.end()!=found)
+	{
+		auto &cached=cache[found->second];
+		cached.lastUsed=++useCount;
+		return &cached;
+	}
+
+	if(hunks.size()<=hunkIndex)
+	{
+		return nullptr;
+	}
+
+	unsigned int slot=0;
+	if(cache.size()<CACHE_NUM_HUNKS)
+	{
+		slot=(unsigned int)cache.size();
+		cache.emplace_back();
+	}
+	else
+	{
+		for(unsigned int i=1; i<cache.size(); ++i)
+		{
+			if(cache[i].lastUsed<cache[slot].lastUsed)
+			{
+				slot=i;
+			}
+		}
+		hunkToCache.erase(cache[slot].hunkIndex);
+		cache[slot].hunkIndex=~(uint64_t)0;
+	}
+
+	auto &hunk=hunks[hunkIndex];
+	std::vector <unsigned char> compressed;
+	compressed.resize(hunk.compressedSize);
+
+	if(true!=ifp.is_open())
+	{
+		ifp.open(fName,std::ios::binary);
+	}
+	ifp.clear();
+	ifp.seekg(hunk.locationInFile,std::ios::beg);
+	ifp.read((char *)compressed.data(),compressed.size());
+	if(ifp.gcount()!=(std::streamsize)compressed.size())
+	{
+		return nullptr;
+	}
+
+	auto &cached=cache[slot];
+	cached.data.resize((size_t)std::min<uint64_t>(HUNK_SIZE,totalLength-hunkIndex*HUNK_SIZE));
+	if(true!=Decompress(cached.data.data(),(unsigned int)cached.data.size(),hunk.codec,compressed.data(),(unsigned int)compressed.size()))
+	{
+		std::cout << "Broken hunk " << hunkIndex << " in " << fName << std::endl;
+		return nullptr;
+	}
+	cached.hunkIndex=hunkIndex;
+	cached.lastUsed=++useCount;
+	hunkToCache[hunkIndex]=slot;
+	return &cached;
+}
+
+
+////////////////////////////////////////////////////////////
+
+
+bool DiscImage::BinaryReader::Open(const DiscImage &img,unsigned int indexToBinary)
+{
+	if(true==ifp.is_open())
+	{
+		ifp.close();
+	}
+	ifp.clear();
+	compressedImage.reset();
+	base=0;
+	length=0;
+	pos=0;
+
+	if(indexToBinary<img.binaries.size())
+	{
+		auto &bin=img.binaries[indexToBinary];
+		if(nullptr!=img.compressedImage)
+		{
+			compressedImage=img.compressedImage;
+			base=bin.locationInContainer;
+			length=bin.lengthInContainer;
+			return true;
+		}
+		ifp.open(bin.fName,std::ios::binary);
+		return ifp.is_open();
+	}
+	return false;
+}
+bool DiscImage::BinaryReader::IsOpen(void) const
+{
+	return nullptr!=compressedImage || true==ifp.is_open();
+}
+uint64_t DiscImage::BinaryReader::GetSize(void)
+{
+	if(nullptr!=compressedImage)
+	{
+		return length;
+	}
+	auto cur=ifp.tellg();
+	ifp.seekg(0,std::ios::end);
+	auto size=ifp.tellg();
+	ifp.seekg(cur,std::ios::beg);
+	return size;
+}
+void DiscImage::BinaryReader::Seek(uint64_t pos)
+{
+	if(nullptr!=compressedImage)
+	{
+		this->pos=pos;
+	}
+	else
+	{
+		ifp.seekg(pos,std::ios::beg);
+	}
+}
+void DiscImage::BinaryReader::Skip(uint64_t len)
+{
+	if(nullptr!=compressedImage)
+	{
+		pos+=len;
+	}
+	else
+	{
+		ifp.seekg(len,std::ios::cur);
+	}
+}
+uint64_t DiscImage::BinaryReader::Read(unsigned char buf[],uint64_t len)
+{
+	uint64_t nRead=0;
+	if(nullptr!=compressedImage)
+	{
+		if(pos<length)
+		{
+			nRead=compressedImage->Read(buf,base+pos,std::min(len,length-pos));
+		}
+		pos+=len;
+	}
+	else
+	{
+		ifp.read((char *)buf,len);
+		nRead=ifp.gcount();
+		if(nRead<len)
+		{
+			ifp.clear();  // Let the next Seek work after hitting the end of file.
+		}
+	}
+	return nRead;
+}
+
+
+////////////////////////////////////////////////////////////
+
+
+unsigned int DiscImage::OpenTCD(const std::string &fName)
+{
+	std::ifstream ifp(fName,std::ios::binary);
+	if(true!=ifp.is_open())
+	{
+		return ERROR_CANNOT_OPEN;
+	}
+
+	ifp.seekg(0,std::ios::end);
+	uint64_t fSize=ifp.tellg();
+	ifp.seekg(0,std::ios::beg);
+
+	std::vector <unsigned char> header;
+	header.resize(TCD_HEADER_LENGTH);
+	ifp.read((char *)header.data(),header.size());
+	if(ifp.gcount()!=TCD_HEADER_LENGTH ||
+	   true!=std::equal(TCD_SIGNATURE,TCD_SIGNATURE+TCD_SIGNATURE_LENGTH,header.begin()))
+	{
+		return ERROR_TCD_BROKEN;
+	}
+
+	size_t ptr=TCD_SIGNATURE_LENGTH;
+	uint32_t version=0,hunkSize=0,numHunks=0,metaLength=0;
+	uint64_t totalLength=0,indexLocation=0;
+	if(true!=TCDGetDword(header,ptr,version) ||
+	   true!=TCDGetDword(header,ptr,hunkSize) ||
+	   true!=TCDGetDword(header,ptr,numHunks) ||
+	   true!=TCDGetDword(header,ptr,metaLength) ||
+	   true!=TCDGetQword(header,ptr,totalLength) ||
+	   true!=TCDGetQword(header,ptr,indexLocation))
+	{
+		return ERROR_TCD_BROKEN;
+	}
+	if(TCD_VERSION!=version || CompressedImage::HUNK_SIZE!=hunkSize)
+	{
+		return ERROR_TCD_VERSION;
+	}
+	if(numHunks!=(totalLength+hunkSize-1)/hunkSize ||
+	   fSize<TCD_HEADER_LENGTH+(uint64_t)metaLength ||
+	   fSize<indexLocation+(uint64_t)numHunks*TCD_INDEX_BYTES_PER_HUNK)
+	{
+		return ERROR_TCD_BROKEN;
+	}
+
+
+	std::vector <unsigned char> meta;
+	meta.resize(metaLength);
+	ifp.read((char *)meta.data(),meta.size());
+	if(ifp.gcount()!=(std::streamsize)meta.size())
+	{
+		return ERROR_TCD_BROKEN;
+	}
+
+	uint32_t numSectors=0,numBinaries=0,numTracks=0,numLayouts=0;
+	uint64_t binLength=0;
+	std::vector <Binary> newBinaries;
+	std::vector <Track> newTracks;
+	std::vector <DiscLayout> newLayout;
+
+	ptr=0;
+	if(true!=TCDGetDword(meta,ptr,numSectors) ||
+	   true!=TCDGetQword(meta,ptr,binLength) ||
+	   true!=TCDGetDword(meta,ptr,numBinaries))
+	{
+		return ERROR_TCD_BROKEN;
+	}
+	for(uint32_t i=0; i<numBinaries; ++i)
+	{
+		Binary bin;
+		bin.fName=fName;
+		if(true!=TCDGetQword(meta,ptr,bin.fileSize) ||
+		   true!=TCDGetQword(meta,ptr,bin.bytesToSkip) ||
+		   true!=TCDGetQword(meta,ptr,bin.byteOffsetInDisc) ||
+		   true!=TCDGetQword(meta,ptr,bin.locationInContainer) ||
+		   true!=TCDGetQword(meta,ptr,bin.lengthInContainer) ||
+		   totalLength<bin.locationInContainer+bin.lengthInContainer)
+		{
+			return ERROR_TCD_BROKEN;
+		}
+		newBinaries.push_back(bin);
+	}
+	if(true!=TCDGetDword(meta,ptr,numTracks))
+	{
+		return ERROR_TCD_BROKEN;
+	}
+	for(uint32_t i=0; i<numTracks; ++i)
+	{
+		Track trk;
+		uint64_t locationInFile;
+		if(true!=TCDGetDword(meta,ptr,trk.trackType) ||
+		   true!=TCDGetDword(meta,ptr,trk.sectorLength) ||
+		   true!=TCDGetDword(meta,ptr,trk.preGapSectorLength) ||
+		   true!=TCDGetQword(meta,ptr,locationInFile) ||
+		   true!=TCDGetMSF(meta,ptr,trk.start) ||
+		   true!=TCDGetMSF(meta,ptr,trk.end) ||
+		   true!=TCDGetMSF(meta,ptr,trk.index00) ||
+		   true!=TCDGetMSF(meta,ptr,trk.preGap) ||
+		   true!=TCDGetMSF(meta,ptr,trk.postGap))
+		{
+			return ERROR_TCD_BROKEN;
+		}
+		trk.locationInFile=locationInFile;
+		newTracks.push_back(trk);
+	}
+	if(true!=TCDGetDword(meta,ptr,numLayouts))
+	{
+		return ERROR_TCD_BROKEN;
+	}
+	for(uint32_t i=0; i<numLayouts; ++i)
+	{
+		DiscLayout lay;
+		uint32_t layoutType;
+		if(true!=TCDGetDword(meta,ptr,layoutType) ||
+		   true!=TCDGetDword(meta,ptr,lay.sectorLength) ||
+		   true!=TCDGetDword(meta,ptr,lay.startHSG) ||
+		   true!=TCDGetDword(meta,ptr,lay.numSectors) ||
+		   true!=TCDGetQword(meta,ptr,lay.locationInFile) ||
+		   true!=TCDGetDword(meta,ptr,lay.indexToBinary) ||
+		   numBinaries<=lay.indexToBinary)
+		{
+			return ERROR_TCD_BROKEN;
+		}
+		lay.layoutType=layoutType;
+		newLayout.push_back(lay);
+	}
+
+
+	auto compressed=std::make_shared <CompressedImage>();
+	compressed->fName=fName;
+	compressed->totalLength=totalLength;
+	compressed->hunks.resize(numHunks);
+
+	std::vector <unsigned char> index;
+	index.resize((size_t)numHunks*TCD_INDEX_BYTES_PER_HUNK);
+	ifp.seekg(indexLocation,std::ios::beg);
+	ifp.read((char *)index.data(),index.size());
+	if(ifp.gcount()!=(std::streamsize)index.size())
+	{
+		return ERROR_TCD_BROKEN;
+	}
+	ptr=0;
+	for(auto &hunk : compressed->hunks)
+	{
+		uint32_t codec;
+		if(true!=TCDGetQword(index,ptr,hunk.locationInFile) ||
+		   true!=TCDGetDword(index,ptr,hunk.compressedSize) ||
+		   true!=TCDGetDword(index,ptr,codec) ||
+		   fSize<hunk.locationInFile+hunk.compressedSize)
+		{
+			return ERROR_TCD_BROKEN;
+		}
+		hunk.codec=codec;
+	}
+
+
+	CleanUp();
+	fileType=FILETYPE_TCD;
+	this->fName=fName;
+	num_sectors=numSectors;
+	totalBinLength=binLength;
+	binaries.swap(newBinaries);
+	tracks.swap(newTracks);
+	layout.swap(newLayout);
+	compressedImage=compressed;
+
+	return ERROR_NOERROR;
+}
+
+unsigned int DiscImage::SaveTCD(const std::string &fName) const
+{
+	if(0==binaries.size())
+	{
+		return ERROR_UNSUPPORTED;
+	}
+
+	auto bins=binaries;
+	uint64_t totalLength=0;
+	for(unsigned int i=0; i<bins.size(); ++i)
+	{
+		BinaryReader reader;
+		if(true!=reader.Open(*this,i))
+		{
+			return ERROR_BINARY_FILE_NOT_FOUND;
+		}
+		bins[i].locationInContainer=totalLength;
+		bins[i].lengthInContainer=reader.GetSize();
+		totalLength+=bins[i].lengthInContainer;
+	}
+	uint64_t numHunks=(totalLength+CompressedImage::HUNK_SIZE-1)/CompressedImage::HUNK_SIZE;
+
+
+	// Audio hunks are tried with the audio codec as well.
+	std::vector <bool> audioHunk;
+	audioHunk.resize(numHunks);
+	for(int i=0; i+1<layout.size(); ++i)
+	{
+		if(LAYOUT_AUDIO==layout[i].layoutType && layout[i].indexToBinary<bins.size())
+		{
+			auto &bin=bins[layout[i].indexToBinary];
+			auto from=bin.locationInContainer+layout[i].locationInFile-bin.byteOffsetInDisc+bin.bytesToSkip;
+			auto to=from+(layout[i+1].locationInFile-layout[i].locationInFile);
+			to=std::min(to,bin.locationInContainer+bin.lengthInContainer);
+			for(auto h=from/CompressedImage::HUNK_SIZE; h<numHunks && h*CompressedImage::HUNK_SIZE<to; ++h)
+			{
+				audioHunk[h]=true;
+			}
+		}
+	}
+
+
+	std::vector <unsigned char> meta;
+	TCDPutDword(meta,num_sectors);
+	TCDPutQword(meta,totalBinLength);
+	TCDPutDword(meta,(uint32_t)bins.size());
+	for(auto &bin : bins)
+	{
+		TCDPutQword(meta,bin.fileSize);
+		TCDPutQword(meta,bin.bytesToSkip);
+		TCDPutQword(meta,bin.byteOffsetInDisc);
+		TCDPutQword(meta,bin.locationInContainer);
+		TCDPutQword(meta,bin.lengthInContainer);
+	}
+	TCDPutDword(meta,(uint32_t)tracks.size());
+	for(auto &trk : tracks)
+	{
+		TCDPutDword(meta,trk.trackType);
+		TCDPutDword(meta,trk.sectorLength);
+		TCDPutDword(meta,trk.preGapSectorLength);
+		TCDPutQword(meta,trk.locationInFile);
+		TCDPutMSF(meta,trk.start);
+		TCDPutMSF(meta,trk.end);
+		TCDPutMSF(meta,trk.index00);
+		TCDPutMSF(meta,trk.preGap);
+		TCDPutMSF(meta,trk.postGap);
+	}
+	TCDPutDword(meta,(uint32_t)layout.size());
+	for(auto &lay : layout)
+	{
+		TCDPutDword(meta,lay.layoutType);
+		TCDPutDword(meta,lay.sectorLength);
+		TCDPutDword(meta,lay.startHSG);
+		TCDPutDword(meta,lay.numSectors);
+		TCDPutQword(meta,lay.locationInFile);
+		TCDPutDword(meta,lay.indexToBinary);
+	}
+
+
+	std::ofstream ofp(fName,std::ios::binary);
+	if(true!=ofp.is_open())
+	{
+		return ERROR_CANNOT_WRITE;
+	}
+
+	std::vector <unsigned char> header;
+	header.resize(TCD_HEADER_LENGTH);
+	ofp.write((char *)header.data(),header.size());
+	ofp.write((char *)meta.data(),meta.size());
+
+	std::vector <unsigned char> index;
+	std::vector <unsigned char> hunk;
+	uint64_t filePtr=TCD_HEADER_LENGTH+meta.size();
+	BinaryReader reader;
+	unsigned int readerBinary=~0;
+	for(uint64_t h=0; h<numHunks; ++h)
+	{
+		auto hunkPos=h*CompressedImage::HUNK_SIZE;
+		hunk.resize((size_t)std::min<uint64_t>(CompressedImage::HUNK_SIZE,totalLength-hunkPos));
+		for(auto &d : hunk)
+		{
+			d=0;
+		}
+
+		for(unsigned int i=0; i<bins.size(); ++i)
+		{
+			auto from=std::max(hunkPos,bins[i].locationInContainer);
+			auto to=std::min(hunkPos+hunk.size(),bins[i].locationInContainer+bins[i].lengthInContainer);
+			if(from<to)
+			{
+				if(readerBinary!=i)
+				{
+					reader.Open(*this,i);
+					readerBinary=i;
+				}
+				reader.Seek(from-bins[i].locationInContainer);
+				if(to-from!=reader.Read(hunk.data()+(from-hunkPos),to-from))
+				{
+					return ERROR_CANNOT_OPEN;  // Binary shrank after the image was opened.
+				}
+			}
+		}
+
+		unsigned int codec;
+		auto compressed=CompressedImage::Compress(codec,hunk.data(),(unsigned int)hunk.size(),audioHunk[h]);
+		ofp.write((char *)compressed.data(),compressed.size());
+
+		TCDPutQword(index,filePtr);
+		TCDPutDword(index,(uint32_t)compressed.size());
+		TCDPutDword(index,codec);
+		filePtr+=compressed.size();
+	}
+
+	ofp.write((char *)index.data(),index.size());
+
+	header.clear();
+	header.insert(header.end(),TCD_SIGNATURE,TCD_SIGNATURE+TCD_SIGNATURE_LENGTH);
+	TCDPutDword(header,TCD_VERSION);
+	TCDPutDword(header,CompressedImage::HUNK_SIZE);
+	TCDPutDword(header,(uint32_t)numHunks);
+	TCDPutDword(header,(uint32_t)meta.size());
+	TCDPutQword(header,totalLength);
+	TCDPutQword(header,filePtr);
+	header.resize(TCD_HEADER_LENGTH);
+	ofp.seekp(0,std::ios::beg);
+	ofp.write((char *)header.data(),header.size());
+
+	if(true!=ofp.good())
+	{
+		return ERROR_CANNOT_WRITE;
+	}
+	return ERROR_NOERROR;
+}
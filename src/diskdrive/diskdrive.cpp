@@ -13,6 +13,10 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 << LICENSE */
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <utility>
+#include <stdio.h>
 
 #include "cpputil.h"
 #include "diskdrive.h"
@@ -88,6 +92,8 @@ void DiskDrive::DiskImage::ClearModifiedFlag(void)
 		}
 		break;
 	}
+	allDirty=false;
+	dirtySectors.clear();
 }
 bool DiskDrive::DiskImage::DiskLoaded(int diskIdx) const
 {
@@ -273,6 +279,7 @@ bool DiskDrive::DiskImage::WriteSector(int diskIdx,unsigned int C,unsigned int H
 			{
 				diskPtr->WriteSector(C,H,R,len,data);
 				diskPtr->SetModified();
+				dirtySectors.insert(DirtySectorKey(diskIdx,C,H,R));
 				return true;
 			}
 		}
@@ -397,6 +404,7 @@ void DiskDrive::DiskImage::SetNumCylinders(int diskIdx,unsigned int n)
 			if(nullptr!=diskPtr)
 			{
 				diskPtr->SetNumTrack(n);
+				allDirty=true;
 			}
 		}
 		break;
@@ -529,6 +537,7 @@ unsigned int DiskDrive::DiskImage::WriteTrack(int diskIdx,unsigned int RealC,uns
 				s.nSectorTrack=(unsigned short)sectors.size();
 			}
 			diskPtr->ForceWriteTrack(RealC,RealH,(int)sectors.size(),sectors.data());
+			allDirty=true;
 		}
 		break;
 	}
@@ -617,28 +626,54 @@ bool DiskDrive::DiskImage::WriteProtected(int diskIdx) const
 
 ////////////////////////////////////////////////////////////
 
-void DiskDrive::ImageFile::SaveIfModified(void)
+bool DiskDrive::ImageFile::MakeSaveJob(ImageWriter::Job &job)
 {
-	if(true==img.IsModified())
+	if(true!=img.IsModified())
 	{
-		auto bin=img.MakeImageBinary();
-		if(0<bin.size())
+		return false;
+	}
+	if(IMGFILE_RAW!=img.fileType && IMGFILE_D77!=img.fileType && IMGFILE_RDD!=img.fileType)
+	{
+		std::cout << "Image-binary save not supported for this format." << std::endl;
+		img.ClearModifiedFlag();
+		return false;
+	}
+
+	job=ImageWriter::Job();
+	job.jobType=ImageWriter::Job::JOB_SAVE;
+	job.fName=fName;
+	job.fileType=img.fileType;
+
+	if(true==img.allDirty)
+	{
+		// Layout may have changed.  Take the whole image.  Image binary is made in the writer thread.
+		job.wholeImage=true;
+		job.image=img.d77;
+	}
+	else
+	{
+		for(auto key : img.dirtySectors)
 		{
-			if(true!=cpputil::WriteBinaryFile(fName,bin.size(),bin.data()))
-			{
-				std::cout << "Warning!  Floppy Disk Image could not be saved." << std::endl;
-			}
-			else
+			ImageWriter::SectorData sec;
+			sec.diskIdx=(key>>24)&0xFF;
+			sec.C=(key>>16)&0xFF;
+			sec.H=(key>>8)&0xFF;
+			sec.R=key&0xFF;
+			auto diskPtr=img.d77.GetDisk(sec.diskIdx);
+			if(nullptr!=diskPtr)
 			{
-				std::cout << "Auto-saved disk image:" << fName << std::endl;
+				sec.data=diskPtr->ReadSector(sec.C,sec.H,sec.R);
+				job.sectors.push_back(std::move(sec));
 			}
 		}
-		else
+		for(unsigned int i=0; i<img.GetNumDisk(); ++i)
 		{
-			std::cout << "Image-binary save not supported for this format." << std::endl;
+			job.writeProtected.push_back(img.WriteProtected(i));
 		}
 	}
+
 	img.ClearModifiedFlag();
+	return true;
 }
 
 bool DiskDrive::ImageFile::LoadD77orRAW(std::string fName)
@@ -664,6 +699,7 @@ bool DiskDrive::ImageFile::LoadD77(std::string fName)
 	}
 
 	this->img.d77.CleanUp();
+	this->img.ClearModifiedFlag();
 	this->img.d77.SetData(bin,verbose);
 	if(0<this->img.d77.GetNumDisk())
 	{
@@ -715,6 +751,7 @@ bool DiskDrive::ImageFile::LoadRDD(std::string fName)
 	}
 
 	this->img.d77.CleanUp();
+	this->img.ClearModifiedFlag();
 	this->img.d77.SetRDDData(bin,verbose);
 	if(0<this->img.d77.GetNumDisk())
 	{
@@ -737,6 +774,7 @@ bool DiskDrive::ImageFile::LoadRAW(std::string fName)
 	}
 
 	this->img.d77.CleanUp();
+	this->img.ClearModifiedFlag();
 	if(true==this->img.d77.SetRawBinary(bin,verbose))
 	{
 		this->img.fileType=IMGFILE_RAW;
@@ -860,6 +898,7 @@ bool DiskDrive::LoadD77(unsigned int driveNum,const char fNameIn[],uint64_t vmTi
 	SaveIfModifiedAndUnlinkDiskImage(imgIdx);
 
 	auto fName=cpputil::FindFileWithSearchPaths(fNameIn,searchPaths);
+	imageWriter.WaitForFile(fName);
 	if(true==imgFile[imgIdx].LoadD77(fName))
 	{
 		LinkDiskImageToDrive(imgIdx,0,driveNum,vmTime);
@@ -876,6 +915,7 @@ bool DiskDrive::LoadRDD(unsigned int driveNum,const char fNameIn[],uint64_t vmTi
 	SaveIfModifiedAndUnlinkDiskImage(imgIdx);
 
 	auto fName=cpputil::FindFileWithSearchPaths(fNameIn,searchPaths);
+	imageWriter.WaitForFile(fName);
 	if(true==imgFile[imgIdx].LoadRDD(fName))
 	{
 		LinkDiskImageToDrive(imgIdx,0,driveNum,vmTime);
@@ -892,6 +932,7 @@ bool DiskDrive::LoadRawBinary(unsigned int driveNum,const char fNameIn[],uint64_
 	SaveIfModifiedAndUnlinkDiskImage(imgIdx);
 
 	auto fName=cpputil::FindFileWithSearchPaths(fNameIn,searchPaths);
+	imageWriter.WaitForFile(fName);
 	if(true==imgFile[imgIdx].LoadRAW(fName))
 	{
 		LinkDiskImageToDrive(imgIdx,0,driveNum,vmTime);
@@ -925,7 +966,19 @@ void DiskDrive::SaveIfModifiedAndUnlinkDiskImage(unsigned int imgIndex)
 			d.mediaType=MEDIA_UNKNOWN;
 		}
 	}
-	imgFile[imgIndex].SaveIfModified();
+	ImageWriter::Job job;
+	if(true==imgFile[imgIndex].MakeSaveJob(job))
+	{
+		imageWriter.Push(std::move(job));
+	}
+	if(""!=imgFile[imgIndex].fName)
+	{
+		ImageWriter::Job closeJob;
+		closeJob.jobType=ImageWriter::Job::JOB_CLOSE;
+		closeJob.fName=imgFile[imgIndex].fName;
+		imageWriter.Push(std::move(closeJob));
+	}
+	// Loading the same file again waits in WaitForFile.
 }
 
 void DiskDrive::Eject(unsigned int driveNum)
@@ -964,10 +1017,19 @@ void DiskDrive::SaveModifiedDiskImages(void)
 {
 	for(auto &img : imgFile)
 	{
-		img.SaveIfModified();
+		ImageWriter::Job job;
+		if(true==img.MakeSaveJob(job))
+		{
+			imageWriter.Push(std::move(job));
+		}
 	}
 }
 
+void DiskDrive::FlushDiskImageWriter(void)
+{
+	imageWriter.Flush();
+}
+
 void DiskDrive::SetWriteProtect(int driveNum,bool writeProtect)
 {
 	if(0<=driveNum && driveNum<NUM_DRIVES)
@@ -1663,6 +1725,9 @@ bool DiskDrive::DeserializeVersion0to6(const unsigned char *&data,std::string st
 		drv.pretendDriveNotReadyUntil=0;
 	}
 
+	// Images may be loaded from files still being written.
+	imageWriter.Flush();
+
 	ReadUint32(data); // Dummy read NUM_DRIVES
 	for(auto &imgf : imgFile)
 	{
@@ -1734,6 +1799,8 @@ bool DiskDrive::DeserializeVersion0to6(const unsigned char *&data,std::string st
 				{
 					imgf.img.SetData(imgf.img.fileType,dskImg,false);
 				}
+				// The file does not have this image.  Write the whole image on the first save.
+				imgf.img.allDirty=true;
 			}
 		}
 	}
@@ -1845,3 +1912,229 @@ void DiskDrive::SetDataReg(int num)
 	state.drive[2].dataReg=num;
 	state.drive[3].dataReg=num;
 }
+
+////////////////////////////////////////////////////////////
+
+DiskDrive::ImageWriter::ImageWriter()
+{
+}
+DiskDrive::ImageWriter::~ImageWriter()
+{
+	{
+		std::unique_lock <std::mutex> ul(lock);
+		terminate=true;
+	}
+	cond.notify_all();
+	if(true==thr.joinable())
+	{
+		thr.join();
+	}
+}
+void DiskDrive::ImageWriter::Push(Job &&job)
+{
+	{
+		std::unique_lock <std::mutex> ul(lock);
+		if(true==job.wholeImage)
+		{
+			for(auto iter=queue.begin(); iter!=queue.end(); )
+			{
+				if(iter->fName==job.fName && Job::JOB_SAVE==iter->jobType)
+				{
+					iter=queue.erase(iter);
+				}
+				else
+				{
+					++iter;
+				}
+			}
+		}
+		queue.push_back(std::move(job));
+		if(true!=thr.joinable())
+		{
+			thr=std::thread(&ImageWriter::ThreadFunc,this);
+		}
+	}
+	cond.notify_all();
+}
+void DiskDrive::ImageWriter::Flush(void)
+{
+	std::unique_lock <std::mutex> ul(lock);
+	cond.wait(ul,[this]{return true==queue.empty() && true!=busy;});
+}
+void DiskDrive::ImageWriter::WaitForFile(const std::string &fName)
+{
+	std::unique_lock <std::mutex> ul(lock);
+	cond.wait(ul,[&]
+	{
+		if(true==busy && busyFName==fName)
+		{
+			return false;
+		}
+		for(auto &job : queue)
+		{
+			if(job.fName==fName)
+			{
+				return false;
+			}
+		}
+		return true;
+	});
+}
+bool DiskDrive::ImageWriter::Write(Job &job)
+{
+	if(Job::JOB_CLOSE==job.jobType)
+	{
+		shadow.erase(job.fName);
+		return true;
+	}
+
+	if(true==job.wholeImage)
+	{
+		auto &s=shadow[job.fName];
+		s.img.fileType=job.fileType;
+		std::swap(s.img.d77,job.image);
+		return WriteWholeImage(job.fName,s);
+	}
+
+	auto found=shadow.find(job.fName);
+	if(shadow.end()==found)
+	{
+		Shadow s;
+		auto bin=cpputil::ReadBinaryFile(job.fName);
+		if(0==bin.size() || true!=s.img.SetData(job.fileType,bin,false) || 0==s.img.GetNumDisk())
+		{
+			std::cout << "Warning!  Floppy Disk Image could not be saved." << std::endl;
+			return false;
+		}
+		s.fileSize=bin.size();
+		found=shadow.insert(std::make_pair(job.fName,std::move(s))).first;
+	}
+
+	auto &s=found->second;
+	for(auto &sec : job.sectors)
+	{
+		auto diskPtr=s.img.d77.GetDisk(sec.diskIdx);
+		if(nullptr!=diskPtr)
+		{
+			diskPtr->WriteSector(sec.C,sec.H,sec.R,sec.data.size(),sec.data.data());
+		}
+	}
+	for(unsigned int i=0; i<job.writeProtected.size() && i<s.img.GetNumDisk(); ++i)
+	{
+		s.img.SetWriteProtect(i,job.writeProtected[i]);
+	}
+
+	if(IMGFILE_RAW==s.img.fileType && true!=s.writeFailed && true==PatchRawImage(job.fName,s,job.sectors))
+	{
+		std::cout << "Auto-saved disk image:" << job.fName << " (" << job.sectors.size() << " sectors)" << std::endl;
+		return true;
+	}
+	return WriteWholeImage(job.fName,s);
+}
+/* static */ bool DiskDrive::ImageWriter::PatchRawImage(const std::string &fName,const Shadow &s,const std::vector <SectorData> &sectors)
+{
+	// Offsets follow D77Disk::MakeRawImage.
+	auto diskPtr=s.img.d77.GetDisk(0);
+	if(nullptr==diskPtr)
+	{
+		return false;
+	}
+
+	std::set <uint32_t> toWrite;
+	for(auto &sec : sectors)
+	{
+		toWrite.insert(DiskImage::DirtySectorKey(sec.diskIdx,sec.C,sec.H,sec.R));
+	}
+
+	std::vector <std::pair <uint64_t,std::vector <unsigned char> > > patches;
+	uint64_t offset=0;
+	for(auto &loc : diskPtr->AllTrack())
+	{
+		auto trkPtr=diskPtr->FindTrack(loc.track,loc.side);
+		if(nullptr==trkPtr)
+		{
+			continue;
+		}
+		auto allSector=trkPtr->AllSector();
+		std::sort(allSector.begin(),allSector.end(),[](const D77File::D77Disk::D77Track::SectorLocation &a,const D77File::D77Disk::D77Track::SectorLocation &b)
+		{
+			return a.sector<b.sector;
+		});
+		for(auto &sl : allSector)
+		{
+			auto sectorDump=diskPtr->ReadSector(sl.track,sl.side,sl.sector);
+			if(toWrite.end()!=toWrite.find(DiskImage::DirtySectorKey(0,sl.track,sl.side,sl.sector)))
+			{
+				patches.push_back(std::make_pair(offset,sectorDump));
+			}
+			offset+=sectorDump.size();
+		}
+	}
+	if(offset!=s.fileSize || patches.size()!=toWrite.size())
+	{
+		// Layout is not what is in the file.
+		return false;
+	}
+
+	std::fstream fp(fName,std::ios::in|std::ios::out|std::ios::binary);
+	if(true!=fp.is_open())
+	{
+		return false;
+	}
+	fp.seekg(0,std::ios::end);
+	if((uint64_t)fp.tellg()!=s.fileSize)
+	{
+		return false;
+	}
+	for(auto &p : patches)
+	{
+		fp.seekp(p.first);
+		fp.write((const char *)p.second.data(),p.second.size());
+	}
+	return true!=fp.fail();
+}
+/* static */ bool DiskDrive::ImageWriter::WriteWholeImage(const std::string &fName,Shadow &s)
+{
+	auto bin=s.img.MakeImageBinary();
+
+	// Write to a temporary file and replace, so that the image is not left half-written if the program dies.
+	// The original is never removed before the temporary file takes its place.
+	std::string tmpFName=fName+".tmp";
+	if(0<bin.size() &&
+	   true==cpputil::WriteBinaryFile(tmpFName,bin.size(),bin.data()) &&
+	   true==cpputil::RenameReplacing(tmpFName,fName))
+	{
+		s.fileSize=bin.size();
+		s.writeFailed=false;
+		std::cout << "Auto-saved disk image:" << fName << std::endl;
+		return true;
+	}
+	remove(tmpFName.c_str());
+	s.writeFailed=true;
+	std::cout << "Warning!  Floppy Disk Image could not be saved." << std::endl;
+	return false;
+}
+void DiskDrive::ImageWriter::ThreadFunc(void)
+{
+	std::unique_lock <std::mutex> ul(lock);
+	for(;;)
+	{
+		cond.wait(ul,[this]{return true==terminate || true!=queue.empty();});
+		if(true==queue.empty())
+		{
+			break;  // Terminate after all jobs are written.
+		}
+		Job job=std::move(queue.front());
+		queue.pop_front();
+		busy=true;
+		busyFName=job.fName;
+		ul.unlock();
+
+		Write(job);
+
+		ul.lock();
+		busy=false;
+		busyFName.clear();
+		cond.notify_all();
+	}
+}
@@ -18,6 +18,12 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 #include <vector>
 #include <string>
+#include <set>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "device.h"
 #include "d77.h"
 
@@ -98,6 +104,17 @@ public:
 		int fileType;
 		D77File d77;
 
+		/*! Sectors written since the last save.  Only these sectors are handed to ImageWriter.
+		    allDirty is set when the layout may have changed (track format, number of cylinders),
+		    or the image did not come from the file.
+		*/
+		bool allDirty=false;
+		std::set <uint32_t> dirtySectors;
+		static inline uint32_t DirtySectorKey(unsigned int diskIdx,unsigned int C,unsigned int H,unsigned int R)
+		{
+			return ((diskIdx&0xFF)<<24)|((C&0xFF)<<16)|((H&0xFF)<<8)|(R&0xFF);
+		}
+
 		unsigned int GetNumDisk(void) const;
 
 		bool IsModified(void) const;
@@ -166,6 +183,81 @@ public:
 			return crc_val >> 8;
 		}
 	};
+	/*! Writes disk images in a background thread so that the VM thread does not stall on file I/O.
+	    The writer keeps its own copy of each image, read from the file when first needed.
+	    The VM thread hands over only the sectors written since the last save, and the writer applies them
+	    to the copy and makes the image binary.
+	    A RAW image is patched in place.  Other images are written to a temporary file, which then replaces
+	    the original by rename.
+	    Jobs are written in the order pushed.
+	*/
+	class ImageWriter
+	{
+	public:
+		class SectorData
+		{
+		public:
+			unsigned int diskIdx=0,C=0,H=0,R=0;
+			std::vector <unsigned char> data;
+		};
+		class Job
+		{
+		public:
+			enum
+			{
+				JOB_SAVE,
+				JOB_CLOSE,  // Image is unlinked.  Writer drops the copy of the image.
+			};
+			unsigned int jobType=JOB_SAVE;
+			std::string fName;
+			int fileType=IMGFILE_RAW;
+			bool wholeImage=false;  // If true, image is a snapshot of the whole image, and sectors is empty.
+			D77File image;
+			std::vector <SectorData> sectors;
+			std::vector <bool> writeProtected;  // For each disk.  Write-protect flag is in the .D77 header.
+		};
+
+		ImageWriter();
+		~ImageWriter();
+
+		/*! Queues a job.  A whole-image job replaces queued save jobs for the same file, since it supersedes them.
+		*/
+		void Push(Job &&job);
+
+		/*! Waits until all queued jobs are written.
+		*/
+		void Flush(void);
+
+		/*! Waits until queued jobs for the file are written.  Must be called before the file is loaded again.
+		*/
+		void WaitForFile(const std::string &fName);
+
+	private:
+		/*! Image as written in the file.  Accessed only in the writer thread.
+		*/
+		class Shadow
+		{
+		public:
+			DiskImage img;
+			uint64_t fileSize=0;
+			bool writeFailed=false;  // If true, sectors written to img may not be in the file.  Next save writes the whole image.
+		};
+		std::map <std::string,Shadow> shadow;
+
+		std::thread thr;
+		std::mutex lock;
+		std::condition_variable cond;
+		std::deque <Job> queue;
+		std::string busyFName;
+		bool busy=false,terminate=false;
+
+		void ThreadFunc(void);
+		bool Write(Job &job);
+		static bool PatchRawImage(const std::string &fName,const Shadow &s,const std::vector <SectorData> &sectors);
+		static bool WriteWholeImage(const std::string &fName,Shadow &s);
+	};
+	ImageWriter imageWriter;
+
 	class ImageFile
 	{
 	public:
@@ -175,7 +267,12 @@ public:
 		bool LoadD77(std::string fName);
 		bool LoadRDD(std::string fName);
 		bool LoadRAW(std::string fName);
-		void SaveIfModified(void);
+
+		/*! Takes the sectors written since the last save as an ImageWriter job, and clears the modified flag.
+		    The whole image is copied only if the layout may have changed.
+		    Returns false if the image is not modified or cannot be saved.
+		*/
+		bool MakeSaveJob(ImageWriter::Job &job);
 	};
 	ImageFile imgFile[NUM_DRIVES];
 
@@ -269,8 +366,14 @@ public:
 	ImageFile *GetDriveImageFile(int driveNum);
 	const ImageFile *GetDriveImageFile(int driveNum) const;
 
+	/*! Snapshots modified disk images and hands them to the background writer.
+	*/
 	void SaveModifiedDiskImages(void);
 
+	/*! Waits until the background writer finishes writing all the disk images.
+	*/
+	void FlushDiskImageWriter(void);
+
 	void SetWriteProtect(int driveNum,bool writeProtect);
 
 	/*! Returns true if disk media type and drive mode is compatible.
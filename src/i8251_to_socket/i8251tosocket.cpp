@@ -1,15 +1,108 @@
+#include <chrono>
 #include "i8251tosocket.h"
 
 
 
+i8251toSocketClient::i8251toSocketClient()
+{
+	toVM.Resize(RING_BUFFER_SIZE);
+	fromVM.Resize(RING_BUFFER_SIZE);
+}
+i8251toSocketClient::~i8251toSocketClient()
+{
+	StopIOThread();
+}
+
+void i8251toSocketClient::StartIOThread(void)
+{
+	StopIOThread();
+	toVM.Clear();
+	fromVM.Clear();
+	txBatch.clear();
+	rxOverflow.clear();
+	socketConnected=(YSTRUE==IsConnected());
+	ioThreadRunning=true;
+	ioThread=std::thread(&i8251toSocketClient::IOThread,this);
+}
+void i8251toSocketClient::StopIOThread(void)
+{
+	ioThreadRunning=false;
+	if(true==ioThread.joinable())
+	{
+		ioThread.join();
+	}
+	socketConnected=false;
+}
+bool i8251toSocketClient::IOThreadRunning(void) const
+{
+	return ioThreadRunning;
+}
+bool i8251toSocketClient::SocketConnected(void) const
+{
+	return socketConnected;
+}
+
+void i8251toSocketClient::IOThread(void)
+{
+	unsigned char batch[TX_BATCH_SIZE];
+	for(;;)
+	{
+		bool running=ioThreadRunning;
+		bool busy=false;
+
+		// VM to outside.  Take whatever the VM has written so far, and send in one write.
+		if(txBatch.size()<TX_BATCH_SIZE)
+		{
+			auto n=fromVM.Pop(batch,TX_BATCH_SIZE-txBatch.size());
+			txBatch.insert(txBatch.end(),batch,batch+n);
+		}
+		if(0<txBatch.size() && true==socketConnected)
+		{
+			if(YSOK==Send(txBatch.size(),txBatch.data(),SEND_TIMEOUT))
+			{
+				txBatch.clear();
+				busy=true;
+			}
+		}
+		else if(true!=socketConnected)
+		{
+			txBatch.clear();
+		}
+
+		// Outside to VM.  Bytes that do not fit in the ring buffer wait here until the VM catches up.
+		if(0<rxOverflow.size())
+		{
+			auto n=toVM.Push(rxOverflow.data(),rxOverflow.size());
+			rxOverflow.erase(rxOverflow.begin(),rxOverflow.begin()+n);
+		}
+		if(0==rxOverflow.size() && true==socketConnected)
+		{
+			auto prevNumReceived=numReceived;
+			CheckReceive();
+			busy=(busy || prevNumReceived!=numReceived);
+		}
+
+		// Exit only after everything the VM wrote before StopIOThread has been sent.
+		if(true!=running && ((0==fromVM.Size() && 0==txBatch.size()) || true!=socketConnected))
+		{
+			break;
+		}
+		if(true!=busy)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(IDLE_SLEEP_MICROSEC));
+		}
+	}
+}
+
 bool i8251toSocketClient::TxRDY(void)
 {
 	// Tx from VM point of view.  i.e., VM to outside.
-	return (YSTRUE==IsConnected());
+	return (true==socketConnected && fromVM.Size()<fromVM.Capacity());
 }
 void i8251toSocketClient::Tx(unsigned char data)
 {
-	Send(1,&data,1);
+	// If the VM ignores TxRDY and overruns the buffer, the byte is lost like real hardware.
+	fromVM.Push(data);
 }
 void i8251toSocketClient::SetStopBits(unsigned char)
 {
@@ -29,24 +122,20 @@ void i8251toSocketClient::Command(bool,bool,bool)
 bool i8251toSocketClient::RxRDY(void)
 {
 	// Rx from VM point of view.  i.e., Outside to VM.
-	CheckReceive();
-	return (0<toVM.size());
+	return true!=toVM.Empty();
 }
 unsigned char i8251toSocketClient::Rx(void)
 {
-	if(0<toVM.size())
-	{
-		auto data=toVM[0];
-		toVM.erase(toVM.begin());
-		return data;
-	}
-	return 0;
+	unsigned char data=0;
+	toVM.Pop(data);
+	return data;
 }
 unsigned char i8251toSocketClient::PeekRx(void) const
 {
-	if(0<toVM.size())
+	auto ptr=toVM.Front();
+	if(nullptr!=ptr)
 	{
-		return toVM[0];
+		return *ptr;
 	}
 	return 0;
 }
@@ -58,14 +147,15 @@ bool i8251toSocketClient::DSR(void)
 
 YSRESULT i8251toSocketClient::Received(YSSIZE_T nBytes,unsigned char dat[])
 {
-	for(int i=0; i<nBytes; ++i)
-	{
-		toVM.push_back(dat[i]);
-	}
+	// Called from the I/O thread.
+	numReceived+=nBytes;
+	auto n=toVM.Push(dat,nBytes);
+	rxOverflow.insert(rxOverflow.end(),dat+n,dat+nBytes);
 	return YSOK;
 }
 
 YSRESULT i8251toSocketClient::ConnectionClosedByServer(void)
 {
+	socketConnected=false;
 	return YSOK;
 }
@@ -2,14 +2,61 @@
 #define I8251_TO_SOCKET_H_IS_INCLUDED
 
 #include <vector>
+#include <cstdint>
+#include <thread>
+#include <atomic>
 #include "i8251.h"
 #include "yssocket.h"
+#include "spscringbuffer.h"
 
 
+/*! Socket traffic is handled in a dedicated I/O thread started by StartIOThread after Connect.
+    The VM thread and the I/O thread only talk through two lock-free ring buffers, therefore
+    TxRDY, Tx, RxRDY, and Rx never touch the socket.
+    The I/O thread sends bytes transmitted by the VM in batches.
+*/
 class i8251toSocketClient : public i8251::Client, public YsSocketClient
 {
 public:
-	std::vector <unsigned char> toVM;
+	enum
+	{
+		RING_BUFFER_SIZE=65536,
+		TX_BATCH_SIZE=4096,
+		IDLE_SLEEP_MICROSEC=500,
+		SEND_TIMEOUT=1,
+	};
+
+	cpputil::SPSCRingBuffer <unsigned char> toVM,fromVM;
+
+private:
+	std::thread ioThread;
+	std::atomic <bool> ioThreadRunning{false};
+	std::atomic <bool> socketConnected{false};
+
+	// Used only in the I/O thread.
+	std::vector <unsigned char> txBatch,rxOverflow;
+	uint64_t numReceived=0;
+
+	void IOThread(void);
+
+public:
+	i8251toSocketClient();
+	~i8251toSocketClient();
+
+	/*! Starts the I/O thread.  Call after Connect.
+	*/
+	void StartIOThread(void);
+
+	/*! Stops the I/O thread.  Bytes that are not sent yet are sent before the thread exits.
+	    Call before Disconnect.
+	*/
+	void StopIOThread(void);
+
+	bool IOThreadRunning(void) const;
+
+	/*! Returns false after the server closes the connection.  Can be called from the VM thread.
+	*/
+	bool SocketConnected(void) const;
 
 
 	/*! i8251 class will call this function to see if the client is ready to receive a byte.
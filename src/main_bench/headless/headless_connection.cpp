@@ -0,0 +1,392 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+
+#include "headless_connection.h"
+#include "framecapture.h"
+#include "towns.h"
+#include "townsdef.h"
+#include "cpputil.h"
+
+
+
+bool HeadlessConnection::LoadInputScript(std::string fName)
+{
+	std::ifstream ifp(fName);
+	if(true!=ifp.is_open())
+	{
+		std::cout << "Cannot open input script " << fName << std::endl;
+		return false;
+	}
+
+	std::vector <std::string> text;
+	while(true!=ifp.eof())
+	{
+		std::string str;
+		std::getline(ifp,str);
+		text.push_back(str);
+	}
+	return LoadInputScript(text);
+}
+
+bool HeadlessConnection::LoadInputScript(const std::vector <std::string> &text)
+{
+	inputScript.clear();
+	inputScriptPtr=0;
+
+	int lineNum=0;
+	for(auto &line : text)
+	{
+		++lineNum;
+		auto argv=cpputil::Parser(line.c_str());
+		if(0==argv.size() || '#'==argv[0][0])
+		{
+			continue;
+		}
+		if(argv.size()<2)
+		{
+			std::cout << "Line " << lineNum << ": Too few arguments." << std::endl;
+			return false;
+		}
+
+		ScriptedInput input;
+		input.townsTime=cpputil::Atoi(argv[0].c_str());
+		input.townsTime*=1000000;
+
+		auto CMD=argv[1];
+		cpputil::Capitalize(CMD);
+		if(("KEYPRESS"==CMD || "KEYRELEASE"==CMD) && 3<=argv.size())
+		{
+			input.type=("KEYPRESS"==CMD ? INPUT_KEY_PRESS : INPUT_KEY_RELEASE);
+			auto KEY=argv[2];
+			cpputil::Capitalize(KEY);
+			input.townsKey=TownsStrToKeyCode(KEY);
+			if(TOWNS_JISKEY_NULL==input.townsKey)
+			{
+				input.townsKey=TownsStrToKeyCode("TOWNS_JISKEY_"+KEY);
+			}
+			if(TOWNS_JISKEY_NULL==input.townsKey)
+			{
+				std::cout << "Line " << lineNum << ": Unknown key " << argv[2] << std::endl;
+				return false;
+			}
+		}
+		else if("MOUSE"==CMD && 4<=argv.size())
+		{
+			input.type=INPUT_MOUSE;
+			input.mx=cpputil::Atoi(argv[2].c_str());
+			input.my=cpputil::Atoi(argv[3].c_str());
+			for(size_t i=4; i<argv.size(); ++i)
+			{
+				auto BTN=argv[i];
+				cpputil::Capitalize(BTN);
+				if("LB"==BTN)
+				{
+					input.lb=true;
+				}
+				else if("RB"==BTN)
+				{
+					input.rb=true;
+				}
+			}
+		}
+		else if("CMD"==CMD && 3<=argv.size())
+		{
+			// Take the rest of the line as is so that the command keeps its own quotes and spaces.
+			auto pos=line.find(argv[1]);
+			pos=line.find_first_not_of(" \t",pos+argv[1].size());
+			input.type=INPUT_COMMAND;
+			input.cmd=line.substr(pos);
+		}
+		else
+		{
+			std::cout << "Line " << lineNum << ": Syntax error." << std::endl;
+			return false;
+		}
+		inputScript.push_back(input);
+	}
+
+	std::stable_sort(inputScript.begin(),inputScript.end(),[](const ScriptedInput &a,const ScriptedInput &b)
+	{
+		return a.townsTime<b.townsTime;
+	});
+	return true;
+}
+
+/* virtual */ void HeadlessConnection::Start(void)
+{
+}
+/* virtual */ void HeadlessConnection::Stop(void)
+{
+}
+/* virtual */ void HeadlessConnection::DevicePolling(class FMTownsCommon &towns)
+{
+	if(true!=townsTime0Set)
+	{
+		townsTime0=towns.state.townsTime;
+		townsTime0Set=true;
+	}
+
+	auto townsTime=towns.state.townsTime-townsTime0;
+	while(inputScriptPtr<inputScript.size() && inputScript[inputScriptPtr].townsTime<=townsTime)
+	{
+		auto &input=inputScript[inputScriptPtr];
+		switch(input.type)
+		{
+		case INPUT_KEY_PRESS:
+			towns.keyboard.PushFifo(TOWNS_KEYFLAG_JIS_PRESS,input.townsKey);
+			break;
+		case INPUT_KEY_RELEASE:
+			towns.keyboard.PushFifo(TOWNS_KEYFLAG_JIS_RELEASE,input.townsKey);
+			break;
+		case INPUT_MOUSE:
+			mouseControlled=true;
+			mouseGoalX=input.mx;
+			mouseGoalY=input.my;
+			towns.SetMouseButtonState(input.lb,input.rb);
+			break;
+		case INPUT_COMMAND:
+			commandQueue.push(input.cmd);
+			break;
+		}
+		++inputScriptPtr;
+	}
+
+	// ControlMouseInVMCoord moves the pointer gradually.  Keep steering until it reaches the goal.
+	if(true==mouseControlled)
+	{
+		towns.ControlMouseInVMCoord(mouseGoalX,mouseGoalY,towns.state.tbiosVersion);
+	}
+}
+/* virtual */ bool HeadlessConnection::ImageNeedsFlip(void)
+{
+	return false;
+}
+/* virtual */ void HeadlessConnection::SetKeyboardLayout(unsigned int layout)
+{
+}
+
+
+
+void HeadlessConnection::WindowConnection::Start(void)
+{
+}
+void HeadlessConnection::WindowConnection::Stop(void)
+{
+}
+void HeadlessConnection::WindowConnection::Interval(void)
+{
+	{
+		std::lock_guard <std::mutex> lock(deviceStateLock);
+		winThr.VMClosed=shared.VMClosedFromVMThread;
+	}
+
+	BaseInterval();
+	if(true==winThr.newImageRendered)
+	{
+		++numFramesRendered;
+		if(true==hashFrames)
+		{
+			auto &img=winThr.mostRecentImage;
+			auto hash=TownsFrameCapture::HashImage(img.wid,img.hei,img.rgba.data());
+			frameHash=frameHash*1099511628211ULL^hash;
+		}
+		winThr.newImageRendered=false;
+	}
+}
+void HeadlessConnection::WindowConnection::Render(bool swapBuffers)
+{
+}
+void HeadlessConnection::WindowConnection::UpdateImage(TownsRender::ImageCopy &img)
+{
+	std::lock_guard <std::mutex> lock(renderingLock);
+	std::swap(winThr.mostRecentImage,img);
+}
+void HeadlessConnection::WindowConnection::Communicate(Outside_World *)
+{
+}
+
+Outside_World::WindowInterface *HeadlessConnection::CreateWindowInterface(void) const
+{
+	return new WindowConnection;
+}
+void HeadlessConnection::DeleteWindowInterface(Outside_World::WindowInterface *ptr) const
+{
+	auto *windowPtr=dynamic_cast <WindowConnection *>(ptr);
+	if(nullptr!=windowPtr)
+	{
+		delete windowPtr;
+	}
+}
+
+
+
+long long int HeadlessConnection::SoundConnection::Now(void) const
+{
+	if(nullptr!=townsTimePtr)
+	{
+		return *townsTimePtr;
+	}
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+/* static */ long long int HeadlessConnection::SoundConnection::SamplesToNanoSec(unsigned long long int numSamples,unsigned int samplingRate)
+{
+	if(0==samplingRate)
+	{
+		return 0;
+	}
+	return (long long int)(numSamples*1000000000ULL/samplingRate);
+}
+void HeadlessConnection::SoundConnection::Start(void)
+{
+}
+void HeadlessConnection::SoundConnection::Stop(void)
+{
+	CDDAStop();
+	FMPCMPlayStop();
+	BeepPlayStop();
+}
+void HeadlessConnection::SoundConnection::Polling(void)
+{
+	CDDAIsPlaying();
+}
+
+void HeadlessConnection::SoundConnection::CDDAPlay(const DiscImage &discImg,DiscImage::MinSecFrm from,DiscImage::MinSecFrm to,bool repeat,unsigned int,unsigned int)
+{
+	// The wave is not read from the disc image.  Only the length matters.
+	CDDAStop();
+	cddaStartHSG=from.ToHSG();
+	cddaEndHSG=to.ToHSG();
+	if(cddaEndHSG<=cddaStartHSG)
+	{
+		return;
+	}
+	cddaRepeat=repeat;
+	cddaPlaying=true;
+	cddaPaused=false;
+	cddaStartTime=Now();
+}
+void HeadlessConnection::SoundConnection::CDDASetVolume(float leftVol,float rightVol)
+{
+}
+void HeadlessConnection::SoundConnection::CDDAStop(void)
+{
+	if(true==cddaPlaying)
+	{
+		auto endTime=(true==cddaPaused ? cddaPauseTime : Now());
+		numCDDASamples+=(endTime-cddaStartTime)*WAVE_SAMPLING_RATE/1000000000LL;
+	}
+	cddaPlaying=false;
+	cddaPaused=false;
+}
+void HeadlessConnection::SoundConnection::CDDAPause(void)
+{
+	if(true==cddaPlaying && true!=cddaPaused)
+	{
+		cddaPauseTime=Now();
+		cddaPaused=true;
+	}
+}
+void HeadlessConnection::SoundConnection::CDDAResume(void)
+{
+	if(true==cddaPlaying && true==cddaPaused)
+	{
+		cddaStartTime+=Now()-cddaPauseTime;
+		cddaPaused=false;
+	}
+}
+bool HeadlessConnection::SoundConnection::CDDAIsPlaying(void)
+{
+	if(true==cddaPlaying && true!=cddaPaused && true!=cddaRepeat)
+	{
+		auto length=SamplesToNanoSec(cddaEndHSG-cddaStartHSG,CDDA_FRAMES_PER_SEC);
+		if(cddaStartTime+length<=Now())
+		{
+			numCDDASamples+=(unsigned long long int)(cddaEndHSG-cddaStartHSG)*WAVE_SAMPLING_RATE/CDDA_FRAMES_PER_SEC;
+			cddaPlaying=false;
+		}
+	}
+	return cddaPlaying;
+}
+DiscImage::MinSecFrm HeadlessConnection::SoundConnection::CDDACurrentPosition(void)
+{
+	unsigned int HSG=cddaStartHSG;
+	if(true==cddaPlaying)
+	{
+		auto endTime=(true==cddaPaused ? cddaPauseTime : Now());
+		auto lengthHSG=cddaEndHSG-cddaStartHSG;
+		auto playedHSG=(unsigned int)((endTime-cddaStartTime)*CDDA_FRAMES_PER_SEC/1000000000LL);
+		if(true==cddaRepeat)
+		{
+			playedHSG%=lengthHSG;
+		}
+		HSG+=std::min(playedHSG,lengthHSG);
+	}
+
+	DiscImage::MinSecFrm msf;
+	msf.FromHSG(HSG);
+	return msf;
+}
+
+void HeadlessConnection::SoundConnection::FMPCMPlay(std::vector <unsigned char> &wave)
+{
+	auto numSamples=wave.size()/BYTES_PER_SAMPLE;
+	numFMPCMSamples+=numSamples;
+	FMPCMEndTime=std::max(FMPCMEndTime,Now())+SamplesToNanoSec(numSamples,WAVE_SAMPLING_RATE);
+}
+void HeadlessConnection::SoundConnection::FMPCMPlayStop(void)
+{
+	FMPCMEndTime=0;
+}
+bool HeadlessConnection::SoundConnection::FMPCMChannelPlaying(void)
+{
+	return Now()<FMPCMEndTime;
+}
+
+void HeadlessConnection::SoundConnection::BeepPlay(int samplingRate, std::vector<unsigned char> &wave)
+{
+	auto numSamples=wave.size()/BYTES_PER_SAMPLE;
+	numBeepSamples+=numSamples;
+	beepEndTime=std::max(beepEndTime,Now())+SamplesToNanoSec(numSamples,samplingRate);
+}
+void HeadlessConnection::SoundConnection::BeepPlayStop()
+{
+	beepEndTime=0;
+}
+bool HeadlessConnection::SoundConnection::BeepChannelPlaying() const
+{
+	return Now()<beepEndTime;
+}
+
+unsigned long long int HeadlessConnection::SoundConnection::GetNumSamples(void) const
+{
+	return numFMPCMSamples+numBeepSamples+numCDDASamples;
+}
+
+Outside_World::Sound *HeadlessConnection::CreateSound(void) const
+{
+	return new SoundConnection;
+}
+void HeadlessConnection::DeleteSound(Sound *ptr) const
+{
+	auto *soundPtr=dynamic_cast <SoundConnection *>(ptr);
+	if(nullptr!=soundPtr)
+	{
+		delete soundPtr;
+	}
+}
@@ -0,0 +1,165 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#ifndef HEADLESS_CONNECTION_IS_INCLUDED
+#define HEADLESS_CONNECTION_IS_INCLUDED
+/* { */
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include "outside_world.h"
+
+/*! Outside_World that does not need a window system or a sound device.
+    Images are rendered into memory and optionally hashed, audio is counted and dropped,
+    and keyboard/mouse input comes from a script keyed on townsTime.
+    Used for benchmarking and automated runs.
+*/
+class HeadlessConnection : public Outside_World
+{
+public:
+	enum
+	{
+		INPUT_KEY_PRESS,
+		INPUT_KEY_RELEASE,
+		INPUT_MOUSE,
+		INPUT_COMMAND,
+	};
+
+	/*! One scripted input.  townsTime is in nano seconds relative to the first DevicePolling.
+	*/
+	class ScriptedInput
+	{
+	public:
+		long long int townsTime=0;
+		unsigned int type=INPUT_KEY_PRESS;
+		unsigned int townsKey=0;
+		int mx=0,my=0;
+		bool lb=false,rb=false;
+		std::string cmd;
+	};
+
+	std::vector <ScriptedInput> inputScript;
+	size_t inputScriptPtr=0;
+	bool townsTime0Set=false;
+	long long int townsTime0=0;
+
+	bool mouseControlled=false;
+	int mouseGoalX=0,mouseGoalY=0;
+
+	/*! Loads an input script.  Each line is:
+	      <ms> KEYPRESS <key>
+	      <ms> KEYRELEASE <key>
+	      <ms> MOUSE <x> <y> [LB] [RB]
+	      <ms> CMD <command line>
+	    <ms> is milliseconds of townsTime from the first device polling.  Key labels are the ones
+	    taken by TownsStrToKeyCode, and the TOWNS_JISKEY_ prefix can be omitted.  A line starting with '#' is a comment.
+	    Returns false if the file cannot be opened or has a syntax error.
+	*/
+	bool LoadInputScript(std::string fName);
+	bool LoadInputScript(const std::vector <std::string> &text);
+
+	virtual void Start(void) override;
+	virtual void Stop(void) override;
+	virtual void DevicePolling(class FMTownsCommon &towns) override;
+	virtual bool ImageNeedsFlip(void) override;
+	virtual void SetKeyboardLayout(unsigned int layout) override;
+
+
+
+	class WindowConnection : public WindowInterface
+	{
+	public:
+		/*! If true, every rendered frame is hashed and the hashes are chained into frameHash.
+		*/
+		bool hashFrames=false;
+
+		// Accessed only in the Window thread.
+		unsigned long long int numFramesRendered=0;
+		uint64_t frameHash=0;
+
+		void Start(void) override;
+		void Stop(void) override;
+		void Interval(void) override;
+		void Render(bool swapBuffers) override;
+		void UpdateImage(TownsRender::ImageCopy &img) override;
+		void Communicate(Outside_World *) override;
+	};
+	WindowInterface *CreateWindowInterface(void) const override;
+	void DeleteWindowInterface(WindowInterface *) const override;
+
+
+
+	/*! Sound sink that drops waves and counts samples.
+	    TownsSound feeds the next FM/PCM segment when the channel is not playing.  To produce sound at the
+	    same pace as the real device, a segment is considered playing for its duration measured in townsTime.
+	    If townsTimePtr is not set, the duration is measured in real time.
+	*/
+	class SoundConnection : public Sound
+	{
+	public:
+		enum
+		{
+			WAVE_SAMPLING_RATE=44100,
+			BYTES_PER_SAMPLE=4,  // 16-bit stereo.
+			CDDA_FRAMES_PER_SEC=75,
+		};
+
+		const long long int *townsTimePtr=nullptr;
+
+		unsigned long long int numFMPCMSamples=0;
+		unsigned long long int numBeepSamples=0;
+		unsigned long long int numCDDASamples=0;
+
+		long long int FMPCMEndTime=0;
+		long long int beepEndTime=0;
+
+		bool cddaPlaying=false,cddaPaused=false,cddaRepeat=false;
+		unsigned int cddaStartHSG=0,cddaEndHSG=0;
+		long long int cddaStartTime=0,cddaPauseTime=0;
+
+		long long int Now(void) const;
+		static long long int SamplesToNanoSec(unsigned long long int numSamples,unsigned int samplingRate);
+
+		void Start(void) override;
+		void Stop(void) override;
+		void Polling(void) override;
+
+		void CDDAPlay(const DiscImage &discImg,DiscImage::MinSecFrm from,DiscImage::MinSecFrm to,bool repeat,unsigned int,unsigned int) override;
+		void CDDASetVolume(float leftVol,float rightVol) override;
+		void CDDAStop(void) override;
+		void CDDAPause(void) override;
+		void CDDAResume(void) override;
+		bool CDDAIsPlaying(void) override;
+		DiscImage::MinSecFrm CDDACurrentPosition(void) override;
+
+		void FMPCMPlay(std::vector <unsigned char> &wave) override;
+		void FMPCMPlayStop(void) override;
+		bool FMPCMChannelPlaying(void) override;
+
+		void BeepPlay(int samplingRate, std::vector<unsigned char> &wave) override;
+		void BeepPlayStop() override;
+		bool BeepChannelPlaying() const override;
+
+		/*! Total number of audio samples produced, including the CDDA samples played so far.
+		*/
+		unsigned long long int GetNumSamples(void) const;
+	};
+	Sound *CreateSound(void) const override;
+	void DeleteSound(Sound *) const override;
+};
+
+/* } */
+#endif
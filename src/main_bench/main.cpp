@@ -0,0 +1,326 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "towns.h"
+#include "townsthread.h"
+#include "townscommand.h"
+#include "townsargv.h"
+#include "cpputil.h"
+
+#include "headless_connection.h"
+
+
+
+class BenchParameters
+{
+public:
+	enum
+	{
+		DEFAULT_BENCH_TIME_MS=10000,
+	};
+	long long int benchTimeInMS=DEFAULT_BENCH_TIME_MS;
+	bool hashFrames=false;
+	std::string inputScriptFName;
+
+	/*! Takes bench-specific options out of the command parameters.
+	    Remaining parameters are returned in passThrough for TownsARGV.
+	*/
+	bool AnalyzeCommandParameter(std::vector <char *> &passThrough,int ac,char *av[]);
+	static void PrintHelp(void);
+};
+
+bool BenchParameters::AnalyzeCommandParameter(std::vector <char *> &passThrough,int ac,char *av[])
+{
+	passThrough.clear();
+	passThrough.push_back(av[0]);
+	for(int i=1; i<ac; ++i)
+	{
+		std::string ARG=av[i];
+		cpputil::Capitalize(ARG);
+		if("-BENCHTIME"==ARG && i+1<ac)
+		{
+			benchTimeInMS=cpputil::Atoi(av[i+1]);
+			if(benchTimeInMS<=0)
+			{
+				std::cout << "-BENCHTIME must be positive." << std::endl;
+				return false;
+			}
+			++i;
+		}
+		else if("-BENCHHASH"==ARG)
+		{
+			hashFrames=true;
+		}
+		else if("-BENCHSCRIPT"==ARG && i+1<ac)
+		{
+			inputScriptFName=av[i+1];
+			++i;
+		}
+		else if("-HELP"==ARG || "-H"==ARG || "-?"==ARG)
+		{
+			PrintHelp();
+			passThrough.push_back(av[i]);
+		}
+		else
+		{
+			passThrough.push_back(av[i]);
+		}
+	}
+	passThrough.push_back(nullptr);
+	return true;
+}
+
+/* static */ void BenchParameters::PrintHelp(void)
+{
+	std::cout << "Usage: tsugaru_bench ROM_directory -LOADSTATE stateFName.TState [bench options] [Tsugaru options]" << std::endl;
+	std::cout << "Runs the VM without waits for a fixed span of VM time and reports the performance." << std::endl;
+	std::cout << "-BENCHTIME ms" << std::endl;
+	std::cout << "  Span of VM time (townsTime) to run in milliseconds.  Default " << DEFAULT_BENCH_TIME_MS << "." << std::endl;
+	std::cout << "-BENCHHASH" << std::endl;
+	std::cout << "  Hash rendered frames and print the chained hash at the end." << std::endl;
+	std::cout << "-BENCHSCRIPT filename" << std::endl;
+	std::cout << "  Scripted input.  Each line is one of:" << std::endl;
+	std::cout << "    ms KEYPRESS key" << std::endl;
+	std::cout << "    ms KEYRELEASE key" << std::endl;
+	std::cout << "    ms MOUSE x y [LB] [RB]" << std::endl;
+	std::cout << "    ms CMD command" << std::endl;
+	std::cout << "  ms is VM time in milliseconds from the start of the run." << std::endl;
+	std::cout << "Other options are the same as Tsugaru_CUI." << std::endl;
+	std::cout << std::endl;
+}
+
+
+
+class BenchResult
+{
+public:
+	bool started=false,finished=false;
+	long long int townsTime0=0,townsTime1=0;
+	uint64_t instructionCount0=0,instructionCount1=0;
+	i486DXCommon::MemoryWindowStatistics memWinStats0,memWinStats1;
+	std::chrono::time_point<std::chrono::steady_clock> wallTime0,wallTime1;
+	std::clock_t CPUTime0=0,CPUTime1=0;
+
+	void Begin(const FMTownsCommon &towns);
+	void End(const FMTownsCommon &towns);
+	void Print(const HeadlessConnection::WindowConnection &window,const HeadlessConnection::SoundConnection &sound,bool hashFrames) const;
+};
+
+void BenchResult::Begin(const FMTownsCommon &towns)
+{
+	townsTime0=towns.state.townsTime;
+	instructionCount0=towns.var.instructionCount;
+	memWinStats0=towns.CPU().memWinStats;
+	wallTime0=std::chrono::steady_clock::now();
+	CPUTime0=std::clock();
+	started=true;
+}
+void BenchResult::End(const FMTownsCommon &towns)
+{
+	townsTime1=towns.state.townsTime;
+	instructionCount1=towns.var.instructionCount;
+	memWinStats1=towns.CPU().memWinStats;
+	wallTime1=std::chrono::steady_clock::now();
+	CPUTime1=std::clock();
+	finished=true;
+}
+void BenchResult::Print(const HeadlessConnection::WindowConnection &window,const HeadlessConnection::SoundConnection &sound,bool hashFrames) const
+{
+	if(true!=started)
+	{
+		std::cout << "VM did not start." << std::endl;
+		return;
+	}
+
+	double townsSec=(double)(townsTime1-townsTime0)/1000000000.0;
+	double wallSec=std::chrono::duration_cast<std::chrono::microseconds>(wallTime1-wallTime0).count()/1000000.0;
+	double CPUSec=(double)(CPUTime1-CPUTime0)/(double)CLOCKS_PER_SEC;
+	auto numInst=instructionCount1-instructionCount0;
+
+	std::cout << "VM Time:           " << townsSec << " sec" << std::endl;
+	std::cout << "Wall Time:         " << wallSec << " sec" << std::endl;
+	std::cout << "Host CPU Time:     " << CPUSec << " sec" << std::endl;
+	std::cout << "Instructions:      " << numInst << std::endl;
+	if(0.0<wallSec)
+	{
+		std::cout << "Guest MIPS:        " << (double)numInst/wallSec/1000000.0 << std::endl;
+		std::cout << "VM/Wall Time:      " << townsSec/wallSec << std::endl;
+	}
+	std::cout << "Frames Rendered:   " << window.numFramesRendered << std::endl;
+	std::cout << "Frame Buffers:" << std::endl;
+	std::cout << "  Allocated:       " << window.frameBufferPool.numAllocated << std::endl;
+	std::cout << "  Reused:          " << window.frameBufferPool.numTaken << std::endl;
+	std::cout << "  Returned:        " << window.frameBufferPool.numReturned << std::endl;
+	std::cout << "  Dropped:         " << window.frameBufferPool.numDropped << std::endl;
+	std::cout << "Audio Samples:     " << sound.GetNumSamples() << std::endl;
+	std::cout << "  FM/PCM:          " << sound.numFMPCMSamples << std::endl;
+	std::cout << "  Beep:            " << sound.numBeepSamples << std::endl;
+	std::cout << "  CDDA:            " << sound.numCDDASamples << std::endl;
+	for(auto str : memWinStats1.Since(memWinStats0).GetStatusText())
+	{
+		std::cout << str << std::endl;
+	}
+	if(true==hashFrames)
+	{
+		std::cout << "Frame Hash:        " << cpputil::Uitox((unsigned int)(window.frameHash>>32)) << cpputil::Uitox((unsigned int)window.frameHash) << std::endl;
+	}
+	if(true!=finished)
+	{
+		std::cout << "VM stopped before the end of the bench span." << std::endl;
+	}
+}
+
+
+
+class BenchUIThread : public TownsUIThread
+{
+public:
+	TownsCommandInterpreter cmdInterpreter;
+	long long int benchTime=0;
+	BenchResult result;
+
+	virtual void Main(TownsThread &vmThread,FMTownsCommon &towns,const TownsARGV &argv,Outside_World &outside_world) override;
+	virtual void ExecCommandQueue(TownsThread &vmThread,FMTownsCommon &towns,Outside_World *outside_world,Outside_World::Sound *sound) override;
+};
+
+/* virtual */ void BenchUIThread::Main(TownsThread &townsThread,FMTownsCommon &towns,const TownsARGV &argv,Outside_World &outside_world)
+{
+}
+
+/* virtual */ void BenchUIThread::ExecCommandQueue(TownsThread &townsThread,FMTownsCommon &towns,Outside_World *outside_world,Outside_World::Sound *sound)
+{
+	// ExecCommandQueue is first called after VMStart loaded the state.  Start measuring there.
+	if(true!=result.started)
+	{
+		result.Begin(towns);
+	}
+
+	while(true!=outside_world->commandQueue.empty())
+	{
+		auto cmd=cmdInterpreter.Interpret(outside_world->commandQueue.front());
+		cmdInterpreter.Execute(townsThread,towns,outside_world,sound,cmd);
+		outside_world->commandQueue.pop();
+	}
+
+	if(true!=result.finished)
+	{
+		if(result.townsTime0+benchTime<=towns.state.townsTime)
+		{
+			result.End(towns);
+			townsThread.SetRunMode(TownsThread::RUNMODE_EXIT);
+		}
+		else if(TownsThread::RUNMODE_EXIT==townsThread.GetRunMode())
+		{
+			result.End(towns);
+			result.finished=false;
+		}
+	}
+}
+
+
+
+template <class CPUCLASS>
+int Run(FMTownsTemplate <CPUCLASS> &towns,const TownsARGV &argv,const BenchParameters &benchParam,HeadlessConnection &outside_world,HeadlessConnection::SoundConnection &sound,HeadlessConnection::WindowConnection &window)
+{
+	TownsThread townsThread;
+	towns.DisableDebugger();
+	townsThread.SetRunMode(TownsThread::RUNMODE_RUN);
+
+	sound.townsTimePtr=&towns.state.townsTime;
+	window.hashFrames=benchParam.hashFrames;
+
+	BenchUIThread benchThread;
+	benchThread.benchTime=benchParam.benchTimeInMS*1000000;
+
+	std::thread UIThread(&BenchUIThread::Run,&benchThread,&townsThread,&towns,&argv,&outside_world);
+
+	std::thread VMThread([&]{
+		townsThread.VMStart(&towns,&outside_world,&benchThread);
+		townsThread.VMMainLoop(&towns,&outside_world,&sound,&window,&benchThread);
+		townsThread.VMEnd(&towns,&outside_world,&benchThread);
+	});
+
+	window.ClearVMClosedFlag();
+	while(true!=window.CheckVMClosed())
+	{
+		window.Interval();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	VMThread.join();
+	UIThread.join();
+
+	benchThread.result.Print(window,sound,benchParam.hashFrames);
+
+	return (true==benchThread.result.finished ? 0 : 1);
+}
+
+int main(int ac,char *av[])
+{
+	BenchParameters benchParam;
+	std::vector <char *> passThrough;
+	if(true!=benchParam.AnalyzeCommandParameter(passThrough,ac,av))
+	{
+		return 1;
+	}
+
+	TownsARGV argv;
+	if(true!=argv.AnalyzeCommandParameter((int)passThrough.size()-1,passThrough.data()))
+	{
+		return 1;
+	}
+
+	// Run as fast as possible.  Fast-forwarding the VM timer to the real time would make the result depend on the host.
+	argv.noWait=true;
+	argv.noWaitStandby=false;
+	argv.catchUpRealTime=false;
+	argv.autoStart=true;
+	argv.interactive=false;
+
+	auto *outside_world=new HeadlessConnection;
+	if(""!=benchParam.inputScriptFName && true!=outside_world->LoadInputScript(benchParam.inputScriptFName))
+	{
+		return 1;
+	}
+	auto *sound=dynamic_cast <HeadlessConnection::SoundConnection *>(outside_world->CreateSound());
+	auto *window=dynamic_cast <HeadlessConnection::WindowConnection *>(outside_world->CreateWindowInterface());
+	if(i486DXCommon::HIGH_FIDELITY==argv.CPUFidelityLevel)
+	{
+		static FMTownsTemplate <i486DXHighFidelity> towns;
+		if(true!=FMTownsCommon::Setup(towns,outside_world,window,argv))
+		{
+			return 1;
+		}
+		window->Start();
+		return Run(towns,argv,benchParam,*outside_world,*sound,*window);
+	}
+	else
+	{
+		static FMTownsTemplate <i486DXDefaultFidelity> towns;
+		if(true!=FMTownsCommon::Setup(towns,outside_world,window,argv))
+		{
+			return 1;
+		}
+		window->Start();
+		return Run(towns,argv,benchParam,*outside_world,*sound,*window);
+	}
+}
@@ -207,6 +207,9 @@ void TownsARGV::PrintHelp(void) const
 	std::cout << "  Specify symbol file name." << std::endl;
 	std::cout << "-EVTLOG filename" << std::endl;
 	std::cout << "  Load and play-back event log." << std::endl;
+	std::cout << "-EVTLOGTOWNSTIME" << std::endl;
+	std::cout << "  Play back the -EVTLOG event log by the VM time instead of the wall-clock time." << std::endl;
+	std::cout << "  Events land at the same emulated time even with -NOWAIT." << std::endl;
 	std::cout << "-HOST2VM hostFileName vmFileName" << std::endl;
 	std::cout << "  Schedule Host to VM file transfer." << std::endl;
 	std::cout << "  File will be transferred when FTCLIENT.EXP is running." << std::endl;
@@ -236,8 +239,26 @@ void TownsARGV::PrintHelp(void) const
 	std::cout << "-FMVOL volume" << std::endl;
 	std::cout << "-PCMVOL volume" << std::endl;
 	std::cout << "  Specify FM/PCM volume.  Volume will be rounded to 0 to 8192." << std::endl;
+	std::cout << "-MIXGAIN source gain" << std::endl;
+	std::cout << "  Specify mixer gain.  source is FM, PCM, HIRES, CDDA, WAVIN, or MASTER." << std::endl;
+	std::cout << "  4096 is 1.0.  Gain will be rounded to 0 to 32767.  Can be used multiple times." << std::endl;
 	std::cout << "-MAXSNDDBLBUF" << std::endl;
 	std::cout << "  Try this option if the sound is choppy or hear static noise." << std::endl;
+	std::cout << "-FMTHREAD" << std::endl;
+	std::cout << "  Synthesize YM2612 FM sound in a separate thread." << std::endl;
+	std::cout << "-DEVTHREAD" << std::endl;
+	std::cout << "  Render sprites and read ahead CD-ROM data sectors in a separate thread." << std::endl;
+	std::cout << "-BLOCKOP" << std::endl;
+	std::cout << "  Run REP MOVS and REP STOS (block moves and fills of BIOS and DOS) by host memcpy/memset." << std::endl;
+	std::cout << "-BLOCKOPVERIFY" << std::endl;
+	std::cout << "  Same as -BLOCKOP, but runs the instruction also one element at a time, and reports if the results differ." << std::endl;
+	std::cout << "-HOSTSVC" << std::endl;
+	std::cout << "  Read files on the Tsugaru Drive (INT 21H AH=3FH) by the host, without running DOS." << std::endl;
+	std::cout << "-HOSTSVCVERIFY" << std::endl;
+	std::cout << "  Let DOS read the files, and report if the result differs from what -HOSTSVC would return." << std::endl;
+	std::cout << "-RASTERLOG" << std::endl;
+	std::cout << "  Log mid-frame palette and layer changes, and render the screen band by band." << std::endl;
+	std::cout << "  Split-screen and palette-change effects may look right.  ChaseHQ special palette is bypassed." << std::endl;
 	std::cout << "-DAMPERWIRELINE" << std::endl;
 	std::cout << "  Render damper-wire line to make you feel nostalgic." << std::endl;
 	std::cout << "-TOWNSTYPE" << std::endl;
@@ -249,6 +270,13 @@ void TownsARGV::PrintHelp(void) const
 	std::cout << "  Use exit(0) to exit the program on power off." << std::endl;
 	std::cout << "-LOADSTATE stateFName.TState" << std::endl;
 	std::cout << "  Load specified state file on start-up." << std::endl;
+	std::cout << "-BOOTSNAPSHOT dir" << std::endl;
+	std::cout << "  Save the state when the boot reaches the snapshot point in the directory, and" << std::endl;
+	std::cout << "  resume from it next time with the same ROM, CMOS, media images, and settings." << std::endl;
+	std::cout << "  Ignored if -LOADSTATE is given." << std::endl;
+	std::cout << "-BOOTSNAPSHOTAT KEYWAIT|SEG:OFFSET" << std::endl;
+	std::cout << "  Snapshot point.  KEYWAIT (default) takes the first time the guest keeps polling" << std::endl;
+	std::cout << "  the keyboard without a key.  Or give CS:EIP." << std::endl;
 
 	std::cout << "-QUICKSSDIR dir" << std::endl;
 	std::cout << "  Specify quick screen shot directory." << std::endl;
@@ -712,6 +740,10 @@ bool TownsARGV::AnalyzeCommandParameter(int argc,char *argv[])
 			playbackEventLogFName=argv[i+1];
 			++i;
 		}
+		else if("-EVTLOGTOWNSTIME"==ARG)
+		{
+			playbackEventLogInTownsTime=true;
+		}
 		else if("-HOST2VM"==ARG && i+2<argc)
 		{
 			if(true==cpputil::FileExists(argv[i+1]))
@@ -848,6 +880,37 @@ bool TownsARGV::AnalyzeCommandParameter(int argc,char *argv[])
 		{
 			maximumSoundDoubleBuffering=true;
 		}
+		else if("-MIXGAIN"==ARG && 2+i<argc)
+		{
+			mixerGain.push_back(std::pair <std::string,int>(argv[i+1],cpputil::Atoi(argv[i+2])));
+			i+=2;
+		}
+		else if("-FMTHREAD"==ARG)
+		{
+			FMSynthesisThread=true;
+		}
+		else if("-DEVTHREAD"==ARG)
+		{
+			deviceThread=true;
+		}
+		else if("-BLOCKOP"==ARG)
+		{
+			hostBlockOp=true;
+		}
+		else if("-BLOCKOPVERIFY"==ARG)
+		{
+			hostBlockOp=true;
+			verifyHostBlockOp=true;
+		}
+		else if("-HOSTSVC"==ARG)
+		{
+			hostService=true;
+		}
+		else if("-HOSTSVCVERIFY"==ARG)
+		{
+			hostService=true;
+			verifyHostService=true;
+		}
 		else if("-ICM"==ARG && i+1<argc)
 		{
 			memCardType=TOWNS_MEMCARD_TYPE_OLD;
@@ -897,6 +960,10 @@ bool TownsARGV::AnalyzeCommandParameter(int argc,char *argv[])
 		{
 			highResAvailable=false;
 		}
+		else if("-RASTERLOG"==ARG)
+		{
+			rasterLog=true;
+		}
 		else if("-DAMPERWIRELINE"==ARG)
 		{
 			damperWireLine=true;
@@ -919,6 +986,17 @@ bool TownsARGV::AnalyzeCommandParameter(int argc,char *argv[])
 			startUpStateFName=argv[i+1];
 			++i;
 		}
+		else if("-BOOTSNAPSHOT"==ARG && i+1<argc)
+		{
+			bootSnapshotDir=argv[i+1];
+			++i;
+		}
+		else if("-BOOTSNAPSHOTAT"==ARG && i+1<argc)
+		{
+			bootSnapshotAt=argv[i+1];
+			cpputil::Capitalize(bootSnapshotAt);
+			++i;
+		}
 		else if("-QUICKSSDIR"==ARG && i+1<argc)
 		{
 			quickScrnShotDir=argv[i+1];
@@ -121,6 +121,7 @@ TownsCommandInterpreter::TownsCommandInterpreter()
 	primaryCmdMap["PLAYEVT"]=CMD_PLAY_EVENTLOG;
 	primaryCmdMap["STOPEVT"]=CMD_STOP_EVENTLOG;
 	primaryCmdMap["MAKEREPEATEVENTLOG"]=CMD_MAKE_REPEAT_EVENTLOG;
+	primaryCmdMap["CONVEVT"]=CMD_CONVERT_EVENTLOG;
 
 	primaryCmdMap["SYM"]=CMD_PRINT_SYMBOL;
 	primaryCmdMap["SYMLAB"]=CMD_PRINT_SYMBOL_LABEL_PROC;
@@ -139,6 +140,7 @@ TownsCommandInterpreter::TownsCommandInterpreter()
 
 	primaryCmdMap["FMVOL"]=CMD_FMVOL;
 	primaryCmdMap["PCMVOL"]=CMD_PCMVOL;
+	primaryCmdMap["MIXGAIN"]=CMD_MIXGAIN;
 	primaryCmdMap["LOADWAV"]=CMD_LOADWAV;
 	primaryCmdMap["SENDWAV"]=CMD_LOADWAV;
 
@@ -216,6 +218,8 @@ TownsCommandInterpreter::TownsCommandInterpreter()
 	primaryCmdMap["STARTVGMREC"]=CMD_START_VGM_RECORDING;
 	primaryCmdMap["ENDVGMREC"]=CMD_END_VGM_RECORDING;
 	primaryCmdMap["SAVEVGMREC"]=CMD_SAVE_VGM_RECORDING;
+	primaryCmdMap["STARTCAPTURE"]=CMD_START_FRAME_CAPTURE;
+	primaryCmdMap["ENDCAPTURE"]=CMD_END_FRAME_CAPTURE;
 
 	primaryCmdMap["SAVEWAVRAM"]=CMD_SAVE_WAVERAM;
 
@@ -313,6 +317,8 @@ TownsCommandInterpreter::TownsCommandInterpreter()
 	dumpableMap["SCHED"]=DUMP_SCHEDULE;
 	dumpableMap["SCHEDULE"]=DUMP_SCHEDULE;
 	dumpableMap["TIMEBALANCE"]=DUMP_TIME_BALANCE;
+	dumpableMap["PACING"]=DUMP_PACING;
+	dumpableMap["MEMWINDOW"]=DUMP_MEMORY_WINDOW;
 	dumpableMap["SPRITE"]=DUMP_SPRITE;
 	dumpableMap["SPRITEAT"]=DUMP_SPRITE_AT;
 	dumpableMap["SPRPAL"]=DUMP_SPRITE_PALETTE;
@@ -331,6 +337,7 @@ TownsCommandInterpreter::TownsCommandInterpreter()
 	dumpableMap["HIGHRESPCM"]=DUMP_HIGHRES_PCM;
 	dumpableMap["HIRESPCM"]=DUMP_HIGHRES_PCM;
 	dumpableMap["SAVESTATEM"]=DUMP_SAVESTATEM;
+	dumpableMap["CAPTURE"]=DUMP_FRAME_CAPTURE;
 
 
 	breakEventMap["ICW1"]=   BREAK_ON_PIC_IWC1;
@@ -365,6 +372,8 @@ TownsCommandInterpreter::TownsCommandInterpreter()
 	breakEventMap["MEMR"]=BREAK_ON_MEM_READ;
 	breakEventMap["MEMWRITE"]=BREAK_ON_MEM_WRITE;
 	breakEventMap["MEMW"]=BREAK_ON_MEM_WRITE;
+	breakEventMap["MEMCHANGE"]=BREAK_ON_MEM_CHANGE;
+	breakEventMap["MEMCHG"]=BREAK_ON_MEM_CHANGE;
 	breakEventMap["BEEP"]=BREAK_ON_BEEP;
 	breakEventMap["PROTECTEDMODE"]=BREAK_ON_PROTECTED_MODE;
 	breakEventMap["REALMODE"]=BREAK_ON_REAL_MODE;
@@ -465,6 +474,7 @@ void TownsCommandInterpreter::PrintHelp(void) const
 	std::cout << "MKMEMFILTERD dwordData" << std::endl;
 	std::cout << "  Make memory filter.  Memory filter caches physical addresses that has the given value." << std::endl;
 	std::cout << "  Data is optional." << std::endl;
+	std::cout << "  Main RAM and sprite RAM are searched.  Add VRAM after the data (or alone) to search VRAM as well." << std::endl;
 	std::cout << "UPDMEMFILTER byteData" << std::endl;
 	std::cout << "  Update memory filter.  Physical addresses that does not have the given value" << std::endl;
 	std::cout << "  are deleted from the memory filter." << std::endl;
@@ -640,6 +650,9 @@ void TownsCommandInterpreter::PrintHelp(void) const
 	std::cout << "  Playback Event Log." << std::endl;
 	std::cout << "STOPEVT" << std::endl;
 	std::cout << "  Stop Playback Event Log." << std::endl;
+	std::cout << "CONVEVT input.txt output.txt" << std::endl;
+	std::cout << "  Convert an event log to be played back by the VM time (townsTime) instead of the wall-clock time." << std::endl;
+	std::cout << "  Converted log plays at the same emulated time regardless of the host speed." << std::endl;
 	
 
 	std::cout << "SS filename.png" << std::endl;
@@ -698,6 +711,13 @@ void TownsCommandInterpreter::PrintHelp(void) const
 	std::cout << "SAVEFMPCMREC filename.wav" << std::endl;
 	std::cout << "  Start/End/Save FM and PCM audio recording." << std::endl;
 
+	std::cout << "STARTCAPTURE prefix [PNG|RAW] [interval] [threads]" << std::endl;
+	std::cout << "ENDCAPTURE" << std::endl;
+	std::cout << "  Start/End capturing every Nth rendered frame in the background." << std::endl;
+	std::cout << "  PNG writes prefixNNNNNN.png for each frame.  RAW appends RGBA frames to prefix.frames." << std::endl;
+	std::cout << "  Frames identical to the previous captured frame are skipped." << std::endl;
+	std::cout << "  Default is PNG, every frame, and as many threads as the host CPU has." << std::endl;
+
 	std::cout << "HOST2VM hostFileName vmFileName" << std::endl;
 	std::cout << "  Schedule Host to VM file transfer." << std::endl;
 	std::cout << "  File will be transferred when FTCLIENT.EXP is executed." << std::endl;
@@ -714,6 +734,11 @@ void TownsCommandInterpreter::PrintHelp(void) const
 	std::cout << "  Enable/Disable YM2612 channels." << std::endl;
 	std::cout << "PCMVOL volume" << std::endl;
 	std::cout << "  Set PCM (RF5C68) volume.  0 to 8192.  Default value is 4096." << std::endl;
+	std::cout << "MIXGAIN source gain" << std::endl;
+	std::cout << "  Set mixer gain.  source is FM, PCM, HIRES, CDDA, WAVIN, or MASTER.  4096 is 1.0.  0 to 32767." << std::endl;
+	std::cout << "  Master gain is applied to the sum of the sources." << std::endl;
+	std::cout << "MIXGAIN" << std::endl;
+	std::cout << "  Print mixer gains and peak levels of the last wave." << std::endl;
 	std::cout << "PCMCH 0/1 0/1 0/1 0/1 0/1 0/1 0/1 0/1" << std::endl;
 	std::cout << "  Enable/Disable PCM channels." << std::endl;
 	std::cout << "LOADWAV filename" << std::endl;
@@ -828,6 +853,11 @@ void TownsCommandInterpreter::PrintHelp(void) const
 	std::cout << "  CD-ROM Status." << std::endl;
 	std::cout << "SCHED" << std::endl;
 	std::cout << "  Device call-back schedule." << std::endl;
+	std::cout << "PACING" << std::endl;
+	std::cout << "  Time-slice length, lag, catch-up, and sleep time of the VM." << std::endl;
+	std::cout << "MEMWINDOW [CLEAR]" << std::endl;
+	std::cout << "  Hit rate of the CS:EIP and SS:ESP memory windows, and the page-table cache.  Counts of the host block operation (-BLOCKOP) and the host service (-HOSTSVC)." << std::endl;
+	std::cout << "  Counters are cleared after printing if CLEAR is given." << std::endl;
 	std::cout << "SPRITE" << std::endl;
 	std::cout << "  Sprite status." << std::endl;
 	std::cout << "SPRITEAT x y" << std::endl;
@@ -865,6 +895,8 @@ void TownsCommandInterpreter::PrintHelp(void) const
 	std::cout << "  CPU TEST registers." << std::endl;
 	std::cout << "SAVESTATEM" << std::endl;
 	std::cout << "  List of memory-saved states." << std::endl;
+	std::cout << "CAPTURE" << std::endl;
+	std::cout << "  Frame capture statistics." << std::endl;
 	std::cout << "" << std::endl;
 
 	std::cout << "<< Event that can break >>" << std::endl;
@@ -904,6 +936,9 @@ void TownsCommandInterpreter::PrintHelp(void) const
 	std::cout << "MEMWRITE addr" << std::endl;
 	std::cout << "MEMWRITE addr DATA=byteData" << std::endl;
 	std::cout << "MEMWRITE addr D=byteData" << std::endl;
+	std::cout << "MEMCHANGE physAddr" << std::endl;
+	std::cout << "MEMCHANGE physAddr0 physAddr1" << std::endl;
+	std::cout << "  Break when a byte is over-written with a different value." << std::endl;
 	std::cout << "BEEP" << std::endl;
 	std::cout << "PROTECTEDMODE" << std::endl;
 	std::cout << "  Entering protected mode." << std::endl;
@@ -999,6 +1034,9 @@ TownsCommandInterpreter::Command TownsCommandInterpreter::Interpret(const std::s
 
 void TownsCommandInterpreter::Execute(TownsThread &thr,FMTownsCommon &towns,class Outside_World *outside_world,class Outside_World::Sound *sound,Command &cmd)
 {
+	// Commands may read or write VRAM, or the state, directly.
+	towns.SyncDeviceThread();
+
 	if(CMD_DISASM!=cmd.primaryCmd && CMD_DISASM16!=cmd.primaryCmd && CMD_DISASM32!=cmd.primaryCmd)
 	{
 		towns.debugger.WriteLogFile(">"+cmd.cmdline);
@@ -1245,6 +1283,9 @@ void TownsCommandInterpreter::Execute(TownsThread &thr,FMTownsCommon &towns,clas
 		printf("Make Event-Log Repeat.\n");
 		towns.eventLog.MakeRepeat();
 		break;
+	case CMD_CONVERT_EVENTLOG:
+		Execute_ConvertEventLog(cmd);
+		break;
 	case CMD_SAVE_KEYMAP:
 		Execute_SaveKeyMap(*outside_world,cmd);
 		break;
@@ -1344,6 +1385,32 @@ void TownsCommandInterpreter::Execute(TownsThread &thr,FMTownsCommon &towns,clas
 		}
 		break;
 
+	case CMD_MIXGAIN:
+		if(3<=cmd.argv.size())
+		{
+			int gain=cpputil::Atoi(cmd.argv[2].c_str());
+			if(gain<0 || TownsSoundMixer::MAX_GAIN<gain)
+			{
+				PrintError(ERROR_WRONG_PARAMETER);
+			}
+			else if(true!=towns.sound.SetMixerGain(cmd.argv[1],gain))
+			{
+				PrintError(ERROR_WRONG_PARAMETER);
+			}
+		}
+		else if(1==cmd.argv.size())
+		{
+			for(auto str : towns.sound.mixer.GetStatusText())
+			{
+				std::cout << str << std::endl;
+			}
+		}
+		else
+		{
+			PrintError(ERROR_TOO_FEW_ARGS);
+		}
+		break;
+
 	case CMD_SAVE_STATE:
 		if(2<=cmd.argv.size())
 		{
@@ -1792,6 +1859,17 @@ void TownsCommandInterpreter::Execute(TownsThread &thr,FMTownsCommon &towns,clas
 		}
 		break;
 
+	case CMD_START_FRAME_CAPTURE:
+		Execute_StartFrameCapture(towns,cmd);
+		break;
+	case CMD_END_FRAME_CAPTURE:
+		towns.frameCapture.Stop();
+		for(auto str : towns.frameCapture.GetStatusText())
+		{
+			std::cout << str << std::endl;
+		}
+		break;
+
 	case CMD_SAVE_WAVERAM:
 		if(2<=cmd.argv.size())
 		{
@@ -2580,6 +2658,43 @@ void TownsCommandInterpreter::Execute_Dump(FMTownsCommon &towns,Command &cmd)
 				std::cout << std::endl;
 			}
 			break;
+		case DUMP_PACING:
+			for(auto str : towns.pacer.GetStatusText())
+			{
+				std::cout << str << std::endl;
+			}
+			break;
+		case DUMP_MEMORY_WINDOW:
+			for(auto str : towns.CPU().memWinStats.GetStatusText())
+			{
+				std::cout << str << std::endl;
+			}
+			std::cout << "Host Block Operation (REP MOVS/STOS)" << std::endl;
+			std::cout << "  Operations:       " << towns.CPU().blockOpCount << std::endl;
+			std::cout << "  Elements:         " << towns.CPU().blockOpElements << std::endl;
+			std::cout << "  Mismatch:         " << towns.CPU().blockOpMismatch << std::endl;
+			std::cout << "Host Service (INT 21H AH=3FH on Tsugaru Drive)" << std::endl;
+			std::cout << "  Calls:            " << towns.var.hostServiceCount << std::endl;
+			std::cout << "  Bytes:            " << towns.var.hostServiceBytes << std::endl;
+			std::cout << "  Verified:         " << towns.var.hostServiceVerified << std::endl;
+			std::cout << "  Mismatch:         " << towns.var.hostServiceMismatch << std::endl;
+			if(3<=cmd.argv.size())
+			{
+				auto ARGV2=cmd.argv[2];
+				cpputil::Capitalize(ARGV2);
+				if("CLEAR"==ARGV2)
+				{
+					towns.CPU().memWinStats.Clear();
+					towns.CPU().blockOpCount=0;
+					towns.CPU().blockOpElements=0;
+					towns.CPU().blockOpMismatch=0;
+					towns.var.hostServiceCount=0;
+					towns.var.hostServiceBytes=0;
+					towns.var.hostServiceVerified=0;
+					towns.var.hostServiceMismatch=0;
+				}
+			}
+			break;
 		case DUMP_SPRITE:
 			for(auto str : towns.sprite.GetStatusText(towns.physMem.state.spriteRAM))
 			{
@@ -2747,6 +2862,12 @@ void TownsCommandInterpreter::Execute_Dump(FMTownsCommon &towns,Command &cmd)
 				std::cout << str << std::endl;
 			}
 			break;
+		case DUMP_FRAME_CAPTURE:
+			for(auto str : towns.frameCapture.GetStatusText())
+			{
+				std::cout << str << std::endl;
+			}
+			break;
 		}
 	}
 	else
@@ -3586,10 +3707,7 @@ void TownsCommandInterpreter::Execute_BreakOn(FMTownsCommon &towns,Command &cmd)
 				{
 					std::swap(addr0,addr1);
 				}
-				for(auto addr=addr0; addr<=addr1; ++addr)
-				{
-					i486DebugMemoryAccess::SetBreakOnMemRead(towns.mem,towns.debugger,addr);
-				}
+				i486DebugMemoryAccess::SetBreakOnMemReadRange(towns.mem,towns.debugger,addr0,addr1);
 				std::cout << "Break on Memory Read" << std::endl;
 				std::cout << "  from PHYS:" << cpputil::Uitox(addr0) << std::endl;
 				std::cout << "  to PHYS:  " << cpputil::Uitox(addr1) << std::endl;
@@ -3608,6 +3726,31 @@ void TownsCommandInterpreter::Execute_BreakOn(FMTownsCommon &towns,Command &cmd)
 		case BREAK_ON_MEM_WRITE:
 			Execute_BreakOnMemoryWrite(towns,cmd);
 			break;
+		case BREAK_ON_MEM_CHANGE:
+			if(4<=cmd.argv.size())
+			{
+				unsigned int addr0=cpputil::Xtoi(cmd.argv[2].c_str());
+				unsigned int addr1=cpputil::Xtoi(cmd.argv[3].c_str());
+				if(addr1<addr0)
+				{
+					std::swap(addr0,addr1);
+				}
+				i486DebugMemoryAccess::SetBreakOnMemChangeRange(towns.mem,towns.debugger,addr0,addr1);
+				std::cout << "Break on Memory Change" << std::endl;
+				std::cout << "  from PHYS:" << cpputil::Uitox(addr0) << std::endl;
+				std::cout << "  to PHYS:  " << cpputil::Uitox(addr1) << std::endl;
+			}
+			else if(3<=cmd.argv.size())
+			{
+				i486DebugMemoryAccess::SetBreakOnMemChange(towns.mem,towns.debugger,cpputil::Xtoi(cmd.argv[2].c_str()));
+				std::cout << "Break on Memory Change PHYS:" << cpputil::Uitox(cpputil::Xtoi(cmd.argv[2].c_str())) << std::endl;
+			}
+			else
+			{
+				PrintError(ERROR_TOO_FEW_ARGS);
+				return;
+			}
+			break;
 		case BREAK_ON_BEEP:
 			towns.timer.breakOnBeep=true;
 			break;
@@ -3900,6 +4043,34 @@ void TownsCommandInterpreter::Execute_ClearBreakOn(FMTownsCommon &towns,Command
 				std::cout << "Clear All Break on Memory Write" << std::endl;
 			}
 			break;
+		case BREAK_ON_MEM_CHANGE:
+			if(4<=cmd.argv.size())
+			{
+				unsigned int addr0=cpputil::Xtoi(cmd.argv[2].c_str());
+				unsigned int addr1=cpputil::Xtoi(cmd.argv[3].c_str());
+				if(addr1<addr0)
+				{
+					std::swap(addr0,addr1);
+				}
+				for(auto addr=addr0; addr<=addr1; ++addr)
+				{
+					i486DebugMemoryAccess::ClearBreakOnMemChange(towns.mem,addr);
+				}
+				std::cout << "Clear Break on Memory Change" << std::endl;
+				std::cout << "  from PHYS:" << cpputil::Uitox(addr0) << std::endl;
+				std::cout << "  to PHYS:  " << cpputil::Uitox(addr1) << std::endl;
+			}
+			else if(3<=cmd.argv.size())
+			{
+				i486DebugMemoryAccess::ClearBreakOnMemChange(towns.mem,cpputil::Xtoi(cmd.argv[2].c_str()));
+				std::cout << "Clear Break on Memory Change:" << cpputil::Uitox(cpputil::Xtoi(cmd.argv[2].c_str())) << std::endl;
+			}
+			else
+			{
+				i486DebugMemoryAccess::ClearBreakOnMemChange(towns.mem);
+				std::cout << "Clear All Break on Memory Change" << std::endl;
+			}
+			break;
 		case BREAK_ON_BEEP:
 			towns.timer.breakOnBeep=false;
 			break;
@@ -4151,6 +4322,30 @@ void TownsCommandInterpreter::Execute_SaveEventLog(FMTownsCommon &towns,const st
 	}
 }
 
+void TownsCommandInterpreter::Execute_ConvertEventLog(Command &cmd)
+{
+	if(3<=cmd.argv.size())
+	{
+		TownsEventLog eventLog;
+		if(true!=eventLog.LoadEventLog(cmd.argv[1]))
+		{
+			PrintError(ERROR_CANNOT_OPEN_FILE);
+			return;
+		}
+		eventLog.ConvertToTownsTime();
+		if(true!=eventLog.SaveEventLog(cmd.argv[2]))
+		{
+			PrintError(ERROR_CANNOT_SAVE_FILE);
+			return;
+		}
+		std::cout << "Converted Event Log." << std::endl;
+	}
+	else
+	{
+		PrintError(ERROR_TOO_FEW_ARGS);
+	}
+}
+
 void TownsCommandInterpreter::Execute_AddSymbol(FMTownsCommon &towns,Command &cmd)
 {
 	if(3<=cmd.argv.size() || 
@@ -4810,15 +5005,27 @@ void TownsCommandInterpreter::Execute_FDEject(int drv,FMTownsCommon &towns,Comma
 
 void TownsCommandInterpreter::Execute_MakeMemoryFilter(FMTownsCommon &towns,Command &cmd,unsigned int unit)
 {
-	if(2<=cmd.argv.size())
+	std::vector <std::string> args;
+	towns.physMem.memFilterIncludeVRAM=false;
+	for(size_t i=1; i<cmd.argv.size(); ++i)
 	{
-		towns.physMem.BeginMemFilter(unit);
-		auto N=towns.physMem.ApplyMemFilter(cpputil::Xtoi(cmd.argv[1].c_str()));
-		std::cout << N << " occurrences" << std::endl;
+		auto arg=cmd.argv[i];
+		cpputil::Capitalize(arg);
+		if("VRAM"==arg)
+		{
+			towns.physMem.memFilterIncludeVRAM=true;
+		}
+		else
+		{
+			args.push_back(cmd.argv[i]);
+		}
 	}
-	else
+
+	towns.physMem.BeginMemFilter(unit);
+	if(1<=args.size())
 	{
-		towns.physMem.BeginMemFilter(unit);
+		auto N=towns.physMem.ApplyMemFilter(cpputil::Xtoi(args[0].c_str()));
+		std::cout << N << " occurrences" << std::endl;
 	}
 }
 void TownsCommandInterpreter::Execute_UpdateMemoryFilter(FMTownsCommon &towns,Command &cmd)
@@ -4949,24 +5156,20 @@ void TownsCommandInterpreter::Execute_Search_ByteSequence(FMTownsCommon &towns,c
 	}
 	std::cout << "Search is limited in the main RAM and VRAM only." << std::endl;
 
-	int maxCount=100;
-	for(unsigned int addr=0; addr+bytes.size()<=towns.physMem.state.RAM.size(); ++addr)
+	for(auto addr : TownsMemorySearch::FindByteSequence(towns.physMem.state.RAM.data(),(uint32_t)towns.physMem.state.RAM.size(),bytes,~(size_t)0))
 	{
-		if(true==cpputil::Match(bytes.size(),bytes.data(),towns.physMem.state.RAM.data()+addr))
-		{
-			FoundAt(towns,addr);
-		}
+		FoundAt(towns,addr);
 	}
-	for(unsigned int addr=0; addr+bytes.size()<=towns.physMem.GetVRAMSize(); ++addr)
+
+	const size_t maxCount=100;
+	auto found=TownsMemorySearch::FindByteSequence(towns.physMem.state.VRAM,towns.physMem.GetVRAMSize(),bytes,maxCount);
+	for(auto addr : found)
 	{
-		if(true==cpputil::Match(bytes.size(),bytes.data(),towns.physMem.state.VRAM+addr))
-		{
-			FoundAt(towns,TOWNSADDR_VRAM0_BASE+addr);
-			if(--maxCount<=0)
-			{
-				std::cout << "Reached maximum count." << std::endl;
-			}
-		}
+		FoundAt(towns,TOWNSADDR_VRAM0_BASE+addr);
+	}
+	if(maxCount<=found.size())
+	{
+		std::cout << "Reached maximum count." << std::endl;
 	}
 }
 
@@ -5437,6 +5640,54 @@ void TownsCommandInterpreter::Execute_AutoShot(FMTownsCommon &towns,Command &cmd
 	}
 }
 
+void TownsCommandInterpreter::Execute_StartFrameCapture(FMTownsCommon &towns,Command &cmd)
+{
+	if(2<=cmd.argv.size())
+	{
+		unsigned int format=TownsFrameCapture::FORMAT_PNG;
+		unsigned int interval=TownsFrameCapture::DEFAULT_INTERVAL;
+		unsigned int numThreads=0;
+		if(3<=cmd.argv.size())
+		{
+			auto fmt=cmd.argv[2];
+			cpputil::Capitalize(fmt);
+			if("RAW"==fmt)
+			{
+				format=TownsFrameCapture::FORMAT_RAW;
+			}
+			else if("PNG"!=fmt)
+			{
+				PrintError(ERROR_WRONG_PARAMETER);
+				return;
+			}
+		}
+		if(4<=cmd.argv.size())
+		{
+			interval=cpputil::Atoi(cmd.argv[3].c_str());
+		}
+		if(5<=cmd.argv.size())
+		{
+			numThreads=cpputil::Atoi(cmd.argv[4].c_str());
+		}
+		if(true==towns.frameCapture.Start(cmd.argv[1],format,interval,numThreads))
+		{
+			std::cout << "Started Frame Capture." << std::endl;
+		}
+		else if(true==towns.frameCapture.IsCapturing())
+		{
+			std::cout << "Frame Capture is already running." << std::endl;
+		}
+		else
+		{
+			PrintError(ERROR_CANNOT_SAVE_FILE);
+		}
+	}
+	else
+	{
+		PrintError(ERROR_TOO_FEW_ARGS);
+	}
+}
+
 void TownsCommandInterpreter::Execute_BreakOnMemoryWrite(FMTownsCommon &towns,Command &cmd)
 {
 	bool useValue=false,useMinMax=false;
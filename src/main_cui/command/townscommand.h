@@ -159,6 +159,7 @@ public:
 		CMD_PLAY_EVENTLOG,
 		CMD_STOP_EVENTLOG,
 		CMD_MAKE_REPEAT_EVENTLOG,
+		CMD_CONVERT_EVENTLOG,
 
 		CMD_SAVE_KEYMAP,
 		CMD_LOAD_KEYMAP,
@@ -168,6 +169,7 @@ public:
 
 		CMD_FMVOL,
 		CMD_PCMVOL,
+		CMD_MIXGAIN,
 		CMD_PCM_CH_ON_OFF,
 		CMD_LOADWAV,
 
@@ -200,6 +202,9 @@ public:
 		CMD_END_VGM_RECORDING,
 		CMD_SAVE_VGM_RECORDING,
 
+		CMD_START_FRAME_CAPTURE,
+		CMD_END_FRAME_CAPTURE,
+
 		CMD_SAVE_WAVERAM,
 
 		CMD_SAVE_DOSSTDOUT,
@@ -290,6 +295,8 @@ public:
 		DUMP_SCSI,
 		DUMP_SCHEDULE,
 		DUMP_TIME_BALANCE,
+		DUMP_PACING,
+		DUMP_MEMORY_WINDOW,
 		DUMP_SPRITE,
 		DUMP_SPRITE_AT,
 		DUMP_SPRITE_PALETTE,
@@ -304,6 +311,7 @@ public:
 		DUMP_INSTRUCTION_HISTOGRAM,
 		DUMP_HIGHRES_PCM,
 		DUMP_SAVESTATEM,
+		DUMP_FRAME_CAPTURE,
 	};
 
 	enum
@@ -333,6 +341,7 @@ public:
 		BREAK_ON_SCSI_DMA_TRANSFER,
 		BREAK_ON_MEM_READ,
 		BREAK_ON_MEM_WRITE,
+		BREAK_ON_MEM_CHANGE,
 		BREAK_ON_BEEP,
 		BREAK_ON_PROTECTED_MODE,
 		BREAK_ON_REAL_MODE,
@@ -413,6 +422,7 @@ public:
 	void Execute_SaveHistory(FMTownsCommon &towns,const std::string &fName);
 
 	void Execute_SaveEventLog(FMTownsCommon &towns,const std::string &fName);
+	void Execute_ConvertEventLog(Command &cmd);
 
 	void Execute_AddSymbol(FMTownsCommon &towns,Command &cmd);
 	void Execute_DelSymbol(FMTownsCommon &towns,Command &cmd);
@@ -475,6 +485,7 @@ public:
 	void Execute_QuickScreenShotDirectory(FMTownsCommon &towns,Command &cmd);
 
 	void Execute_AutoShot(FMTownsCommon &towns,Command &cmd);
+	void Execute_StartFrameCapture(FMTownsCommon &towns,Command &cmd);
 
 	void Execute_BreakOnMemoryWrite(FMTownsCommon &towns,Command &cmd);
 
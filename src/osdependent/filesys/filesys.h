@@ -8,6 +8,9 @@
 #include <vector>
 #include <cstdint>
 #include <string>
+#include <map>
+#include <memory>
+#include <chrono>
 
 // When C++17's filesystem library is commonly available and stable, I'll change it to
 // non-platform dependent library.
@@ -78,6 +81,10 @@ public:
 		bool used=false;
 		std::string subPath;
 		FindContext *findContext=nullptr;
+
+		// Index-based FindFirst/FindNext walk through a cached directory listing.
+		std::shared_ptr <const std::vector <DirectoryEntry> > listing;
+		size_t listingPtr=0;
 		FindStruct();
 		~FindStruct();
 	};
@@ -145,10 +152,51 @@ public:
 		subPath is in the Shift-JIS encoding.
 	*/
 	DirectoryEntry GetFileAttrib(std::string subPath) const;
+
+	/*! Returns the last-modification time of a host file or directory.
+	    The unit is OS-dependent.  It is only compared against the value returned previously.
+	    Returns false if the time stamp cannot be obtained.
+	*/
+	static bool GetModificationTime(const std::string &hostPath,long long int &mtime);
 	// In OS-Dependent part <<
 
 
 
+	/*! Index-based FindFirst/FindNext walk through a cached listing of the directory so that
+	    a program scanning the same directory many times does not make the host re-read it each time.
+	    A cached listing is discarded when the modification time of the host directory changes, or when
+	    a file is created, written, renamed, or deleted through this FileSys.
+	    A file rewritten on the host does not change the modification time of the directory.  Therefore,
+	    a cached listing is also discarded after DIRECTORY_CACHE_LIFETIME_MS.
+	*/
+	class DirectoryListing
+	{
+	public:
+		long long int mtime=0;
+		std::chrono::time_point <std::chrono::steady_clock> cachedTime;
+		std::shared_ptr <const std::vector <DirectoryEntry> > entries;
+	};
+	enum
+	{
+		MAX_NUM_CACHED_DIRECTORY=64,
+		DIRECTORY_CACHE_LIFETIME_MS=500,
+	};
+	std::map <std::string,DirectoryListing> directoryCache;
+
+	/*! Returns the listing of the directory.  Empty if the directory does not exist.
+	    subPath is in the Shift-JIS encoding.
+	*/
+	std::shared_ptr <const std::vector <DirectoryEntry> > GetDirectoryListing(const std::string &subPath);
+
+	void InvalidateDirectoryCache(void);
+
+	/*! If a file has been written since the last check, discards the directory cache and
+	    the read-ahead buffers of the other files.
+	*/
+	void CheckWrittenFiles(void);
+
+
+
 	enum
 	{
 		MAX_NUM_OPEN_FILE=32,
@@ -160,9 +208,33 @@ public:
 	// Corresponds to DOS SFT
 	{
 	public:
+		enum
+		{
+			READ_AHEAD_SIZE=65536,
+		};
+
 		unsigned int mode=0;
 		unsigned int PSP=0;
 		std::fstream fp;
+
+		/*! A file opened for read is read in READ_AHEAD_SIZE chunks.  Small sequential reads are served
+		    from the buffer.  readPos is the file pointer seen from the VM.
+		*/
+		std::vector <unsigned char> readAheadBuf;
+		uint32_t readAheadPos=0;
+		uint32_t readPos=0;
+
+		/*! True if readAheadBuf covers the file up to the end.  A read beyond the buffer is capped at the
+		    file size and does not re-read the file.
+		*/
+		bool readAheadToEOF=false;
+
+		/*! Set when the file is written.  Cleared by FileSys::CheckWrittenFiles.
+		*/
+		bool written=false;
+
+		void ResetReadAhead(void);
+
 		bool IsOpen(void) const;
 		const uint32_t GetFileSize(void); // Can't be const.  seekg is a modifier.
 		const uint32_t GetFilePointer(void); // Can't be const.  tellg is a modifier.  Seriously?
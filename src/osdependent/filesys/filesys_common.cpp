@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 #include "filesys.h"
 #include "cpputil.h"
 
@@ -36,18 +37,24 @@ void FileSys::HasTimeStamp::CopyTimeStampFrom(const HasTimeStamp &incoming)
 }
 int FileSys::FindFirst(DirectoryEntry &ent,unsigned int PSP,const std::string &subPath)
 {
+	CheckWrittenFiles();
+
 	auto fsIdx=FindAvailableFindStruct(subPath);
 	if(0<=fsIdx)
 	{
-		ent=FindFirst(subPath,findStruct[fsIdx].findContext);
-		if(true!=ent.endOfDir)
+		auto listing=GetDirectoryListing(subPath);
+		if(0<listing->size())
 		{
+			ent=listing->front();
 			findStruct[fsIdx].PSP=PSP;
 			findStruct[fsIdx].usedTime=++usedTimeSeed;
 			findStruct[fsIdx].used=true;
 			findStruct[fsIdx].subPath=subPath;
+			findStruct[fsIdx].listing=listing;
+			findStruct[fsIdx].listingPtr=1;
 			return fsIdx;
 		}
+		ent.endOfDir=true;
 	}
 	return -1;
 }
@@ -56,10 +63,16 @@ FileSys::DirectoryEntry FileSys::FindNext(int fsIdx)
 	DirectoryEntry ent;
 	if(true==findStruct[fsIdx].used)
 	{
-		ent=FindNext(findStruct[fsIdx].findContext);
-		if(true==ent.endOfDir)
+		auto &fs=findStruct[fsIdx];
+		if(nullptr!=fs.listing && fs.listingPtr<fs.listing->size())
 		{
-			findStruct[fsIdx].used=false;
+			ent=(*fs.listing)[fs.listingPtr++];
+		}
+		else
+		{
+			ent.endOfDir=true;
+			fs.used=false;
+			fs.listing.reset();
 		}
 	}
 	else
@@ -68,6 +81,69 @@ FileSys::DirectoryEntry FileSys::FindNext(int fsIdx)
 	}
 	return ent;
 }
+std::shared_ptr <const std::vector <FileSys::DirectoryEntry> > FileSys::GetDirectoryListing(const std::string &subPath)
+{
+	long long int mtime=0;
+	bool mtimeValid=GetModificationTime(MakeHostPath(ToHostEncoding(subPath)),mtime);
+	if(true==mtimeValid)
+	{
+		auto found=directoryCache.find(subPath);
+		if(directoryCache.end()!=found && found->second.mtime==mtime &&
+		   std::chrono::steady_clock::now()-found->second.cachedTime<std::chrono::milliseconds(DIRECTORY_CACHE_LIFETIME_MS))
+		{
+			return found->second.entries;
+		}
+	}
+
+	auto entries=std::make_shared <std::vector <DirectoryEntry> >();
+	auto findContext=CreateFindContext();
+	for(auto ent=FindFirst(subPath,findContext); true!=ent.endOfDir; ent=FindNext(findContext))
+	{
+		entries->push_back(ent);
+	}
+	FindClose(findContext);
+	DeleteFindContext(findContext);
+
+	if(true==mtimeValid)
+	{
+		if(MAX_NUM_CACHED_DIRECTORY<=directoryCache.size())
+		{
+			directoryCache.clear();
+		}
+		auto &cached=directoryCache[subPath];
+		cached.mtime=mtime;
+		cached.cachedTime=std::chrono::steady_clock::now();
+		cached.entries=entries;
+	}
+	return entries;
+}
+void FileSys::InvalidateDirectoryCache(void)
+{
+	directoryCache.clear();
+}
+void FileSys::CheckWrittenFiles(void)
+{
+	bool written=false;
+	for(auto &w : sft)
+	{
+		if(true==w.written)
+		{
+			w.written=false;
+			written=true;
+			for(auto &r : sft)
+			{
+				if(&r!=&w && OPENMODE_READ==r.mode && r.fName==w.fName)
+				{
+					r.ResetReadAhead();
+				}
+			}
+		}
+	}
+	if(true==written)
+	{
+		InvalidateDirectoryCache();
+	}
+}
 bool FileSys::FindStructValid(int findStructIdx) const
 {
 	if(0<=findStructIdx && findStructIdx<MAX_NUM_OPEN_DIRECTORY)
@@ -143,6 +219,12 @@ uint16_t FileSys::HasTimeStamp::FormatDOSDate(void) const
 {
 	return ((year-1980)<<9)|(month<<5)|(day);
 }
+void FileSys::SystemFileTable::ResetReadAhead(void)
+{
+	readAheadBuf.clear();
+	readAheadPos=0;
+	readAheadToEOF=false;
+}
 bool FileSys::SystemFileTable::IsOpen(void) const
 {
 	return fp.is_open();
@@ -164,6 +246,10 @@ const uint32_t FileSys::SystemFileTable::GetFileSize(void)
 }
 const uint32_t FileSys::SystemFileTable::GetFilePointer(void)
 {
+	if(OPENMODE_READ==mode)
+	{
+		return readPos;
+	}
 	if(true==fp.eof())
 	{
 		fp.clear(); // Otherwise, cannot seek, tellg() will return -1.
@@ -174,7 +260,31 @@ const uint32_t FileSys::SystemFileTable::GetFilePointer(void)
 std::vector <unsigned char> FileSys::SystemFileTable::Read(uint32_t len)
 {
 	std::vector <unsigned char> buf;
-	if(true==fp.is_open())
+	if(true==fp.is_open() && OPENMODE_READ==mode)
+	{
+		if(readPos<readAheadPos || (readAheadPos+readAheadBuf.size()<readPos+len && true!=readAheadToEOF))
+		{
+			if(true==fp.eof())
+			{
+				fp.clear();
+			}
+			fp.seekg(readPos,std::ios::beg);
+			readAheadBuf.resize(std::max<uint32_t>(len,READ_AHEAD_SIZE));
+			fp.read((char *)readAheadBuf.data(),readAheadBuf.size());
+			readAheadToEOF=((size_t)fp.gcount()<readAheadBuf.size());
+			readAheadBuf.resize(fp.gcount());
+			readAheadPos=readPos;
+		}
+
+		auto offset=readPos-readAheadPos;
+		if(offset<readAheadBuf.size())
+		{
+			auto actualRead=std::min<uint32_t>(len,readAheadBuf.size()-offset);
+			buf.insert(buf.end(),readAheadBuf.begin()+offset,readAheadBuf.begin()+offset+actualRead);
+			readPos+=actualRead;
+		}
+	}
+	else if(true==fp.is_open())
 	{
 		buf.resize(len);
 		fp.read((char *)buf.data(),len);
@@ -191,6 +301,7 @@ uint32_t FileSys::SystemFileTable::Write(const std::vector <unsigned char> &data
 {
 	if(true==fp.is_open())
 	{
+		written=true;
 		auto ptr0=fp.tellp();
 		fp.write((const char *)data.data(),data.size());
 		auto ptr1=fp.tellp();
@@ -224,6 +335,8 @@ std::cout << fullPath << std::endl;
 		sft[sftIdx].fName=subPath;
 		sft[sftIdx].mode=openMode;
 		sft[sftIdx].PSP=PSP;
+		sft[sftIdx].ResetReadAhead();
+		sft[sftIdx].readPos=0;
 		switch(openMode)
 		{
 		case OPENMODE_READ:
@@ -231,6 +344,7 @@ std::cout << fullPath << std::endl;
 			break;
 		case OPENMODE_WRITE:
 			sft[sftIdx].fp.open(fullPath,std::ios::out|std::ios::binary);
+			InvalidateDirectoryCache(); // Truncated.
 			break;
 		case OPENMODE_RW:
 			sft[sftIdx].fp.open(fullPath,std::ios::in|std::ios::out|std::ios::binary);
@@ -257,6 +371,7 @@ int FileSys::OpenFileNotTruncate(unsigned int PSP,std::string subPath,unsigned i
 		{
 			// If not exist, make one.
 			std::ofstream fp(fullPath,std::ios::binary);
+			InvalidateDirectoryCache();
 		}
 
 		auto dirent=GetFileAttrib(subPath);
@@ -264,6 +379,8 @@ int FileSys::OpenFileNotTruncate(unsigned int PSP,std::string subPath,unsigned i
 		sft[sftIdx].fName=subPath;
 		sft[sftIdx].mode=openMode;
 		sft[sftIdx].PSP=PSP;
+		sft[sftIdx].ResetReadAhead();
+		sft[sftIdx].readPos=0;
 		switch(openMode)
 		{
 		case OPENMODE_READ:
@@ -300,12 +417,15 @@ int FileSys::OpenFileTruncate(unsigned int PSP,std::string subPath,unsigned int
 			// If not exist, make one.
 			std::ofstream fp(fullPath,std::ios::binary);
 		}
+		InvalidateDirectoryCache(); // Size of the file changes.
 
 		auto dirent=GetFileAttrib(subPath);
 
 		sft[sftIdx].fName=subPath;
 		sft[sftIdx].mode=openMode;
 		sft[sftIdx].PSP=PSP;
+		sft[sftIdx].ResetReadAhead();
+		sft[sftIdx].readPos=0;
 		sft[sftIdx].fp.open(fullPath,std::ios::in|std::ios::out|std::ios::trunc|std::ios::binary);
 
 		if(true==sft[sftIdx].fp.is_open())
@@ -335,7 +455,8 @@ void FileSys::Seek(int sftIdx,uint32_t pos)
 		switch(sft[sftIdx].mode)
 		{
 		case OPENMODE_READ://   // Keep this number.  Compatible with DOS SFT
-			sft[sftIdx].fp.seekg(pos,std::ios::beg);
+			CheckWrittenFiles();
+			sft[sftIdx].readPos=pos; // Read will seek if pos is outside of the read-ahead buffer.
 			break;
 		case OPENMODE_WRITE://  // Keep this number.  Compatible with DOS SFT
 			sft[sftIdx].fp.seekp(pos,std::ios::beg);
@@ -418,6 +539,7 @@ void FileSys::TruncateToSize(int sftIdx,uint32_t pos)
 
 		sft[sftIdx].fp.open(fullPath,std::ios::in|std::ios::out|std::ios::trunc|std::ios::binary);
 		sft[sftIdx].fp.write((char *)data.data(),data.size());
+		sft[sftIdx].written=true;
 		// Leave it open.
 	}
 }
@@ -429,6 +551,7 @@ bool FileSys::CloseFile(int sftIdx)
 	   true==sft[sftIdx].fp.is_open())
 	{
 		sft[sftIdx].fp.close();
+		sft[sftIdx].ResetReadAhead();
 		return true;
 	}
 	return false;
@@ -440,22 +563,26 @@ bool FileSys::RenameSubPath(std::string subPathFrom,std::string subPathTo)
 
 	auto fullPathFrom=cpputil::MakeFullPathName(hostPath,ToHostEncoding(subPathFrom));
 	auto fullPathTo=cpputil::MakeFullPathName(hostPath,ToHostEncoding(subPathTo));
+	InvalidateDirectoryCache();
 	return 0==rename(fullPathFrom.c_str(),fullPathTo.c_str());
 }
 bool FileSys::DeleteSubPathFile(std::string subPath)
 {
 	BackSlashToSlash(subPath);
 	auto fullPath=cpputil::MakeFullPathName(hostPath,ToHostEncoding(subPath));
+	InvalidateDirectoryCache();
 	return 0==remove(fullPath.c_str());
 }
 bool FileSys::RmdirSubPath(std::string subPath)
 {
 	BackSlashToSlash(subPath);
+	InvalidateDirectoryCache();
 	return Rmdir(cpputil::MakeFullPathName(hostPath,ToHostEncoding(subPath)));
 }
 bool FileSys::MkdirSubPath(std::string subPath)
 {
 	BackSlashToSlash(subPath);
+	InvalidateDirectoryCache();
 	return Mkdir(cpputil::MakeFullPathName(hostPath,ToHostEncoding(subPath)));
 }
 int FileSys::FindAvailableSFT(void) const
@@ -479,6 +606,7 @@ void FileSys::CloseAllForPSP(unsigned int PSP)
 			{
 				FindClose(fs.findContext);
 				fs.used=false;
+				fs.listing.reset();
 			}
 		}
 		for(auto &t : sft)
@@ -486,6 +614,7 @@ void FileSys::CloseAllForPSP(unsigned int PSP)
 			if(PSP==t.PSP && true==t.fp.is_open())
 			{
 				t.fp.close();
+				t.ResetReadAhead();
 			}
 		}
 	}
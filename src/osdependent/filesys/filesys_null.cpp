@@ -16,6 +16,10 @@ FileSys::~FileSys()
 {
 	return host;
 }
+/* static */ bool FileSys::GetModificationTime(const std::string &hostPath,long long int &mtime)
+{
+	return false;
+}
 /* static */ std::string FileSys::Getcwd(void)
 {
 	return "";
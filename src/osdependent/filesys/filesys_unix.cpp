@@ -1,6 +1,7 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <time.h>
 #include "filesys.h"
 #include "sjis2utf8.h"
 
@@ -160,6 +161,26 @@ FileSys::DirectoryEntry FileSys::GetFileAttrib(std::string fileName) const
 
 	return ent;
 }
+/* static */ bool FileSys::GetModificationTime(const std::string &hostPath,long long int &mtime)
+{
+	struct stat st;
+	if(0!=stat(hostPath.c_str(),&st))
+	{
+		return false;
+	}
+	// Some file systems only keep the time stamp in seconds.  If the directory was modified just now,
+	// another change in the same second will not be detected.  Don't trust a time stamp that recent.
+	if(time(nullptr)<st.st_mtime+2)
+	{
+		return false;
+	}
+#ifdef __APPLE__
+	mtime=(long long int)st.st_mtimespec.tv_sec*1000000000LL+st.st_mtimespec.tv_nsec;
+#else
+	mtime=(long long int)st.st_mtim.tv_sec*1000000000LL+st.st_mtim.tv_nsec;
+#endif
+	return true;
+}
 FileSys::DirectoryEntry FileSys::FindNext(FindContext *context)
 {
 	DirectoryEntry ent;
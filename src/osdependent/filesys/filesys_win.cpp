@@ -283,6 +283,28 @@ FileSys::DirectoryEntry FileSys::GetFileAttrib(std::string fileName) const
 	}
 	return ent;
 }
+/* static */ bool FileSys::GetModificationTime(const std::string &hostPath,long long int &mtime)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attr;
+	if(TRUE!=GetFileAttributesExA(hostPath.c_str(),GetFileExInfoStandard,&attr))
+	{
+		return false;
+	}
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+
+	long long int writeTime=((long long int)attr.ftLastWriteTime.dwHighDateTime<<32)|attr.ftLastWriteTime.dwLowDateTime;
+	long long int nowTime=((long long int)now.dwHighDateTime<<32)|now.dwLowDateTime;
+
+	// FAT keeps the time stamp in 2 seconds.  If the directory was modified just now,
+	// another change may not change the time stamp.  Don't trust a time stamp that recent.
+	if(nowTime<writeTime+30000000LL) // 100ns unit
+	{
+		return false;
+	}
+	mtime=writeTime;
+	return true;
+}
 /* static */ std::string FileSys::Getcwd(void)
 {
 	char buf[1024];
@@ -1,4 +1,8 @@
 #include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <stdio.h>
 #include "filesys.h"
 
 
@@ -54,6 +58,92 @@ int main(int ac,char *av[])
 
 	fsys.DeleteFindContext(context);
 
+	// Index-based FindFirst/FindNext go through the directory cache.  Must give the same listing twice.
+	unsigned int numFiles[2]={0,0};
+	for(auto &n : numFiles)
+	{
+		FileSys::DirectoryEntry ent;
+		auto fsIdx=fsys.FindFirst(ent,0,av[2]);
+		while(0<=fsIdx && true!=ent.endOfDir)
+		{
+			++n;
+			ent=fsys.FindNext(fsIdx);
+		}
+	}
+	if(numFiles[0]!=numFiles[1] || numFiles[0]<5)
+	{
+		std::cout << "Directory listing mismatch." << std::endl;
+		return 1;
+	}
+
+	// Small reads must give the same bytes as reading the file at once.
+	{
+		std::string subPath=av[2];
+		subPath+="/filesys.h";
+		auto sftIdx=fsys.OpenExistingFile(0,subPath,FileSys::OPENMODE_READ);
+		if(sftIdx<0)
+		{
+			std::cout << "Cannot open filesys.h" << std::endl;
+			return 1;
+		}
+		auto size=fsys.Fsize(sftIdx);
+		auto all=fsys.sft[sftIdx].Read(size);
+
+		std::vector <unsigned char> pieces;
+		fsys.Seek(sftIdx,0);
+		for(;;)
+		{
+			auto piece=fsys.sft[sftIdx].Read(37);
+			if(0==piece.size())
+			{
+				break;
+			}
+			pieces.insert(pieces.end(),piece.begin(),piece.end());
+			fsys.Seek(sftIdx,fsys.sft[sftIdx].GetFilePointer());
+		}
+		fsys.CloseFile(sftIdx);
+		if(all.size()!=size || all!=pieces)
+		{
+			std::cout << "Read-ahead mismatch." << std::endl;
+			return 1;
+		}
+	}
+
+	// A file rewritten on the host does not change the modification time of the directory.
+	// The listing must show the new size once the cached listing expires.
+	{
+		FileSys rewriteFsys;
+		rewriteFsys.hostPath=".";
+		const std::string fName="FSYSTEST.TXT";
+		auto GetLength=[&](void) -> unsigned long long int
+		{
+			unsigned long long int length=0;
+			FileSys::DirectoryEntry ent;
+			auto fsIdx=rewriteFsys.FindFirst(ent,0,".");
+			while(0<=fsIdx && true!=ent.endOfDir)
+			{
+				if(ent.fName==fName)
+				{
+					length=ent.length;
+				}
+				ent=rewriteFsys.FindNext(fsIdx);
+			}
+			return length;
+		};
+
+		std::ofstream(fName,std::ios::binary) << std::string(10,'A');
+		auto length0=GetLength();
+		std::ofstream(fName,std::ios::binary) << std::string(100,'B');
+		std::this_thread::sleep_for(std::chrono::milliseconds(FileSys::DIRECTORY_CACHE_LIFETIME_MS+100));
+		auto length1=GetLength();
+		remove(fName.c_str());
+		if(10!=length0 || 100!=length1)
+		{
+			std::cout << "Rewritten file not detected. " << length0 << " " << length1 << std::endl;
+			return 1;
+		}
+	}
+
 	if(31==checked)
 	{
 		std::cout << "Detected all files." << std::endl;
@@ -40,6 +40,8 @@ public:
 	*/
 	MemoryAccess *memAccessChain=nullptr;
 
+	virtual ~MemoryAccess(){}
+
 	virtual unsigned int FetchByte(unsigned int physAddr) const=0;
 	virtual unsigned int FetchWord(unsigned int physAddr) const;
 	virtual unsigned int FetchDword(unsigned int physAddr) const;
@@ -252,6 +254,7 @@ public:
 
 private:
 	std::vector <MemoryAccess *> memAccessPtr;
+	uint32_t windowGeneration=0;
 	enum
 	{
 		GRANURALITY_SHIFT=12,  // 4KB slot.
@@ -290,6 +293,15 @@ public:
 	*/
 	MemoryAccess *GetAccessObject(unsigned int physAddr);
 
+	/*! Returns a counter that is incremented every time memory-access objects are re-assigned.
+	    A memory window taken before the counter changed may point to the storage that is no longer mapped,
+	    or may bypass the memory-access object that now handles the slot (VRAM mask, debugger break, etc.).
+	*/
+	inline uint32_t GetWindowGeneration(void) const
+	{
+		return windowGeneration;
+	}
+
 
 	inline unsigned int FetchByte(unsigned int physAddr) const
 	{
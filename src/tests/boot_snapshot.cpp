@@ -0,0 +1,118 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+
+#include "towns.h"
+#include "cpputil.h"
+
+
+// Boot-snapshot key must follow the start-up parameters, and the snapshot must be saved at the snapshot point,
+// resumed next time, and discarded if broken.
+
+int main(void)
+{
+	static FMTownsWithMediumFidelityCPU towns;
+	TownsStartParameters argv;
+
+	auto key=towns.MakeBootSnapshotKey(argv);
+	if(16!=key.size() || key!=towns.MakeBootSnapshotKey(argv))
+	{
+		std::cout << "Key is not stable." << std::endl;
+		return 1;
+	}
+
+	argv.memSizeInMB=8;
+	if(key==towns.MakeBootSnapshotKey(argv))
+	{
+		std::cout << "Key does not follow memory size." << std::endl;
+		return 1;
+	}
+	argv.memSizeInMB=4;
+
+	towns.physMem.state.CMOSRAM[0x100]^=1;
+	if(key==towns.MakeBootSnapshotKey(argv))
+	{
+		std::cout << "Key does not follow CMOS." << std::endl;
+		return 1;
+	}
+	towns.physMem.state.CMOSRAM[0x100]^=1;
+
+	const std::string imgFName="boot_snapshot_test.iso";
+	std::vector <unsigned char> img(2048);
+	cpputil::WriteBinaryFile(imgFName,img.size(),img.data());
+	argv.cdImgFName=imgFName;
+	auto keyWithCD=towns.MakeBootSnapshotKey(argv);
+	img.resize(4096);
+	cpputil::WriteBinaryFile(imgFName,img.size(),img.data());
+	if(key==keyWithCD || keyWithCD==towns.MakeBootSnapshotKey(argv))
+	{
+		std::cout << "Key does not follow the media image." << std::endl;
+		return 1;
+	}
+	remove(imgFName.c_str());
+
+
+	const std::string snapshotFName="boot_snapshot_test.TState";
+	remove(snapshotFName.c_str());
+	towns.var.bootSnapshotFName=snapshotFName;
+	towns.var.bootSnapshotAtKeyWait=true;
+
+	towns.StartBootSnapshot();
+	if(true!=towns.var.bootSnapshotPending)
+	{
+		std::cout << "Boot snapshot is not armed." << std::endl;
+		return 1;
+	}
+	towns.CheckBootSnapshot();
+	if(true!=towns.var.bootSnapshotPending || true==cpputil::FileExists(snapshotFName))
+	{
+		std::cout << "Saved too early." << std::endl;
+		return 1;
+	}
+
+	const uint64_t snapshotTime=123456789;
+	towns.state.townsTime=snapshotTime;
+	towns.keyboard.emptyStatusPollCount=FMTownsCommon::BOOT_SNAPSHOT_KEYWAIT_POLL_COUNT;
+	towns.CheckBootSnapshot();
+	if(true==towns.var.bootSnapshotPending || true!=cpputil::FileExists(snapshotFName))
+	{
+		std::cout << "Boot snapshot not saved." << std::endl;
+		return 1;
+	}
+
+	towns.state.townsTime=0;
+	towns.StartBootSnapshot();
+	if(true==towns.var.bootSnapshotPending || snapshotTime!=towns.state.townsTime)
+	{
+		std::cout << "Boot snapshot not resumed." << std::endl;
+		return 1;
+	}
+
+	{
+		std::ofstream ofp(snapshotFName,std::ios::binary);
+		ofp << "Broken";
+	}
+	towns.StartBootSnapshot();
+	if(true!=towns.var.bootSnapshotPending || true==cpputil::FileExists(snapshotFName))
+	{
+		std::cout << "Broken boot snapshot not discarded." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Boot snapshot test passed." << std::endl;
+	return 0;
+}
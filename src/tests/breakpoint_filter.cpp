@@ -0,0 +1,127 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+
+#include "cpputil.h"
+#include "towns.h"
+
+
+
+bool CheckPage(const i486Debugger &debugger,uint32_t EIP,bool expect,const char what[])
+{
+	if(expect!=debugger.BreakPointMayExistAt(EIP))
+	{
+		std::cout << what << ": Page filter of " << cpputil::Uitox(EIP) << " expected to be " << (true==expect ? "set" : "clear") << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool CheckStop(FMTownsWithMediumFidelityCPU &towns,uint16_t CS,uint32_t EIP,bool expect,const char what[])
+{
+	auto &cpu=towns.CPU();
+	cpu.state.CS().value=CS;
+	cpu.state.EIP=EIP;
+	towns.debugger.ClearStopFlag();
+	towns.debugger.CheckForBreakPoints(cpu);
+	if(expect!=towns.debugger.stop)
+	{
+		std::cout << what << ": Expected " << (true==expect ? "a break" : "no break") << " at " << cpputil::Ustox(CS) << ":" << cpputil::Uitox(EIP) << std::endl;
+		return false;
+	}
+	towns.debugger.ClearStopFlag();
+	return true;
+}
+
+i486Debugger::CS_EIP MakeCSEIP(uint16_t CS,uint32_t EIP)
+{
+	i486Debugger::CS_EIP cseip;
+	cseip.SEG=CS;
+	cseip.OFFSET=EIP;
+	return cseip;
+}
+
+int main(void)
+{
+	static FMTownsWithMediumFidelityCPU towns;
+	auto &debugger=towns.debugger;
+	debugger.ClearBreakPoints();
+
+	i486Debugger::BreakPointInfo info;
+	i486Debugger::BreakPointInfo oneTime;
+	oneTime.flags=i486Debugger::BRKPNT_FLAG_ONE_TIME;
+
+	if(true!=CheckPage(debugger,0x12340,false,"No break points"))
+	{
+		return 1;
+	}
+
+	// Two break points share a page, and one more is in a different page.
+	debugger.AddBreakPoint(MakeCSEIP(0x0C,0x12340),info);
+	debugger.AddBreakPoint(MakeCSEIP(0x0C,0x12FF0),info);
+	debugger.AddBreakPoint(MakeCSEIP(0x14,0x400000),info);
+	if(true!=CheckPage(debugger,0x12000,true,"Shared page") ||
+	   true!=CheckPage(debugger,0x13000,false,"Next page") ||
+	   true!=CheckPage(debugger,0x400FFF,true,"Other page") ||
+	   true!=CheckStop(towns,0x0C,0x12340,true,"Hit") ||
+	   true!=CheckStop(towns,0x0C,0x12344,false,"Miss in a filtered page") ||
+	   true!=CheckStop(towns,0x14,0x12340,false,"Miss by CS") ||
+	   true!=CheckStop(towns,0x0C,0x13340,false,"Miss in an unfiltered page"))
+	{
+		return 1;
+	}
+
+	debugger.RemoveBreakPoint(MakeCSEIP(0x0C,0x12340));
+	if(true!=CheckPage(debugger,0x12000,true,"After removing one of the shared page") ||
+	   true!=CheckStop(towns,0x0C,0x12340,false,"Removed break point") ||
+	   true!=CheckStop(towns,0x0C,0x12FF0,true,"Remaining break point"))
+	{
+		return 1;
+	}
+	debugger.RemoveBreakPoint(MakeCSEIP(0x0C,0x12FF0));
+	if(true!=CheckPage(debugger,0x12000,false,"After removing both") ||
+	   true!=CheckPage(debugger,0x400000,true,"Other page after removing both"))
+	{
+		return 1;
+	}
+
+	// One-time break point removes itself, but keeps the page of a remaining break point.
+	debugger.AddBreakPoint(MakeCSEIP(0x0C,0x50010),oneTime);
+	debugger.AddBreakPoint(MakeCSEIP(0x0C,0x50020),info);
+	if(true!=CheckStop(towns,0x0C,0x50010,true,"One-time break point") ||
+	   true!=CheckStop(towns,0x0C,0x50010,false,"One-time break point second time") ||
+	   true!=CheckPage(debugger,0x50000,true,"After one-time break in a shared page") ||
+	   true!=CheckStop(towns,0x0C,0x50020,true,"Break point next to the one-time break point"))
+	{
+		return 1;
+	}
+
+	debugger.AddBreakPoint(MakeCSEIP(0x0C,0x60010),oneTime);
+	if(true!=CheckStop(towns,0x0C,0x60010,true,"Lone one-time break point") ||
+	   true!=CheckPage(debugger,0x60000,false,"After lone one-time break"))
+	{
+		return 1;
+	}
+
+	debugger.ClearBreakPoints();
+	if(true!=CheckPage(debugger,0x50000,false,"After clearing") ||
+	   true!=CheckPage(debugger,0x400000,false,"After clearing"))
+	{
+		return 1;
+	}
+
+	std::cout << "Passed." << std::endl;
+	return 0;
+}
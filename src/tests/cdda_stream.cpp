@@ -0,0 +1,122 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+
+#include "cdrom.h"
+#include "cpputil.h"
+
+
+// CDDA streamed through AsyncWaveReader in odd-sized pieces must match DiscImage::GetWave of the whole range.
+// Also checks seek (re-target) and repeat.
+
+int main(void)
+{
+	const std::string binFName="cdda_stream_test.bin";
+	const std::string cueFName="cdda_stream_test.cue";
+	const unsigned int numDataSectors=150,numAudioSectors=400;
+
+	std::vector <unsigned char> bin((numDataSectors+numAudioSectors)*DiscImage::AUDIO_SECTOR_SIZE);
+	for(size_t i=0; i<bin.size(); ++i)
+	{
+		bin[i]=(unsigned char)((i*13)^(i>>8));
+	}
+	cpputil::WriteBinaryFile(binFName,bin.size(),bin.data());
+	{
+		std::ofstream ofp(cueFName);
+		ofp << "FILE \"" << binFName << "\" BINARY" << std::endl;
+		ofp << "  TRACK 01 MODE1/2352" << std::endl;
+		ofp << "    INDEX 01 00:00:00" << std::endl;
+		ofp << "  TRACK 02 AUDIO" << std::endl;
+		ofp << "    INDEX 01 00:02:00" << std::endl;
+	}
+
+	DiscImage img;
+	if(DiscImage::ERROR_NOERROR!=img.Open(cueFName) || img.GetNumTracks()<2)
+	{
+		std::cout << "Cannot open the test image." << std::endl;
+		return 1;
+	}
+
+	DiscImage::MinSecFrm from,to;
+	from.FromHSG(numDataSectors+10);
+	to.FromHSG(numDataSectors+numAudioSectors-5);
+	auto whole=img.GetWave(from,to);
+	if(0==whole.size() || whole.size()!=img.GetWaveLength(from,to))
+	{
+		std::cout << "GetWaveLength does not match GetWave." << std::endl;
+		return 1;
+	}
+
+	TownsCDROM::AsyncWaveReader reader;
+	reader.Start(&img,from,to);
+
+	std::vector <unsigned char> streamed(whole.size());
+	unsigned long long int pos=0;
+	while(pos<whole.size())
+	{
+		auto n=reader.Read(pos,std::min<unsigned long long int>(1764*3+4,whole.size()-pos),streamed.data()+pos);
+		if(0==n)
+		{
+			std::cout << "Stream ended early." << std::endl;
+			return 1;
+		}
+		pos+=n;
+	}
+	if(streamed!=whole)
+	{
+		std::cout << "Streamed wave does not match." << std::endl;
+		return 1;
+	}
+	if(0!=reader.Read(pos,4,streamed.data()))
+	{
+		std::cout << "Read beyond the end." << std::endl;
+		return 1;
+	}
+
+	// Seek
+	std::vector <unsigned char> buf(10000);
+	pos=DiscImage::AUDIO_SECTOR_SIZE*100+8;
+	if(buf.size()!=reader.Read(pos,buf.size(),buf.data()) ||
+	   true!=std::equal(buf.begin(),buf.end(),whole.begin()+pos))
+	{
+		std::cout << "Seek failed." << std::endl;
+		return 1;
+	}
+
+	// Repeat
+	reader.SetRepeat(true);
+	pos=whole.size()-400;
+	if(buf.size()!=reader.Read(pos,buf.size(),buf.data()) ||
+	   true!=std::equal(buf.begin(),buf.begin()+400,whole.begin()+pos) ||
+	   true!=std::equal(buf.begin()+400,buf.end(),whole.begin()))
+	{
+		std::cout << "Repeat failed." << std::endl;
+		return 1;
+	}
+
+	reader.Stop();
+	if(TownsCDROM::AsyncWaveReader::STATE_IDLE!=reader.GetState())
+	{
+		std::cout << "Stop failed." << std::endl;
+		return 1;
+	}
+
+	remove(binFName.c_str());
+	remove(cueFName.c_str());
+	std::cout << "CDDA stream test passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,131 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <vector>
+
+#include "cpputil.h"
+#include "i486.h"
+#include "i486debug.h"
+#include "i486debugmemaccess.h"
+
+
+
+class PlainRAM : public MemoryAccess
+{
+public:
+	std::vector <unsigned char> ram;
+	virtual unsigned int FetchByte(unsigned int physAddr) const
+	{
+		return ram[physAddr&0xFFFF];
+	}
+	virtual void StoreByte(unsigned int physAddr,unsigned char data)
+	{
+		ram[physAddr&0xFFFF]=data;
+	}
+};
+
+bool CheckBreak(i486Debugger &debugger,bool expectBreak,const char what[])
+{
+	if(expectBreak!=debugger.stop)
+	{
+		std::cout << what << ": Expected " << (true==expectBreak ? "a break" : "no break") << std::endl;
+		std::cout << "Reason:" << debugger.externalBreakReason << std::endl;
+		return false;
+	}
+	debugger.ClearStopFlag();
+	return true;
+}
+
+int main(void)
+{
+	Memory mem;
+	PlainRAM ram;
+	ram.ram.resize(0x10000);
+	mem.AddAccess(&ram,0x00000,0x0FFFF);
+
+	i486Debugger debugger;
+	debugger.ClearStopFlag();
+
+	// Watch a range that crosses a slot boundary.
+	const unsigned int watch0=Memory::MEMORY_ACCESS_SLOT_SIZE-2,watch1=Memory::MEMORY_ACCESS_SLOT_SIZE+1;
+	i486DebugMemoryAccess::SetBreakOnMemChangeRange(mem,debugger,watch0,watch1);
+
+	if(nullptr==dynamic_cast <i486DebugMemoryAccess *>(mem.GetAccessObject(watch0)) ||
+	   nullptr==dynamic_cast <i486DebugMemoryAccess *>(mem.GetAccessObject(watch1)) ||
+	   &ram!=mem.GetAccessObject(watch1+Memory::MEMORY_ACCESS_SLOT_SIZE))
+	{
+		std::cout << "Debug memory access not inserted in the expected slots." << std::endl;
+		return 1;
+	}
+
+	mem.StoreByte(watch0-1,0x11);
+	if(true!=CheckBreak(debugger,false,"Store below the range"))
+	{
+		return 1;
+	}
+	mem.StoreByte(watch1+1,0x11);
+	if(true!=CheckBreak(debugger,false,"Store above the range"))
+	{
+		return 1;
+	}
+	mem.StoreByte(watch0,0);
+	if(true!=CheckBreak(debugger,false,"Store of the same value"))
+	{
+		return 1;
+	}
+	mem.StoreByte(watch0,0x22);
+	if(true!=CheckBreak(debugger,true,"Change in the lower slot"))
+	{
+		return 1;
+	}
+	mem.StoreByte(watch1,0x33);
+	if(true!=CheckBreak(debugger,true,"Change in the upper slot"))
+	{
+		return 1;
+	}
+	mem.StoreWord(watch1-1,0x3300);
+	if(true!=CheckBreak(debugger,false,"Word store of the same value"))
+	{
+		return 1;
+	}
+	if(0x22!=ram.ram[watch0] || 0x33!=ram.ram[watch1])
+	{
+		std::cout << "Stores did not reach the RAM." << std::endl;
+		return 1;
+	}
+
+	// The last address of the physical space must not wrap around.
+	i486DebugMemoryAccess::SetBreakOnMemChangeRange(mem,debugger,0xFFFFF000,0xFFFFFFFF);
+	if(nullptr==dynamic_cast <i486DebugMemoryAccess *>(mem.GetAccessObject(0xFFFFFFFF)))
+	{
+		std::cout << "Debug memory access not inserted in the last slot." << std::endl;
+		return 1;
+	}
+
+	i486DebugMemoryAccess::ClearBreakOnMemChange(mem);
+	if(&ram!=mem.GetAccessObject(watch0) || &ram!=mem.GetAccessObject(watch1))
+	{
+		std::cout << "Debug memory access not removed." << std::endl;
+		return 1;
+	}
+	mem.StoreByte(watch0,0x44);
+	if(true!=CheckBreak(debugger,false,"Change after clearing"))
+	{
+		return 1;
+	}
+
+	std::cout << "Passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,147 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstring>
+
+#include "cpputil.h"
+#include "towns.h"
+
+
+
+int main(void)
+{
+	{
+		TownsDeviceThread thr;
+
+		std::vector <unsigned int> order;
+		if(0!=thr.Push([&order]{order.push_back(0);}) || 1!=order.size())
+		{
+			std::cout << "Job was not executed immediately without the thread." << std::endl;
+			return 1;
+		}
+
+		thr.Start();
+		TownsDeviceThread::Ticket last=0;
+		for(unsigned int i=1; i<100; ++i)
+		{
+			last=thr.Push([&order,i]{order.push_back(i);});
+		}
+		thr.Wait(last);
+		if(true!=thr.IsDone(last) || 100!=order.size())
+		{
+			std::cout << "Wait returned before the job was done." << std::endl;
+			return 1;
+		}
+		for(unsigned int i=0; i<order.size(); ++i)
+		{
+			if(i!=order[i])
+			{
+				std::cout << "Jobs were executed out of order." << std::endl;
+				return 1;
+			}
+		}
+
+		thr.Push([]{std::this_thread::sleep_for(std::chrono::milliseconds(20));});
+		thr.Push([&order]{order.push_back(100);});
+		thr.Stop();
+		if(101!=order.size())
+		{
+			std::cout << "Stop did not finish the queued jobs." << std::endl;
+			return 1;
+		}
+	}
+
+	{
+		static FMTownsWithMediumFidelityCPU towns;
+		towns.townsType=TOWNSTYPE_2_MX;
+		towns.physMem.SetUpMemoryAccess(towns.townsType,towns.GetCPUType());
+		towns.EnableDeviceThread(true);
+
+		// One 32768-color sprite at (16,16) on page 0.
+		auto &sprite=towns.sprite;
+		auto spriteRAM=towns.physMem.state.spriteRAM;
+		const unsigned int spriteIndex=TownsSprite::MAX_NUM_SPRITE_INDEX-1;
+		const unsigned int patternIndex=128;
+		cpputil::PutWord(spriteRAM+spriteIndex*8  ,16);
+		cpputil::PutWord(spriteRAM+spriteIndex*8+2,16);
+		cpputil::PutWord(spriteRAM+spriteIndex*8+4,patternIndex);
+		cpputil::PutWord(spriteRAM+spriteIndex*8+6,0);
+		for(unsigned int i=0; i<TownsSprite::SPRITE_DIMENSION*TownsSprite::SPRITE_DIMENSION; ++i)
+		{
+			cpputil::PutWord(spriteRAM+(patternIndex<<7)+i*2,0x1234);
+		}
+		sprite.state.page=0;
+		sprite.state.firstSpriteIndexCapture=spriteIndex;
+
+		const uint32_t pixelOffset=TownsSprite::SPRITE_VRAM_BYTES_PER_LINE*16+2*16;
+		const uint32_t physAddr=TOWNSADDR_VRAM0_BASE+0x40000+pixelOffset;
+
+		// Keep the device thread busy so that the rendering is still pending when the CPU reads VRAM.
+		towns.deviceThread.Push([]{std::this_thread::sleep_for(std::chrono::milliseconds(100));});
+		sprite.RenderToPhysicalMemory();
+
+		// The job must render the sprite RAM at the time of the request.
+		cpputil::PutWord(spriteRAM+(patternIndex<<7),0x4321);
+
+		if(0==towns.physMem.VRAMWriterTicket ||
+		   towns.mem.GetAccessObject(physAddr)!=&towns.physMem.VRAMFenceAccess ||
+		   towns.mem.GetAccessObject(TOWNSADDR_VRAM1_BASE)!=&towns.physMem.VRAMFenceAccess)
+		{
+			std::cout << "Sprite page is not fenced." << std::endl;
+			return 1;
+		}
+		if(towns.mem.GetAccessObject(TOWNSADDR_VRAM0_BASE)==&towns.physMem.VRAMFenceAccess ||
+		   towns.mem.GetAccessObject(TOWNSADDR_VRAM1_BASE+0x40000)==&towns.physMem.VRAMFenceAccess)
+		{
+			std::cout << "VRAM outside of the sprite page is fenced." << std::endl;
+			return 1;
+		}
+
+		auto data=towns.mem.FetchWord(physAddr);
+		if(0x1234!=data)
+		{
+			std::cout << "CPU read VRAM before the sprite was rendered. " << cpputil::Ustox(data) << std::endl;
+			return 1;
+		}
+		if(0!=towns.physMem.VRAMWriterTicket ||
+		   towns.mem.GetAccessObject(physAddr)!=&towns.physMem.VRAMAccess0 ||
+		   towns.mem.GetAccessObject(TOWNSADDR_VRAM1_BASE)!=&towns.physMem.VRAMAccess1 ||
+		   towns.mem.GetAccessObject(TOWNSADDR_VRAM_HIGHRES0_BASE+0x40000)!=&towns.physMem.VRAMAccessHighRes0 ||
+		   towns.mem.GetAccessObject(TOWNSADDR_VRAM_HIGHRES2_BASE)!=&towns.physMem.VRAMAccessHighRes2)
+		{
+			std::cout << "VRAM fence was not released." << std::endl;
+			return 1;
+		}
+
+		// Same result as the synchronous rendering.
+		std::vector <unsigned char> asyncPage(towns.physMem.state.VRAM+0x40000,towns.physMem.state.VRAM+0x40000+TownsSprite::SPRITE_HALF_VRAM_SIZE);
+		towns.EnableDeviceThread(false);
+		cpputil::PutWord(spriteRAM+(patternIndex<<7),0x1234);
+		memset(towns.physMem.state.VRAM+0x40000,0,TownsSprite::SPRITE_HALF_VRAM_SIZE);
+		sprite.InvalidateSpritePageRows();
+		sprite.RenderToPhysicalMemory();
+		if(0!=memcmp(asyncPage.data(),towns.physMem.state.VRAM+0x40000,TownsSprite::SPRITE_HALF_VRAM_SIZE))
+		{
+			std::cout << "Sprite page rendered on the device thread does not match." << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "Device thread OK." << std::endl;
+	return 0;
+}
@@ -0,0 +1,153 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <fstream>
+#include <math.h>
+#include <stdio.h>
+
+#include "discimg.h"
+#include "cpputil.h"
+
+
+// BIN/CUE with a data track, a silent audio track, and a tone must read identically after converting to .TCD.
+
+int main(void)
+{
+	const std::string binFName="disc_tcd_test.bin";
+	const std::string cueFName="disc_tcd_test.cue";
+	const std::string tcdFName="disc_tcd_test.tcd";
+	const unsigned int numDataSectors=150,numSilentSectors=300,numToneSectors=200;
+
+	std::vector <unsigned char> bin((numDataSectors+numSilentSectors+numToneSectors)*DiscImage::AUDIO_SECTOR_SIZE);
+	for(size_t i=0; i<numDataSectors*DiscImage::AUDIO_SECTOR_SIZE; ++i)
+	{
+		bin[i]=(unsigned char)((i*13)^(i>>8));
+	}
+	for(size_t i=(numDataSectors+numSilentSectors)*DiscImage::AUDIO_SECTOR_SIZE; i+4<=bin.size(); i+=4)
+	{
+		auto s=(short)(8000.0*sin((double)i*0.001));
+		cpputil::PutWord(bin.data()+i,(unsigned short)s);
+		cpputil::PutWord(bin.data()+i+2,(unsigned short)(s/2));
+	}
+	cpputil::WriteBinaryFile(binFName,bin.size(),bin.data());
+	{
+		std::ofstream ofp(cueFName);
+		ofp << "FILE \"" << binFName << "\" BINARY" << std::endl;
+		ofp << "  TRACK 01 MODE1/2352" << std::endl;
+		ofp << "    INDEX 01 00:00:00" << std::endl;
+		ofp << "  TRACK 02 AUDIO" << std::endl;
+		ofp << "    INDEX 01 00:02:00" << std::endl;
+		ofp << "  TRACK 03 AUDIO" << std::endl;
+		ofp << "    INDEX 01 00:06:00" << std::endl;
+	}
+
+	DiscImage src,tcd;
+	if(DiscImage::ERROR_NOERROR!=src.Open(cueFName) || 3!=src.GetNumTracks())
+	{
+		std::cout << "Cannot open the test image." << std::endl;
+		return 1;
+	}
+	if(DiscImage::ERROR_NOERROR!=src.SaveTCD(tcdFName))
+	{
+		std::cout << "Cannot write .TCD." << std::endl;
+		return 1;
+	}
+	if(DiscImage::ERROR_NOERROR!=tcd.Open(tcdFName) || DiscImage::FILETYPE_TCD!=tcd.fileType)
+	{
+		std::cout << "Cannot open .TCD." << std::endl;
+		return 1;
+	}
+	if(src.GetNumTracks()!=tcd.GetNumTracks() || src.GetNumSectors()!=tcd.GetNumSectors())
+	{
+		std::cout << "Tracks do not match." << std::endl;
+		return 1;
+	}
+
+	unsigned int numHunks[4]={0,0,0,0};
+	for(auto &h : tcd.compressedImage->hunks)
+	{
+		++numHunks[h.codec&3];
+	}
+	if(0==numHunks[DiscImage::CompressedImage::CODEC_FILL] ||
+	   0==numHunks[DiscImage::CompressedImage::CODEC_AUDIO] ||
+	   (long long int)bin.size()/2<cpputil::FileSize(tcdFName))
+	{
+		std::cout << "Not compressed as expected." << std::endl;
+		return 1;
+	}
+
+	for(unsigned int HSG=0; HSG<numDataSectors; HSG+=7)
+	{
+		if(src.ReadSectorMODE1(HSG,3)!=tcd.ReadSectorMODE1(HSG,3) ||
+		   src.ReadSectorRAW(HSG,2)!=tcd.ReadSectorRAW(HSG,2) ||
+		   0==tcd.ReadSectorMODE1(HSG,1).size())
+		{
+			std::cout << "Data sector " << HSG << " does not match." << std::endl;
+			return 1;
+		}
+	}
+
+	for(unsigned int HSG=numDataSectors; HSG<src.GetNumSectors(); HSG+=11)
+	{
+		auto from=DiscImage::HSGtoMSF(HSG);
+		auto to=DiscImage::HSGtoMSF(std::min(HSG+20,src.GetNumSectors()));
+		auto wave=tcd.GetWave(from,to);
+		if(0==wave.size() || src.GetWave(from,to)!=wave)
+		{
+			std::cout << "Audio sector " << HSG << " does not match." << std::endl;
+			return 1;
+		}
+	}
+
+	// Reading hunks in reverse goes through the cache eviction.
+	for(unsigned int HSG=src.GetNumSectors(); numDataSectors<HSG; HSG-=5)
+	{
+		auto from=DiscImage::HSGtoMSF(HSG-5);
+		auto to=DiscImage::HSGtoMSF(HSG);
+		if(src.GetWave(from,to)!=tcd.GetWave(from,to))
+		{
+			std::cout << "Audio sector " << HSG << " does not match after eviction." << std::endl;
+			return 1;
+		}
+	}
+
+	if(true!=tcd.CacheBinary() || tcd.binaryCache!=bin)
+	{
+		std::cout << "CacheBinary does not match." << std::endl;
+		return 1;
+	}
+
+	// Truncated .TCD must be rejected, not read from uninitialized header fields or a short index.
+	{
+		auto tcdBin=cpputil::ReadBinaryFile(tcdFName);
+		const size_t cutAt[]={20,tcdBin.size()-1};
+		for(auto cut : cutAt)
+		{
+			cpputil::WriteBinaryFile(tcdFName,cut,tcdBin.data());
+			DiscImage broken;
+			if(DiscImage::ERROR_TCD_BROKEN!=broken.Open(tcdFName))
+			{
+				std::cout << "Truncated .TCD (" << cut << " bytes) not rejected." << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	remove(binFName.c_str());
+	remove(cueFName.c_str());
+	remove(tcdFName.c_str());
+	std::cout << "TCD test passed." << std::endl;
+	return 0;
+}
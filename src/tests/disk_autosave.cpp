@@ -0,0 +1,164 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <stdio.h>
+
+#include "diskdrive.h"
+#include "cpputil.h"
+
+
+// Only written sectors are handed to the writer.  A RAW image is patched in place, and a whole-image save
+// replaces the file by rename.
+
+int main(void)
+{
+	const std::string fName="disk_autosave_test.bin";
+	const unsigned int numCyl=77,numSide=2,numSec=8,secLen=1024;
+
+	std::vector <unsigned char> bin(numCyl*numSide*numSec*secLen);
+	for(size_t i=0; i<bin.size(); ++i)
+	{
+		bin[i]=(unsigned char)(i*7);
+	}
+	if(true!=cpputil::WriteBinaryFile(fName,bin.size(),bin.data()))
+	{
+		std::cout << "Cannot write the test image." << std::endl;
+		return 1;
+	}
+
+	DiskDrive::ImageFile imgFile;
+	if(true!=imgFile.LoadRAW(fName))
+	{
+		std::cout << "Cannot load the test image." << std::endl;
+		return 1;
+	}
+
+	std::vector <unsigned char> sector(secLen,0xA5);
+	unsigned int C=10,H=1,R=3;
+	imgFile.img.WriteSector(0,C,H,R,sector.size(),sector.data());
+	imgFile.img.WriteSector(0,C,H,R,sector.size(),sector.data());
+
+	DiskDrive::ImageWriter writer;
+	DiskDrive::ImageWriter::Job job;
+	if(true!=imgFile.MakeSaveJob(job) || 1!=job.sectors.size() || true==job.wholeImage || sector!=job.sectors[0].data)
+	{
+		std::cout << "Expected a one-sector job." << std::endl;
+		return 1;
+	}
+	if(true==imgFile.img.IsModified() || true==imgFile.MakeSaveJob(job))
+	{
+		std::cout << "Modified flag not cleared." << std::endl;
+		return 1;
+	}
+	writer.Push(std::move(job));
+	writer.Flush();
+
+	auto offset=((C*numSide+H)*numSec+(R-1))*secLen;
+	for(unsigned int i=0; i<secLen; ++i)
+	{
+		bin[offset+i]=0xA5;
+	}
+	if(bin!=cpputil::ReadBinaryFile(fName))
+	{
+		std::cout << "Patched image does not match." << std::endl;
+		return 1;
+	}
+
+	// Changing the layout falls back to a whole-image write.
+	sector.assign(secLen,0x5A);
+	imgFile.img.WriteSector(0,0,0,1,sector.size(),sector.data());
+	imgFile.img.allDirty=true;
+	if(true!=imgFile.MakeSaveJob(job) || 0!=job.sectors.size() || true!=job.wholeImage)
+	{
+		std::cout << "Expected a whole-image job." << std::endl;
+		return 1;
+	}
+	writer.Push(std::move(job));
+	writer.Flush();
+
+	for(unsigned int i=0; i<secLen; ++i)
+	{
+		bin[i]=0x5A;
+	}
+	if(bin!=cpputil::ReadBinaryFile(fName) || true==cpputil::FileExists(fName+".tmp"))
+	{
+		std::cout << "Whole image not written atomically." << std::endl;
+		return 1;
+	}
+
+	// After the image is closed, the writer reads the file again.
+	DiskDrive::ImageWriter::Job closeJob;
+	closeJob.jobType=DiskDrive::ImageWriter::Job::JOB_CLOSE;
+	closeJob.fName=fName;
+	writer.Push(std::move(closeJob));
+	writer.WaitForFile(fName);
+	if(true!=imgFile.LoadRAW(fName))
+	{
+		std::cout << "Cannot reload the test image." << std::endl;
+		return 1;
+	}
+	sector.assign(secLen,0x3C);
+	imgFile.img.WriteSector(0,76,1,8,sector.size(),sector.data());
+	if(true!=imgFile.MakeSaveJob(job))
+	{
+		std::cout << "Expected a save job after reloading." << std::endl;
+		return 1;
+	}
+	writer.Push(std::move(job));
+	writer.Flush();
+	for(unsigned int i=0; i<secLen; ++i)
+	{
+		bin[bin.size()-secLen+i]=0x3C;
+	}
+	if(bin!=cpputil::ReadBinaryFile(fName))
+	{
+		std::cout << "Image reloaded by the writer does not match." << std::endl;
+		return 1;
+	}
+
+	// D77 image is made from the writer's copy.
+	const std::string d77FName="disk_autosave_test.d77";
+	auto d77Bin=imgFile.img.d77.MakeD77Image();
+	if(true!=cpputil::WriteBinaryFile(d77FName,d77Bin.size(),d77Bin.data()))
+	{
+		std::cout << "Cannot write the D77 test image." << std::endl;
+		return 1;
+	}
+	DiskDrive::ImageFile d77File;
+	if(true!=d77File.LoadD77(d77FName))
+	{
+		std::cout << "Cannot load the D77 test image." << std::endl;
+		return 1;
+	}
+	sector.assign(secLen,0xC3);
+	d77File.img.WriteSector(0,40,0,5,sector.size(),sector.data());
+	if(true!=d77File.MakeSaveJob(job) || 1!=job.sectors.size())
+	{
+		std::cout << "Expected a one-sector D77 job." << std::endl;
+		return 1;
+	}
+	writer.Push(std::move(job));
+	writer.Flush();
+	if(d77File.img.d77.MakeD77Image()!=cpputil::ReadBinaryFile(d77FName) || true==cpputil::FileExists(d77FName+".tmp"))
+	{
+		std::cout << "D77 image does not match." << std::endl;
+		return 1;
+	}
+
+	remove(fName.c_str());
+	remove(d77FName.c_str());
+	std::cout << "Disk auto-save OK." << std::endl;
+	return 0;
+}
@@ -0,0 +1,102 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+
+#include "towns.h"
+
+
+// Converts a wall-clock event log to townsTime, plays it back while advancing townsTime in fixed steps,
+// and checks that the events land at the recorded emulated time.
+
+static bool Play(FMTownsCommon &towns,long long int start,long long int step,long long int pressedAt[2])
+{
+	towns.state.townsTime=start;
+	towns.gameport.state.ports[0].button[0]=false;
+	towns.gameport.state.ports[0].button[1]=false;
+	pressedAt[0]=-1;
+	pressedAt[1]=-1;
+	towns.eventLog.BeginPlayback();
+	for(int i=0; i<100000 && TownsEventLog::MODE_PLAYBACK==towns.eventLog.mode; ++i)
+	{
+		towns.eventLog.Interval(towns);
+		for(int b=0; b<2; ++b)
+		{
+			if(pressedAt[b]<0 && true==towns.gameport.state.ports[0].button[b])
+			{
+				pressedAt[b]=towns.state.townsTime-start;
+			}
+		}
+		towns.state.townsTime+=step;
+	}
+	return TownsEventLog::MODE_NONE==towns.eventLog.mode;
+}
+
+int main(void)
+{
+	const std::string legacyFName="eventlog_townstime_legacy.txt";
+	const std::string convertedFName="eventlog_townstime_converted.txt";
+	{
+		std::ofstream ofp(legacyFName);
+		ofp << "EVT PAD0ADOWN" << std::endl;
+		ofp << "DELTAT 0ms" << std::endl;
+		ofp << "EVT PAD0BDOWN" << std::endl;
+		ofp << "DELTAT 250ms" << std::endl;
+		ofp << "EVT PAD0AUP" << std::endl;
+		ofp << "DELTAT 100ms" << std::endl;
+	}
+
+	static FMTownsWithMediumFidelityCPU towns;
+	TownsEventLog eventLog;
+	if(true!=eventLog.LoadEventLog(legacyFName))
+	{
+		std::cout << "Cannot load the legacy log." << std::endl;
+		return 1;
+	}
+	remove(legacyFName.c_str());
+	eventLog.ConvertToTownsTime();
+	if(true!=eventLog.SaveEventLog(convertedFName))
+	{
+		std::cout << "Cannot save the converted log." << std::endl;
+		return 1;
+	}
+
+	if(true!=towns.eventLog.LoadEventLog(convertedFName) || TownsEventLog::PLAYBACK_BY_TOWNSTIME!=towns.eventLog.playbackClock)
+	{
+		std::cout << "Converted log is not loaded as a townsTime log." << std::endl;
+		return 1;
+	}
+	remove(convertedFName.c_str());
+
+	// Same emulated time regardless of the step and the starting time.
+	const long long int steps[]={1000000,333333,10000000};
+	for(auto step : steps)
+	{
+		long long int pressedAt[2];
+		if(true!=Play(towns,step*7,step,pressedAt))
+		{
+			std::cout << "Playback did not finish." << std::endl;
+			return 1;
+		}
+		std::cout << "Step:" << step << " A:" << pressedAt[0] << " B:" << pressedAt[1] << std::endl;
+		if(0!=pressedAt[0] || pressedAt[1]<250000000 || 250000000+step<=pressedAt[1] || true==towns.gameport.state.ports[0].button[0])
+		{
+			std::cout << "Event did not land at the recorded townsTime." << std::endl;
+			return 1;
+		}
+	}
+	return 0;
+}
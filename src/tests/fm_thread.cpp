@@ -0,0 +1,185 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <vector>
+
+#include "sound.h"
+
+
+// Verifies that the FM synthesis thread renders exactly what the VM thread would render.
+
+class RegWrite
+{
+public:
+	unsigned int chBase,reg,data;
+	uint64_t townsTime;
+};
+
+std::vector <RegWrite> MakeProgram(void)
+{
+	std::vector <RegWrite> prog;
+	const unsigned char tone[]=
+	{
+		0x30,0x71,0x34,0x0D,0x38,0x33,0x3C,0x01,
+		0x40,0x23,0x44,0x2D,0x48,0x26,0x4C,0x00,
+		0x50,0x5F,0x54,0x99,0x58,0x5F,0x5C,0x94,
+		0x60,0x05,0x64,0x05,0x68,0x05,0x6C,0x07,
+		0x70,0x02,0x74,0x02,0x78,0x02,0x7C,0x02,
+		0x80,0x11,0x84,0x11,0x88,0x11,0x8C,0xA6,
+		0xB0,0x32,0xB4,0xC0,
+	};
+	for(unsigned int ch=0; ch<3; ++ch)
+	{
+		for(unsigned int i=0; i<sizeof(tone); i+=2)
+		{
+			prog.push_back({0,tone[i]+ch,tone[i+1],1000});
+			prog.push_back({3,tone[i]+ch,tone[i+1],1000});
+		}
+	}
+	uint64_t t=5000000;
+	for(unsigned int note=0; note<24; ++note)
+	{
+		unsigned int ch=note%6;
+		unsigned int chBase=(ch<3 ? 0 : 3);
+		unsigned int chKey=(ch<3 ? ch : ch+1);
+		prog.push_back({chBase,0xA4+(ch%3),(unsigned int)(0x20+note%8),t});
+		prog.push_back({chBase,0xA0+(ch%3),(unsigned int)(0x40+note*7),t});
+		prog.push_back({0,0x28,0xF0|chKey,t+100000});
+		prog.push_back({0,0x28,chKey,t+17000000});
+		t+=13000000;
+	}
+	return prog;
+}
+
+int main(void)
+{
+	const unsigned int numSamplesPerWave=TownsSound::FM_PCM_MILLISEC_PER_WAVE*YM2612::WAVE_SAMPLING_RATE/1000;
+	const uint64_t nanosecPerWave=(uint64_t)TownsSound::FM_PCM_MILLISEC_PER_WAVE*1000000;
+	auto prog=MakeProgram();
+
+	YM2612 vmYM;
+	vmYM.useScheduling=true;
+	vmYM.PowerOn();
+
+	YM2612 reference(vmYM);
+
+	TownsSound::FMSynthesisThread thr;
+	thr.Start(vmYM);
+
+	size_t progPtr=0;
+	std::vector <std::vector <unsigned char> > refWaves;
+	std::vector <unsigned int> refPlayingCh;
+	auto requestSegment=[&](unsigned int segment)
+	{
+		uint64_t lastWaveGenTime=segment*nanosecPerWave;
+		uint64_t nextWaveGenTime=lastWaveGenTime+nanosecPerWave;
+		for(; progPtr<prog.size() && prog[progPtr].townsTime<nextWaveGenTime; ++progPtr)
+		{
+			auto &w=prog[progPtr];
+			reference.WriteRegister(w.chBase,w.reg,w.data,w.townsTime);
+			thr.SendRegisterWrite(w.chBase,w.reg,w.data,w.townsTime);
+		}
+
+		std::vector <unsigned char> refWave;
+		refWave.resize(numSamplesPerWave*4);
+		reference.MakeWaveForNSamples(refWave.data(),numSamplesPerWave,lastWaveGenTime);
+		reference.CheckToneDoneAllChannels();
+		refWaves.push_back(refWave);
+		refPlayingCh.push_back(reference.state.playingCh);
+
+		thr.RequestRender(numSamplesPerWave,lastWaveGenTime,reference.state.volume,reference.channelMute);
+	};
+	auto checkSegment=[&](unsigned int segment,const TownsSound::FMSynthesisThread::Segment &seg)
+	{
+		if(seg.wave!=refWaves[segment])
+		{
+			std::cout << "Wave mismatch in segment " << segment << std::endl;
+			return false;
+		}
+		if(seg.playingCh!=refPlayingCh[segment])
+		{
+			std::cout << "Playing channels mismatch in segment " << segment << std::endl;
+			return false;
+		}
+		return true;
+	};
+
+	// One segment at a time.
+	unsigned int segment=0;
+	for(; segment<10; ++segment)
+	{
+		requestSegment(segment);
+		TownsSound::FMSynthesisThread::Segment seg;
+		if(true!=thr.WaitSegment(seg))
+		{
+			std::cout << "Segment not rendered." << std::endl;
+			return 1;
+		}
+		if(true!=checkSegment(segment,seg))
+		{
+			return 1;
+		}
+	}
+
+	// Worker renders ahead of the VM.  More requests than the segment queue can hold must not dead-lock
+	// even if the VM waits for the worker to become idle before taking any segment.
+	const unsigned int firstAhead=segment;
+	for(; segment<firstAhead+TownsSound::FMSynthesisThread::SEGMENT_QUEUE_SIZE*2+3; ++segment)
+	{
+		requestSegment(segment);
+	}
+	{
+		YM2612 copy(vmYM);
+		thr.CopyWaveGenerationState(copy);
+		if(copy.state.playingCh!=reference.state.playingCh)
+		{
+			std::cout << "Wave generation state mismatch while rendering ahead." << std::endl;
+			return 1;
+		}
+	}
+	for(unsigned int i=firstAhead; i<segment; ++i)
+	{
+		TownsSound::FMSynthesisThread::Segment seg;
+		if(true!=thr.TryGetSegment(seg))
+		{
+			std::cout << "Segment rendered ahead is not ready." << std::endl;
+			return 1;
+		}
+		if(true!=checkSegment(i,seg))
+		{
+			return 1;
+		}
+	}
+	{
+		TownsSound::FMSynthesisThread::Segment seg;
+		if(true==thr.TryGetSegment(seg) || true==thr.WaitSegment(seg))
+		{
+			std::cout << "More segments than requested." << std::endl;
+			return 1;
+		}
+	}
+
+	YM2612 copy(vmYM);
+	thr.CopyWaveGenerationState(copy);
+	if(copy.state.playingCh!=reference.state.playingCh)
+	{
+		std::cout << "Wave generation state mismatch." << std::endl;
+		return 1;
+	}
+	thr.Stop();
+
+	std::cout << "FM synthesis thread matches the VM-thread synthesis." << std::endl;
+	return 0;
+}
@@ -0,0 +1,85 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <stdio.h>
+
+#include "cpputil.h"
+#include "towns.h"
+#include "framecapture.h"
+
+
+// Captures frames where every frame repeats once, and checks that duplicates are skipped,
+// and that the raw dump has the remaining frames in order.
+
+int main(void)
+{
+	const unsigned int numFrames=40;
+	const std::string prefix="frame_capture_test";
+
+	static FMTownsWithMediumFidelityCPU towns;
+	auto &crtc=towns.crtc;
+	std::vector <unsigned char> VRAM(TOWNS_VRAM_SIZE);
+
+	TownsFrameCapture capture;
+	if(true!=capture.Start(prefix,TownsFrameCapture::FORMAT_RAW,1,3,numFrames))
+	{
+		std::cout << "Cannot start capture." << std::endl;
+		return 1;
+	}
+	for(unsigned int frame=0; frame<numFrames; ++frame)
+	{
+		for(unsigned int i=0; i<VRAM.size(); ++i)
+		{
+			VRAM[i]=(unsigned char)(i*7+frame/2);
+		}
+		capture.NextFrame(crtc,VRAM.data(),false,false,false,frame*16000000ULL);
+	}
+	capture.Stop();
+
+	auto stat=capture.GetStatistics();
+	for(auto str : capture.GetStatusText())
+	{
+		std::cout << str << std::endl;
+	}
+	if(numFrames!=stat.framesQueued || 0!=stat.framesDropped || numFrames/2!=stat.framesWritten || numFrames/2!=stat.framesDuplicate)
+	{
+		std::cout << "Unexpected frame counts." << std::endl;
+		return 1;
+	}
+
+	auto dump=cpputil::ReadBinaryFile(prefix+".frames");
+	remove((prefix+".frames").c_str());
+	if(dump.size()!=TownsFrameCapture::RAW_FILE_HEADER_SIZE+stat.bytesWritten || 0!=memcmp(dump.data(),"TSUGARU_FRAMES",14))
+	{
+		std::cout << "Raw dump size or header is wrong." << std::endl;
+		return 1;
+	}
+	size_t ptr=TownsFrameCapture::RAW_FILE_HEADER_SIZE;
+	for(unsigned int frame=0; frame<numFrames; frame+=2)
+	{
+		auto frameNumber=cpputil::GetDword(dump.data()+ptr);
+		auto wid=cpputil::GetDword(dump.data()+ptr+4);
+		auto hei=cpputil::GetDword(dump.data()+ptr+8);
+		if(frameNumber!=frame || 0==wid || 0==hei)
+		{
+			std::cout << "Frame " << frame << " is out of order or broken." << std::endl;
+			return 1;
+		}
+		ptr+=TownsFrameCapture::RAW_FRAME_HEADER_SIZE+wid*hei*4;
+	}
+	return 0;
+}
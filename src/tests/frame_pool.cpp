@@ -0,0 +1,101 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <cstring>
+
+#include "render.h"
+
+
+// Hands images from a render thread to a window thread, and checks that the steady state does not allocate.
+
+int main(void)
+{
+	const unsigned int numFrames=600;
+
+	TownsRender::FrameBufferPool pool;
+	TownsRender render;
+	render.SetFrameBufferPool(&pool);
+
+	std::mutex lock;
+	bool newImage=false,quit=false;
+	TownsRender::ImageCopy handOver,mostRecentImage;
+
+	std::thread windowThread([&]
+	{
+		for(;;)
+		{
+			TownsRender::ImageCopy img;
+			bool got=false;
+			{
+				std::lock_guard <std::mutex> guard(lock);
+				if(true==newImage)
+				{
+					std::swap(img,handOver);
+					newImage=false;
+					got=true;
+				}
+				else if(true==quit)
+				{
+					break;
+				}
+			}
+			if(true==got)
+			{
+				std::swap(mostRecentImage,img);
+				pool.Return(img);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	for(unsigned int frame=0; frame<numFrames; ++frame)
+	{
+		const int wid=(frame<numFrames/2 ? 640 : 320),hei=480;
+		render.Create(wid,hei);
+		auto img=render.GetImage();
+		memset((void *)img.rgba,frame&255,wid*hei*4);
+
+		auto copy=render.MoveImage();
+		for(;;)
+		{
+			std::lock_guard <std::mutex> guard(lock);
+			if(true!=newImage)
+			{
+				std::swap(handOver,copy);
+				newImage=true;
+				break;
+			}
+		}
+	}
+	{
+		std::lock_guard <std::mutex> guard(lock);
+		quit=true;
+	}
+	windowThread.join();
+
+	std::cout << "Frames:" << numFrames << " Allocated:" << pool.numAllocated << " Taken:" << pool.numTaken
+	          << " Returned:" << pool.numReturned << " Dropped:" << pool.numDropped << std::endl;
+	if(TownsRender::FrameBufferPool::POOL_SIZE+2<pool.numAllocated)
+	{
+		std::cout << "Steady-state rendering is allocating frame buffers." << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,134 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+
+#include "towns.h"
+#include "headless_connection.h"
+
+
+// Scripted input is applied at the scheduled townsTime, and the sound sink paces and counts samples by townsTime.
+
+static bool TestScript(void)
+{
+	static FMTownsWithMediumFidelityCPU towns;
+	HeadlessConnection outside_world;
+
+	std::vector <std::string> bad={"100 JUMP"};
+	if(true==outside_world.LoadInputScript(bad))
+	{
+		std::cout << "Syntax error not detected." << std::endl;
+		return false;
+	}
+
+	std::vector <std::string> script=
+	{
+		"# Comment",
+		"200 CMD  TYPE \"DIR  A:\"",
+		"100 KEYPRESS A",
+		"150 KEYRELEASE A",
+		"300 MOUSE 100 80 LB",
+	};
+	if(true!=outside_world.LoadInputScript(script) || 4!=outside_world.inputScript.size())
+	{
+		std::cout << "Cannot load the script." << std::endl;
+		return false;
+	}
+	if(100000000!=outside_world.inputScript[0].townsTime ||
+	   HeadlessConnection::INPUT_KEY_PRESS!=outside_world.inputScript[0].type ||
+	   HeadlessConnection::INPUT_COMMAND!=outside_world.inputScript[2].type ||
+	   "TYPE \"DIR  A:\""!=outside_world.inputScript[2].cmd ||
+	   true!=outside_world.inputScript[3].lb)
+	{
+		std::cout << "Script not parsed correctly." << std::endl;
+		return false;
+	}
+
+	towns.state.townsTime=5000000000LL;
+	for(long long int t=0; t<=400; t+=10)
+	{
+		towns.state.townsTime=5000000000LL+t*1000000;
+		outside_world.DevicePolling(towns);
+		if(t<200 && true!=outside_world.commandQueue.empty())
+		{
+			std::cout << "Command applied too early." << std::endl;
+			return false;
+		}
+		if(200<=t && 1!=outside_world.commandQueue.size())
+		{
+			std::cout << "Command not applied." << std::endl;
+			return false;
+		}
+	}
+	if(true!=outside_world.mouseControlled || 100!=outside_world.mouseGoalX || 80!=outside_world.mouseGoalY)
+	{
+		std::cout << "Mouse not applied." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static bool TestSound(void)
+{
+	long long int townsTime=0;
+	HeadlessConnection::SoundConnection sound;
+	sound.townsTimePtr=&townsTime;
+
+	std::vector <unsigned char> wave;
+	wave.resize(4410*4);  // 100ms
+	sound.FMPCMPlay(wave);
+	townsTime=99000000;
+	if(true!=sound.FMPCMChannelPlaying())
+	{
+		std::cout << "FM/PCM stopped too early." << std::endl;
+		return false;
+	}
+	townsTime=100000000;
+	if(true==sound.FMPCMChannelPlaying() || 4410!=sound.numFMPCMSamples)
+	{
+		std::cout << "FM/PCM not paced by townsTime." << std::endl;
+		return false;
+	}
+
+	DiscImage discImg;
+	DiscImage::MinSecFrm from,to;
+	from.Set(0,2,0);
+	to.Set(0,4,0);
+	townsTime=1000000000;
+	sound.CDDAPlay(discImg,from,to,false,0,0);
+	townsTime=2000000000;
+	auto pos=sound.CDDACurrentPosition();
+	if(true!=sound.CDDAIsPlaying() || 0!=pos.min || 3!=pos.sec || 0!=pos.frm)
+	{
+		std::cout << "CDDA position is wrong." << std::endl;
+		return false;
+	}
+	townsTime=3000000000;
+	if(true==sound.CDDAIsPlaying() || 88200!=sound.numCDDASamples)
+	{
+		std::cout << "CDDA did not end or samples not counted." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int main(void)
+{
+	if(true!=TestScript() || true!=TestSound())
+	{
+		return 1;
+	}
+	std::cout << "Headless connection OK." << std::endl;
+	return 0;
+}
@@ -0,0 +1,233 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <vector>
+#include <cstring>
+
+#include "cpputil.h"
+#include "towns.h"
+
+
+
+void SetFlatSegment(i486DXCommon::SegmentRegister &seg)
+{
+	seg.value=0;
+	seg.baseLinearAddr=0;
+	seg.operandSize=32;
+	seg.addressSize=32;
+	seg.limit=0xFFFFFFFF;
+}
+
+class Result
+{
+public:
+	uint64_t clocks=0;
+	uint32_t ECX,ESI,EDI;
+	std::vector <unsigned char> RAM,VRAM;
+};
+
+class Scenario
+{
+public:
+	const char *label;
+	std::vector <unsigned char> code;
+	uint32_t EAX,ECX,ESI,EDI;
+	bool DF=false;
+	bool VRAMMask=false;
+	bool expectBlockOp=true;
+	bool checkBlockOpCount=true;
+};
+
+Result Run(FMTownsWithMediumFidelityCPU &towns,const Scenario &scn,unsigned int blockOpMode)
+{
+	auto &cpu=towns.CPU();
+	auto &physMem=towns.physMem;
+
+	for(unsigned int i=0; i<0x40000; ++i)
+	{
+		physMem.state.RAM[i]=(unsigned char)(i*7+(i>>8));
+	}
+	for(unsigned int i=0; i<0x10000; ++i)
+	{
+		physMem.state.VRAM[i]=0;
+	}
+	if(true==scn.VRAMMask)
+	{
+		physMem.IOWriteByte(TOWNSIO_VRAMACCESSCTRL_ADDR,0);
+		physMem.IOWriteByte(TOWNSIO_VRAMACCESSCTRL_DATA_LOW,0x0F);
+	}
+
+	cpu.Reset();
+	cpu.SetCR(0,i486DXCommon::CR0_PROTECTION_ENABLE,towns.mem);
+	SetFlatSegment(cpu.state.CS());
+	SetFlatSegment(cpu.state.SS());
+	SetFlatSegment(cpu.state.DS());
+	SetFlatSegment(cpu.state.ES());
+	cpu.state.ESP()=0x8000;
+	for(unsigned int i=0; i<scn.code.size(); ++i)
+	{
+		physMem.state.RAM[0x1000+i]=scn.code[i];
+	}
+	cpu.state.EIP=0x1000;
+	cpu.state.EAX()=scn.EAX;
+	cpu.state.ECX()=scn.ECX;
+	cpu.state.ESI()=scn.ESI;
+	cpu.state.EDI()=scn.EDI;
+	cpu.SetDF(scn.DF);
+	cpu.blockOpMode=blockOpMode;
+
+	Result res;
+	while(0x1000==cpu.state.EIP)
+	{
+		res.clocks+=towns.RunOneInstruction();
+	}
+	res.ECX=cpu.state.ECX();
+	res.ESI=cpu.state.ESI();
+	res.EDI=cpu.state.EDI();
+	res.RAM.assign(physMem.state.RAM.data(),physMem.state.RAM.data()+0x40000);
+	res.VRAM.assign(physMem.state.VRAM+0,physMem.state.VRAM+0x10000);
+
+	if(true==scn.VRAMMask)
+	{
+		physMem.IOWriteByte(TOWNSIO_VRAMACCESSCTRL_DATA_LOW,0xFF);
+	}
+	return res;
+}
+
+int main(void)
+{
+	static FMTownsWithMediumFidelityCPU towns;
+	auto &cpu=towns.CPU();
+
+	std::vector <Scenario> scenarios;
+	{
+		Scenario scn;
+		scn.label="REP MOVSD across pages";
+		scn.code={0xF3,0xA5};
+		scn.EAX=0;
+		scn.ECX=1000;
+		scn.ESI=0x10004;
+		scn.EDI=0x20F00;
+		scenarios.push_back(scn);
+	}
+	{
+		Scenario scn;
+		scn.label="REP MOVSW to VRAM";
+		scn.code={0x66,0xF3,0xA5};
+		scn.EAX=0;
+		scn.ECX=3000;
+		scn.ESI=0x10001;
+		scn.EDI=TOWNSADDR_VRAM0_BASE+0x100;
+		scenarios.push_back(scn);
+	}
+	{
+		Scenario scn;
+		scn.label="REP STOSD to VRAM";
+		scn.code={0xF3,0xAB};
+		scn.EAX=0x7FFF1234;
+		scn.ECX=0x2345;
+		scn.ESI=0;
+		scn.EDI=TOWNSADDR_VRAM0_BASE+0x1002;
+		scenarios.push_back(scn);
+	}
+	{
+		Scenario scn;
+		scn.label="REP STOSB with 16-bit address wrapping around";
+		scn.code={0x67,0xF3,0xAA};
+		scn.EAX=0x5A;
+		scn.ECX=0x300;
+		scn.ESI=0;
+		scn.EDI=0xFF00;
+		scenarios.push_back(scn);
+	}
+	{
+		Scenario scn;
+		scn.label="Overlapping REP MOVSB";
+		scn.code={0xF3,0xA4};
+		scn.EAX=0;
+		scn.ECX=5000;
+		scn.ESI=0x10000;
+		scn.EDI=0x10001;
+		scn.checkBlockOpCount=false; // A single byte does not overlap, and can be moved by the host.
+		scenarios.push_back(scn);
+	}
+	{
+		Scenario scn;
+		scn.label="REP MOVSB with DF=1";
+		scn.code={0xF3,0xA4};
+		scn.EAX=0;
+		scn.ECX=5000;
+		scn.ESI=0x18000;
+		scn.EDI=0x30000;
+		scn.DF=true;
+		scn.expectBlockOp=false;
+		scenarios.push_back(scn);
+	}
+	{
+		Scenario scn;
+		scn.label="REP STOSD to masked VRAM";
+		scn.code={0xF3,0xAB};
+		scn.EAX=0xFFFFFFFF;
+		scn.ECX=0x800;
+		scn.ESI=0;
+		scn.EDI=TOWNSADDR_VRAM0_BASE;
+		scn.VRAMMask=true;
+		scn.expectBlockOp=false;
+		scenarios.push_back(scn);
+	}
+
+	for(auto &scn : scenarios)
+	{
+		cpu.blockOpCount=0;
+		auto ref=Run(towns,scn,i486DXCommon::BLOCKOP_OFF);
+		if(0!=cpu.blockOpCount)
+		{
+			std::cout << scn.label << ": Host block operation ran while turned off." << std::endl;
+			return 1;
+		}
+
+		for(auto mode : {i486DXCommon::BLOCKOP_ON,i486DXCommon::BLOCKOP_VERIFY})
+		{
+			cpu.blockOpCount=0;
+			cpu.blockOpMismatch=0;
+			auto res=Run(towns,scn,mode);
+			if(ref.clocks!=res.clocks || ref.ECX!=res.ECX || ref.ESI!=res.ESI || ref.EDI!=res.EDI)
+			{
+				std::cout << scn.label << ": Registers or clocks differ." << std::endl;
+				std::cout << ref.clocks << " " << res.clocks << std::endl;
+				return 1;
+			}
+			if(ref.RAM!=res.RAM || ref.VRAM!=res.VRAM)
+			{
+				std::cout << scn.label << ": Memory differs." << std::endl;
+				return 1;
+			}
+			if(true==scn.checkBlockOpCount && scn.expectBlockOp!=(0!=cpu.blockOpCount))
+			{
+				std::cout << scn.label << ": Host block operation count " << cpu.blockOpCount << std::endl;
+				return 1;
+			}
+			if(0!=cpu.blockOpMismatch)
+			{
+				std::cout << scn.label << ": Verification failed." << std::endl;
+				return 1;
+			}
+		}
+		std::cout << scn.label << ": OK" << std::endl;
+	}
+
+	std::cout << "Host block operation OK." << std::endl;
+	return 0;
+}
@@ -0,0 +1,114 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+
+#include "towns.h"
+#include "anonmem.h"
+
+
+// Main RAM and VRAM are committed on the first write, Reset gives the pages back, and the state skips zero pages.
+
+#ifdef __linux__
+static long long int ResidentBytes(void)
+{
+	std::ifstream ifp("/proc/self/statm");
+	long long int total=0,resident=0;
+	ifp >> total >> resident;
+	return resident*4096;
+}
+#endif
+
+int main(void)
+{
+	{
+		const size_t size=256*1024*1024;
+	#ifdef __linux__
+		auto resident0=ResidentBytes();
+	#endif
+		cpputil::AnonymousMemory mem;
+		mem.resize(size);
+		for(size_t page=0; page<mem.GetNumPages(); ++page)
+		{
+			if(true!=mem.IsZeroPage(page))
+			{
+				std::cout << "New memory is not zero." << std::endl;
+				return 1;
+			}
+		}
+	#ifdef __linux__
+		if(32*1024*1024<ResidentBytes()-resident0)
+		{
+			std::cout << "Reading never-written pages used physical memory." << std::endl;
+			return 1;
+		}
+	#endif
+
+		mem[12345]=1;
+		mem[size-1]=2;
+		auto copy=mem;
+		mem.resize(size/2);
+		mem.resize(size);
+		if(1!=mem[12345] || 0!=mem[size-1] || 1!=copy[12345] || 2!=copy[size-1])
+		{
+			std::cout << "Resize or copy lost the contents." << std::endl;
+			return 1;
+		}
+
+		auto ptr=copy.data();
+		copy.Discard();
+		if(ptr!=copy.data() || 0!=copy[12345] || 0!=copy[size-1])
+		{
+			std::cout << "Discard failed." << std::endl;
+			return 1;
+		}
+	}
+
+	{
+		static FMTownsWithMediumFidelityCPU towns;
+		const size_t RAMSize=64*1024*1024;
+		towns.physMem.SetMainRAMSize(RAMSize);
+		towns.physMem.state.RAM[0x123456]=0x77;
+		towns.physMem.state.VRAM[0x1000]=0x55;
+
+		auto saved=towns.physMem.Serialize("");
+		if(1024*1024<saved.size())
+		{
+			std::cout << "Zero pages are saved. " << saved.size() << " bytes." << std::endl;
+			return 1;
+		}
+
+		towns.physMem.Reset();
+		if(0!=towns.physMem.state.RAM[0x123456] || 0!=towns.physMem.state.VRAM[0x1000])
+		{
+			std::cout << "Reset did not clear RAM or VRAM." << std::endl;
+			return 1;
+		}
+
+		if(true!=towns.physMem.Deserialize(saved,"") ||
+		   RAMSize!=towns.physMem.state.RAM.size() ||
+		   0x77!=towns.physMem.state.RAM[0x123456] ||
+		   0x55!=towns.physMem.state.VRAM[0x1000] ||
+		   0!=towns.physMem.state.RAM[0x123457])
+		{
+			std::cout << "State did not restore RAM or VRAM." << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "Lazy RAM test passed." << std::endl;
+	return 0;
+}
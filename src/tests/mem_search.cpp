@@ -0,0 +1,202 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include "cpputil.h"
+#include "memsearch.h"
+
+
+// Compares TownsMemorySearch against the per-byte filter it replaced.
+
+class ReferenceFilter
+{
+public:
+	unsigned int unit;
+	std::vector <bool> filter;
+	std::vector <unsigned char> prev;
+
+	void Begin(unsigned int unit,const std::vector <unsigned char> &mem)
+	{
+		this->unit=unit;
+		filter.assign(mem.size(),true);
+		for(size_t i=0; i<mem.size(); ++i)
+		{
+			if(mem.size()<i+unit)
+			{
+				filter[i]=false;
+			}
+		}
+		prev=mem;
+	}
+	uint32_t Load(const unsigned char *ptr) const
+	{
+		return (1==unit ? *ptr : (2==unit ? cpputil::GetWord(ptr) : cpputil::GetDword(ptr)));
+	}
+	std::vector <uint32_t> Apply(unsigned int predicate,uint32_t value,const std::vector <unsigned char> &mem)
+	{
+		std::vector <uint32_t> found;
+		for(size_t i=0; i+unit<=mem.size(); ++i)
+		{
+			auto cur=Load(mem.data()+i),p=Load(prev.data()+i);
+			bool keep=false;
+			switch(predicate)
+			{
+			case TownsMemorySearch::PREDICATE_EQUAL_TO_VALUE: keep=(cur==value); break;
+			case TownsMemorySearch::PREDICATE_INCREASE:       keep=(cur>p);      break;
+			case TownsMemorySearch::PREDICATE_DECREASE:       keep=(cur<p);      break;
+			case TownsMemorySearch::PREDICATE_CHANGED:        keep=(cur!=p);     break;
+			case TownsMemorySearch::PREDICATE_UNCHANGED:      keep=(cur==p);     break;
+			}
+			if(true!=keep)
+			{
+				filter[i]=false;
+			}
+			if(true==filter[i])
+			{
+				found.push_back((uint32_t)i);
+			}
+		}
+		prev=mem;
+		return found;
+	}
+};
+
+int main(void)
+{
+	std::mt19937 rnd(7);
+	const uint32_t size=0x100000+13;
+	const uint32_t physBase=0x1000;
+
+	for(unsigned int unit : {1,2,4})
+	{
+		for(unsigned int trial=0; trial<3; ++trial)
+		{
+			std::vector <unsigned char> mem(size);
+			for(auto &b : mem)
+			{
+				b=rnd()%4;  // Small value range so that every predicate keeps many candidates.
+			}
+
+			TownsMemorySearch search;
+			search.numThreads=3;
+			search.Begin(unit);
+			search.AddRegion(physBase,mem.data(),size);
+			ReferenceFilter ref;
+			ref.Begin(unit,mem);
+
+			for(unsigned int step=0; step<4; ++step)
+			{
+				for(unsigned int i=0; i<size/(step+2); ++i)
+				{
+					mem[rnd()%size]=rnd()%4;
+				}
+
+				const unsigned int predicate=(trial+step)%5;
+				const unsigned int at=rnd()%(size-4);
+				const uint32_t value=ref.Load(mem.data()+at);
+
+				const unsigned char *current[1]={mem.data()};
+				auto N=search.Apply(predicate,value,current);
+				auto expect=ref.Apply(predicate,value,mem);
+				auto got=search.GetCandidates();
+				for(auto &addr : got)
+				{
+					addr-=physBase;
+				}
+				if(N!=expect.size() || got!=expect)
+				{
+					std::cout << "Mismatch.  Unit " << unit << " Trial " << trial << " Step " << step << " Predicate " << predicate << std::endl;
+					std::cout << "Expected " << expect.size() << " candidates.  Got " << N << std::endl;
+					return 1;
+				}
+			}
+		}
+	}
+
+	// Dense candidates stay in the bitmap.  The list is made once they become sparse.
+	{
+		std::vector <unsigned char> mem(size,0);
+		TownsMemorySearch search;
+		search.Begin(1);
+		search.AddRegion(physBase,mem.data(),size);
+		for(uint32_t i=0; i<size; i+=2)
+		{
+			mem[i]=1;
+		}
+		const unsigned char *current[1]={mem.data()};
+		auto N=search.Apply(TownsMemorySearch::PREDICATE_CHANGED,0,current);
+		auto &rgn=search.regions[0];
+		if((size+1)/2!=N || true==rgn.sparse || 0!=rgn.offset.capacity())
+		{
+			std::cout << "Dense candidates must stay in the bitmap." << std::endl;
+			return 1;
+		}
+
+		mem[100]=2;
+		mem[1000]=2;
+		N=search.Apply(TownsMemorySearch::PREDICATE_INCREASE,0,current);
+		if(2!=N || true!=rgn.sparse || 0!=rgn.candidateBit.capacity() || 0!=rgn.prevImage.capacity())
+		{
+			std::cout << "Sparse candidates must be in the list." << std::endl;
+			return 1;
+		}
+
+		search.ShrinkRegion(0,500);
+		auto got=search.GetCandidates();
+		if(1!=got.size() || physBase+100!=got[0])
+		{
+			std::cout << "Shrinking the region must drop the candidates beyond the size." << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector <unsigned char> mem(size);
+	for(auto &b : mem)
+	{
+		b=rnd()&255;
+	}
+	std::vector <unsigned char> ptn={mem[12345],mem[12346],mem[12347],mem[12348]};
+	auto found=TownsMemorySearch::FindByteSequence(mem.data(),size,ptn,~(size_t)0);
+	std::vector <uint32_t> expect;
+	for(uint32_t i=0; i+ptn.size()<=size; ++i)
+	{
+		if(true==cpputil::Match(ptn.size(),ptn.data(),mem.data()+i))
+		{
+			expect.push_back(i);
+		}
+	}
+	if(found!=expect)
+	{
+		std::cout << "Byte-sequence search mismatch." << std::endl;
+		return 1;
+	}
+
+	// 64MB first step, which used to take seconds with the per-byte filter.
+	mem.resize(64*1024*1024);
+	TownsMemorySearch search;
+	search.Begin(4);
+	search.AddRegion(0,mem.data(),(uint32_t)mem.size());
+	const unsigned char *current[1]={mem.data()};
+	auto t0=std::chrono::high_resolution_clock::now();
+	auto N=search.Apply(TownsMemorySearch::PREDICATE_EQUAL_TO_VALUE,0x12345678,current);
+	auto t1=std::chrono::high_resolution_clock::now();
+	std::cout << "64MB DWORD scan: " << std::chrono::duration_cast<std::chrono::milliseconds>(t1-t0).count() << "ms  " << N << " candidates" << std::endl;
+
+	std::cout << "Memory search matches the reference." << std::endl;
+	return 0;
+}
@@ -0,0 +1,164 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <vector>
+
+#include "cpputil.h"
+#include "i486.h"
+#include "inout.h"
+
+
+
+// 0x00000000 to 0x0000FFFF is RAM that gives memory windows.
+// 0x00010000 to 0x0001FFFF is RAM that does not, like memory-mapped I/O.
+class RAMWithWindow : public MemoryAccess
+{
+public:
+	std::vector <unsigned char> ram;
+	bool giveWindow=true;
+	virtual unsigned int FetchByte(unsigned int physAddr) const
+	{
+		return ram[physAddr&0xFFFF];
+	}
+	virtual void StoreByte(unsigned int physAddr,unsigned char data)
+	{
+		ram[physAddr&0xFFFF]=data;
+	}
+	virtual ConstMemoryWindow GetConstMemoryWindow(unsigned int physAddr) const
+	{
+		ConstMemoryWindow memWin;
+		if(true==giveWindow)
+		{
+			memWin.ptr=ram.data()+(physAddr&0xF000);
+		}
+		return memWin;
+	}
+	virtual MemoryWindow GetMemoryWindow(unsigned int physAddr)
+	{
+		MemoryWindow memWin;
+		if(true==giveWindow)
+		{
+			memWin.ptr=ram.data()+(physAddr&0xF000);
+		}
+		return memWin;
+	}
+};
+
+void SetFlatSegment(i486DXCommon::SegmentRegister &seg)
+{
+	seg.value=0;
+	seg.baseLinearAddr=0;
+	seg.operandSize=32;
+	seg.addressSize=32;
+	seg.limit=0xFFFFFFFF;
+}
+
+int main(void)
+{
+	static i486DXDefaultFidelity cpu(nullptr);
+	Memory mem;
+	InOut io;
+	RAMWithWindow windowRAM,noWindowRAM;
+	windowRAM.ram.resize(0x10000);
+	noWindowRAM.ram.resize(0x10000);
+	noWindowRAM.giveWindow=false;
+	mem.AddAccess(&windowRAM,0x00000,0x0FFFF);
+	mem.AddAccess(&noWindowRAM,0x10000,0x1FFFF);
+
+	cpu.Reset();
+	cpu.SetCR(0,i486DXCommon::CR0_PROTECTION_ENABLE,mem);
+	SetFlatSegment(cpu.state.CS());
+	SetFlatSegment(cpu.state.SS());
+	SetFlatSegment(cpu.state.DS());
+
+	// 200 NOPs ending at the 4KB border at 0x2000, then PUSH EAX/POP EAX at 0x3000 with the stack in the same RAM.
+	const unsigned int codeAddr=0x2000-200;
+	for(unsigned int i=0; i<200; ++i)
+	{
+		windowRAM.ram[codeAddr+i]=0x90;
+	}
+	cpu.state.EIP=codeAddr;
+	cpu.state.ESP()=0x8000;
+	for(unsigned int i=0; i<200; ++i)
+	{
+		cpu.RunOneInstruction(mem,io);
+	}
+	windowRAM.ram[0x3000]=0x50; // PUSH EAX
+	windowRAM.ram[0x3001]=0x58; // POP EAX
+	cpu.state.EIP=0x3000;
+	cpu.RunOneInstruction(mem,io);
+	cpu.RunOneInstruction(mem,io);
+
+	auto stats=cpu.memWinStats;
+	for(auto str : stats.GetStatusText())
+	{
+		std::cout << str << std::endl;
+	}
+	if(202!=stats.CSEIPFetch ||
+	   2!=stats.CSEIPRefill ||
+	   1!=stats.CSEIPRefillFromEmpty ||
+	   0!=stats.CSEIPNoWindow ||
+	   i486DXCommon::MAX_INSTRUCTION_LENGTH-1!=stats.CSEIPPageCross)
+	{
+		std::cout << "CS:EIP window counters are wrong." << std::endl;
+		return 1;
+	}
+	if(2!=stats.stackAccess || 1!=stats.stackRefill || 1!=stats.stackRefillFromEmpty || 0!=stats.stackNoWindow || 0!=stats.stackPageCross)
+	{
+		std::cout << "SS:ESP window counters are wrong." << std::endl;
+		return 1;
+	}
+	if(0!=stats.pageTableCacheHit || 0!=stats.pageTableCacheMiss)
+	{
+		std::cout << "Page-table cache is counted without paging." << std::endl;
+		return 1;
+	}
+
+	// Code and stack in RAM without windows.
+	auto before=cpu.memWinStats;
+	for(unsigned int i=0; i<10; ++i)
+	{
+		noWindowRAM.ram[0x1000+i]=0x90;
+	}
+	noWindowRAM.ram[0x100A]=0x50; // PUSH EAX
+	noWindowRAM.ram[0x100B]=0x58; // POP EAX
+	cpu.state.EIP=0x11000;
+	cpu.state.ESP()=0x18000;
+	for(unsigned int i=0; i<12; ++i)
+	{
+		cpu.RunOneInstruction(mem,io);
+	}
+	stats=cpu.memWinStats.Since(before);
+	if(12!=stats.CSEIPFetch || 12!=stats.CSEIPRefill || 12!=stats.CSEIPNoWindow || 2!=stats.stackNoWindow)
+	{
+		std::cout << "No-window counters are wrong." << std::endl;
+		return 1;
+	}
+	if(0x1100C!=cpu.state.EIP)
+	{
+		std::cout << "Instructions were not executed." << std::endl;
+		return 1;
+	}
+
+	cpu.memWinStats.Clear();
+	if(0!=cpu.memWinStats.CSEIPFetch || 0!=cpu.memWinStats.stackAccess)
+	{
+		std::cout << "Clear failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Memory-window statistics OK." << std::endl;
+	return 0;
+}
@@ -0,0 +1,84 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+
+#include "townspacer.h"
+
+
+// Catch-up is applied in bulk at slice boundaries, and the slice length follows the lag.
+
+int main(void)
+{
+	TownsPacer pacer;
+	pacer.Reset();
+
+	if(0!=pacer.BeginSlice(0) || 0!=pacer.BeginSlice(-5000))
+	{
+		std::cout << "Caught up without a deficit." << std::endl;
+		return 1;
+	}
+	if(300000!=pacer.BeginSlice(300000))
+	{
+		std::cout << "Small deficit must be caught up at once." << std::endl;
+		return 1;
+	}
+	if(TownsPacer::MAX_CATCHUP_PER_SLICE!=pacer.BeginSlice(50000000))
+	{
+		std::cout << "Catch-up is not capped." << std::endl;
+		return 1;
+	}
+
+	// Lagging VM.  Slice grows up to SLICE_MAX.
+	for(int i=0; i<10; ++i)
+	{
+		pacer.EndSlice(TownsPacer::SLICE_MAX*2,0,0);
+	}
+	if(TownsPacer::SLICE_MAX!=pacer.sliceLength || TownsPacer::SLICE_MAX*2!=pacer.stat.maxLag)
+	{
+		std::cout << "Slice did not grow while lagging." << std::endl;
+		return 1;
+	}
+
+	// Sound underrun.  Back to the shortest slice.
+	pacer.EndSlice(TownsPacer::SLICE_MAX*2,0,1);
+	if(TownsPacer::SLICE_MIN!=pacer.sliceLength || 1!=pacer.stat.numUnderruns)
+	{
+		std::cout << "Underrun did not shorten the slice." << std::endl;
+		return 1;
+	}
+
+	// VM is ahead, and waits for the real time.
+	pacer.EndSlice(TownsPacer::SLICE_MAX*2,0,1);
+	pacer.EndSlice(0,200000,1);
+	pacer.EndSlice(0,300000,1);
+	if(TownsPacer::SLICE_MIN!=pacer.sliceLength || 500000!=pacer.stat.totalSleep || 0!=pacer.stat.lag)
+	{
+		std::cout << "Slice did not shrink while waiting." << std::endl;
+		return 1;
+	}
+
+	if(14!=pacer.stat.numSlices || 300000+TownsPacer::MAX_CATCHUP_PER_SLICE!=pacer.stat.totalCatchUp)
+	{
+		std::cout << "Statistics are wrong." << std::endl;
+		return 1;
+	}
+	for(auto str : pacer.GetStatusText())
+	{
+		std::cout << str << std::endl;
+	}
+
+	std::cout << "Pacing test passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,143 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <cstring>
+
+#include "cpputil.h"
+#include "towns.h"
+#include "render.h"
+
+
+
+// Writes the palette and a layer register in the middle of a frame, and checks the band each change lands in.
+
+void SetPalette(TownsCRTC &crtc,unsigned char code,unsigned char r,unsigned char g,unsigned char b)
+{
+	crtc.IOWriteByte(TOWNSIO_ANALOGPALETTE_CODE,code);
+	crtc.IOWriteByte(TOWNSIO_ANALOGPALETTE_BLUE,b);
+	crtc.IOWriteByte(TOWNSIO_ANALOGPALETTE_RED,r);
+	crtc.IOWriteByte(TOWNSIO_ANALOGPALETTE_GREEN,g);
+}
+
+void SetTime(FMTownsCommon &towns,unsigned long long int townsTime)
+{
+	towns.state.townsTime=townsTime;
+	towns.crtc.ProcessVSYNCIRQ(townsTime);
+}
+
+// Returns 'R', 'G', 'B', or '?'.
+char PixelColor(const TownsRender::Image &img,int x,int y)
+{
+	auto pix=img.rgba+(y*img.wid+x)*4;
+	if(0x80<=pix[0] && pix[1]<0x80 && pix[2]<0x80)
+	{
+		return 'R';
+	}
+	if(pix[0]<0x80 && 0x80<=pix[1] && pix[2]<0x80)
+	{
+		return 'G';
+	}
+	if(pix[0]<0x80 && pix[1]<0x80 && 0x80<=pix[2])
+	{
+		return 'B';
+	}
+	return '?';
+}
+
+int main(void)
+{
+	static FMTownsWithMediumFidelityCPU towns;
+	auto &crtc=towns.crtc;
+	auto VRAM=towns.physMem.state.VRAM;
+
+	// Default is the 2-layer 16-color mode.  Layer 0 is in front.
+	// Layer 0 shows color 1 from the first half, and color 2 if FA0 points to the second half.
+	memset(VRAM        ,0x11,0x20000);
+	memset(VRAM+0x20000,0x22,0x20000);
+	memset(VRAM+0x40000,0x00,0x40000);
+	SetPalette(crtc,1,0xF0,0,0);
+	SetPalette(crtc,2,0,0,0xF0);
+
+	crtc.rasterLog.enabled=true;
+	const unsigned long long int frameTop=TownsCRTC::VSYNC_CYCLE;
+	SetTime(towns,TownsCRTC::CRT_VERTICAL_DURATION);
+	SetTime(towns,frameTop);
+
+	SetTime(towns,frameTop+TownsCRTC::CRT_VERTICAL_DURATION/4);
+	SetPalette(crtc,1,0,0xF0,0);
+
+	SetTime(towns,frameTop+TownsCRTC::CRT_VERTICAL_DURATION/2);
+	crtc.IOWriteByte(TOWNSIO_CRTC_ADDRESS,TownsCRTC::REG_FA0);
+	crtc.IOWriteWord(TOWNSIO_CRTC_DATA_LOW,0x20000/4);
+
+	SetTime(towns,frameTop+TownsCRTC::CRT_VERTICAL_DURATION);
+
+	// Only the written registers are logged.
+	auto &events=crtc.rasterLog.last.events;
+	if(5!=events.size() ||
+	   TownsCRTC::RasterEvent::TYPE_CRTC_REG!=events.back().type ||
+	   TownsCRTC::REG_FA0!=events.back().reg ||
+	   0x20000/4!=events.back().value)
+	{
+		std::cout << "Unexpected raster events.  " << events.size() << " events." << std::endl;
+		return 1;
+	}
+
+	// Change the current state so that the image can come only from the log.
+	SetPalette(crtc,1,0xF0,0xF0,0xF0);
+
+	TownsRender render;
+	render.Prepare(crtc);
+	render.BuildImage(VRAM,crtc.GetPalette(),crtc.chaseHQPalette);
+	auto img=render.GetImage();
+
+	TownsCRTC::Layer layer;
+	crtc.MakeLowResPageLayerInfo(layer,0);
+	const int x=layer.originOnMonitor.x()+8;
+	const int top=layer.originOnMonitor.y();
+	const int bottom=top+layer.sizeOnMonitor.y();
+	const int band1=(int)img.hei/4,band2=(int)img.hei/2;
+	if(band1-2<=top || bottom<=band2+2)
+	{
+		std::cout << "Layer does not cover the bands." << std::endl;
+		return 1;
+	}
+
+	const struct
+	{
+		int y;
+		char color;
+	} expect[]=
+	{
+		{top,'R'},
+		{band1-2,'R'},
+		{band1+2,'G'},
+		{band2-2,'G'},
+		{band2+2,'B'},
+		{bottom-1,'B'},
+	};
+	for(auto e : expect)
+	{
+		auto c=PixelColor(img,x,e.y);
+		if(e.color!=c)
+		{
+			std::cout << "Line " << e.y << " Expected " << e.color << " Got " << c << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "Raster bands OK." << std::endl;
+	return 0;
+}
@@ -0,0 +1,185 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "i8251tosocket.h"
+
+
+// Loopback benchmark of the serial-to-socket bridge.  The VM side sends bytes through an echo server, and reads them back.
+
+class EchoServer : public YsSocketServer
+{
+public:
+	std::atomic <uint64_t> numReceived{0};
+
+	EchoServer(int port) : YsSocketServer(port,1)
+	{
+	}
+	virtual YSRESULT ReceivedFrom(int clientId,YSSIZE_T nBytes,unsigned char dat[]) override
+	{
+		numReceived+=nBytes;
+		return Send(clientId,nBytes,dat,1);
+	}
+};
+
+int main(void)
+{
+	const int basePort=28251;
+	const unsigned int emulatedBaudRate=38400;
+	const unsigned int numBytes=256*1024;
+
+	std::unique_ptr <EchoServer> svr;
+	int port=0;
+	for(int i=0; i<16; ++i)
+	{
+		svr.reset(new EchoServer(basePort+i));
+		if(YSOK==svr->Start())
+		{
+			port=basePort+i;
+			break;
+		}
+		svr.reset();
+	}
+	if(nullptr==svr)
+	{
+		std::cout << "Cannot start the echo server." << std::endl;
+		return 1;
+	}
+
+	std::atomic <bool> quit{false};
+	std::thread svrThread([&]
+	{
+		while(true!=quit)
+		{
+			svr->CheckAndAcceptConnection();
+			svr->CheckReceive();
+		}
+	});
+
+	i8251toSocketClient client;
+	if(YSOK!=client.Start(port) || YSOK!=client.Connect("127.0.0.1"))
+	{
+		std::cout << "Cannot connect." << std::endl;
+		quit=true;
+		svrThread.join();
+		return 1;
+	}
+	client.StartIOThread();
+
+	int err=0;
+
+	// Polling an empty receiver must not wait for the socket.
+	{
+		const unsigned int numPolls=1000000;
+		auto t0=std::chrono::high_resolution_clock::now();
+		unsigned int numReady=0;
+		for(unsigned int i=0; i<numPolls; ++i)
+		{
+			numReady+=(true==client.RxRDY() ? 1 : 0);
+		}
+		auto usec=std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now()-t0).count();
+		std::cout << numPolls << " RxRDY polls in " << usec << " microseconds." << std::endl;
+		if(0!=numReady || 1000000<usec)
+		{
+			std::cout << "RxRDY is too slow." << std::endl;
+			err=1;
+		}
+	}
+
+	// Loopback.
+	{
+		std::vector <unsigned char> received;
+		unsigned int numSent=0;
+		auto t0=std::chrono::high_resolution_clock::now();
+		auto deadline=t0+std::chrono::seconds(30);
+		while(0==err && received.size()<numBytes && std::chrono::high_resolution_clock::now()<deadline)
+		{
+			while(numSent<numBytes && true==client.TxRDY())
+			{
+				client.Tx((unsigned char)(numSent*7+(numSent>>8)));
+				++numSent;
+			}
+			while(true==client.RxRDY())
+			{
+				auto peek=client.PeekRx();
+				auto data=client.Rx();
+				if(peek!=data || (unsigned char)(received.size()*7+(received.size()>>8))!=data)
+				{
+					std::cout << "Wrong byte at " << received.size() << std::endl;
+					err=1;
+					break;
+				}
+				received.push_back(data);
+			}
+			std::this_thread::yield();
+		}
+		auto usec=std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now()-t0).count();
+		std::cout << received.size() << " bytes echoed in " << usec << " microseconds." << std::endl;
+		if(received.size()!=numBytes)
+		{
+			std::cout << "Bytes were lost." << std::endl;
+			err=1;
+		}
+		else
+		{
+			auto bytesPerSec=(double)numBytes*1000000.0/(double)(usec+1);
+			std::cout << bytesPerSec << " bytes per second.  (" << emulatedBaudRate/10 << " needed)" << std::endl;
+			if(bytesPerSec<emulatedBaudRate/10)
+			{
+				std::cout << "Too slow for the emulated baud rate." << std::endl;
+				err=1;
+			}
+		}
+	}
+
+	// Bytes still in the ring buffer when the I/O thread is stopped must be sent, not only the current batch.
+	{
+		auto numReceivedBefore=svr->numReceived.load();
+		const unsigned int numFlush=i8251toSocketClient::TX_BATCH_SIZE*3+123;
+		for(unsigned int i=0; i<numFlush; ++i)
+		{
+			client.Tx((unsigned char)i);
+		}
+		client.StopIOThread();
+
+		auto deadline=std::chrono::high_resolution_clock::now()+std::chrono::seconds(10);
+		while(svr->numReceived<numReceivedBefore+numFlush && std::chrono::high_resolution_clock::now()<deadline)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		if(svr->numReceived!=numReceivedBefore+numFlush)
+		{
+			std::cout << "Only " << svr->numReceived-numReceivedBefore << " of " << numFlush << " bytes were sent before StopIOThread returned." << std::endl;
+			err=1;
+		}
+	}
+
+	client.Disconnect();
+	client.Terminate();
+	quit=true;
+	svrThread.join();
+	svr->Terminate();
+
+	if(0==err)
+	{
+		std::cout << "Serial socket test passed." << std::endl;
+	}
+	return err;
+}
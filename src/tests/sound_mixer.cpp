@@ -0,0 +1,117 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+#include "cpputil.h"
+#include "mixer.h"
+
+
+// Compares TownsSoundMixer against a plain per-sample reference, including saturation and odd tail lengths.
+
+int main(void)
+{
+	std::mt19937 rnd(20231017);
+	TownsSoundMixer mixer;
+	for(unsigned int trial=0; trial<64; ++trial)
+	{
+		const unsigned int numSamples=1+rnd()%1800;
+		mixer.Begin(numSamples);
+
+		const int masterGain=(0==rnd()%2 ? (int)TownsSoundMixer::UNITY_GAIN : (int)(rnd()%(TownsSoundMixer::MAX_GAIN+1)));
+		mixer.SetMasterGain(masterGain);
+
+		std::vector <int32_t> ref(numSamples*2,0);
+		bool used[TownsSoundMixer::NUM_SOURCES];
+		for(unsigned int src=0; src<TownsSoundMixer::NUM_SOURCES; ++src)
+		{
+			used[src]=(0!=rnd()%3);
+			int gain=(0==rnd()%2 ? (int)TownsSoundMixer::UNITY_GAIN : (int)(rnd()%(TownsSoundMixer::MAX_GAIN+1)));
+			mixer.SetGain(src,gain);
+			if(true!=used[src])
+			{
+				continue;
+			}
+
+			// Sometimes the same source is accumulated twice, like the FM segment from the worker thread.
+			const unsigned int numPass=1+rnd()%2;
+			for(unsigned int pass=0; pass<numPass; ++pass)
+			{
+				auto wave=mixer.Stage16();
+				const int amplitude=(0==rnd()%2 ? 32768 : 4096);
+				for(unsigned int i=0; i<numSamples*2; ++i)
+				{
+					int value=(int)(rnd()%(amplitude*2))-amplitude;
+					value=std::max(-32768,std::min(32767,value));
+					cpputil::PutWord(wave+i*2,(value&0xFFFF));
+					ref[i]+=(value*gain)>>TownsSoundMixer::GAIN_SHIFT;
+				}
+				mixer.Accumulate16(src,wave);
+			}
+		}
+
+		std::vector <unsigned char> out(numSamples*4,0xCD);
+		mixer.Mix(out.data());
+		for(unsigned int i=0; i<numSamples*2; ++i)
+		{
+			int expect=ref[i];
+			if(TownsSoundMixer::UNITY_GAIN!=masterGain)
+			{
+				expect=(int)std::lrint((float)expect*((float)masterGain/(float)TownsSoundMixer::UNITY_GAIN));
+			}
+			expect=std::max(-32768,std::min(32767,expect));
+			if(cpputil::GetSignedWord(out.data()+i*2)!=expect)
+			{
+				std::cout << "Mismatch at trial " << trial << " word " << i << std::endl;
+				std::cout << "Expected " << expect << " Got " << cpputil::GetSignedWord(out.data()+i*2) << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	// Full-scale negative input must show as peak 32767 both in the 8-word vector body and in the scalar tail.
+	for(unsigned int numSamples : {4,1,5})
+	{
+		mixer.Begin(numSamples);
+		auto wave=mixer.Stage16();
+		for(unsigned int i=0; i<numSamples*2; i+=2)
+		{
+			cpputil::PutWord(wave+i*2,0x8000);
+			cpputil::PutWord(wave+i*2+2,0x0100);
+		}
+		mixer.Accumulate16(TownsSoundMixer::SOURCE_PCM,wave);
+		auto &b=mixer.bus[TownsSoundMixer::SOURCE_PCM];
+		if(32767!=b.peakL || 0x100!=b.peakR)
+		{
+			std::cout << "Peak mismatch for " << numSamples << " samples." << std::endl;
+			std::cout << "Got L=" << b.peakL << " R=" << b.peakR << std::endl;
+			return 1;
+		}
+	}
+
+	// Gains are set by the source label.
+	if(TownsSoundMixer::SOURCE_CDDA!=TownsSoundMixer::StrToSource("cdda") ||
+	   TownsSoundMixer::NUM_SOURCES!=TownsSoundMixer::StrToSource("MASTER"))
+	{
+		std::cout << "Source label lookup failed." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Mixer output matches the reference." << std::endl;
+	return 0;
+}
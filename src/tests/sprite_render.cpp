@@ -0,0 +1,247 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+#include "cpputil.h"
+#include "townsdef.h"
+#include "sprite.h"
+
+
+// Per-pixel rasterizer that TownsSprite::Render used before the row-oriented rasterizer.
+// Kept as a reference to verify the new rasterizer and to measure the gain.
+void ReferenceRender(const TownsSprite &sprite,unsigned char VRAMIn[],const unsigned char spriteRAM[])
+{
+	unsigned char *VRAMTop=VRAMIn + TownsSprite::SPRITE_HALF_VRAM_SIZE * sprite.PAGE();
+
+	for(unsigned int offset=TownsSprite::SPRITE_VRAM_BYTES_PER_LINE*2; offset<0x20000; offset+=2)
+	{
+		VRAMTop[offset  ]=VRAMTop[ offset   &(TownsSprite::SPRITE_VRAM_BYTES_PER_LINE*2-1)];
+		VRAMTop[offset+1]=VRAMTop[(offset+1)&(TownsSprite::SPRITE_VRAM_BYTES_PER_LINE*2-1)];
+	}
+
+	auto xOffset=sprite.HOffset(),yOffset=sprite.VOffset();
+	for(unsigned int spriteIndex=sprite.state.firstSpriteIndexCapture; spriteIndex<TownsSprite::MAX_NUM_SPRITE_INDEX; ++spriteIndex)
+	{
+		auto indexPtr=spriteRAM+TownsSprite::SPRITERAM_INDEX_OFFSET+(spriteIndex<<3);
+		const unsigned short indexInfo[4]=
+		{
+			(unsigned short)(indexPtr[0]|(indexPtr[1]<<8)),
+			(unsigned short)(indexPtr[2]|(indexPtr[3]<<8)),
+			(unsigned short)(indexPtr[4]|(indexPtr[5]<<8)),
+			(unsigned short)(indexPtr[6]|(indexPtr[7]<<8)),
+		};
+
+		unsigned int dstX=indexInfo[0]&511;
+		unsigned int dstY=indexInfo[1]&511;
+		const unsigned int attrib=indexInfo[2];
+		const unsigned int paletteInfo=indexInfo[3];
+		if(0!=(paletteInfo&TownsSprite::PALETTE_DISP))
+		{
+			continue;
+		}
+		if(0!=(attrib&TownsSprite::ATTR_OFFS))
+		{
+			dstX+=xOffset;
+			dstY+=yOffset;
+		}
+		unsigned int patternIndex=attrib&TownsSprite::ATTR_PAT_MASK;
+		const unsigned char rot=((attrib&TownsSprite::ATTR_ROT_MASK)>>TownsSprite::ATTR_ROT_SHIFT);
+		const bool sux=(0!=(attrib&TownsSprite::ATTR_SUX));
+		const bool suy=(0!=(attrib&TownsSprite::ATTR_SUY));
+		uint8_t spys=(paletteInfo&TownsSprite::PALETTE_SPYS) ? 0x80 : 0;
+
+		auto transform=[rot,sux,suy](int &dx,int &dy,int px,int py)
+		{
+			switch(rot)
+			{
+			default:
+			case 0: dx=px;    dy=py;    break;
+			case 1: dx=px;    dy=15-py; break;
+			case 2: dx=15-px; dy=py;    break;
+			case 3: dx=15-px; dy=15-py; break;
+			case 4: dx=py;    dy=px;    break;
+			case 5: dx=py;    dy=15-px; break;
+			case 6: dx=15-py; dy=px;    break;
+			case 7: dx=15-py; dy=15-px; break;
+			}
+			if(sux) dx>>=1;
+			if(suy) dy>>=1;
+		};
+
+		const bool CTEN=(0!=(paletteInfo&TownsSprite::PALETTE_CTEN));
+		if(true!=CTEN)
+		{
+			patternIndex&=(~3);
+		}
+		auto palettePtr=spriteRAM+((paletteInfo&TownsSprite::PALETTE_INDEX_MASK)<<5);
+		auto srcPtr=spriteRAM+(patternIndex<<7);
+		for(int patY=0; patY<16; ++patY)
+		{
+			for(int patX=0; patX<16; ++patX)
+			{
+				int dx,dy;
+				transform(dx,dy,patX,patY);
+				unsigned int sx=(dstX+dx)&0x1ff;
+				unsigned int sy=(dstY+dy)&0x1ff;
+				if(sx<256 && 2<=sy && sy<256)
+				{
+					auto dst=VRAMTop+TownsSprite::SPRITE_VRAM_BYTES_PER_LINE*sy+2*sx;
+					if(true==CTEN)
+					{
+						auto src=srcPtr+TownsSprite::SPRITE_PTN16_BYTES_PER_LINE*patY+(patX>>1);
+						auto pix4bit=(src[0]>>((patX&1) ? 4 : 0))&0x0f;
+						if(pix4bit)
+						{
+							auto col=palettePtr+(pix4bit<<1);
+							dst[0]=col[0];
+							dst[1]=(col[1]&0x7f)|spys;
+						}
+					}
+					else
+					{
+						auto src=srcPtr+TownsSprite::SPRITE_PTN32K_BYTES_PER_LINE*patY+2*patX;
+						if((src[1]&0x80)==0)
+						{
+							dst[0]=src[0];
+							dst[1]=src[1]|spys;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void MakeRandomSprites(unsigned char spriteRAM[],unsigned int seed,unsigned int xyRange)
+{
+	srand(seed);
+	for(unsigned int i=0; i<TOWNS_SPRITERAM_SIZE; ++i)
+	{
+		spriteRAM[i]=rand()&255;
+	}
+	for(unsigned int spriteIndex=0; spriteIndex<TownsSprite::MAX_NUM_SPRITE_INDEX; ++spriteIndex)
+	{
+		auto indexPtr=spriteRAM+TownsSprite::SPRITERAM_INDEX_OFFSET+(spriteIndex<<3);
+		unsigned int x=rand()%xyRange;
+		unsigned int y=rand()%xyRange;
+		unsigned int attrib=rand()&(TownsSprite::ATTR_OFFS|TownsSprite::ATTR_ROT_MASK|TownsSprite::ATTR_SUX|TownsSprite::ATTR_SUY);
+		attrib|=(128+rand()%(TownsSprite::MAX_NUM_SPRITE_PATTERN-128));  // Keep patterns out of the index and palette area.
+		unsigned int palette=(rand()&(TownsSprite::PALETTE_SPYS|TownsSprite::PALETTE_CTEN))|(rand()&0xff);
+		if(0==rand()%16)
+		{
+			palette|=TownsSprite::PALETTE_DISP;
+		}
+		indexPtr[0]=x&255;
+		indexPtr[1]=(x>>8)&255;
+		indexPtr[2]=y&255;
+		indexPtr[3]=(y>>8)&255;
+		indexPtr[4]=attrib&255;
+		indexPtr[5]=(attrib>>8)&255;
+		indexPtr[6]=palette&255;
+		indexPtr[7]=(palette>>8)&255;
+	}
+}
+
+int main(void)
+{
+	std::vector <unsigned char> spriteRAM,VRAMRef,VRAMNew;
+	spriteRAM.resize(TOWNS_SPRITERAM_SIZE);
+	VRAMRef.resize(TownsSprite::SPRITE_HALF_VRAM_SIZE*2);
+	for(auto &v : VRAMRef)
+	{
+		v=rand()&255;
+	}
+	VRAMNew=VRAMRef;
+
+	TownsSprite sprite(nullptr,nullptr);
+	sprite.PowerOn();
+
+	// Verification.  Both pages, with and without offset, wrap-around, and the CPU writing to the sprite page between frames.
+	for(unsigned int frame=0; frame<64; ++frame)
+	{
+		MakeRandomSprites(spriteRAM.data(),frame,(0==frame%2 ? 300 : 512));
+		sprite.state.page=(frame>>1)&1;
+		sprite.state.reg[TownsSprite::REG_HORIZONTAL_OFFSET0]=(frame*37)&255;
+		sprite.state.reg[TownsSprite::REG_HORIZONTAL_OFFSET1]=(frame>>2)&1;
+		sprite.state.reg[TownsSprite::REG_VERTICAL_OFFSET0]=(frame*91)&255;
+		sprite.state.reg[TownsSprite::REG_VERTICAL_OFFSET1]=(frame>>3)&1;
+		sprite.state.firstSpriteIndexCapture=(frame*13)%TownsSprite::MAX_NUM_SPRITE_INDEX;
+
+		if(0==frame%5)
+		{
+			unsigned int addr=rand()%VRAMRef.size();
+			VRAMRef[addr]^=0x55;
+			VRAMNew[addr]^=0x55;
+		}
+
+		ReferenceRender(sprite,VRAMRef.data(),spriteRAM.data());
+		sprite.Render(VRAMNew.data(),spriteRAM.data());
+		if(VRAMRef!=VRAMNew)
+		{
+			for(unsigned int i=0; i<VRAMRef.size(); ++i)
+			{
+				if(VRAMRef[i]!=VRAMNew[i])
+				{
+					std::cout << "Mismatch in frame " << frame << " at offset " << cpputil::Uitox(i) << std::endl;
+					break;
+				}
+			}
+			return 1;
+		}
+	}
+	std::cout << "Sprite rasterizer matches the reference." << std::endl;
+
+	// Benchmark.  1024 active sprites mostly on screen.
+	MakeRandomSprites(spriteRAM.data(),12345,240);
+	for(unsigned int spriteIndex=0; spriteIndex<TownsSprite::MAX_NUM_SPRITE_INDEX; ++spriteIndex)
+	{
+		spriteRAM[TownsSprite::SPRITERAM_INDEX_OFFSET+(spriteIndex<<3)+7]&=~(TownsSprite::PALETTE_DISP>>8);
+	}
+	sprite.state.firstSpriteIndexCapture=0;
+	sprite.state.reg[TownsSprite::REG_HORIZONTAL_OFFSET1]=0;
+	sprite.state.reg[TownsSprite::REG_VERTICAL_OFFSET1]=0;
+
+	const unsigned int nFrame=200;
+	auto t0=std::chrono::high_resolution_clock::now();
+	for(unsigned int frame=0; frame<nFrame; ++frame)
+	{
+		sprite.state.page=frame&1;
+		ReferenceRender(sprite,VRAMRef.data(),spriteRAM.data());
+	}
+	auto t1=std::chrono::high_resolution_clock::now();
+	for(unsigned int frame=0; frame<nFrame; ++frame)
+	{
+		sprite.state.page=frame&1;
+		sprite.Render(VRAMNew.data(),spriteRAM.data());
+	}
+	auto t2=std::chrono::high_resolution_clock::now();
+
+	auto refMicro=std::chrono::duration_cast<std::chrono::microseconds>(t1-t0).count();
+	auto newMicro=std::chrono::duration_cast<std::chrono::microseconds>(t2-t1).count();
+	std::cout << "1024 sprites x " << nFrame << " frames" << std::endl;
+	std::cout << "Per-pixel rasterizer:     " << refMicro/nFrame << "us per frame" << std::endl;
+	std::cout << "Row-oriented rasterizer:  " << newMicro/nFrame << "us per frame" << std::endl;
+
+	if(VRAMRef!=VRAMNew)
+	{
+		std::cout << "Mismatch in the benchmark frames." << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,138 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <stdio.h>
+
+#include "i486symtable.h"
+#include "cpputil.h"
+
+
+// Text symbol table is loaded once from the text and once from the binary cache, and both must give the same table.
+// Changing the text must invalidate the cache.
+
+static std::string MakeSymbol(const char seg_offset[],const char label[],const char comment[])
+{
+	std::string str;
+	str+="/begin0\n";
+	str+="T 1\n";
+	str+="* ";
+	str+=seg_offset;
+	str+="\n# ";
+	str+=comment;
+	str+="\nR int\nL ";
+	str+=label;
+	str+="\nP void\n% 0\nM 0\nB 1\nA 0\nO 0\nX \nI info line\n/end\n";
+	return str;
+}
+
+int main(void)
+{
+	const std::string fName="symtable_cache_test.txt";
+	const std::string cacheFName=i486SymbolTable::GetCacheFileName(fName.c_str());
+	remove(cacheFName.c_str());
+
+	std::string text;
+	text+=MakeSymbol("000C:00004000","main","entry");
+	text+=MakeSymbol("000C:00004100","sub","");
+	text+=MakeSymbol("0014:00004000","data","");
+	if(true!=cpputil::WriteBinaryFile(fName,text.size(),(const unsigned char *)text.data()))
+	{
+		std::cout << "Cannot write the test symbol table." << std::endl;
+		return 1;
+	}
+
+	i486SymbolTable fromText;
+	if(true!=fromText.Load(fName.c_str()) || true!=cpputil::FileExists(cacheFName))
+	{
+		std::cout << "Cache was not created." << std::endl;
+		return 1;
+	}
+
+	i486SymbolTable fromCache;
+	if(true!=fromCache.LoadCache(fName.c_str()) ||
+	   fromText.GetList(true,true,true)!=fromCache.GetList(true,true,true) ||
+	   3!=fromCache.GetTable().size())
+	{
+		std::cout << "Cache does not match the text." << std::endl;
+		return 1;
+	}
+
+	auto sym=fromCache.Find(0x0C,0x4000);
+	if(nullptr==sym || "main"!=sym->label || "entry"!=sym->inLineComment || true!=sym->immIsSymbol || 1!=sym->info.size())
+	{
+		std::cout << "Find failed." << std::endl;
+		return 1;
+	}
+	if(nullptr!=fromCache.Find(0x0C,0x4001))
+	{
+		std::cout << "Find returned a wrong symbol." << std::endl;
+		return 1;
+	}
+	sym=fromCache.FindFromOffset(0x4000);
+	if(nullptr==sym || "main"!=sym->label)
+	{
+		std::cout << "FindFromOffset failed." << std::endl;
+		return 1;
+	}
+
+	i486DXCommon::FarPointer ptr,symPtr;
+	ptr.SEG=0x0C;
+	ptr.OFFSET=0x4080;
+	sym=fromCache.FindNearest(ptr,symPtr);
+	if(nullptr==sym || "main"!=sym->label || 0x4000!=symPtr.OFFSET)
+	{
+		std::cout << "FindNearest failed." << std::endl;
+		return 1;
+	}
+	ptr.SEG=0x14;
+	ptr.OFFSET=0x3FFF;
+	if(nullptr!=fromCache.FindNearest(ptr,symPtr))
+	{
+		std::cout << "FindNearest crossed the segment." << std::endl;
+		return 1;
+	}
+
+	ptr.SEG=0x0C;
+	ptr.OFFSET=0x4080;
+	fromCache.Update(ptr,"added");
+	sym=fromCache.Find(ptr);
+	if(nullptr==sym || "added"!=sym->label)
+	{
+		std::cout << "Index was not updated." << std::endl;
+		return 1;
+	}
+
+	// Changing the text invalidates the cache.
+	text+=MakeSymbol("000C:00005000","more","");
+	cpputil::WriteBinaryFile(fName,text.size(),(const unsigned char *)text.data());
+	i486SymbolTable stale;
+	if(true==stale.LoadCache(fName.c_str()))
+	{
+		std::cout << "Cache was not invalidated." << std::endl;
+		return 1;
+	}
+	i486SymbolTable reloaded;
+	if(true!=reloaded.Load(fName.c_str()) || 4!=reloaded.GetTable().size() ||
+	   true!=stale.LoadCache(fName.c_str()) || 4!=stale.GetTable().size())
+	{
+		std::cout << "Cache was not re-written." << std::endl;
+		return 1;
+	}
+
+	remove(fName.c_str());
+	remove(cacheFName.c_str());
+	std::cout << "Symbol-table cache test passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,260 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <fstream>
+
+#include "cpputil.h"
+#include "towns.h"
+
+
+
+// Synthetic DOS 3.x structures in the conventional memory.
+const uint16_t PSPSEG=0x2000;
+const uint16_t SFTSEG=0x3000;
+const uint16_t BUFSEG=0x4000;
+const unsigned int SFT_ENTRY_LEN=0x35;
+const unsigned int TGDRV_HANDLE=5;
+const unsigned int CLOSED_HANDLE=6;
+const unsigned int LOCAL_HANDLE=7;
+const char *const testFName="tgdrv_host_read.bin";
+
+unsigned char FileByte(unsigned int pos)
+{
+	return (unsigned char)(pos*7+3);
+}
+
+uint32_t SFTEntryAddr(unsigned int blockOffset,unsigned int idxInBlock)
+{
+	return SFTSEG*0x10+blockOffset+6+SFT_ENTRY_LEN*idxInBlock;
+}
+
+void MakeDOS(FMTownsWithMediumFidelityCPU &towns,int hostSFTIdx)
+{
+	auto &mem=towns.mem;
+	towns.state.DOSVER=0x0A03;
+	towns.state.DOSLOLSEG=TOWNS_DOS_SEG;
+	const uint32_t DOSADDR=TOWNS_DOS_SEG*0x10;
+
+	mem.StoreWord(DOSADDR+TOWNS_DOS_CURRENT_PDB,PSPSEG);
+	mem.StoreWord(PSPSEG*0x10+TOWNS_DOS_PSP_FILE_TAB_SIZE,20);
+	mem.StoreWord(PSPSEG*0x10+TOWNS_DOS_PSP_FILE_TABLE_PTR,TOWNS_DOS_PSP_FILE_TABLE);
+	mem.StoreWord(PSPSEG*0x10+TOWNS_DOS_PSP_FILE_TABLE_PTR+2,PSPSEG);
+	for(unsigned int i=0; i<20; ++i)
+	{
+		mem.StoreByte(PSPSEG*0x10+TOWNS_DOS_PSP_FILE_TABLE+i,0xFF);
+	}
+	mem.StoreByte(PSPSEG*0x10+TOWNS_DOS_PSP_FILE_TABLE+TGDRV_HANDLE,7); // Second block, third entry.
+	mem.StoreByte(PSPSEG*0x10+TOWNS_DOS_PSP_FILE_TABLE+LOCAL_HANDLE,2); // First block, third entry.
+
+	// Two SFT blocks of 5 entries.
+	mem.StoreWord(DOSADDR+TOWNS_DOS_SFT_PTR,0);
+	mem.StoreWord(DOSADDR+TOWNS_DOS_SFT_PTR+2,SFTSEG);
+	mem.StoreWord(SFTSEG*0x10,0x100);
+	mem.StoreWord(SFTSEG*0x10+2,SFTSEG);
+	mem.StoreWord(SFTSEG*0x10+4,5);
+	mem.StoreWord(SFTSEG*0x10+0x100,0xFFFF);
+	mem.StoreWord(SFTSEG*0x10+0x102,0xFFFF);
+	mem.StoreWord(SFTSEG*0x10+0x104,5);
+
+	auto local=SFTEntryAddr(0,2);
+	mem.StoreWord(local,1);
+	mem.StoreWord(local+0x02,0);
+	mem.StoreWord(local+0x05,'E'-'A');
+
+	auto remote=SFTEntryAddr(0x100,2);
+	mem.StoreWord(remote,1);
+	mem.StoreWord(remote+0x02,0);
+	mem.StoreWord(remote+0x05,0x8000|('E'-'A'));
+	mem.StoreDword(remote+0x07,towns.tgdrv.TGDRV_ID);
+	mem.StoreWord(remote+0x0B,hostSFTIdx);
+	mem.StoreDword(remote+0x15,100);
+}
+
+void SetUpINT21H_3FH(FMTownsWithMediumFidelityCPU &towns,unsigned int handle,unsigned int len)
+{
+	auto &cpu=towns.CPU();
+	cpu.SetAX(0x3F00);
+	cpu.SetBX(handle);
+	cpu.SetCX(len);
+	cpu.SetDX(0x10);
+	cpu.state.DS().value=BUFSEG;
+	cpu.state.DS().baseLinearAddr=BUFSEG*0x10;
+	cpu.state.DS().limit=0xFFFF;
+	cpu.state.CS().value=0x1000;
+	cpu.state.EIP=0x200;
+	cpu.SetCF(true);
+}
+
+bool CheckBuffer(FMTownsWithMediumFidelityCPU &towns,unsigned int filePos,unsigned int len,const char what[])
+{
+	for(unsigned int i=0; i<len; ++i)
+	{
+		if(FileByte(filePos+i)!=towns.mem.FetchByte(BUFSEG*0x10+0x10+i))
+		{
+			std::cout << what << ": Buffer does not match at " << i << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(void)
+{
+	{
+		std::ofstream ofp(testFName,std::ios::binary);
+		for(unsigned int i=0; i<1000; ++i)
+		{
+			ofp.put((char)FileByte(i));
+		}
+	}
+
+	static FMTownsWithMediumFidelityCPU towns;
+	auto &cpu=towns.CPU();
+	auto &tgdrv=towns.tgdrv;
+	tgdrv.sharedDir[0].linked=true;
+	tgdrv.sharedDir[0].hostPath=".";
+	tgdrv.hostDriveLetter[0]='E';
+
+	int hostSFTIdx=tgdrv.sharedDir[0].OpenExistingFile(PSPSEG,testFName,FileSys::OPENMODE_READ);
+	if(hostSFTIdx<0)
+	{
+		std::cout << "Cannot open " << testFName << std::endl;
+		return 1;
+	}
+	MakeDOS(towns,hostSFTIdx);
+	const uint32_t filePtrAddr=SFTEntryAddr(0x100,2)+0x15;
+
+
+	std::vector <unsigned char> data;
+	if(true!=tgdrv.HostReadFromHandle(data,TGDRV_HANDLE,50,true) ||
+	   50!=data.size() ||
+	   FileByte(100)!=data[0] ||
+	   FileByte(149)!=data[49] ||
+	   150!=towns.mem.FetchDword(filePtrAddr))
+	{
+		std::cout << "Read from a Tsugaru Drive file failed." << std::endl;
+		return 1;
+	}
+	if(true==tgdrv.HostReadFromHandle(data,CLOSED_HANDLE,50,true) ||
+	   true==tgdrv.HostReadFromHandle(data,LOCAL_HANDLE,50,true) ||
+	   true==tgdrv.HostReadFromHandle(data,25,50,true))
+	{
+		std::cout << "Host read must leave closed, local, or out-of-table handles to DOS." << std::endl;
+		return 1;
+	}
+	towns.mem.StoreWord(SFTEntryAddr(0x100,2)+0x02,1);
+	if(true==tgdrv.HostReadFromHandle(data,TGDRV_HANDLE,50,true))
+	{
+		std::cout << "Host read must leave a write-only file to DOS." << std::endl;
+		return 1;
+	}
+	towns.mem.StoreWord(SFTEntryAddr(0x100,2)+0x02,0);
+
+
+	towns.var.hostServiceMode=FMTownsCommon::Variable::HOSTSVC_OFF;
+	SetUpINT21H_3FH(towns,TGDRV_HANDLE,20);
+	if(true==towns.HostINT21H())
+	{
+		std::cout << "Host service must be off by default." << std::endl;
+		return 1;
+	}
+
+	towns.var.hostServiceMode=FMTownsCommon::Variable::HOSTSVC_ON;
+	SetUpINT21H_3FH(towns,TGDRV_HANDLE,20);
+	if(true!=towns.HostINT21H() ||
+	   20!=cpu.GetAX() ||
+	   true==cpu.GetCF() ||
+	   170!=towns.mem.FetchDword(filePtrAddr) ||
+	   1!=towns.var.hostServiceCount ||
+	   20!=towns.var.hostServiceBytes ||
+	   true!=CheckBuffer(towns,150,20,"HOSTSVC_ON"))
+	{
+		std::cout << "INT 21H AH=3FH by the host failed." << std::endl;
+		return 1;
+	}
+
+	// Runs past the end of file.
+	towns.mem.StoreDword(filePtrAddr,990);
+	SetUpINT21H_3FH(towns,TGDRV_HANDLE,20);
+	if(true!=towns.HostINT21H() ||
+	   10!=cpu.GetAX() ||
+	   1000!=towns.mem.FetchDword(filePtrAddr) ||
+	   true!=CheckBuffer(towns,990,10,"End of file"))
+	{
+		std::cout << "INT 21H AH=3FH at the end of file failed." << std::endl;
+		return 1;
+	}
+
+	SetUpINT21H_3FH(towns,LOCAL_HANDLE,20);
+	if(true==towns.HostINT21H())
+	{
+		std::cout << "INT 21H AH=3FH on a local file must go to DOS." << std::endl;
+		return 1;
+	}
+	SetUpINT21H_3FH(towns,TGDRV_HANDLE,20);
+	cpu.SetDX(0xFFF0);
+	if(true==towns.HostINT21H())
+	{
+		std::cout << "INT 21H AH=3FH beyond the segment limit must go to DOS." << std::endl;
+		return 1;
+	}
+
+
+	// Verify mode lets DOS run, and compares at the return.
+	towns.var.hostServiceMode=FMTownsCommon::Variable::HOSTSVC_VERIFY;
+	towns.mem.StoreDword(filePtrAddr,300);
+	SetUpINT21H_3FH(towns,TGDRV_HANDLE,30);
+	if(true==towns.HostINT21H() ||
+	   true!=towns.var.hostServiceVerification.pending ||
+	   300!=towns.mem.FetchDword(filePtrAddr))
+	{
+		std::cout << "HOSTSVC_VERIFY must leave the call and the file pointer to DOS." << std::endl;
+		return 1;
+	}
+	// What DOS would do.
+	for(unsigned int i=0; i<30; ++i)
+	{
+		towns.mem.StoreByte(BUFSEG*0x10+0x10+i,FileByte(300+i));
+	}
+	cpu.SetAX(30);
+	cpu.SetCF(false);
+	towns.InterceptINT21HReturn(0x1000,0x200);
+	if(1!=towns.var.hostServiceVerified || 0!=towns.var.hostServiceMismatch || true==towns.var.hostServiceVerification.pending)
+	{
+		std::cout << "HOSTSVC_VERIFY reported a mismatch for the same result." << std::endl;
+		return 1;
+	}
+
+	SetUpINT21H_3FH(towns,TGDRV_HANDLE,30);
+	towns.HostINT21H();
+	towns.InterceptINT21HReturn(0x1000,0x300); // Return from a different INT 21H.
+	if(1!=towns.var.hostServiceVerified || true!=towns.var.hostServiceVerification.pending)
+	{
+		std::cout << "HOSTSVC_VERIFY must wait for the return from the same INT 21H." << std::endl;
+		return 1;
+	}
+	towns.mem.StoreByte(BUFSEG*0x10+0x10+29,~FileByte(329));
+	cpu.SetAX(30);
+	cpu.SetCF(false);
+	towns.InterceptINT21HReturn(0x1000,0x200);
+	if(2!=towns.var.hostServiceVerified || 1!=towns.var.hostServiceMismatch)
+	{
+		std::cout << "HOSTSVC_VERIFY did not catch a mismatch." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,138 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <cstring>
+
+#include "cpputil.h"
+#include "towns.h"
+
+
+
+void SetFlatSegment(i486DXCommon::SegmentRegister &seg)
+{
+	seg.value=0;
+	seg.baseLinearAddr=0;
+	seg.operandSize=32;
+	seg.addressSize=32;
+	seg.limit=0xFFFFFFFF;
+}
+
+int main(void)
+{
+	static FMTownsWithMediumFidelityCPU towns;
+	auto &physMem=towns.physMem;
+	auto &mem=towns.mem;
+	auto &cpu=towns.CPU();
+
+	// Direct-mapped VRAM gives read and write windows while the mask is all ones.
+	{
+		auto memWin=mem.GetMemoryWindow(TOWNSADDR_VRAM0_BASE+0x1234);
+		auto constMemWin=mem.GetConstMemoryWindow(TOWNSADDR_VRAM0_BASE+0x1234);
+		if(physMem.state.VRAM+0x1000!=memWin.ptr || physMem.state.VRAM+0x1000!=constMemWin.ptr)
+		{
+			std::cout << "VRAM window is not given." << std::endl;
+			return 1;
+		}
+		memWin=mem.GetMemoryWindow(TOWNSADDR_VRAM_HIGHRES1_BASE+0x1000);
+		if(physMem.state.VRAM+0x81000!=memWin.ptr)
+		{
+			std::cout << "High-Res VRAM window 1 is not displaced." << std::endl;
+			return 1;
+		}
+		// Single-page VRAM interleaves layers, and cannot be accessed through a window.
+		if(nullptr!=mem.GetMemoryWindow(TOWNSADDR_VRAM1_BASE).ptr)
+		{
+			std::cout << "Single-page VRAM gave a window." << std::endl;
+			return 1;
+		}
+	}
+
+	// Sprite RAM and ROMs.
+	{
+		auto memWin=mem.GetMemoryWindow(TOWNSADDR_SPRITERAM_BASE+0x2345);
+		if(physMem.state.spriteRAM+0x2000!=memWin.ptr)
+		{
+			std::cout << "Sprite RAM window is not given." << std::endl;
+			return 1;
+		}
+
+		physMem.dosRom.clear();
+		if(nullptr!=mem.GetConstMemoryWindow(TOWNSADDR_OSROM_BASE+0x3000).ptr)
+		{
+			std::cout << "OS ROM window is given without the ROM image." << std::endl;
+			return 1;
+		}
+		physMem.dosRom.resize(512*1024);
+		if(physMem.dosRom.data()+0x3000!=mem.GetConstMemoryWindow(TOWNSADDR_OSROM_BASE+0x3456).ptr ||
+		   nullptr!=mem.GetMemoryWindow(TOWNSADDR_OSROM_BASE+0x3456).ptr)
+		{
+			std::cout << "OS ROM window must be read-only." << std::endl;
+			return 1;
+		}
+		physMem.fontRom.resize(256*1024);
+		if(physMem.fontRom.data()+0x1000!=mem.GetConstMemoryWindow(TOWNSADDR_FONT_BASE+0x1000).ptr)
+		{
+			std::cout << "Font ROM window is not given." << std::endl;
+			return 1;
+		}
+	}
+
+	// The CPU takes SS:ESP window in VRAM, and then the VRAM mask is turned on.
+	// Next PUSH must not write through the old window.
+	cpu.Reset();
+	cpu.SetCR(0,i486DXCommon::CR0_PROTECTION_ENABLE,mem);
+	SetFlatSegment(cpu.state.CS());
+	SetFlatSegment(cpu.state.SS());
+	SetFlatSegment(cpu.state.DS());
+	physMem.state.RAM[0x1000]=0x50; // PUSH EAX
+	physMem.state.RAM[0x1001]=0x50; // PUSH EAX
+	cpu.state.EIP=0x1000;
+	cpu.state.ESP()=TOWNSADDR_VRAM0_BASE+0x2000;
+	cpu.state.EAX()=0xFFFFFFFF;
+	memset(physMem.state.VRAM+0x1FF8,0,8);
+
+	towns.RunOneInstruction();
+	if(0xFFFFFFFF!=cpputil::GetDword(physMem.state.VRAM+0x1FFC))
+	{
+		std::cout << "PUSH to VRAM failed." << std::endl;
+		return 1;
+	}
+
+	auto generation=mem.GetWindowGeneration();
+	physMem.IOWriteByte(TOWNSIO_VRAMACCESSCTRL_ADDR,0);
+	physMem.IOWriteByte(TOWNSIO_VRAMACCESSCTRL_DATA_LOW,0x0F);
+	physMem.IOWriteByte(TOWNSIO_VRAMACCESSCTRL_DATA_HIGH,0x0F);
+	if(generation==mem.GetWindowGeneration())
+	{
+		std::cout << "Turning on the VRAM mask did not change the window generation." << std::endl;
+		return 1;
+	}
+	if(nullptr!=mem.GetMemoryWindow(TOWNSADDR_VRAM0_BASE).ptr || nullptr==mem.GetConstMemoryWindow(TOWNSADDR_VRAM0_BASE).ptr)
+	{
+		std::cout << "Masked VRAM must give a read-only window." << std::endl;
+		return 1;
+	}
+
+	towns.RunOneInstruction();
+	auto pushed=cpputil::GetDword(physMem.state.VRAM+0x1FF8);
+	if(0xFFFF0F0F!=pushed)
+	{
+		std::cout << "PUSH bypassed the VRAM mask. " << cpputil::Uitox(pushed) << std::endl;
+		return 1;
+	}
+
+	std::cout << "VRAM/ROM memory windows OK." << std::endl;
+	return 0;
+}
@@ -14,6 +14,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 << LICENSE */
 #include <iostream>
 #include <math.h>
+#include <string.h>
 #include "discimg.h"
 #include "cdrom.h"
 #include "townsdef.h"
@@ -22,47 +23,181 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 TownsCDROM::AsyncWaveReader::AsyncWaveReader()
 {
+	ring.resize(RING_BUFFER_SIZE);
 }
 TownsCDROM::AsyncWaveReader::~AsyncWaveReader()
 {
-	if(STATE_IDLE!=GetState())
+	lock.lock();
+	terminate=true;
+	lock.unlock();
+	cond.notify_all();
+	if(true==thr.joinable())
 	{
 		thr.join();
-		state=STATE_IDLE;
 	}
 }
 unsigned int TownsCDROM::AsyncWaveReader::GetState(void)
 {
-	stateLock.lock();
-	auto stateCopy=state;
-	stateLock.unlock();
-	return stateCopy;
+	std::unique_lock <std::mutex> lk(lock);
+	if(true!=active)
+	{
+		return STATE_IDLE;
+	}
+	if(0<ringFilled || 0==length || (true!=repeat && length<=nextReadPos))
+	{
+		return STATE_DATAREADY;
+	}
+	return STATE_BUSY;
+}
+void TownsCDROM::AsyncWaveReader::Start(DiscImage *discImg,DiscImage::MinSecFrm from,DiscImage::MinSecFrm to,unsigned long long int startPos)
+{
+	{
+		std::unique_lock <std::mutex> lk(lock);
+		this->discImg=discImg;
+		this->from=from;
+		this->to=to;
+		this->length=discImg->GetWaveLength(from,to);
+		this->repeat=false;
+		this->active=true;
+		Retarget(startPos);
+		if(true!=thr.joinable())
+		{
+			std::thread t(&TownsCDROM::AsyncWaveReader::ThreadFunc,this);
+			std::swap(t,thr);
+		}
+	}
+	cond.notify_all();
+}
+void TownsCDROM::AsyncWaveReader::Stop(void)
+{
+	std::unique_lock <std::mutex> lk(lock);
+	active=false;
+	++generation;
+	ringFilled=0;
+	cond.notify_all();
+	cond.wait(lk,[&]{return true!=reading;});
 }
-void TownsCDROM::AsyncWaveReader::Start(DiscImage *discImg,DiscImage::MinSecFrm from,DiscImage::MinSecFrm to)
+void TownsCDROM::AsyncWaveReader::SetRepeat(bool repeat)
 {
-	if(STATE_IDLE!=GetState())
 	{
-		thr.join(); // Just in case.  Flush the last task.
+		std::unique_lock <std::mutex> lk(lock);
+		this->repeat=repeat;
+	}
+	cond.notify_all();
+}
+unsigned long long int TownsCDROM::AsyncWaveReader::GetLength(void)
+{
+	std::unique_lock <std::mutex> lk(lock);
+	return length;
+}
+size_t TownsCDROM::AsyncWaveReader::Read(unsigned long long int pos,size_t len,unsigned char buf[])
+{
+	std::unique_lock <std::mutex> lk(lock);
+	if(true!=active || 0==length)
+	{
+		return 0;
+	}
+	if(pos!=playPos)
+	{
+		Retarget(pos);
+		cond.notify_all();
+	}
+
+	size_t done=0;
+	while(done<len)
+	{
+		cond.wait(lk,[&]
+		{
+			return 0<ringFilled || true==terminate || true!=active || (true!=repeat && length<=nextReadPos);
+		});
+		if(0==ringFilled)
+		{
+			break;
+		}
+
+		auto n=std::min(len-done,ringFilled);
+		n=std::min(n,RING_BUFFER_SIZE-ringHead);
+		if(nullptr!=buf)
+		{
+			memcpy(buf+done,ring.data()+ringHead,n);
+		}
+		ringHead=(ringHead+n)%RING_BUFFER_SIZE;
+		ringFilled-=n;
+		done+=n;
+		playPos+=n;
+		if(true==repeat && length<=playPos)
+		{
+			playPos-=length;
+		}
+		cond.notify_all();
 	}
-	this->discImg=discImg;
-	this->from=from;
-	this->to=to;
-	this->state=STATE_BUSY;
-	std::thread t(&TownsCDROM::AsyncWaveReader::ThreadFunc,this);
-	std::swap(t,thr);
+	return done;
+}
+void TownsCDROM::AsyncWaveReader::Retarget(unsigned long long int pos)
+{
+	// lock must be locked by the caller.
+	++generation;
+	ringHead=0;
+	ringFilled=0;
+	playPos=pos;
+	nextReadPos=pos;
 }
-std::vector <unsigned char> &TownsCDROM::AsyncWaveReader::GetWave(void)
+bool TownsCDROM::AsyncWaveReader::ReaderHasWork(void) const
 {
-	thr.join();
-	state=STATE_IDLE;
-	return wave;
+	return true==active &&
+	       ringFilled+CHUNK_SIZE<=RING_BUFFER_SIZE &&
+	       (nextReadPos<length || (true==repeat && 0<length));
 }
 void TownsCDROM::AsyncWaveReader::ThreadFunc(void)
 {
-	wave=discImg->GetWave(from,to);
-	stateLock.lock();
-	state=STATE_DATAREADY;
-	stateLock.unlock();
+	std::unique_lock <std::mutex> lk(lock);
+	for(;;)
+	{
+		cond.wait(lk,[&]{return true==terminate || true==ReaderHasWork();});
+		if(true==terminate)
+		{
+			break;
+		}
+		if(length<=nextReadPos)
+		{
+			nextReadPos=0;  // Repeat
+		}
+
+		auto gen=generation;
+		auto pos=nextReadPos;
+		auto img=discImg;
+		auto startHSG=from.ToHSG();
+		auto endHSG=to.ToHSG();
+		auto len=length;
+		reading=true;
+		lk.unlock();
+
+		auto sector=pos/DiscImage::AUDIO_SECTOR_SIZE;
+		auto skip=pos%DiscImage::AUDIO_SECTOR_SIZE;
+		auto chunkSize=std::min<unsigned long long int>(CHUNK_SIZE-skip,len-pos);
+
+		DiscImage::MinSecFrm chunkFrom,chunkTo;
+		chunkFrom.FromHSG(startHSG+sector);
+		chunkTo.FromHSG(std::min<unsigned long long int>(startHSG+sector+CHUNK_NUM_SECTORS,endHSG));
+		auto chunk=img->GetWave(chunkFrom,chunkTo);
+		chunk.resize(skip+chunkSize,0);  // Pad with silence in case the image is shorter than the layout.
+
+		lk.lock();
+		reading=false;
+		if(gen==generation)
+		{
+			for(size_t ptr=0; ptr<chunkSize; )
+			{
+				auto writePos=(ringHead+ringFilled)%RING_BUFFER_SIZE;
+				auto n=std::min<size_t>(chunkSize-ptr,RING_BUFFER_SIZE-writePos);
+				memcpy(ring.data()+writePos,chunk.data()+skip+ptr,n);
+				ringFilled+=n;
+				ptr+=n;
+			}
+			nextReadPos=pos+chunkSize;
+		}
+		cond.notify_all();
+	}
 }
 
 ////////////////////////////////////////////////////////////
@@ -104,7 +239,6 @@ void TownsCDROM::State::Reset(void)
 	nextCDDAPollingTime=0;
 	CDDAEndTime.Set(0,2,0);
 
-	CDDAWave.clear();
 	CDDAPlayPointer=0;
 }
 
@@ -113,7 +247,7 @@ void TownsCDROM::UpdateCDDAStateInternal(long long int townsTime)
 	state.nextCDDAPollingTime=townsTime+CDDA_POLLING_INTERVAL;
 	if(CDDA_PLAYING==state.CDDAState)
 	{
-		if(state.CDDAWave.size()<=state.CDDAPlayPointer)
+		if(waveReader.GetLength()<=state.CDDAPlayPointer)
 		{
 			state.CDDAState=CDDA_STOPPING;
 		}
@@ -161,19 +295,18 @@ TownsCDROM::~TownsCDROM()
 }
 void TownsCDROM::WaitUntilAsyncWaveReaderFinished(void)
 {
-	if(AsyncWaveReader::STATE_IDLE!=waveReader.GetState())
-	{
-		waveReader.GetWave(); // This will join the thread.
-	}
+	waveReader.Stop();
 }
 
 
 /* virtual */ void TownsCDROM::PowerOn(void)
 {
+	DiscardPrefetch();
 	state.Reset();
 }
 /* virtual */ void TownsCDROM::Reset(void)
 {
+	DiscardPrefetch();
 	state.Reset();
 }
 /* virtual */ void TownsCDROM::IOWriteByte(unsigned int ioport,unsigned int data)
@@ -323,18 +456,7 @@ void TownsCDROM::WaitUntilAsyncWaveReaderFinished(void)
 		{
 			if(0==var.sectorCacheForCPUTransfer.size())
 			{
-				if(CDCMD_MODE1READ==(state.cmd&0x9F))
-				{
-					var.sectorCacheForCPUTransfer=state.GetDisc().ReadSectorMODE1(state.readingSectorHSG,1);
-				}
-				else if(CDCMD_MODE2READ==(state.cmd&0x9F))
-				{
-					var.sectorCacheForCPUTransfer=state.GetDisc().ReadSectorMODE2(state.readingSectorHSG,1);
-				}
-				else
-				{
-					var.sectorCacheForCPUTransfer=state.GetDisc().ReadSectorRAW(state.readingSectorHSG,1);
-				}
+				var.sectorCacheForCPUTransfer=ReadDataSector();
 			}
 
 			if(state.CPUTransferPointer<var.sectorCacheForCPUTransfer.size())
@@ -520,7 +642,8 @@ std::vector <std::string> TownsCDROM::GetStatusText(void) const
 
 unsigned int TownsCDROM::LoadDiscImage(const std::string &fName)
 {
-	while(AsyncWaveReader::STATE_BUSY==waveReader.GetState());
+	waveReader.Stop();
+	DiscardPrefetch();
 
 	std::string ext=cpputil::GetExtension(fName.c_str());
 	cpputil::Capitalize(ext);
@@ -548,9 +671,105 @@ unsigned int TownsCDROM::LoadDiscImage(const std::string &fName)
 
 void TownsCDROM::Eject(void)
 {
+	DiscardPrefetch();
 	state.GetDisc().CleanUp();
 }
 
+void TownsCDROM::DiscardPrefetch(void)
+{
+	if(0!=prefetch.ticket)
+	{
+		townsPtr->deviceThread.Wait(prefetch.ticket);
+		prefetch.ticket=0;
+	}
+	prefetch.pending.clear();
+	prefetch.ready.clear();
+}
+
+/* static */ std::vector <unsigned char> TownsCDROM::ReadSectorInMode(const DiscImage &disc,unsigned int readMode,unsigned int HSG)
+{
+	if(CDCMD_MODE1READ==readMode)
+	{
+		return disc.ReadSectorMODE1(HSG,1);
+	}
+	else if(CDCMD_MODE2READ==readMode)
+	{
+		return disc.ReadSectorMODE2(HSG,1);
+	}
+	return disc.ReadSectorRAW(HSG,1);
+}
+
+std::vector <unsigned char> TownsCDROM::ReadDataSector(void)
+{
+	auto &deviceThread=townsPtr->deviceThread;
+	const DiscImage &disc=state.GetDisc();
+	const unsigned int readMode=(state.cmd&0x9F);
+	const unsigned int HSG=state.readingSectorHSG;
+	if(true!=deviceThread.IsRunning())
+	{
+		return ReadSectorInMode(disc,readMode,HSG);
+	}
+
+	if(readMode!=prefetch.readMode)
+	{
+		DiscardPrefetch();
+		prefetch.readMode=readMode;
+	}
+
+	// Wait only if the job is already done, or the sector is in the job.
+	if(0!=prefetch.ticket &&
+	   (true==deviceThread.IsDone(prefetch.ticket) ||
+	    (prefetch.pendingFirstHSG<=HSG && HSG<prefetch.pendingFirstHSG+SectorPrefetch::NUM_SECTORS)))
+	{
+		deviceThread.Wait(prefetch.ticket);
+		prefetch.ticket=0;
+		if(prefetch.pendingFirstHSG!=prefetch.readyFirstHSG+prefetch.ready.size())
+		{
+			prefetch.ready.clear();
+			prefetch.readyFirstHSG=prefetch.pendingFirstHSG;
+		}
+		for(auto &sector : prefetch.pending)
+		{
+			prefetch.ready.push_back(std::move(sector));
+		}
+		prefetch.pending.clear();
+	}
+
+	std::vector <unsigned char> data;
+	if(prefetch.readyFirstHSG<=HSG && HSG<prefetch.readyFirstHSG+prefetch.ready.size())
+	{
+		// Sectors before HSG won't be read in this sequence.
+		auto i=HSG-prefetch.readyFirstHSG;
+		data.swap(prefetch.ready[i]);
+		prefetch.ready.erase(prefetch.ready.begin(),prefetch.ready.begin()+i+1);
+	}
+	else
+	{
+		data=ReadSectorInMode(disc,readMode,HSG);
+		prefetch.ready.clear();
+	}
+	prefetch.readyFirstHSG=HSG+1;
+
+	if(0==prefetch.ticket && prefetch.ready.size()<SectorPrefetch::NUM_SECTORS/2)
+	{
+		const unsigned int firstHSG=prefetch.readyFirstHSG+(unsigned int)prefetch.ready.size();
+		if(firstHSG<disc.GetNumSectors())
+		{
+			auto discPtr=&disc;
+			auto pendingPtr=&prefetch.pending;
+			prefetch.pendingFirstHSG=firstHSG;
+			prefetch.ticket=deviceThread.Push([discPtr,pendingPtr,readMode,firstHSG]
+			{
+				for(unsigned int i=0; i<SectorPrefetch::NUM_SECTORS && firstHSG+i<discPtr->GetNumSectors(); ++i)
+				{
+					pendingPtr->push_back(ReadSectorInMode(*discPtr,readMode,firstHSG+i));
+				}
+			});
+		}
+	}
+	return data;
+}
+
 void TownsCDROM::BreakOnCommandCheck(const char phase[])
 {
 	if(true==var.debugBreakOnCommandWrite || true==var.debugMonitorCommandWrite)
@@ -703,7 +922,7 @@ void TownsCDROM::DelayedCommandExecution(unsigned long long int townsTime)
 			msfEnd-=offset;
 
 			bool repeat=(1==state.paramQueue[6]); // Should I say 0!= ?
-			state.CDDAWave=waveReader.GetWave();;
+			waveReader.SetRepeat(repeat);
 			state.CDDAPlayPointer=0;
 
 			state.CDDAState=CDDA_PLAYING;
@@ -1145,19 +1364,7 @@ void TownsCDROM::BeginReadSector(DiscImage::MinSecFrm msfBegin,DiscImage::MinSec
 
 					state.headPositionHSG=state.readingSectorHSG;
 
-					std::vector <unsigned char> data;
-					if(CDCMD_MODE1READ==(state.cmd&0x9F))
-					{
-						data=state.GetDisc().ReadSectorMODE1(state.readingSectorHSG,1);
-					}
-					else if(CDCMD_MODE2READ==(state.cmd&0x9F))
-					{
-						data=state.GetDisc().ReadSectorMODE2(state.readingSectorHSG,1);
-					}
-					else
-					{
-						data=state.GetDisc().ReadSectorRAW(state.readingSectorHSG,1);
-					}
+					std::vector <unsigned char> data=ReadDataSector();
 					if(DMACh->currentCount+1<data.size())
 					{
 						data.resize(DMACh->currentCount+1);
@@ -1507,6 +1714,8 @@ void TownsCDROM::SetSIRQ_IRR(void)
 }
 /* virtual */ bool TownsCDROM::SpecificDeserialize(const unsigned char *&data,std::string stateFName,uint32_t version)
 {
+	DiscardPrefetch();
+
 	std::string stateDir,stateName;
 	cpputil::SeparatePathFile(stateDir,stateName,stateFName);
 
@@ -1661,8 +1870,9 @@ void TownsCDROM::ResumeCDDAAfterRestore(void)
 	unsigned int rightLinear=255;
 	if(CDDA_PLAYING==state.CDDAState || CDDA_PAUSED==state.CDDAState)
 	{
-		state.CDDAWave=state.GetDisc().GetWave(state.CDDAStartTime,state.CDDAEndTime);
 		// state.CDDAPlayPointer should have already been set.
+		waveReader.Start(&state.GetDisc(),state.CDDAStartTime,state.CDDAEndTime,state.CDDAPlayPointer);
+		waveReader.SetRepeat(state.CDDARepeat);
 	}
 }
 
@@ -1675,22 +1885,49 @@ void TownsCDROM::AddWaveForNumSamples(unsigned char waveBuf[],unsigned int numSa
 		return;
 	}
 
-	auto CDDAWaveSize=(state.CDDAWave.size()+3)&~3;  // Just in case, force it to be 4*N.
+	auto CDDAWaveSize=waveReader.GetLength();
 	if(0==CDDAWaveSize)
 	{
 		state.CDDAState=CDDA_STOPPING;
 		return;
 	}
 
+	// Take numSamples from the stream.  The stream wraps around to the beginning if repeat.
+	auto &CDDAWave=var.CDDAWaveBuf;
+	CDDAWave.resize(numSamples*4);
+	size_t CDDAWaveFilled=0;
 	if(true==var.CDDAmute)
 	{
-		state.CDDAPlayPointer+=numSamples*4;
-		if(true==state.CDDARepeat)
+		// Nothing to play.  Just advance the pointer without waiting for the disc.
+		// The reader re-targets when un-muted.
+		unsigned long long int playPtr=state.CDDAPlayPointer;
+		playPtr+=CDDAWave.size();
+		if(CDDAWaveSize<=playPtr)
 		{
-			state.CDDAPlayPointer%=CDDAWaveSize;
+			playPtr=(true==state.CDDARepeat ? playPtr%CDDAWaveSize : CDDAWaveSize);
 		}
+		state.CDDAPlayPointer=(unsigned int)playPtr;
+		CDDAWaveFilled=CDDAWave.size();
 	}
-	else
+	while(CDDAWaveFilled<CDDAWave.size() && state.CDDAPlayPointer<CDDAWaveSize)
+	{
+		auto toRead=std::min<unsigned long long int>(CDDAWave.size()-CDDAWaveFilled,CDDAWaveSize-state.CDDAPlayPointer);
+		auto nRead=waveReader.Read(state.CDDAPlayPointer,toRead,CDDAWave.data()+CDDAWaveFilled);
+		if(0==nRead)
+		{
+			// Stream has been stopped.
+			state.CDDAPlayPointer=CDDAWaveSize;
+			break;
+		}
+		CDDAWaveFilled+=nRead;
+		state.CDDAPlayPointer+=nRead;
+		if(true==state.CDDARepeat && CDDAWaveSize<=state.CDDAPlayPointer)
+		{
+			state.CDDAPlayPointer=0;
+		}
+	}
+
+	if(true!=var.CDDAmute)
 	{
 		int Lvol = townsPtr->GetEleVolCDLeft();
 		float Ltr;
@@ -1761,13 +1998,13 @@ void TownsCDROM::AddWaveForNumSamples(unsigned char waveBuf[],unsigned int numSa
 		if(63==Lvol && 63==Rvol)
 		{
 			uint64_t writePtr=0;
-			for(uint64_t i=0; i<numSamples && state.CDDAPlayPointer<CDDAWaveSize; ++i)
+			for(uint64_t i=0; i+4<=CDDAWaveFilled; i+=4)
 			{
 				int L=cpputil::GetSignedWord(waveBuf+writePtr);
 				int R=cpputil::GetSignedWord(waveBuf+writePtr+2);
 
-				L+=cpputil::GetSignedWord(state.CDDAWave.data()+state.CDDAPlayPointer);
-				R+=cpputil::GetSignedWord(state.CDDAWave.data()+state.CDDAPlayPointer+2);
+				L+=cpputil::GetSignedWord(CDDAWave.data()+i);
+				R+=cpputil::GetSignedWord(CDDAWave.data()+i+2);
 
 				L=std::max(std::min(L,32767),-32767);
 				R=std::max(std::min(R,32767),-32767);
@@ -1776,23 +2013,18 @@ void TownsCDROM::AddWaveForNumSamples(unsigned char waveBuf[],unsigned int numSa
 				cpputil::PutWord(waveBuf+writePtr+2,R);
 
 				writePtr+=4;
-				state.CDDAPlayPointer+=4;
-				if(true==state.CDDARepeat && CDDAWaveSize<=state.CDDAPlayPointer)
-				{
-					state.CDDAPlayPointer=0;
-				}
 			}
 		}
 		else
 		{
 			uint64_t writePtr=0;
-			for(uint64_t i=0; i<numSamples && state.CDDAPlayPointer<CDDAWaveSize; ++i)
+			for(uint64_t i=0; i+4<=CDDAWaveFilled; i+=4)
 			{
 				int L=cpputil::GetSignedWord(waveBuf+writePtr);
 				int R=cpputil::GetSignedWord(waveBuf+writePtr+2);
 
-				int Lcd=cpputil::GetSignedWord(state.CDDAWave.data()+state.CDDAPlayPointer);
-				int Rcd=cpputil::GetSignedWord(state.CDDAWave.data()+state.CDDAPlayPointer+2);
+				int Lcd=cpputil::GetSignedWord(CDDAWave.data()+i);
+				int Rcd=cpputil::GetSignedWord(CDDAWave.data()+i+2);
 
 				Lcd=Lcd*Ltr;
 				Rcd=Rcd*Rtr;
@@ -1807,16 +2039,11 @@ void TownsCDROM::AddWaveForNumSamples(unsigned char waveBuf[],unsigned int numSa
 				cpputil::PutWord(waveBuf+writePtr+2,R);
 
 				writePtr+=4;
-				state.CDDAPlayPointer+=4;
-				if(true==state.CDDARepeat && CDDAWaveSize<=state.CDDAPlayPointer)
-				{
-					state.CDDAPlayPointer=0;
-				}
 			}
 		}
-		if(true!=state.CDDARepeat && CDDAWaveSize<=state.CDDAPlayPointer)
-		{
-			state.CDDAState=CDDA_STOPPING;
-		}
+	}
+	if(true!=state.CDDARepeat && CDDAWaveSize<=state.CDDAPlayPointer)
+	{
+		state.CDDAState=CDDA_STOPPING;
 	}
 }
@@ -21,6 +21,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include <string>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <algorithm>
 #include "discimg.h"
 #include "device.h"
@@ -176,6 +177,12 @@ public:
 		CDDA_POLLING_INTERVAL=1000000000/75, // 1 frame = 1/75 second.
 	};
 
+	/*! Streams CDDA wave from the disc image through a ring buffer.
+	    The reader thread reads CHUNK_NUM_SECTORS sectors at a time ahead of the play pointer, up to RING_BUFFER_SIZE bytes.
+	    Start only sets the range, and the reading is done in the reader thread.
+	    If Read is given a position that does not follow the last Read (seek, state load, or mute), the stream is re-targeted to the position.
+	    With repeat, the stream wraps around to the beginning of the range.
+	*/
 	class AsyncWaveReader
 	{
 	public:
@@ -185,22 +192,60 @@ public:
 			STATE_BUSY,
 			STATE_DATAREADY,
 		};
+		enum
+		{
+			CHUNK_NUM_SECTORS=75,  // 1 second
+			CHUNK_SIZE=CHUNK_NUM_SECTORS*DiscImage::AUDIO_SECTOR_SIZE,
+			RING_BUFFER_SIZE=CHUNK_SIZE*8,
+		};
 	private:
 		std::thread thr;
-		std::mutex stateLock;
-		int state=STATE_IDLE;
-		std::vector <unsigned char> wave;
-		DiscImage *discImg;
+		std::mutex lock;
+		std::condition_variable cond;
+		bool terminate=false,reading=false;
+
+		bool active=false;
+		bool repeat=false;
+		DiscImage *discImg=nullptr;
 		DiscImage::MinSecFrm from,to;
+		unsigned long long int length=0;
+
+		// Incremented every time the stream is re-targeted so that the chunk that was being read for the old position is thrown away.
+		unsigned int generation=0;
+
+		std::vector <unsigned char> ring;
+		size_t ringHead=0,ringFilled=0;
+		unsigned long long int playPos=0;  // Stream position of ringHead.
+		unsigned long long int nextReadPos=0;  // Stream position of the next chunk to read.
 
 	public:
 		AsyncWaveReader();
 		~AsyncWaveReader();
 		unsigned int GetState(void);
-		void Start(DiscImage *discImg,DiscImage::MinSecFrm from,DiscImage::MinSecFrm to);
-		std::vector <unsigned char> &GetWave(void);
+
+		/*! Starts streaming the range from the byte offset startPos.
+		*/
+		void Start(DiscImage *discImg,DiscImage::MinSecFrm from,DiscImage::MinSecFrm to,unsigned long long int startPos=0);
+
+		/*! Stops streaming and waits until the reader thread finishes the current chunk.
+		*/
+		void Stop(void);
+
+		void SetRepeat(bool repeat);
+
+		/*! Returns the length of the wave in bytes.  Same as the size of DiscImage::GetWave for the range.
+		*/
+		unsigned long long int GetLength(void);
+
+		/*! Reads len bytes from the stream position pos.  If buf is nullptr, the bytes are skipped.
+		    It waits for the reader thread if the data is not in the ring buffer yet.
+		    Returns the number of bytes read, which is less than len only at the end of the range without repeat.
+		*/
+		size_t Read(unsigned long long int pos,size_t len,unsigned char buf[]);
 
 	private:
+		void Retarget(unsigned long long int pos);
+		bool ReaderHasWork(void) const;
 		void ThreadFunc(void);
 	};
 	AsyncWaveReader waveReader;
@@ -263,8 +308,7 @@ public:
 		DiscImage::MinSecFrm CDDAStartTime,CDDAEndTime;
 		bool CDDARepeat=false;
 
-		std::vector <unsigned char> CDDAWave;
-		unsigned int CDDAPlayPointer=0;
+		unsigned int CDDAPlayPointer=0;  // Byte offset in the wave from CDDAStartTime.  The wave itself is streamed by waveReader.
 
 	private:
 		DiscImage *imgPtr;
@@ -307,11 +351,32 @@ public:
 		unsigned int debugBreakOnSpecificCommand=0xffff;
 
 		std::vector <uint8_t> sectorCacheForCPUTransfer;
+
+		std::vector <uint8_t> CDDAWaveBuf;
 	};
 
 	State state;
 	Variables var;
 
+	/*! Data sectors read ahead on the device thread.  Not part of the machine state.
+	    The job fills pending.  The VM thread moves pending to ready after waiting for the ticket.
+	*/
+	class SectorPrefetch
+	{
+	public:
+		enum
+		{
+			NUM_SECTORS=16,
+		};
+		unsigned int readMode=0;  // state.cmd&0x9F
+		uint64_t ticket=0;
+		unsigned int pendingFirstHSG=0;
+		std::vector <std::vector <unsigned char> > pending;
+		unsigned int readyFirstHSG=0;
+		std::vector <std::vector <unsigned char> > ready;
+	};
+	SectorPrefetch prefetch;
+
 	std::vector <std::string> searchPaths;
 
 	virtual const char *DeviceName(void) const{return "CDROM";}
@@ -376,6 +441,10 @@ public:
 	*/
 	void Eject(void);
 
+	/*! Waits for the prefetch job, and throws away the prefetched sectors.
+	*/
+	void DiscardPrefetch(void);
+
 	/*! 
 	*/
 	void ExecuteCDROMCommand(void);
@@ -386,6 +455,12 @@ public:
 
 	void BeginReadSector(DiscImage::MinSecFrm from,DiscImage::MinSecFrm to);
 
+	/*! Reads state.readingSectorHSG in the mode of state.cmd.
+	    If the device thread is running, the sector is taken from the prefetch, and the following sectors are read ahead.
+	*/
+	std::vector <unsigned char> ReadDataSector(void);
+	static std::vector <unsigned char> ReadSectorInMode(const DiscImage &disc,unsigned int readMode,unsigned int HSG);
+
 	void BreakOnCommandCheck(const char phase[]);
 
 	/*! Call-back from FMTownsCommon class.
@@ -258,6 +258,111 @@ void TownsCRTC::TurnOnVSYNCIRQ(void)
 	townsPtr->pic.SetInterruptRequestBit(TOWNSIRQ_VSYNC,true);
 }
 
+void TownsCRTC::RasterFrame::Clear(void)
+{
+	events.clear();
+}
+
+void TownsCRTC::RasterLogNextFrame(void)
+{
+	std::swap(rasterLog.current,rasterLog.last);
+	rasterLog.current.Clear();
+	rasterLog.current.startState=state;
+	rasterLog.current.spriteVRAMOffset=townsPtr->sprite.DisplayVRAMOffset();
+}
+
+/* static */ TownsCRTC::RasterLayerState TownsCRTC::MakeRasterLayerState(const State &st,unsigned int spriteVRAMOffset)
+{
+	RasterLayerState layerState;
+	layerState.singlePage=LowResCrtcIsInSinglePageMode(st);
+	layerState.showPage[0]=st.ShowPage(0);
+	layerState.showPage[1]=st.ShowPage(1);
+	layerState.priorityPage=st.sifter[1]&1;
+	MakeLowResPageLayerInfo(layerState.layer[0],st,0,spriteVRAMOffset);
+	if(true!=layerState.singlePage)
+	{
+		MakeLowResPageLayerInfo(layerState.layer[1],st,1,spriteVRAMOffset);
+	}
+	return layerState;
+}
+
+/* static */ void TownsCRTC::ApplyRasterEvent(State &st,const RasterEvent &e)
+{
+	switch(e.type)
+	{
+	case RasterEvent::TYPE_PALETTE:
+		st.palette.codeLatch=e.code;
+		st.palette.SetRed(e.red,e.PLT);
+		st.palette.SetGreen(e.green,e.PLT);
+		st.palette.SetBlue(e.blue,e.PLT);
+		return;
+	case RasterEvent::TYPE_CRTC_REG:
+		st.crtcReg[e.reg&(NUM_CRTC_REGISTERS-1)]=e.value;
+		break;
+	case RasterEvent::TYPE_SIFTER:
+		st.sifter[e.reg&3]=(unsigned char)e.value;
+		break;
+	}
+	st.showPageFDA0[0]=(0!=(e.showPage&RasterEvent::SHOW_PAGE_FDA0_0));
+	st.showPageFDA0[1]=(0!=(e.showPage&RasterEvent::SHOW_PAGE_FDA0_1));
+	st.showPage0448[0]=(0!=(e.showPage&RasterEvent::SHOW_PAGE_0448_0));
+	st.showPage0448[1]=(0!=(e.showPage&RasterEvent::SHOW_PAGE_0448_1));
+}
+
+void TownsCRTC::RecordRasterEvent(unsigned int ioport)
+{
+	auto &frame=rasterLog.current;
+	if(true==state.highResCRTCEnabled || RasterEventLog::MAX_EVENTS_PER_FRAME<=frame.events.size())
+	{
+		return;
+	}
+
+	RasterEvent e;
+	e.PLT=0;
+	e.code=0;
+	e.red=0;
+	e.green=0;
+	e.blue=0;
+	e.reg=0;
+	e.value=0;
+	switch(ioport)
+	{
+	case TOWNSIO_ANALOGPALETTE_CODE://=  0xFD90,
+	case TOWNSIO_ANALOGPALETTE_BLUE://=  0xFD92,
+	case TOWNSIO_ANALOGPALETTE_RED://=   0xFD94,
+	case TOWNSIO_ANALOGPALETTE_GREEN://= 0xFD96,
+		e.type=RasterEvent::TYPE_PALETTE;
+		e.PLT=(state.sifter[1]>>4)&3;
+		e.code=state.palette.codeLatch;
+		e.red=state.palette.GetRed(e.PLT);
+		e.green=state.palette.GetGreen(e.PLT);
+		e.blue=state.palette.GetBlue(e.PLT);
+		break;
+	case TOWNSIO_CRTC_DATA_LOW://            0x442,
+	case TOWNSIO_CRTC_DATA_HIGH://           0x443,
+		e.type=RasterEvent::TYPE_CRTC_REG;
+		e.reg=state.crtcAddrLatch;
+		e.value=state.crtcReg[state.crtcAddrLatch];
+		break;
+	case TOWNSIO_VIDEO_OUT_CTRL_DATA://=      0x44A,
+		e.type=RasterEvent::TYPE_SIFTER;
+		e.reg=state.sifterAddrLatch;
+		e.value=state.sifter[state.sifterAddrLatch];
+		break;
+	case TOWNSIO_HSYNC_VSYNC://              0xFDA0
+		e.type=RasterEvent::TYPE_SHOW_PAGE;
+		break;
+	default:
+		return;
+	}
+	e.showPage=(state.showPageFDA0[0] ? RasterEvent::SHOW_PAGE_FDA0_0 : 0)|
+	           (state.showPageFDA0[1] ? RasterEvent::SHOW_PAGE_FDA0_1 : 0)|
+	           (state.showPage0448[0] ? RasterEvent::SHOW_PAGE_0448_0 : 0)|
+	           (state.showPage0448[1] ? RasterEvent::SHOW_PAGE_0448_1 : 0);
+	e.timeInCycle=(uint32_t)(townsPtr->state.townsTime%VSYNC_CYCLE);
+	frame.events.push_back(e);
+}
+
 TownsCRTC::ScreenModeCache::ScreenModeCache()
 {
 	MakeFMRCompatible();
@@ -351,7 +456,11 @@ bool TownsCRTC::InSinglePageMode(void) const
 
 bool TownsCRTC::LowResCrtcIsInSinglePageMode(void) const
 {
-	return (0==(state.sifter[0]&0x10));
+	return LowResCrtcIsInSinglePageMode(state);
+}
+/* static */ bool TownsCRTC::LowResCrtcIsInSinglePageMode(const State &st)
+{
+	return (0==(st.sifter[0]&0x10));
 }
 
 uint32_t TownsCRTC::GetEffectiveVRAMSize(void) const
@@ -414,19 +523,23 @@ Vec2i TownsCRTC::GetPageZoom2X(unsigned char page) const
 	}
 }
 Vec2i TownsCRTC::GetLowResPageZoom2X(unsigned char page) const
+{
+	return GetLowResPageZoom2X(state,page);
+}
+/* static */ Vec2i TownsCRTC::GetLowResPageZoom2X(const State &st,unsigned char page)
 {
 	Vec2i zoom;
-	auto pageZoom=(state.crtcReg[REG_ZOOM]>>(8*page));
+	auto pageZoom=(st.crtcReg[REG_ZOOM]>>(8*page));
 	zoom.x()=(( pageZoom    &15)+1);
 	zoom.y()=(((pageZoom>>4)&15)+1);
 
 	// I'm not sure if this logic is correct.  This doesn't cover screen mode 16.
-	if(15==GetHorizontalFrequency())
+	if(15==GetHorizontalFrequency(st))
 	{
-		if(true==LowResCrtcIsInSinglePageMode())
+		if(true==LowResCrtcIsInSinglePageMode(st))
 		{
-			auto FO=state.crtcReg[REG_FO0+4*page];
-			auto LO=state.crtcReg[REG_LO0+4*page];
+			auto FO=st.crtcReg[REG_FO0+4*page];
+			auto LO=st.crtcReg[REG_LO0+4*page];
 			if(0==FO || FO==LO)  // FO==LO condition is to render GENOCIDE2 opening correctly.
 			{
 				zoom[1]*=4;
@@ -441,7 +554,7 @@ Vec2i TownsCRTC::GetLowResPageZoom2X(unsigned char page) const
 			zoom[1]*=4;
 		}
 	}
-	else if(3==CLKSEL() && 0x29D==state.crtcReg[REG_HST])
+	else if(3==CLKSEL(st) && 0x29D==st.crtcReg[REG_HST])
 	{
 		// VING games use this settings.  Apparently zoom-x needs to be interpreted as 4+(pageZoom&15).
 		// Chase HQ        HST=029DH  ZOOM=1111H  Zoom2X=5
@@ -475,6 +588,10 @@ Vec2i TownsCRTC::GetPageOriginOnMonitor(unsigned char page) const
 	}
 }
 Vec2i TownsCRTC::GetLowResPageOriginOnMonitor(unsigned char page) const
+{
+	return GetLowResPageOriginOnMonitor(state,page);
+}
+/* static */ Vec2i TownsCRTC::GetLowResPageOriginOnMonitor(const State &st,unsigned char page)
 {
 	int x0,y0;
 	static const int reg[6]=
@@ -486,16 +603,16 @@ Vec2i TownsCRTC::GetLowResPageOriginOnMonitor(unsigned char page) const
 	   If my interpretation is correct, CRTC won't start scanning VRAM until reaching HAJ0,
 	   making the left-edge be at HAJ0, not HDS0.
 	*/
-	auto HDS=std::max(state.crtcReg[reg[page*3]],state.crtcReg[reg[page*3+1]]);
-	auto VDS=state.crtcReg[reg[page*3+2]];
-	switch(CLKSEL())
+	auto HDS=std::max(st.crtcReg[reg[page*3]],st.crtcReg[reg[page*3+1]]);
+	auto VDS=st.crtcReg[reg[page*3+2]];
+	switch(CLKSEL(st))
 	{
 	case 0:
 		x0=(HDS-0x129)>>1;
 		y0=(VDS-0x2a)>>1; // I'm not sure if I should divide by 2.  Will need experiments.
 		break;
 	case 1:
-		if(0x31F==state.crtcReg[REG_HST])
+		if(0x31F==st.crtcReg[REG_HST])
 		{
 			// RAGNAROK in Free Software Collection 10 uses this setting.
 			// It is unknown if any other programs use the same setting at this time.
@@ -518,7 +635,7 @@ Vec2i TownsCRTC::GetLowResPageOriginOnMonitor(unsigned char page) const
 		// TBIOS exclusively uses CLKSEL=3 for 24KHz mode, in which case 0x9C is the left-edge of the monitor, and
 		// 0x40 is the top-edge.
 		// I still don't know the correct way to calculate he origin on the monitor.  I make an ad-hoc fix for the time being.
-		if(0x29D!=state.crtcReg[REG_HST])
+		if(0x29D!=st.crtcReg[REG_HST])
 		{
 			x0=(HDS-0x9c);
 			y0=(VDS-0x40)>>1;
@@ -536,7 +653,7 @@ Vec2i TownsCRTC::GetLowResPageOriginOnMonitor(unsigned char page) const
 	}
 
 	// Probably >>
-	if(15==GetHorizontalFrequency())
+	if(15==GetHorizontalFrequency(st))
 	{
 		y0<<=1;
 	}
@@ -553,14 +670,18 @@ Vec2i TownsCRTC::GetLowResPageOriginOnMonitor(unsigned char page) const
 	return Vec2i::Make(x0,y0);
 }
 unsigned int TownsCRTC::GetVRAMHSkip1X(unsigned char page) const
+{
+	return GetVRAMHSkip1X(state,page);
+}
+/* static */ unsigned int TownsCRTC::GetVRAMHSkip1X(const State &st,unsigned char page)
 {
 	static const unsigned int regs[2][2]=
 	{
 		{REG_HAJ0,REG_HDS0},
 		{REG_HAJ1,REG_HDS1},
 	};
-	int HAJ=state.crtcReg[regs[page][0]];
-	int HDS=state.crtcReg[regs[page][1]];
+	int HAJ=st.crtcReg[regs[page][0]];
+	int HDS=st.crtcReg[regs[page][1]];
 	if(HAJ<HDS)
 	{
 		return (HDS-HAJ);
@@ -569,15 +690,19 @@ unsigned int TownsCRTC::GetVRAMHSkip1X(unsigned char page) const
 }
 Vec2i TownsCRTC::GetPageSizeOnMonitor(unsigned char page) const
 {
-	auto KHz=GetHorizontalFrequency();
-	auto wid=state.crtcReg[REG_HDE0+page*2]-state.crtcReg[REG_HDS0+page*2];
-	auto hei=state.crtcReg[REG_VDE0+page*2]-state.crtcReg[REG_VDS0+page*2];
+	return GetPageSizeOnMonitor(state,page);
+}
+/* static */ Vec2i TownsCRTC::GetPageSizeOnMonitor(const State &st,unsigned char page)
+{
+	auto KHz=GetHorizontalFrequency(st);
+	auto wid=st.crtcReg[REG_HDE0+page*2]-st.crtcReg[REG_HDS0+page*2];
+	auto hei=st.crtcReg[REG_VDE0+page*2]-st.crtcReg[REG_VDS0+page*2];
 	if(15==KHz)
 	{
 		wid/=2;
 		hei*=2;
 	}
-	else if(3==CLKSEL() && 0x29D==state.crtcReg[REG_HST]) // VING Setting
+	else if(3==CLKSEL(st) && 0x29D==st.crtcReg[REG_HST]) // VING Setting
 	{
 		// VING games use this settings.  Apparently zoom-x needs to be interpreted as 4+(pageZoom&15).
 		// Chase HQ        HDS0=0082H  HDE0=00282H (Diff=512)  HST=029DH  ZOOM=1111H  Zoom2X=5  wid=640
@@ -601,7 +726,7 @@ Vec2i TownsCRTC::GetPageSizeOnMonitor(unsigned char page) const
 		// Looks like zoom2X=5 -> wid*5/4
 		//            zoom2X=2 -> wid*4/4
 
-		auto zoom=GetLowResPageZoom2X(page);
+		auto zoom=GetLowResPageZoom2X(st,page);
 		if(5<=zoom.x())  // I have zero confidence in this condition.  It just takes care of known cases.
 		{
 			wid*=zoom.x();
@@ -612,8 +737,8 @@ Vec2i TownsCRTC::GetPageSizeOnMonitor(unsigned char page) const
 			wid=640;
 		}
 	}
-	auto FO=state.crtcReg[REG_FO0+4*page];
-	auto LO=state.crtcReg[REG_LO0+4*page];
+	auto FO=st.crtcReg[REG_FO0+4*page];
+	auto LO=st.crtcReg[REG_LO0+4*page];
 	if(0==FO || FO==LO)  // FO==LO condition is to render GENOCIDE2 opening correctly.
 	{
 		hei/=2;
@@ -623,10 +748,14 @@ Vec2i TownsCRTC::GetPageSizeOnMonitor(unsigned char page) const
 }
 Vec2i TownsCRTC::GetPageVRAMCoverageSize1X(unsigned char page) const
 {
-	auto wid=state.crtcReg[REG_HDE0+page*2]-state.crtcReg[REG_HDS0+page*2];
-	auto hei=state.crtcReg[REG_VDE0+page*2]-state.crtcReg[REG_VDS0+page*2];
-	auto FO=state.crtcReg[REG_FO0+4*page];
-	auto LO=state.crtcReg[REG_LO0+4*page];
+	return GetPageVRAMCoverageSize1X(state,page);
+}
+/* static */ Vec2i TownsCRTC::GetPageVRAMCoverageSize1X(const State &st,unsigned char page)
+{
+	auto wid=st.crtcReg[REG_HDE0+page*2]-st.crtcReg[REG_HDS0+page*2];
+	auto hei=st.crtcReg[REG_VDE0+page*2]-st.crtcReg[REG_VDS0+page*2];
+	auto FO=st.crtcReg[REG_FO0+4*page];
+	auto LO=st.crtcReg[REG_LO0+4*page];
 	if(0==FO || FO==LO)  // FO==LO condition is to render GENOCIDE2 opening correctly.
 	{
 		hei/=2;
@@ -635,8 +764,12 @@ Vec2i TownsCRTC::GetPageVRAMCoverageSize1X(unsigned char page) const
 }
 unsigned int TownsCRTC::GetPageBitsPerPixel(unsigned char page) const
 {
-	const unsigned int CL=(state.crtcReg[REG_CR0]>>(page*2))&3;
-	if(true==LowResCrtcIsInSinglePageMode())
+	return GetPageBitsPerPixel(state,page);
+}
+/* static */ unsigned int TownsCRTC::GetPageBitsPerPixel(const State &st,unsigned char page)
+{
+	const unsigned int CL=(st.crtcReg[REG_CR0]>>(page*2))&3;
+	if(true==LowResCrtcIsInSinglePageMode(st))
 	{
 		if(2==CL)
 		{
@@ -663,17 +796,21 @@ unsigned int TownsCRTC::GetPageBitsPerPixel(unsigned char page) const
 	return 4; // What else can I do?
 }
 unsigned int TownsCRTC::GetPageVRAMAddressOffset(unsigned char page) const
+{
+	return GetPageVRAMAddressOffset(state,page);
+}
+/* static */ unsigned int TownsCRTC::GetPageVRAMAddressOffset(const State &st,unsigned char page)
 {
 	// [2] pp. 145
-	auto FA0=state.crtcReg[REG_FA0+page*4];
-	switch(GetPageBitsPerPixel(page))
+	auto FA0=st.crtcReg[REG_FA0+page*4];
+	switch(GetPageBitsPerPixel(st,page))
 	{
 	case 4:
 		return FA0*4;  // 8 pixels for 1 count.
 	case 8:
 		return FA0*8;  // 8 pixels for 1 count.
 	case 16:
-		return (LowResCrtcIsInSinglePageMode() ? FA0*8 : FA0*4); // 4 pixels or 2 pixels depending on the single-page or 2-page mode.
+		return (LowResCrtcIsInSinglePageMode(st) ? FA0*8 : FA0*4); // 4 pixels or 2 pixels depending on the single-page or 2-page mode.
 	}
 	return 0;
 }
@@ -690,9 +827,13 @@ unsigned int TownsCRTC::GetPriorityPage(void) const
 }
 unsigned int TownsCRTC::GetPageBytesPerLine(unsigned char page) const
 {
-	auto LOx=state.crtcReg[REG_LO0+page*4];
+	return GetPageBytesPerLine(state,page);
+}
+/* static */ unsigned int TownsCRTC::GetPageBytesPerLine(const State &st,unsigned char page)
+{
+	auto LOx=st.crtcReg[REG_LO0+page*4];
 	auto numBytes=LOx*4;   // Why did I think it was (LOx-FOx)*4?
-	if(true==LowResCrtcIsInSinglePageMode())
+	if(true==LowResCrtcIsInSinglePageMode(st))
 	{
 		numBytes*=2;
 	}
@@ -724,26 +865,30 @@ const TownsCRTC::AnalogPalette &TownsCRTC::GetPalette(void) const
 }
 
 void TownsCRTC::MakeLowResPageLayerInfo(Layer &layer,unsigned char page) const
+{
+	MakeLowResPageLayerInfo(layer,state,page,townsPtr->sprite.DisplayVRAMOffset());
+}
+/* static */ void TownsCRTC::MakeLowResPageLayerInfo(Layer &layer,const State &st,unsigned char page,unsigned int spriteVRAMOffset)
 {
 	page&=1;
-	layer.bitsPerPixel=GetPageBitsPerPixel(page);
-	layer.originOnMonitor=GetLowResPageOriginOnMonitor(page);
-	layer.sizeOnMonitor=GetPageSizeOnMonitor(page);
-	layer.VRAMCoverage1X=GetPageVRAMCoverageSize1X(page);
-	layer.zoom2x=GetLowResPageZoom2X(page);
+	layer.bitsPerPixel=GetPageBitsPerPixel(st,page);
+	layer.originOnMonitor=GetLowResPageOriginOnMonitor(st,page);
+	layer.sizeOnMonitor=GetPageSizeOnMonitor(st,page);
+	layer.VRAMCoverage1X=GetPageVRAMCoverageSize1X(st,page);
+	layer.zoom2x=GetLowResPageZoom2X(st,page);
 	layer.VRAMAddr=0x40000*page;
-	layer.VRAMOffset=GetPageVRAMAddressOffset(page);
+	layer.VRAMOffset=GetPageVRAMAddressOffset(st,page);
 	if (page == 0) {
-		layer.FlipVRAMOffset = state.FMRVRAMOffset; // Can be applied only to layer 0 in two-layer mode, or in the single-page mode.  Either way page==0.
+		layer.FlipVRAMOffset = st.FMRVRAMOffset; // Can be applied only to layer 0 in two-layer mode, or in the single-page mode.  Either way page==0.
 	} else {
-		layer.FlipVRAMOffset = townsPtr->sprite.DisplayVRAMOffset();
+		layer.FlipVRAMOffset = spriteVRAMOffset;
 	}
-	layer.FMRGVRAMMask=(0==page ? state.FMRGVRAMDisplayPlanes : 0x0F); // GVRAM Planes works as a mask in 4-bit color mode for VRAM layer 0 only.
-	layer.bytesPerLine=GetPageBytesPerLine(page);
+	layer.FMRGVRAMMask=(0==page ? st.FMRGVRAMDisplayPlanes : 0x0F); // GVRAM Planes works as a mask in 4-bit color mode for VRAM layer 0 only.
+	layer.bytesPerLine=GetPageBytesPerLine(st,page);
 
 	// VRAMSkipBytes looks to depend on raw zoom factor.
-	auto rawZoomX=((state.crtcReg[REG_ZOOM]>>(8*page))&15)+1;
-	layer.VRAMHSkipBytes=(((GetVRAMHSkip1X(page)/rawZoomX)*layer.bitsPerPixel)>>3);
+	auto rawZoomX=((st.crtcReg[REG_ZOOM]>>(8*page))&15)+1;
+	layer.VRAMHSkipBytes=(((GetVRAMHSkip1X(st,page)/rawZoomX)*layer.bitsPerPixel)>>3);
 
 	if(true==cpputil::Is2toN(layer.bytesPerLine))
 	{
@@ -753,7 +898,7 @@ void TownsCRTC::MakeLowResPageLayerInfo(Layer &layer,unsigned char page) const
 	{
 		layer.HScrollMask=0xFFFFFFFF;
 	}
-	if(true==LowResCrtcIsInSinglePageMode() && 0==page)
+	if(true==LowResCrtcIsInSinglePageMode(st) && 0==page)
 	{
 		layer.VScrollMask=0x7FFFF;
 	}
@@ -1028,6 +1173,10 @@ void TownsCRTC::MEMIOWriteFMRVRAMDisplayMode(unsigned char data)
 		TurnOffVSYNCIRQ();
 		break;
 	}
+	if(true==rasterLog.enabled)
+	{
+		RecordRasterEvent(ioport);
+	}
 }
 
 /* virtual */ void TownsCRTC::IOWriteWord(unsigned int ioport,unsigned int data)
@@ -1220,7 +1369,11 @@ void TownsCRTC::MEMIOWriteFMRVRAMDisplayMode(unsigned char data)
 
 	default:
 		Device::IOWriteWord(ioport,data); // Let it write twice.
-		break;
+		return; // Raster event is recorded in IOWriteByte.
+	}
+	if(true==rasterLog.enabled)
+	{
+		RecordRasterEvent(ioport);
 	}
 }
 
@@ -1407,7 +1560,11 @@ void TownsCRTC::MEMIOWriteFMRVRAMDisplayMode(unsigned char data)
 		// 0110:000015CB B292                      MOV     DL,92H
 		// 0110:000015CD EE                        OUT     DX,AL
 		Device::IOWriteDword(ioport,data); // Let it write 4 times.
-		break;
+		return; // Raster event is recorded in IOWriteByte.
+	}
+	if(true==rasterLog.enabled)
+	{
+		RecordRasterEvent(ioport);
 	}
 }
 
@@ -325,6 +325,66 @@ public:
 	};
 	ChaseHQPalette chaseHQPalette;
 
+	/* Palette, scroll, and layer-register writes made while the CRTC is drawing a frame.
+	   Each event is tagged with the time in the VSYNC cycle, which TownsRender maps to the line on the monitor.
+	   Only the written register is recorded.  TownsRender replays the events on the registers at the start of
+	   the frame, and draws the frame band by band, each band with the palette and layers at the time.
+	   Only the low-res CRTC is logged.
+	*/
+	class RasterLayerState
+	{
+	public:
+		bool singlePage=false;
+		bool showPage[2]={false,false};
+		unsigned int priorityPage=0;
+		Layer layer[2];
+	};
+	class RasterEvent
+	{
+	public:
+		enum
+		{
+			TYPE_PALETTE,   // Palette code of PLT became red,green,blue.
+			TYPE_CRTC_REG,  // crtcReg[reg]=value
+			TYPE_SIFTER,    // sifter[reg]=value
+			TYPE_SHOW_PAGE, // Only the show-page flags changed.
+		};
+		enum
+		{
+			SHOW_PAGE_FDA0_0=1,
+			SHOW_PAGE_FDA0_1=2,
+			SHOW_PAGE_0448_0=4,
+			SHOW_PAGE_0448_1=8,
+		};
+		unsigned char type;
+		unsigned char PLT,code;
+		unsigned char red,green,blue;
+		unsigned char reg;
+		unsigned char showPage;  // Show-page flags after the write if not TYPE_PALETTE.
+		uint16_t value;
+		uint32_t timeInCycle;
+	};
+	class RasterFrame
+	{
+	public:
+		State startState;  // Registers and palette at the start of the frame.
+		unsigned int spriteVRAMOffset=0;
+		std::vector <RasterEvent> events;
+
+		void Clear(void);
+	};
+	class RasterEventLog
+	{
+	public:
+		enum
+		{
+			MAX_EVENTS_PER_FRAME=8192
+		};
+		bool enabled=false;
+		RasterFrame current,last;
+	};
+	RasterEventLog rasterLog;
+
 	class FMTownsCommon *townsPtr;
 	class TownsSprite *spritePtr;
 	State state;
@@ -384,6 +444,10 @@ public:
 				   Start recording here to get first 16 palettes for sky color, next 16 buildings, and the last road.
 				*/
 				chaseHQPalette.NextFrame();
+				if(true==rasterLog.enabled)
+				{
+					RasterLogNextFrame();
+				}
 				TurnOnVSYNCIRQ();
 			}
 		}
@@ -400,7 +464,18 @@ private:
 	void TurnOffVSYNCIRQ(void);
 	void TurnOnVSYNCIRQ(void);
 
+	void RasterLogNextFrame(void);
+	void RecordRasterEvent(unsigned int ioport);
+
 public:
+	/*! Applies a raster event to the registers.
+	*/
+	static void ApplyRasterEvent(State &st,const RasterEvent &e);
+
+	/*! Makes low-res layers from the registers.
+	*/
+	static RasterLayerState MakeRasterLayerState(const State &st,unsigned int spriteVRAMOffset);
+
 	bool InSinglePageMode(void) const;
 
 
@@ -501,6 +576,20 @@ public:
 
 	void MakeLowResPageLayerInfo(Layer &layer,unsigned char page) const;
 
+	/*! Low-res page calculations from the given registers instead of this->state.
+	    They are used for replaying raster events.
+	*/
+	static bool LowResCrtcIsInSinglePageMode(const State &st);
+	static Vec2i GetLowResPageZoom2X(const State &st,unsigned char page);
+	static Vec2i GetLowResPageOriginOnMonitor(const State &st,unsigned char page);
+	static unsigned int GetVRAMHSkip1X(const State &st,unsigned char page);
+	static Vec2i GetPageSizeOnMonitor(const State &st,unsigned char page);
+	static Vec2i GetPageVRAMCoverageSize1X(const State &st,unsigned char page);
+	static unsigned int GetPageBytesPerLine(const State &st,unsigned char page);
+	static unsigned int GetPageBitsPerPixel(const State &st,unsigned char page);
+	static unsigned int GetPageVRAMAddressOffset(const State &st,unsigned char page);
+	static void MakeLowResPageLayerInfo(Layer &layer,const State &st,unsigned char page,unsigned int spriteVRAMOffset);
+
 	void MEMIOWriteFMRVRAMDisplayMode(unsigned char data);	// [2] pp.158
 
 	virtual void IOWriteByte(unsigned int ioport,unsigned int data);
@@ -521,14 +610,22 @@ public:
 
 	inline unsigned int CLKSEL(void) const
 	{
-		return state.crtcReg[REG_CR1]&3;
+		return CLKSEL(state);
+	}
+	static inline unsigned int CLKSEL(const State &st)
+	{
+		return st.crtcReg[REG_CR1]&3;
 	}
 	inline unsigned int GetHorizontalFrequency(void) const
 	{
-		auto Hz=CLKSELtoHz[CLKSEL()];
-		if(0<state.crtcReg[REG_HST])
+		return GetHorizontalFrequency(state);
+	}
+	static inline unsigned int GetHorizontalFrequency(const State &st)
+	{
+		auto Hz=CLKSELtoHz[CLKSEL(st)];
+		if(0<st.crtcReg[REG_HST])
 		{
-			return (Hz/state.crtcReg[REG_HST])/1000;
+			return (Hz/st.crtcReg[REG_HST])/1000;
 		}
 		return 31; // Just make it 31KHz.  Not to crash.
 	}
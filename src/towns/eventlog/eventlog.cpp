@@ -39,11 +39,14 @@ void TownsEventLog::AddEvent(Event e)
 	if(events.size()==0)
 	{
 		e.t=std::chrono::milliseconds(0);
+		e.townsTime=townsTime0;
 	}
 	else
 	{
+		e.townsTime=events.back().townsTime+std::chrono::duration_cast<std::chrono::nanoseconds>(e.t).count();
 		e.t+=events.back().t;
 	}
+	e.hasTownsTime=true;
 	events.push_back(e);
 }
 void TownsEventLog::BeginRecording(long long int townsTime)
@@ -57,6 +60,7 @@ void TownsEventLog::BeginPlayback(void)
 {
 	mode=MODE_PLAYBACK;
 	t0=std::chrono::system_clock::now();
+	playbackTownsTime0Set=false; // townsTime is not known here.  Taken when Playback is called first time.
 	playbackPtr=events.begin();
 }
 
@@ -142,6 +146,7 @@ void TownsEventLog::SkipPlaybackFileEvent(void)
 		if(events.begin()==playbackPtr)
 		{
 			playbackPtr->tPlayed=std::chrono::system_clock::now();
+			playbackPtr->townsTimePlayed=playbackTownsTime0+(playbackPtr->townsTime-townsTime0);
 		}
 		else
 		{
@@ -149,6 +154,7 @@ void TownsEventLog::SkipPlaybackFileEvent(void)
 			--prevPtr;
 			auto dt=(playbackPtr->t-prevPtr->t);
 			playbackPtr->tPlayed=prevPtr->tPlayed+dt;
+			playbackPtr->townsTimePlayed=prevPtr->townsTimePlayed+(playbackPtr->townsTime-prevPtr->townsTime);
 		}
 		++playbackPtr;
 	}
@@ -162,6 +168,7 @@ void TownsEventLog::LogMouseStart(long long int townsTime)
 		events.push_back(Event());
 		events.back().t=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()-t0);
 		events.back().townsTime=townsTime;
+		events.back().hasTownsTime=true;
 		events.back().eventType=eventType;
 	}
 	else if(MODE_PLAYBACK==mode)
@@ -177,6 +184,7 @@ void TownsEventLog::LogMouseEnd(long long int townsTime)
 		events.push_back(Event());
 		events.back().t=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()-t0);
 		events.back().townsTime=townsTime;
+		events.back().hasTownsTime=true;
 		events.back().eventType=eventType;
 	}
 	else if(MODE_PLAYBACK==mode)
@@ -192,6 +200,7 @@ void TownsEventLog::LogLeftButtonDown(long long int townsTime,int mx,int my)
 		events.push_back(Event());
 		events.back().t=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()-t0);
 		events.back().townsTime=townsTime;
+		events.back().hasTownsTime=true;
 		events.back().eventType=eventType;
 		events.back().mos[0]=mx;
 		events.back().mos[1]=my;
@@ -205,6 +214,7 @@ void TownsEventLog::LogLeftButtonUp(long long int townsTime,int mx,int my)
 		events.push_back(Event());
 		events.back().t=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()-t0);
 		events.back().townsTime=townsTime;
+		events.back().hasTownsTime=true;
 		events.back().eventType=eventType;
 		events.back().mos[0]=mx;
 		events.back().mos[1]=my;
@@ -218,6 +228,7 @@ void TownsEventLog::LogRightButtonDown(long long int townsTime,int mx,int my)
 		events.push_back(Event());
 		events.back().t=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()-t0);
 		events.back().townsTime=townsTime;
+		events.back().hasTownsTime=true;
 		events.back().eventType=eventType;
 		events.back().mos[0]=mx;
 		events.back().mos[1]=my;
@@ -231,6 +242,7 @@ void TownsEventLog::LogRightButtonUp(long long int townsTime,int mx,int my)
 		events.push_back(Event());
 		events.back().t=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()-t0);
 		events.back().townsTime=townsTime;
+		events.back().hasTownsTime=true;
 		events.back().eventType=eventType;
 		events.back().mos[0]=mx;
 		events.back().mos[1]=my;
@@ -244,6 +256,7 @@ void TownsEventLog::LogFileOpen(long long int townsTime,std::string fName)
 		events.push_back(Event());
 		events.back().t=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()-t0);
 		events.back().townsTime=townsTime;
+		events.back().hasTownsTime=true;
 		events.back().eventType=eventType;
 		events.back().fName=fName;
 	}
@@ -256,6 +269,7 @@ void TownsEventLog::LogFileExec(long long int townsTime,std::string fName)
 		events.push_back(Event());
 		events.back().t=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()-t0);
 		events.back().townsTime=townsTime;
+		events.back().hasTownsTime=true;
 		events.back().eventType=eventType;
 		events.back().fName=fName;
 	}
@@ -268,6 +282,7 @@ void TownsEventLog::LogKeyCode(long long int townsTime,unsigned char keyCode1,un
 		events.push_back(Event());
 		events.back().t=std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()-t0);
 		events.back().townsTime=townsTime;
+		events.back().hasTownsTime=true;
 		events.back().eventType=eventType;
 		events.back().keyCode[0]=keyCode1;
 		events.back().keyCode[1]=keyCode2;
@@ -277,6 +292,10 @@ void TownsEventLog::LogKeyCode(long long int townsTime,unsigned char keyCode1,un
 std::vector <std::string> TownsEventLog::GetText(void) const
 {
 	std::vector <std::string> text;
+	if(PLAYBACK_BY_TOWNSTIME==playbackClock)
+	{
+		text.push_back("CLOCK TOWNSTIME");
+	}
 	if(0<events.size())
 	{
 		auto prev=events.front();
@@ -293,6 +312,9 @@ std::vector <std::string> TownsEventLog::GetText(void) const
 			text.back()+=cpputil::Uitoa((int)((e.townsTime-townsTime0)/1000000));
 			text.back()+="ms";
 
+			text.push_back("TWTNS ");
+			text.back()+=std::to_string(e.townsTime-townsTime0);
+
 			switch(e.eventType)
 			{
 			case EVT_LBUTTONDOWN:
@@ -352,6 +374,28 @@ void TownsEventLog::MakeRepeat(void)
 	}
 }
 
+void TownsEventLog::ConvertToTownsTime(void)
+{
+	const Event *prev=nullptr;
+	for(auto &e : events)
+	{
+		if(true!=e.hasTownsTime)
+		{
+			if(nullptr==prev)
+			{
+				e.townsTime=townsTime0+std::chrono::duration_cast<std::chrono::nanoseconds>(e.t).count();
+			}
+			else
+			{
+				e.townsTime=prev->townsTime+std::chrono::duration_cast<std::chrono::nanoseconds>(e.t-prev->t).count();
+			}
+			e.hasTownsTime=true;
+		}
+		prev=&e;
+	}
+	playbackClock=PLAYBACK_BY_TOWNSTIME;
+}
+
 void TownsEventLog::AddClick(int x,int y,int t0,int t1)
 {
 	Event e;
@@ -396,6 +440,8 @@ bool TownsEventLog::LoadEventLog(std::string fName)
 
 		CleanUp();
 		t0=std::chrono::system_clock::now();
+		townsTime0=0;
+		playbackClock=PLAYBACK_BY_REALTIME;
 
 		while(true!=ifp.eof())
 		{
@@ -405,7 +451,24 @@ bool TownsEventLog::LoadEventLog(std::string fName)
 			std::vector <std::string> argv=cpputil::Parser(line.c_str());
 			if(0<argv.size())
 			{
-				if("EVT"==argv[0])
+				if("CLOCK"==argv[0])
+				{
+					if(2<=argv.size() && "TOWNSTIME"==argv[1])
+					{
+						playbackClock=PLAYBACK_BY_TOWNSTIME;
+					}
+					else if(2<=argv.size() && "REALTIME"==argv[1])
+					{
+						playbackClock=PLAYBACK_BY_REALTIME;
+					}
+					else
+					{
+						std::cout << "Unknown clock" << std::endl;
+						std::cout << "  " << line << std::endl;
+						return false;
+					}
+				}
+				else if("EVT"==argv[0])
 				{
 					if(2<=argv.size())
 					{
@@ -485,8 +548,30 @@ bool TownsEventLog::LoadEventLog(std::string fName)
 					}
 					if(2<=argv.size())
 					{
+						// TWTNS, if present, comes after TWT, and overwrites this.
 						events.back().townsTime=cpputil::Atoi(argv[1].c_str());
 						events.back().townsTime*=1000000;
+						events.back().hasTownsTime=true;
+					}
+					else
+					{
+						std::cout << "Too few arguments" << std::endl;
+						std::cout << "  " << line << std::endl;
+						return false;
+					}
+				}
+				else if("TWTNS"==argv[0])
+				{
+					if(0==events.size())
+					{
+						std::cout << "No event defined before this line" << std::endl;
+						std::cout << "  " << line << std::endl;
+						return false;
+					}
+					if(2<=argv.size())
+					{
+						events.back().townsTime=strtoll(argv[1].c_str(),nullptr,10);
+						events.back().hasTownsTime=true;
 					}
 					else
 					{
@@ -603,6 +688,11 @@ bool TownsEventLog::LoadEventLog(std::string fName)
 		}
 
 		ifp.close();
+		if(PLAYBACK_BY_TOWNSTIME==playbackClock)
+		{
+			// Hand-written events may not have TWT.
+			ConvertToTownsTime();
+		}
 		return true;
 	}
 	return false;
@@ -618,6 +708,12 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 {
 	if(MODE_PLAYBACK==mode)
 	{
+		if(true!=playbackTownsTime0Set)
+		{
+			playbackTownsTime0=towns.state.townsTime;
+			playbackTownsTime0Set=true;
+		}
+
 		auto prevPtr=playbackPtr;
 		if(true==dontWaitFileEventInPlayback)
 		{
@@ -630,22 +726,50 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 		}
 		else
 		{
-			std::chrono::time_point <std::chrono::system_clock> baseT;
-			std::chrono::milliseconds dt;
-			if(events.begin()==playbackPtr)
+			// dt and tPassed are in nanoseconds of the playback clock.
+			long long int dt,tPassed;
+			auto now=std::chrono::system_clock::now();
+			if(PLAYBACK_BY_TOWNSTIME==playbackClock)
 			{
-				dt=playbackPtr->t;
-				baseT=t0;
+				long long int baseTownsTime;
+				if(events.begin()==playbackPtr)
+				{
+					dt=playbackPtr->townsTime-townsTime0;
+					baseTownsTime=playbackTownsTime0;
+				}
+				else
+				{
+					auto prev=playbackPtr;
+					--prev;
+					dt=playbackPtr->townsTime-prev->townsTime;
+					baseTownsTime=prev->townsTimePlayed;
+				}
+				tPassed=towns.state.townsTime-baseTownsTime;
 			}
 			else
 			{
-				auto prev=playbackPtr;
-				--prev;
-				dt=playbackPtr->t-prev->t;
-				baseT=prev->tPlayed;
+				std::chrono::time_point <std::chrono::system_clock> baseT;
+				std::chrono::milliseconds dtMillisec;
+				if(events.begin()==playbackPtr)
+				{
+					dtMillisec=playbackPtr->t;
+					baseT=t0;
+				}
+				else
+				{
+					auto prev=playbackPtr;
+					--prev;
+					dtMillisec=playbackPtr->t-prev->t;
+					baseT=prev->tPlayed;
+				}
+				dt=std::chrono::duration_cast<std::chrono::nanoseconds>(dtMillisec).count();
+				tPassed=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration_cast<std::chrono::milliseconds>(now-baseT)).count();
 			}
-			auto now=std::chrono::system_clock::now();
-			auto tPassed=std::chrono::duration_cast<std::chrono::milliseconds>(now-baseT);
+			auto markPlayed=[&]
+			{
+				playbackPtr->tPlayed=now;
+				playbackPtr->townsTimePlayed=towns.state.townsTime;
+			};
 
 			switch(playbackPtr->eventType)
 			{
@@ -653,7 +777,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(true==received_MOS_start)
 				{
 					received_MOS_start=false;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -661,7 +785,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(true==received_MOS_end)
 				{
 					received_MOS_end=false;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -675,7 +799,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 					if(std::abs(mx-playbackPtr->mos.x())<=tol && std::abs(my-playbackPtr->mos.y())<=tol && dt<=tPassed)
 					{
 						towns.SetMouseButtonState(true,false);
-						playbackPtr->tPlayed=now;
+						markPlayed();
 						++playbackPtr;
 					}
 				}
@@ -690,7 +814,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 					if(std::abs(mx-playbackPtr->mos.x())<=tol && std::abs(my-playbackPtr->mos.y())<=tol && dt<=tPassed)
 					{
 						towns.SetMouseButtonState(false,false);
-						playbackPtr->tPlayed=now;
+						markPlayed();
 						++playbackPtr;
 					}
 				}
@@ -705,7 +829,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 					if(std::abs(mx-playbackPtr->mos.x())<=tol && std::abs(my-playbackPtr->mos.y())<=tol && dt<=tPassed)
 					{
 						towns.SetMouseButtonState(false,true);
-						playbackPtr->tPlayed=now;
+						markPlayed();
 						++playbackPtr;
 					}
 				}
@@ -720,7 +844,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 					if(std::abs(mx-playbackPtr->mos.x())<=tol && std::abs(my-playbackPtr->mos.y())<=tol && dt<=tPassed)
 					{
 						towns.SetMouseButtonState(false,false);
-						playbackPtr->tPlayed=now;
+						markPlayed();
 						++playbackPtr;
 					}
 				}
@@ -730,7 +854,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].button[0]=true;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -738,7 +862,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].button[0]=false;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -747,7 +871,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].button[1]=true;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -755,7 +879,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].button[1]=false;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -763,7 +887,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].button[2]=true;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -771,7 +895,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].button[2]=false;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -779,7 +903,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].button[3]=true;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -787,7 +911,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].button[3]=false;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -796,7 +920,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].up=true;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -804,7 +928,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].up=false;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -812,7 +936,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].down=true;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -820,7 +944,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].down=false;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -828,7 +952,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].left=true;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -836,7 +960,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].left=false;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -844,7 +968,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].right=true;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -852,7 +976,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.gameport.state.ports[0].right=false;
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -866,7 +990,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 				if(dt<=tPassed)
 				{
 					towns.keyboard.PushFifo(playbackPtr->keyCode[0],playbackPtr->keyCode[1]);
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -880,7 +1004,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 					byteData|=TOWNS_KEYFLAG_JIS_PRESS;
 
 					towns.keyboard.PushFifo(byteData,playbackPtr->keyCode[0]);
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -893,7 +1017,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 					byteData|=TOWNS_KEYFLAG_JIS_RELEASE;
 
 					towns.keyboard.PushFifo(byteData,playbackPtr->keyCode[0]);
-					playbackPtr->tPlayed=now;
+					markPlayed();
 					++playbackPtr;
 				}
 				break;
@@ -912,6 +1036,7 @@ void TownsEventLog::Playback(class FMTownsCommon &towns)
 					}
 					playbackPtr=events.begin();
 					t0=now;
+					playbackTownsTime0=towns.state.townsTime;
 				}
 				break;
 			}
@@ -73,12 +73,25 @@ public:
 		REP_INFINITY=0x7fffffff
 	};
 
+	/*! Clock that paces the playback.
+	    PLAYBACK_BY_REALTIME waits for the host time (Event::t) to pass, therefore the playback only works at the wall-clock speed.
+	    PLAYBACK_BY_TOWNSTIME waits for the VM time (Event::townsTime) to pass.  The events are played at the same
+	    emulated time regardless of how fast the host runs, including -NOWAIT.
+	*/
+	enum
+	{
+		PLAYBACK_BY_REALTIME,
+		PLAYBACK_BY_TOWNSTIME,
+	};
+
 	class Event
 	{
 	public:
 		std::chrono::milliseconds  t;
 		mutable std::chrono::time_point <std::chrono::system_clock> tPlayed;
-		long long int townsTime;
+		long long int townsTime=0;
+		mutable long long int townsTimePlayed=0;
+		bool hasTownsTime=false; // False if the log only had the wall-clock time for this event.
 		int eventType;
 		Vec2i mos;
 		int mosTolerance=0; // Not saved
@@ -92,9 +105,13 @@ public:
 	std::list <Event>::iterator playbackPtr;
 	bool dontWaitFileEventInPlayback=true;
 	std::chrono::time_point <std::chrono::system_clock>  t0;
-	long long int townsTime0;
+	long long int townsTime0=0;
 	std::list <Event> events;
 
+	int playbackClock=PLAYBACK_BY_REALTIME;
+	bool playbackTownsTime0Set=false;
+	long long int playbackTownsTime0=0;
+
 
 
 	TownsEventLog();
@@ -161,6 +178,12 @@ public:
 
 	void MakeRepeat(void);
 
+	/*! Gives townsTime to the events that only have the wall-clock time, assuming the VM was running at
+	    the real-time speed, and then switches the playback clock to PLAYBACK_BY_TOWNSTIME.
+	    Used for converting the event logs made before townsTime was saved.
+	*/
+	void ConvertToTownsTime(void);
+
 	void AddClick(int x,int y,int t0=100,int t1=100);
 
 	bool SaveEventLog(std::string fName) const;
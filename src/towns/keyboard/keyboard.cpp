@@ -619,8 +619,10 @@ void TownsKeyboard::SetBootKeyCombination(unsigned int keyComb)
 	case TOWNSIO_KEYBOARD_STATUS_CMD:// 0x602, // [2] pp.231
 		if(0<nFifoFilled || BOOT_KEYCOMB_NONE!=state.bootKeyComb)
 		{
+			emptyStatusPollCount=0;
 			return 1; // Data (Keyboard -> CPU) Ready.
 		}
+		++emptyStatusPollCount;
 		return 0;  // IBF=0 Data Empty. Always Ready.
 	case TOWNSIO_KEYBOARD_IRQ://        0x604, // [2] pp.236
 		return (true==state.KBINT ? 1 : 0);
@@ -630,6 +632,7 @@ void TownsKeyboard::SetBootKeyCombination(unsigned int keyComb)
 /* virtual */ void TownsKeyboard::Reset(void)
 {
 	state.Reset();
+	emptyStatusPollCount=0;
 }
 
 /* virtual */ void TownsKeyboard::RunScheduledTask(unsigned long long int townsTime)
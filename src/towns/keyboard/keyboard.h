@@ -58,6 +58,11 @@ public:
 	unsigned char fifoBuf[FIFO_BUF_LEN];
 	std::string autoType;
 
+	/*! Number of consecutive status reads without key data.  Large number means the guest is polling for a key.
+	    Not saved in the state.
+	*/
+	unsigned int emptyStatusPollCount=0;
+
 	bool debugBreakOnReturnKey=false;
 
 	class FMTownsCommon *townsPtr;
@@ -465,6 +465,16 @@ TownsFMRVRAMAccess::TownsFMRVRAMAccess()
 {
 	// It's a ROM.
 }
+/* virtual */ MemoryAccess::ConstMemoryWindow TownsNativeDICROMAccess::GetConstMemoryWindow(unsigned int physAddr) const
+{
+	MemoryAccess::ConstMemoryWindow memWin;
+	const unsigned int offset=(physAddr&(~0xfff)&TOWNSADDR_NATIVE_DICROM_AND);
+	if(offset+MEMORY_WINDOW_SIZE<=physMemPtr->dicRom.size())
+	{
+		memWin.ptr=physMemPtr->dicRom.data()+offset;
+	}
+	return memWin;
+}
 
 
 ////////////////////////////////////////////////////////////
@@ -485,6 +495,46 @@ TownsFMRVRAMAccess::TownsFMRVRAMAccess()
 ////////////////////////////////////////////////////////////
 
 
+MemoryAccess *TownsVRAMFenceAccess::Release(unsigned int physAddr) const
+{
+	physMemPtr->WaitVRAMWriter();
+	// Objects in front of the fence (debugger) already have seen this access.  Skip to the end of the chain.
+	auto memAccess=physMemPtr->memPtr->GetAccessObject(physAddr);
+	while(nullptr!=memAccess->memAccessChain)
+	{
+		memAccess=memAccess->memAccessChain;
+	}
+	return memAccess;
+}
+/* virtual */ unsigned int TownsVRAMFenceAccess::FetchByte(unsigned int physAddr) const
+{
+	return Release(physAddr)->FetchByte(physAddr);
+}
+/* virtual */ unsigned int TownsVRAMFenceAccess::FetchWord(unsigned int physAddr) const
+{
+	return Release(physAddr)->FetchWord(physAddr);
+}
+/* virtual */ unsigned int TownsVRAMFenceAccess::FetchDword(unsigned int physAddr) const
+{
+	return Release(physAddr)->FetchDword(physAddr);
+}
+/* virtual */ void TownsVRAMFenceAccess::StoreByte(unsigned int physAddr,unsigned char data)
+{
+	Release(physAddr)->StoreByte(physAddr,data);
+}
+/* virtual */ void TownsVRAMFenceAccess::StoreWord(unsigned int physAddr,unsigned int data)
+{
+	Release(physAddr)->StoreWord(physAddr,data);
+}
+/* virtual */ void TownsVRAMFenceAccess::StoreDword(unsigned int physAddr,unsigned int data)
+{
+	Release(physAddr)->StoreDword(physAddr,data);
+}
+
+
+////////////////////////////////////////////////////////////
+
+
 /* virtual */ unsigned int TownsSpriteRAMAccess::FetchByte(unsigned int physAddr) const
 {
 	// 0x81000000,0x8101FFFF
@@ -516,6 +566,19 @@ TownsFMRVRAMAccess::TownsFMRVRAMAccess()
 	auto &state=physMemPtr->state;
 	cpputil::PutDword(state.spriteRAM+(physAddr&TOWNSADDR_SPRITERAM_AND),data);
 }
+/* virtual */ MemoryAccess::ConstMemoryWindow TownsSpriteRAMAccess::GetConstMemoryWindow(unsigned int physAddr) const
+{
+	MemoryAccess::ConstMemoryWindow memWin;
+	memWin.ptr=physMemPtr->state.spriteRAM+(physAddr&(~0xfff)&TOWNSADDR_SPRITERAM_AND);
+	return memWin;
+}
+/* virtual */ MemoryAccess::MemoryWindow TownsSpriteRAMAccess::GetMemoryWindow(unsigned int physAddr)
+{
+	// Sprite rendering on the device thread reads a snapshot, not spriteRAM.  Direct writes are safe.
+	MemoryAccess::MemoryWindow memWin;
+	memWin.ptr=physMemPtr->state.spriteRAM+(physAddr&(~0xfff)&TOWNSADDR_SPRITERAM_AND);
+	return memWin;
+}
 
 ////////////////////////////////////////////////////////////
 
@@ -668,6 +731,16 @@ TownsFMRVRAMAccess::TownsFMRVRAMAccess()
 /* virtual */ void TownsOsROMAccess::StoreByte(unsigned int physAddr,unsigned char data)
 {
 }
+/* virtual */ MemoryAccess::ConstMemoryWindow TownsOsROMAccess::GetConstMemoryWindow(unsigned int physAddr) const
+{
+	MemoryAccess::ConstMemoryWindow memWin;
+	const unsigned int offset=(physAddr&(~0xfff)&TOWNSADDR_OSROM_AND);
+	if(offset+MEMORY_WINDOW_SIZE<=physMemPtr->dosRom.size())
+	{
+		memWin.ptr=physMemPtr->dosRom.data()+offset;
+	}
+	return memWin;
+}
 
 
 ////////////////////////////////////////////////////////////
@@ -681,6 +754,16 @@ TownsFMRVRAMAccess::TownsFMRVRAMAccess()
 /* virtual */ void TownsFontROMAccess::StoreByte(unsigned int physAddr,unsigned char data)
 {
 }
+/* virtual */ MemoryAccess::ConstMemoryWindow TownsFontROMAccess::GetConstMemoryWindow(unsigned int physAddr) const
+{
+	MemoryAccess::ConstMemoryWindow memWin;
+	const unsigned int offset=(physAddr&(~0xfff)&TOWNSADDR_FONT_AND);
+	if(offset+MEMORY_WINDOW_SIZE<=physMemPtr->fontRom.size())
+	{
+		memWin.ptr=physMemPtr->fontRom.data()+offset;
+	}
+	return memWin;
+}
 
 ////////////////////////////////////////////////////////////
 
@@ -692,6 +775,16 @@ TownsFMRVRAMAccess::TownsFMRVRAMAccess()
 /* virtual */ void TownsFont20ROMAccess::StoreByte(unsigned int physAddr,unsigned char data)
 {
 }
+/* virtual */ MemoryAccess::ConstMemoryWindow TownsFont20ROMAccess::GetConstMemoryWindow(unsigned int physAddr) const
+{
+	MemoryAccess::ConstMemoryWindow memWin;
+	const unsigned int offset=(physAddr&(~0xfff)&TOWNSADDR_FONT20_AND);
+	if(offset+MEMORY_WINDOW_SIZE<=physMemPtr->font20Rom.size())
+	{
+		memWin.ptr=physMemPtr->font20Rom.data()+offset;
+	}
+	return memWin;
+}
 
 ////////////////////////////////////////////////////////////
 
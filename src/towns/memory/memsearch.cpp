@@ -0,0 +1,492 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+
+#include "cpputil.h"
+#include "memsearch.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2<=_M_IX86_FP)
+	#define TOWNSMEMSEARCH_USE_SSE2
+	#include <emmintrin.h>
+#endif
+
+
+
+static inline uint32_t LoadValue(const unsigned char *ptr,unsigned int unit)
+{
+	switch(unit)
+	{
+	case 1:
+		return *ptr;
+	case 2:
+		return cpputil::GetWord(ptr);
+	default:
+		return cpputil::GetDword(ptr);
+	}
+}
+
+static inline bool Satisfy(unsigned int predicate,uint32_t cur,uint32_t prev,uint32_t value)
+{
+	switch(predicate)
+	{
+	case TownsMemorySearch::PREDICATE_EQUAL_TO_VALUE:
+		return cur==value;
+	case TownsMemorySearch::PREDICATE_INCREASE:
+		return cur>prev;
+	case TownsMemorySearch::PREDICATE_DECREASE:
+		return cur<prev;
+	case TownsMemorySearch::PREDICATE_CHANGED:
+		return cur!=prev;
+	case TownsMemorySearch::PREDICATE_UNCHANGED:
+		return cur==prev;
+	}
+	return false;
+}
+
+static inline unsigned int CountBits(uint64_t bits)
+{
+	bits=bits-((bits>>1)&0x5555555555555555ULL);
+	bits=(bits&0x3333333333333333ULL)+((bits>>2)&0x3333333333333333ULL);
+	bits=(bits+(bits>>4))&0x0F0F0F0F0F0F0F0FULL;
+	return (unsigned int)((bits*0x0101010101010101ULL)>>56);
+}
+
+static inline unsigned int LowestBit(uint64_t bits)
+{
+	unsigned int i=0;
+	while(0==(bits&((uint64_t)1<<i)))
+	{
+		++i;
+	}
+	return i;
+}
+
+#ifdef TOWNSMEMSEARCH_USE_SSE2
+/*! Returns bit i set if offset ptr+i may satisfy the predicate, for i=0 to 15.
+    Reads ptr[0] to ptr[15+unit-1].
+    Exact except for PREDICATE_INCREASE and PREDICATE_DECREASE, for which it returns changed offsets.
+*/
+static inline unsigned int Match16(unsigned int predicate,unsigned int unit,const unsigned char *cur,const unsigned char *prev,uint32_t value)
+{
+	__m128i same=_mm_set1_epi8(-1);
+	if(TownsMemorySearch::PREDICATE_EQUAL_TO_VALUE==predicate)
+	{
+		for(unsigned int i=0; i<unit; ++i)
+		{
+			__m128i c=_mm_loadu_si128((const __m128i *)(cur+i));
+			same=_mm_and_si128(same,_mm_cmpeq_epi8(c,_mm_set1_epi8((char)(value>>(8*i)))));
+		}
+		return _mm_movemask_epi8(same);
+	}
+
+	for(unsigned int i=0; i<unit; ++i)
+	{
+		__m128i c=_mm_loadu_si128((const __m128i *)(cur+i));
+		__m128i p=_mm_loadu_si128((const __m128i *)(prev+i));
+		same=_mm_and_si128(same,_mm_cmpeq_epi8(c,p));
+	}
+	unsigned int unchanged=_mm_movemask_epi8(same);
+	if(TownsMemorySearch::PREDICATE_UNCHANGED==predicate)
+	{
+		return unchanged;
+	}
+	return (~unchanged)&0xFFFF;
+}
+#endif
+
+void TownsMemorySearch::Begin(unsigned int unit)
+{
+	this->unit=unit;
+	regions.clear();
+}
+
+void TownsMemorySearch::AddRegion(uint32_t physAddrBase,const unsigned char mem[],uint32_t size)
+{
+	Region rgn;
+	rgn.physAddrBase=physAddrBase;
+	rgn.size=size;
+	rgn.sparse=false;
+	rgn.all=true;
+	rgn.prevImage.assign(mem,mem+size);
+	regions.push_back(std::move(rgn));
+}
+
+size_t TownsMemorySearch::Apply(unsigned int predicate,uint32_t value,const unsigned char *const current[])
+{
+	if(TownsMemorySearch::PREDICATE_EQUAL_TO_VALUE==predicate && unit<4 && (1u<<(8*unit))<=value)
+	{
+		// Can never be equal.
+		for(auto &rgn : regions)
+		{
+			rgn.sparse=true;
+			rgn.all=false;
+			std::vector <uint64_t>().swap(rgn.candidateBit);
+			std::vector <unsigned char>().swap(rgn.prevImage);
+			rgn.offset.clear();
+			rgn.prevValue.clear();
+		}
+		return 0;
+	}
+
+	for(size_t i=0; i<regions.size(); ++i)
+	{
+		if(true!=regions[i].sparse)
+		{
+			ApplyToBitmap(regions[i],predicate,value,current[i]);
+		}
+		else
+		{
+			ApplyToList(regions[i],predicate,value,current[i]);
+		}
+	}
+	return NumCandidates();
+}
+
+void TownsMemorySearch::ShrinkRegion(size_t regionIndex,uint32_t newSize)
+{
+	if(regions.size()<=regionIndex || regions[regionIndex].size<=newSize)
+	{
+		return;
+	}
+
+	auto &rgn=regions[regionIndex];
+	rgn.size=newSize;
+	if(true==rgn.sparse)
+	{
+		size_t n=0;
+		while(n<rgn.offset.size() && rgn.offset[n]+unit<=newSize)
+		{
+			++n;
+		}
+		rgn.offset.resize(n);
+		rgn.prevValue.resize(n);
+		return;
+	}
+
+	rgn.prevImage.resize(newSize);
+	if(true!=rgn.all)
+	{
+		const uint32_t numPos=NumPositions(rgn);
+		rgn.candidateBit.resize((numPos+63)/64);
+		if(0!=(numPos&63))
+		{
+			rgn.candidateBit.back()&=((uint64_t)1<<(numPos&63))-1;
+		}
+		rgn.numBitmapCandidates=0;
+		for(auto bits : rgn.candidateBit)
+		{
+			rgn.numBitmapCandidates+=CountBits(bits);
+		}
+	}
+}
+
+size_t TownsMemorySearch::NumCandidates(void) const
+{
+	size_t N=0;
+	for(auto &rgn : regions)
+	{
+		N+=NumCandidates(rgn);
+	}
+	return N;
+}
+
+size_t TownsMemorySearch::NumCandidates(const Region &rgn) const
+{
+	if(true==rgn.sparse)
+	{
+		return rgn.offset.size();
+	}
+	if(true==rgn.all)
+	{
+		return NumPositions(rgn);
+	}
+	return rgn.numBitmapCandidates;
+}
+
+std::vector <uint32_t> TownsMemorySearch::GetCandidates(void) const
+{
+	std::vector <uint32_t> addr;
+	for(auto &rgn : regions)
+	{
+		if(true==rgn.sparse)
+		{
+			for(auto offset : rgn.offset)
+			{
+				addr.push_back(rgn.physAddrBase+offset);
+			}
+		}
+		else if(true==rgn.all)
+		{
+			for(uint32_t i=0; i+unit<=rgn.size; ++i)
+			{
+				addr.push_back(rgn.physAddrBase+i);
+			}
+		}
+		else
+		{
+			for(size_t w=0; w<rgn.candidateBit.size(); ++w)
+			{
+				auto bits=rgn.candidateBit[w];
+				while(0!=bits)
+				{
+					auto i=LowestBit(bits);
+					bits&=~((uint64_t)1<<i);
+					addr.push_back(rgn.physAddrBase+(uint32_t)(w*64+i));
+				}
+			}
+		}
+	}
+	return addr;
+}
+
+uint32_t TownsMemorySearch::NumPositions(const Region &rgn) const
+{
+	return (unit<=rgn.size ? rgn.size-unit+1 : 0);
+}
+
+unsigned int TownsMemorySearch::NumThreadsFor(size_t numItems) const
+{
+	unsigned int maxThreads=(0!=numThreads ? numThreads : std::thread::hardware_concurrency());
+	size_t n=numItems/MIN_ITEMS_PER_THREAD;
+	return (unsigned int)std::max<size_t>(1,std::min<size_t>(std::max(1u,maxThreads),n));
+}
+
+/* static */ void TownsMemorySearch::Concatenate(Region &rgn,std::vector <Output> &out)
+{
+	size_t total=0;
+	for(auto &o : out)
+	{
+		total+=o.offset.size();
+	}
+	rgn.offset.clear();
+	rgn.prevValue.clear();
+	rgn.offset.reserve(total);
+	rgn.prevValue.reserve(total);
+	for(auto &o : out)
+	{
+		rgn.offset.insert(rgn.offset.end(),o.offset.begin(),o.offset.end());
+		rgn.prevValue.insert(rgn.prevValue.end(),o.value.begin(),o.value.end());
+	}
+}
+
+void TownsMemorySearch::ApplyToBitmap(Region &rgn,unsigned int predicate,uint32_t value,const unsigned char current[]) const
+{
+	const unsigned int unit=this->unit;
+	const uint32_t numPos=NumPositions(rgn);
+	const size_t numWords=(numPos+63)/64;
+	if(true==rgn.all)
+	{
+		rgn.candidateBit.assign(numWords,~(uint64_t)0);
+		if(0!=(numPos&63))
+		{
+			rgn.candidateBit.back()=((uint64_t)1<<(numPos&63))-1;
+		}
+		rgn.all=false;
+	}
+
+	uint64_t *candidateBit=rgn.candidateBit.data();
+	const unsigned char *prev=rgn.prevImage.data();
+	auto scan=[predicate,value,unit,numPos,current,prev,candidateBit](size_t wordBegin,size_t wordEnd,size_t &count)
+	{
+		count=0;
+		for(size_t w=wordBegin; w<wordEnd; ++w)
+		{
+			uint64_t bits=candidateBit[w];
+			if(0==bits)
+			{
+				continue;
+			}
+
+			const uint32_t pos0=(uint32_t)(w*64);
+			uint64_t keep=0;
+		#ifdef TOWNSMEMSEARCH_USE_SSE2
+			if(pos0+64<=numPos)
+			{
+				const bool exact=(PREDICATE_INCREASE!=predicate && PREDICATE_DECREASE!=predicate);
+				for(unsigned int i=0; i<64; i+=16)
+				{
+					if(0!=((bits>>i)&0xFFFF))
+					{
+						keep|=(uint64_t)Match16(predicate,unit,current+pos0+i,prev+pos0+i,value)<<i;
+					}
+				}
+				keep&=bits;
+				if(true!=exact)
+				{
+					auto check=keep;
+					while(0!=check)
+					{
+						auto i=LowestBit(check);
+						check&=~((uint64_t)1<<i);
+						if(true!=Satisfy(predicate,LoadValue(current+pos0+i,unit),LoadValue(prev+pos0+i,unit),value))
+						{
+							keep&=~((uint64_t)1<<i);
+						}
+					}
+				}
+			}
+			else
+		#endif
+			{
+				while(0!=bits)
+				{
+					auto i=LowestBit(bits);
+					bits&=~((uint64_t)1<<i);
+					if(true==Satisfy(predicate,LoadValue(current+pos0+i,unit),LoadValue(prev+pos0+i,unit),value))
+					{
+						keep|=((uint64_t)1<<i);
+					}
+				}
+			}
+			candidateBit[w]=keep;
+			count+=CountBits(keep);
+		}
+	};
+
+	const unsigned int nThr=NumThreadsFor(numPos);
+	std::vector <size_t> count(nThr,0);
+	if(1==nThr)
+	{
+		scan(0,numWords,count[0]);
+	}
+	else
+	{
+		std::vector <std::thread> thr;
+		for(unsigned int t=0; t<nThr; ++t)
+		{
+			size_t begin=numWords*t/nThr;
+			size_t end=numWords*(t+1)/nThr;
+			thr.push_back(std::thread(scan,begin,end,std::ref(count[t])));
+		}
+		for(auto &t : thr)
+		{
+			t.join();
+		}
+	}
+
+	rgn.numBitmapCandidates=0;
+	for(auto c : count)
+	{
+		rgn.numBitmapCandidates+=c;
+	}
+	if(0<rgn.size)
+	{
+		memcpy(rgn.prevImage.data(),current,rgn.size);
+	}
+	if(rgn.numBitmapCandidates<=numWords*64/SPARSE_RATIO)
+	{
+		MakeSparse(rgn);
+	}
+}
+
+void TownsMemorySearch::MakeSparse(Region &rgn) const
+{
+	rgn.offset.clear();
+	rgn.prevValue.clear();
+	rgn.offset.reserve(rgn.numBitmapCandidates);
+	rgn.prevValue.reserve(rgn.numBitmapCandidates);
+	for(size_t w=0; w<rgn.candidateBit.size(); ++w)
+	{
+		auto bits=rgn.candidateBit[w];
+		while(0!=bits)
+		{
+			auto i=LowestBit(bits);
+			bits&=~((uint64_t)1<<i);
+			const uint32_t offset=(uint32_t)(w*64+i);
+			rgn.offset.push_back(offset);
+			rgn.prevValue.push_back(LoadValue(rgn.prevImage.data()+offset,unit));
+		}
+	}
+	rgn.sparse=true;
+	rgn.all=false;
+	rgn.numBitmapCandidates=0;
+	std::vector <uint64_t>().swap(rgn.candidateBit);
+	std::vector <unsigned char>().swap(rgn.prevImage);
+}
+
+void TownsMemorySearch::ApplyToList(Region &rgn,unsigned int predicate,uint32_t value,const unsigned char current[]) const
+{
+	const unsigned int unit=this->unit;
+	const uint32_t *offset=rgn.offset.data();
+	const uint32_t *prevValue=rgn.prevValue.data();
+
+	auto filter=[predicate,value,unit,current,offset,prevValue](size_t begin,size_t end,Output &out)
+	{
+		for(size_t i=begin; i<end; ++i)
+		{
+			auto cur=LoadValue(current+offset[i],unit);
+			if(true==Satisfy(predicate,cur,prevValue[i],value))
+			{
+				out.offset.push_back(offset[i]);
+				out.value.push_back(cur);
+			}
+		}
+	};
+
+	const size_t numCandidates=rgn.offset.size();
+	std::vector <Output> out;
+	const unsigned int nThr=NumThreadsFor(numCandidates);
+	out.resize(nThr);
+	if(1==nThr)
+	{
+		filter(0,numCandidates,out[0]);
+	}
+	else
+	{
+		std::vector <std::thread> thr;
+		for(unsigned int t=0; t<nThr; ++t)
+		{
+			size_t begin=numCandidates*t/nThr;
+			size_t end=numCandidates*(t+1)/nThr;
+			thr.push_back(std::thread(filter,begin,end,std::ref(out[t])));
+		}
+		for(auto &t : thr)
+		{
+			t.join();
+		}
+	}
+
+	Concatenate(rgn,out);
+}
+
+/* static */ std::vector <uint32_t> TownsMemorySearch::FindByteSequence(const unsigned char mem[],uint32_t size,const std::vector <unsigned char> &ptn,size_t maxCount)
+{
+	std::vector <uint32_t> found;
+	if(0==ptn.size() || size<ptn.size())
+	{
+		return found;
+	}
+
+	// memchr is vectorized in most C libraries.  Check the rest of the pattern only where the first byte matches.
+	const unsigned char *ptr=mem;
+	const unsigned char *last=mem+size-ptn.size();
+	while(ptr<=last && found.size()<maxCount)
+	{
+		ptr=(const unsigned char *)memchr(ptr,ptn[0],last-ptr+1);
+		if(nullptr==ptr)
+		{
+			break;
+		}
+		if(0==memcmp(ptr,ptn.data(),ptn.size()))
+		{
+			found.push_back((uint32_t)(ptr-mem));
+		}
+		++ptr;
+	}
+	return found;
+}
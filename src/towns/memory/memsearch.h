@@ -0,0 +1,116 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#ifndef MEMSEARCH_IS_INCLUDED
+#define MEMSEARCH_IS_INCLUDED
+/* { */
+
+#include <vector>
+#include <cstdint>
+
+/*! Memory search (cheat filter) engine for the debugger.
+    While many offsets are candidates, a region keeps a candidate bitmap and the image at the last update,
+    and is scanned 16 offsets at a time with SIMD, skipping 64-offset blocks that have no candidate.
+    Once the candidates become sparse, the region switches to a list of offsets and values, and only the
+    candidates are checked.  Both are split over threads.
+*/
+class TownsMemorySearch
+{
+public:
+	enum
+	{
+		PREDICATE_EQUAL_TO_VALUE,
+		PREDICATE_INCREASE,   // Unsigned
+		PREDICATE_DECREASE,   // Unsigned
+		PREDICATE_CHANGED,
+		PREDICATE_UNCHANGED,
+	};
+	enum
+	{
+		MIN_ITEMS_PER_THREAD=0x40000,
+		// A region switches to the list when there is one or fewer candidate per SPARSE_RATIO offsets,
+		// at which point the list is no larger than the bitmap.
+		SPARSE_RATIO=64,
+	};
+
+	class Region
+	{
+	public:
+		uint32_t physAddrBase=0;
+		uint32_t size=0;
+
+		// Bitmap form.  Bit i of candidateBit is set if offset i is a candidate.
+		// prevImage is the region at the last update.
+		// If all is true, every offset is a candidate, and candidateBit is not made yet.
+		bool sparse=false;
+		bool all=true;
+		size_t numBitmapCandidates=0;
+		std::vector <uint64_t> candidateBit;
+		std::vector <unsigned char> prevImage;
+
+		// List form.  Used if sparse is true.
+		std::vector <uint32_t> offset;     // Candidate offsets in ascending order.
+		std::vector <uint32_t> prevValue;  // Value at each candidate at the last update.
+	};
+
+	unsigned int unit=1;   // 1, 2, or 4 bytes
+	unsigned int numThreads=0;  // 0 for std::thread::hardware_concurrency()
+	std::vector <Region> regions;
+
+	/*! Drops all regions and starts a new search of unit-byte values.
+	*/
+	void Begin(unsigned int unit);
+
+	/*! Adds a region and takes a snapshot of it.
+	*/
+	void AddRegion(uint32_t physAddrBase,const unsigned char mem[],uint32_t size);
+
+	/*! Removes candidates that do not satisfy the predicate.
+	    current[i] must point to the current memory of regions[i].
+	    Returns the number of remaining candidates.
+	*/
+	size_t Apply(unsigned int predicate,uint32_t value,const unsigned char *const current[]);
+
+	/*! Drops the candidates beyond newSize bytes of the region, for when the memory behind the region shrank.
+	*/
+	void ShrinkRegion(size_t regionIndex,uint32_t newSize);
+
+	size_t NumCandidates(void) const;
+	size_t NumCandidates(const Region &rgn) const;
+
+	/*! Returns physical addresses of the candidates.
+	*/
+	std::vector <uint32_t> GetCandidates(void) const;
+
+	/*! Returns offsets where the byte sequence is found in mem.
+	    Stops when maxCount offsets are found.
+	*/
+	static std::vector <uint32_t> FindByteSequence(const unsigned char mem[],uint32_t size,const std::vector <unsigned char> &ptn,size_t maxCount);
+
+private:
+	class Output
+	{
+	public:
+		std::vector <uint32_t> offset,value;
+	};
+	void ApplyToBitmap(Region &rgn,unsigned int predicate,uint32_t value,const unsigned char current[]) const;
+	void ApplyToList(Region &rgn,unsigned int predicate,uint32_t value,const unsigned char current[]) const;
+	void MakeSparse(Region &rgn) const;
+	uint32_t NumPositions(const Region &rgn) const;
+	unsigned int NumThreadsFor(size_t numItems) const;
+	static void Concatenate(Region &rgn,std::vector <Output> &out);
+};
+
+/* } */
+#endif
@@ -21,6 +21,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "townsdef.h"
 #include "i486.h"
 #include "i486debug.h"
+#include "i486debugmemaccess.h"
 
 
 void TownsPhysicalMemory::KanjiROMAccess::Reset()
@@ -46,14 +47,8 @@ void TownsPhysicalMemory::State::Reset(void)
 	ANKFont=false;
 	kanjiROMAccess.Reset();
 
-	for(auto &c : RAM)
-	{
-		c=0;
-	}
-	for(auto &c : VRAM)
-	{
-		c=0;
-	}
+	RAM.Discard();
+	VRAM.Discard();
 	for(auto &c : CVRAM)
 	{
 		c=0;
@@ -339,10 +334,13 @@ TownsPhysicalMemory::TownsPhysicalMemory(class FMTownsCommon *townsPtr,class Mem
 	JEIDA4MemCardAccess(townsPtr)
 {
 	this->townsPtr=townsPtr;
+	VRAMFenceAccess.SetPhysicalMemoryPointer(this);
 
 	takeJISCodeLog=false;
 	this->memPtr=memPtr;
 
+	state.VRAM.resize(TOWNS_VRAM_SIZE);
+
 	for(auto &b : state.CMOSRAM)
 	{
 		b=0;
@@ -583,6 +581,7 @@ void TownsPhysicalMemory::SetDummySize(long long int size)
 
 /* virtual */ void TownsPhysicalMemory::Reset(void)
 {
+	WaitVRAMWriter();
 	state.Reset();
 	ResetSysROMDicROMMappingFlag(state.sysRomMapping,state.dicRom);
 	ResetFMRVRAMMappingFlag(state.FMRVRAM);
@@ -594,6 +593,7 @@ void TownsPhysicalMemory::SetUpMemoryAccess(unsigned int townsType,unsigned int
 	auto &mem=*memPtr;
 	auto &cpu=townsPtr->CPU();
 
+	WaitVRAMWriter();
 	mem.CleanUp();
 
 	mainRAMAccess.SetPhysicalMemoryPointer(this);
@@ -648,16 +648,6 @@ void TownsPhysicalMemory::SetUpMemoryAccess(unsigned int townsType,unsigned int
 	VRAMAccessWithMaskHighRes2.SetPhysicalMemoryPointer(this);
 	VRAMAccessWithMaskHighRes2.SetCPUPointer(&cpu);
 
-	VRAMAccess0Debug.SetPhysicalMemoryPointer(this);
-	VRAMAccess0Debug.SetCPUPointer(&cpu);
-	VRAMAccess1Debug.SetPhysicalMemoryPointer(this);
-	VRAMAccess1Debug.SetCPUPointer(&cpu);
-	VRAMAccessHighRes0Debug.SetPhysicalMemoryPointer(this);
-	VRAMAccessHighRes0Debug.SetCPUPointer(&cpu);
-	VRAMAccessHighRes1Debug.SetPhysicalMemoryPointer(this);
-	VRAMAccessHighRes1Debug.SetCPUPointer(&cpu);
-	VRAMAccessHighRes2Debug.SetPhysicalMemoryPointer(this);
-	VRAMAccessHighRes2Debug.SetCPUPointer(&cpu);
 	SetUpVRAMAccess(cpuType,false,false);
 
 	spriteRAMAccess.SetPhysicalMemoryPointer(this);
@@ -735,47 +725,32 @@ void TownsPhysicalMemory::SetUpMemoryAccess(unsigned int townsType,unsigned int
 void TownsPhysicalMemory::SetUpVRAMAccess(unsigned int cpuType,bool breakOnRead,bool breakOnWrite)
 {
 	auto &mem=*memPtr;
-	if(true!=breakOnRead && true!=breakOnWrite)
+	WaitVRAMWriter();
+	// Break on VRAM read/write is done by the debug memory-access object inserted in front of each VRAM slot.
+	// AddAccess only replaces the end of the chain, therefore the debug objects stay even when the VRAM mask is turned on or off.
+	if(TOWNSCPU_80386SX!=cpuType)
 	{
-		if(TOWNSCPU_80386SX!=cpuType)
-		{
-			mem.AddAccess(&VRAMAccess0,TOWNSADDR_VRAM0_BASE,TOWNSADDR_VRAM0_END-1);
-			mem.AddAccess(&VRAMAccess1,TOWNSADDR_VRAM1_BASE,TOWNSADDR_VRAM1_END-1);
-			mem.AddAccess(&VRAMAccessHighRes0,TOWNSADDR_VRAM_HIGHRES0_BASE,TOWNSADDR_VRAM_HIGHRES0_END-1); // For IIMX High Resolution Access.
-			mem.AddAccess(&VRAMAccessHighRes1,TOWNSADDR_VRAM_HIGHRES1_BASE,TOWNSADDR_VRAM_HIGHRES1_END-1); // For IIMX High Resolution Access.
-			mem.AddAccess(&VRAMAccessHighRes2,TOWNSADDR_VRAM_HIGHRES2_BASE,TOWNSADDR_VRAM_HIGHRES2_END-1); // For IIMX High Resolution Access.
-		}
-		else
-		{
-			mem.AddAccess(&VRAMAccess0,TOWNSADDR_386SX_VRAM0_BASE,TOWNSADDR_386SX_VRAM0_END-1);
-			mem.AddAccess(&VRAMAccess1,TOWNSADDR_386SX_VRAM1_BASE,TOWNSADDR_386SX_VRAM1_END-1);
-		}
+		mem.AddAccess(&VRAMAccess0,TOWNSADDR_VRAM0_BASE,TOWNSADDR_VRAM0_END-1);
+		mem.AddAccess(&VRAMAccess1,TOWNSADDR_VRAM1_BASE,TOWNSADDR_VRAM1_END-1);
+		mem.AddAccess(&VRAMAccessHighRes0,TOWNSADDR_VRAM_HIGHRES0_BASE,TOWNSADDR_VRAM_HIGHRES0_END-1); // For IIMX High Resolution Access.
+		mem.AddAccess(&VRAMAccessHighRes1,TOWNSADDR_VRAM_HIGHRES1_BASE,TOWNSADDR_VRAM_HIGHRES1_END-1); // For IIMX High Resolution Access.
+		mem.AddAccess(&VRAMAccessHighRes2,TOWNSADDR_VRAM_HIGHRES2_BASE,TOWNSADDR_VRAM_HIGHRES2_END-1); // For IIMX High Resolution Access.
+
+		auto &debugger=townsPtr->debugger;
+		i486DebugMemoryAccess::SetBreakOnMemSlotAccess(mem,debugger,TOWNSADDR_VRAM0_BASE,TOWNSADDR_VRAM0_END-1,breakOnRead,breakOnWrite);
+		i486DebugMemoryAccess::SetBreakOnMemSlotAccess(mem,debugger,TOWNSADDR_VRAM1_BASE,TOWNSADDR_VRAM1_END-1,breakOnRead,breakOnWrite);
+		i486DebugMemoryAccess::SetBreakOnMemSlotAccess(mem,debugger,TOWNSADDR_VRAM_HIGHRES0_BASE,TOWNSADDR_VRAM_HIGHRES0_END-1,breakOnRead,breakOnWrite);
+		i486DebugMemoryAccess::SetBreakOnMemSlotAccess(mem,debugger,TOWNSADDR_VRAM_HIGHRES1_BASE,TOWNSADDR_VRAM_HIGHRES1_END-1,breakOnRead,breakOnWrite);
+		i486DebugMemoryAccess::SetBreakOnMemSlotAccess(mem,debugger,TOWNSADDR_VRAM_HIGHRES2_BASE,TOWNSADDR_VRAM_HIGHRES2_END-1,breakOnRead,breakOnWrite);
 	}
 	else
 	{
-		VRAMAccess0Debug.breakOnRead=breakOnRead;
-		VRAMAccess0Debug.breakOnWrite=breakOnWrite;
-		VRAMAccess1Debug.breakOnRead=breakOnRead;
-		VRAMAccess1Debug.breakOnWrite=breakOnWrite;
-		VRAMAccessHighRes0Debug.breakOnRead=breakOnRead;
-		VRAMAccessHighRes0Debug.breakOnWrite=breakOnWrite;
-		VRAMAccessHighRes1Debug.breakOnRead=breakOnRead;
-		VRAMAccessHighRes1Debug.breakOnWrite=breakOnWrite;
-		VRAMAccessHighRes2Debug.breakOnRead=breakOnRead;
-		VRAMAccessHighRes2Debug.breakOnWrite=breakOnWrite;
-		if(TOWNSCPU_80386SX!=cpuType)
-		{
-			mem.AddAccess(&VRAMAccess0Debug,TOWNSADDR_VRAM0_BASE,TOWNSADDR_VRAM0_END-1);
-			mem.AddAccess(&VRAMAccess1Debug,TOWNSADDR_VRAM1_BASE,TOWNSADDR_VRAM1_END-1);
-			mem.AddAccess(&VRAMAccessHighRes0Debug,TOWNSADDR_VRAM_HIGHRES0_BASE,TOWNSADDR_VRAM_HIGHRES0_END-1); // For IIMX High Resolution Access.
-			mem.AddAccess(&VRAMAccessHighRes1Debug,TOWNSADDR_VRAM_HIGHRES1_BASE,TOWNSADDR_VRAM_HIGHRES1_END-1); // For IIMX High Resolution Access.
-			mem.AddAccess(&VRAMAccessHighRes2Debug,TOWNSADDR_VRAM_HIGHRES2_BASE,TOWNSADDR_VRAM_HIGHRES2_END-1); // For IIMX High Resolution Access.
-		}
-		else
-		{
-			mem.AddAccess(&VRAMAccess0Debug,TOWNSADDR_386SX_VRAM0_BASE,TOWNSADDR_386SX_VRAM0_END-1);
-			mem.AddAccess(&VRAMAccess1Debug,TOWNSADDR_386SX_VRAM1_BASE,TOWNSADDR_386SX_VRAM1_END-1);
-		}
+		mem.AddAccess(&VRAMAccess0,TOWNSADDR_386SX_VRAM0_BASE,TOWNSADDR_386SX_VRAM0_END-1);
+		mem.AddAccess(&VRAMAccess1,TOWNSADDR_386SX_VRAM1_BASE,TOWNSADDR_386SX_VRAM1_END-1);
+
+		auto &debugger=townsPtr->debugger;
+		i486DebugMemoryAccess::SetBreakOnMemSlotAccess(mem,debugger,TOWNSADDR_386SX_VRAM0_BASE,TOWNSADDR_386SX_VRAM0_END-1,breakOnRead,breakOnWrite);
+		i486DebugMemoryAccess::SetBreakOnMemSlotAccess(mem,debugger,TOWNSADDR_386SX_VRAM1_BASE,TOWNSADDR_386SX_VRAM1_END-1,breakOnRead,breakOnWrite);
 	}
 }
 
@@ -877,6 +852,7 @@ void TownsPhysicalMemory::ResetFMRVRAMMappingFlag(bool FMRVRAMMapping)
 void TownsPhysicalMemory::EnableOrDisableNativeVRAMMask(void)
 {
 	auto &mem=*memPtr;
+	WaitVRAMWriter();
 	if(0xffffffff==cpputil::GetDword(state.nativeVRAMMask))
 	{
 		mem.AddAccess(&VRAMAccess0,TOWNSADDR_VRAM0_BASE,TOWNSADDR_VRAM0_END-1);
@@ -895,336 +871,124 @@ void TownsPhysicalMemory::EnableOrDisableNativeVRAMMask(void)
 	}
 }
 
-void TownsPhysicalMemory::BeginMemFilter(unsigned int unit)
+void TownsPhysicalMemory::FenceSpritePage(uint64_t ticket,unsigned int spritePage)
 {
-	memFilter.RAMFilter.resize(state.RAM.size());
-	memFilter.prevRAM.resize(state.RAM.size());
-	memFilter.spriteRAMFilter.resize(GetSpriteRAMSize());
-	memFilter.prevSpriteRAM.resize(GetSpriteRAMSize());
-	memFilter.unit=unit;
-	for(uint32_t i=0; i<state.RAM.size(); ++i)
+	WaitVRAMWriter();
+	if(0==ticket || true==townsPtr->deviceThread.IsDone(ticket))
 	{
-		memFilter.RAMFilter[i]=true;
-		memFilter.prevRAM[i]=state.RAM[i];
-		if(state.RAM.size()<i+unit)
-		{
-			memFilter.RAMFilter[i]=false;
-		}
+		return;
 	}
-	for(uint32_t i=0; i<GetSpriteRAMSize(); ++i)
+	VRAMWriterTicket=ticket;
+
+	// Sprite page p is VRAM offset 0x40000+p*0x20000 to 0x40000+p*0x20000+0x1FFFF.
+	// In the direct-mapped windows it is at the same offset from the base.
+	// In the single-page windows, the layer-1 bytes of the page are interleaved in base+p*0x40000 to base+p*0x40000+0x3FFFF.
+	// High-Res window 1 does not reach the sprite page.
+	if(TOWNSCPU_80386SX!=townsPtr->GetCPUType())
 	{
-		memFilter.spriteRAMFilter[i]=true;
-		memFilter.prevSpriteRAM[i]=state.spriteRAM[i];
-		if(GetSpriteRAMSize()<i+unit)
-		{
-			memFilter.spriteRAMFilter[i]=false;
-		}
+		FenceVRAMSlots(TOWNSADDR_VRAM0_BASE+0x40000+spritePage*0x20000,0x20000);
+		FenceVRAMSlots(TOWNSADDR_VRAM1_BASE+spritePage*0x40000,0x40000);
+		FenceVRAMSlots(TOWNSADDR_VRAM_HIGHRES0_BASE+0x40000+spritePage*0x20000,0x20000);
+		FenceVRAMSlots(TOWNSADDR_VRAM_HIGHRES2_BASE+spritePage*0x40000,0x40000);
+	}
+	else
+	{
+		FenceVRAMSlots(TOWNSADDR_386SX_VRAM0_BASE+0x40000+spritePage*0x20000,0x20000);
+		FenceVRAMSlots(TOWNSADDR_386SX_VRAM1_BASE+spritePage*0x40000,0x40000);
 	}
 }
-unsigned int TownsPhysicalMemory::ApplyMemFilter(uint32_t currentValue)
+
+void TownsPhysicalMemory::FenceVRAMSlots(uint32_t physAddrLow,uint32_t length)
 {
-	unsigned int N=0;
-	if(1==memFilter.unit)
+	auto &mem=*memPtr;
+	for(uint32_t physAddr=physAddrLow; physAddr<physAddrLow+length; physAddr+=MemoryAccess::MEMORY_WINDOW_SIZE)
 	{
-		for(uint32_t i=0; i<state.RAM.size(); ++i)
+		// Debug objects in front of the slot stay.  Only the end of the chain is replaced.
+		auto memAccess=mem.GetAccessObject(physAddr);
+		while(nullptr!=memAccess->memAccessChain)
 		{
-			if(state.RAM[i]!=currentValue)
-			{
-				memFilter.RAMFilter[i]=false;
-			}
-			if(true==memFilter.RAMFilter[i])
-			{
-				++N;
-			}
-		}
-		for(uint32_t i=0; i<GetSpriteRAMSize(); ++i)
-		{
-			if(state.spriteRAM[i]!=currentValue)
-			{
-				memFilter.spriteRAMFilter[i]=false;
-			}
-			if(true==memFilter.spriteRAMFilter[i])
-			{
-				++N;
-			}
+			memAccess=memAccess->memAccessChain;
 		}
+		VRAMFenceSaved.push_back(std::pair <uint32_t,MemoryAccess *>(physAddr,memAccess));
+		mem.AddAccess(&VRAMFenceAccess,physAddr,physAddr+MemoryAccess::MEMORY_WINDOW_SIZE-1);
 	}
-	else if(2==memFilter.unit)
+}
+
+void TownsPhysicalMemory::ReleaseVRAMFence(void)
+{
+	auto &mem=*memPtr;
+	townsPtr->deviceThread.Wait(VRAMWriterTicket);
+	for(auto saved : VRAMFenceSaved)
 	{
-		for(uint32_t i=0; i+1<state.RAM.size(); ++i)
-		{
-			if(cpputil::GetWord(state.RAM.data()+i)!=currentValue)
-			{
-				memFilter.RAMFilter[i]=false;
-			}
-			if(true==memFilter.RAMFilter[i])
-			{
-				++N;
-			}
-		}
-		for(uint32_t i=0; i+1<GetSpriteRAMSize(); ++i)
-		{
-			if(cpputil::GetWord(state.spriteRAM+i)!=currentValue)
-			{
-				memFilter.spriteRAMFilter[i]=false;
-			}
-			if(true==memFilter.spriteRAMFilter[i])
-			{
-				++N;
-			}
-		}
+		mem.AddAccess(saved.second,saved.first,saved.first+MemoryAccess::MEMORY_WINDOW_SIZE-1);
 	}
-	else if(4==memFilter.unit)
+	VRAMFenceSaved.clear();
+	VRAMWriterTicket=0;
+}
+
+void TownsPhysicalMemory::BeginMemFilter(unsigned int unit)
+{
+	memFilter.Begin(unit);
+	memFilter.AddRegion(0,state.RAM.data(),(uint32_t)state.RAM.size());
+	memFilter.AddRegion(TOWNSADDR_SPRITERAM_BASE,state.spriteRAM,GetSpriteRAMSize());
+	if(true==memFilterIncludeVRAM)
 	{
-		for(uint32_t i=0; i+3<state.RAM.size(); ++i)
-		{
-			if(cpputil::GetDword(state.RAM.data()+i)!=currentValue)
-			{
-				memFilter.RAMFilter[i]=false;
-			}
-			if(true==memFilter.RAMFilter[i])
-			{
-				++N;
-			}
-		}
-		for(uint32_t i=0; i+3<GetSpriteRAMSize(); ++i)
-		{
-			if(cpputil::GetDword(state.spriteRAM+i)!=currentValue)
-			{
-				memFilter.spriteRAMFilter[i]=false;
-			}
-			if(true==memFilter.spriteRAMFilter[i])
-			{
-				++N;
-			}
-		}
+		memFilter.AddRegion(TOWNSADDR_VRAM0_BASE,state.VRAM,GetVRAMSize());
 	}
-	memcpy(memFilter.prevRAM.data(),state.RAM.data(),state.RAM.size());
-	memcpy(memFilter.prevSpriteRAM.data(),state.spriteRAM,GetSpriteRAMSize());
-
-	return N;
 }
-
-
-template <class MemFilterHelper> class TownsPhysicalMemory::MemFilterTemplate
+unsigned int TownsPhysicalMemory::ApplyMemFilterPredicate(unsigned int predicate,uint32_t value)
 {
-public:
-	static unsigned int Apply(uint32_t length,uint32_t unit,const unsigned char current[],unsigned char prev[],std::vector <bool> &filter)
+	const unsigned char *current[3];
+	for(size_t i=0; i<memFilter.regions.size() && i<3; ++i)
 	{
-		unsigned int N=0;
-		for(uint32_t i=0; i+unit<=length; ++i)
+		auto &rgn=memFilter.regions[i];
+		switch(i)
 		{
-			if(true!=MemFilterHelper::Compare(current+i,prev+i))
-			{
-				filter[i]=false;
-			}
-			if(true==filter[i])
+		case 0:
+			current[i]=state.RAM.data();
+			// Main RAM may have been resized since the filter started.
+			if(state.RAM.size()<rgn.size)
 			{
-				++N;
+				std::cout << "Main RAM shrank from " << rgn.size << " to " << state.RAM.size() << " bytes." << std::endl;
+				std::cout << "Candidates beyond the new size are dropped." << std::endl;
+				memFilter.ShrinkRegion(i,(uint32_t)state.RAM.size());
 			}
+			break;
+		case 1:
+			current[i]=state.spriteRAM;
+			break;
+		case 2:
+			current[i]=state.VRAM;
+			break;
 		}
-		memcpy(prev,current,length);
-		return N;
 	}
-};
-
+	return (unsigned int)memFilter.Apply(predicate,value,current);
+}
+unsigned int TownsPhysicalMemory::ApplyMemFilter(uint32_t currentValue)
+{
+	return ApplyMemFilterPredicate(TownsMemorySearch::PREDICATE_EQUAL_TO_VALUE,currentValue);
+}
 unsigned int TownsPhysicalMemory::ApplyMemFilterDecrease(void)
 {
-	class CompareByte
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return *current<*prev;
-		}
-	};
-	class CompareWord
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return cpputil::GetWord(current)<cpputil::GetWord(prev);
-		}
-	};
-	class CompareDword
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return cpputil::GetDword(current)<cpputil::GetDword(prev);
-		}
-	};
-	unsigned int N=0;
-	const auto unit=memFilter.unit;
-
-	if(1==unit)
-	{
-		N=MemFilterTemplate<CompareByte>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareByte>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	else if(2==unit)
-	{
-		N=MemFilterTemplate<CompareWord>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareWord>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	else if(4==unit)
-	{
-		N=MemFilterTemplate<CompareDword>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareDword>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-
-	return N;
+	return ApplyMemFilterPredicate(TownsMemorySearch::PREDICATE_DECREASE,0);
 }
 unsigned int TownsPhysicalMemory::ApplyMemFilterIncrease(void)
 {
-	class CompareByte
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return *current>*prev;
-		}
-	};
-	class CompareWord
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return cpputil::GetWord(current)>cpputil::GetWord(prev);
-		}
-	};
-	class CompareDword
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return cpputil::GetDword(current)>cpputil::GetDword(prev);
-		}
-	};
-	unsigned int N=0;
-	const auto unit=memFilter.unit;
-	if(1==unit)
-	{
-		N=MemFilterTemplate<CompareByte>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareByte>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	else if(2==unit)
-	{
-		N=MemFilterTemplate<CompareWord>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareWord>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	else if(4==unit)
-	{
-		N=MemFilterTemplate<CompareDword>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareDword>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	return N;
+	return ApplyMemFilterPredicate(TownsMemorySearch::PREDICATE_INCREASE,0);
 }
 unsigned int TownsPhysicalMemory::ApplyMemFilterDifferent(void)
 {
-	class CompareByte
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return *current!=*prev;
-		}
-	};
-	class CompareWord
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return cpputil::GetWord(current)!=cpputil::GetWord(prev);
-		}
-	};
-	class CompareDword
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return cpputil::GetDword(current)!=cpputil::GetDword(prev);
-		}
-	};
-	unsigned int N=0;
-	const auto unit=memFilter.unit;
-	if(1==unit)
-	{
-		N=MemFilterTemplate<CompareByte>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareByte>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	else if(2==unit)
-	{
-		N=MemFilterTemplate<CompareWord>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareWord>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	else if(4==unit)
-	{
-		N=MemFilterTemplate<CompareDword>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareDword>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	return N;
+	return ApplyMemFilterPredicate(TownsMemorySearch::PREDICATE_CHANGED,0);
 }
 unsigned int TownsPhysicalMemory::ApplyMemFilterEqual(void)
 {
-	class CompareByte
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return *current==*prev;
-		}
-	};
-	class CompareWord
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return cpputil::GetWord(current)==cpputil::GetWord(prev);
-		}
-	};
-	class CompareDword
-	{
-	public:
-		static bool Compare(const uint8_t *current,uint8_t *prev)
-		{
-			return cpputil::GetDword(current)==cpputil::GetDword(prev);
-		}
-	};
-	unsigned int N=0;
-	const auto unit=memFilter.unit;
-	if(1==unit)
-	{
-		N=MemFilterTemplate<CompareByte>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareByte>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	else if(2==unit)
-	{
-		N=MemFilterTemplate<CompareWord>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareWord>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	else if(4==unit)
-	{
-		N=MemFilterTemplate<CompareDword>::Apply(state.RAM.size(),unit,state.RAM.data(),memFilter.prevRAM.data(),memFilter.RAMFilter)
-		 +MemFilterTemplate<CompareDword>::Apply(GetSpriteRAMSize(),unit,state.spriteRAM,memFilter.prevSpriteRAM.data(),memFilter.spriteRAMFilter);
-	}
-	return N;
+	return ApplyMemFilterPredicate(TownsMemorySearch::PREDICATE_UNCHANGED,0);
 }
 void TownsPhysicalMemory::PrintMemFilter(void)
 {
-	for(unsigned int i=0; i<memFilter.RAMFilter.size(); ++i)
-	{
-		if(true==memFilter.RAMFilter[i])
-		{
-			std::cout << "PHYS:" << cpputil::Uitox(i) << std::endl;
-		}
-	}
-	for(unsigned int i=0; i<memFilter.spriteRAMFilter.size(); ++i)
+	for(auto physAddr : memFilter.GetCandidates())
 	{
-		if(true==memFilter.spriteRAMFilter[i])
-		{
-			std::cout << "PHYS:" << cpputil::Uitox(i+TOWNSADDR_SPRITERAM_BASE) << std::endl;
-		}
+		std::cout << "PHYS:" << cpputil::Uitox(physAddr) << std::endl;
 	}
 }
 
@@ -1291,10 +1055,57 @@ std::vector <std::string> TownsPhysicalMemory::GetStatusText(void) const
 
 /* virtual */ uint32_t TownsPhysicalMemory::SerializeVersion(void) const
 {
-	return 1;
+	// Version 2 saves RAM and VRAM without zero pages.
+	return 2;
+}
+/* static */ void TownsPhysicalMemory::PushSparseMemory(std::vector <unsigned char> &data,const cpputil::AnonymousMemory &mem)
+{
+	std::vector <uint32_t> pages;
+	for(size_t page=0; page<mem.GetNumPages(); ++page)
+	{
+		if(true!=mem.IsZeroPage(page))
+		{
+			pages.push_back((uint32_t)page);
+		}
+	}
+
+	PushUint32(data,(uint32_t)mem.size());
+	PushUint32(data,(uint32_t)pages.size());
+	for(auto page : pages)
+	{
+		size_t offset=page*cpputil::AnonymousMemory::PAGE_SIZE;
+		PushUint32(data,page);
+		PushUcharArray(data,std::min<size_t>(cpputil::AnonymousMemory::PAGE_SIZE,mem.size()-offset),mem.data()+offset);
+	}
+}
+/* static */ void TownsPhysicalMemory::ReadSparseMemory(const unsigned char *&data,cpputil::AnonymousMemory &mem,bool resize)
+{
+	size_t size=ReadUint32(data);
+	if(true==resize)
+	{
+		mem.resize(size);
+	}
+	mem.Discard();
+
+	auto numPages=ReadUint32(data);
+	for(uint32_t i=0; i<numPages; ++i)
+	{
+		size_t offset=ReadUint32(data)*(size_t)cpputil::AnonymousMemory::PAGE_SIZE;
+		auto pageLen=std::min<size_t>(cpputil::AnonymousMemory::PAGE_SIZE,size-offset);
+		if(offset+pageLen<=mem.size())
+		{
+			ReadUcharArray(data,pageLen,mem.data()+offset);
+		}
+		else
+		{
+			data+=pageLen;
+		}
+	}
 }
 /* virtual */ void TownsPhysicalMemory::SpecificSerialize(std::vector <unsigned char> &data,std::string stateFName) const
 {
+	townsPtr->deviceThread.WaitAll();
+
 	std::string stateDir,stateName;
 	cpputil::SeparatePathFile(stateDir,stateName,stateFName);
 
@@ -1313,14 +1124,12 @@ std::vector <std::string> TownsPhysicalMemory::GetStatusText(void) const
 		PushUint16(data, nvMsk);
 	}
 
-	std::vector <uint8_t> VRAM,spriteRAM; // For absolute backward compatibility, save as vector.
-	VRAM.resize(GetVRAMSize());
-	memcpy(VRAM.data(),state.VRAM,GetVRAMSize());
+	std::vector <uint8_t> spriteRAM; // For absolute backward compatibility, save as vector.
 	spriteRAM.resize(GetSpriteRAMSize());
 	memcpy(spriteRAM.data(),state.spriteRAM,GetSpriteRAMSize());
 
-	PushUcharArray(data,state.RAM);
-	PushUcharArray(data,VRAM);
+	PushSparseMemory(data,state.RAM);
+	PushSparseMemory(data,state.VRAM);
 	PushUcharArray(data,state.CVRAM);
 	PushUcharArray(data,spriteRAM);
 	PushUcharArray(data,state.notUsed);
@@ -1351,6 +1160,8 @@ std::vector <std::string> TownsPhysicalMemory::GetStatusText(void) const
 }
 /* virtual */ bool TownsPhysicalMemory::SpecificDeserialize(const unsigned char *&data,std::string stateFName,uint32_t version)
 {
+	WaitVRAMWriter();
+
 	std::string stateDir,stateName;
 	cpputil::SeparatePathFile(stateDir,stateName,stateFName);
 
@@ -1373,14 +1184,25 @@ std::vector <std::string> TownsPhysicalMemory::GetStatusText(void) const
 		nvMsk=ReadUint16(data);
 	}
 
-	state.RAM=ReadUcharArray(data);
-	auto VRAM=ReadUcharArray(data);
+	if(2<=version)
+	{
+		ReadSparseMemory(data,state.RAM,true);
+		ReadSparseMemory(data,state.VRAM,false);
+	}
+	else
+	{
+		auto RAM=ReadUcharArray(data);
+		auto VRAM=ReadUcharArray(data);
+		state.RAM.resize(RAM.size());
+		memcpy(state.RAM.data(),RAM.data(),RAM.size());
+		state.VRAM.Discard();
+		memcpy(state.VRAM,VRAM.data(),std::min<uint32_t>(GetVRAMSize(),VRAM.size()));
+	}
 	state.CVRAM=ReadUcharArray(data);
 	auto spriteRAM=ReadUcharArray(data);
 	state.notUsed=ReadUcharArray(data);
 	ReadUcharArray(data,TOWNS_CMOS_SIZE,state.CMOSRAM);
 
-	memcpy(state.VRAM,     VRAM.data(),     std::min<uint32_t>(GetVRAMSize(),VRAM.size()));
 	memcpy(state.spriteRAM,spriteRAM.data(),std::min<uint32_t>(GetSpriteRAMSize(),spriteRAM.size()));
 
 
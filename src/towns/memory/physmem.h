@@ -25,8 +25,10 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #endif
 
 #include "cpputil.h"
+#include "anonmem.h"
 #include "i486.h"
 #include "i486debug.h"
+#include "memsearch.h"
 
 #include "device.h"
 #include "ramrom.h"
@@ -102,6 +104,8 @@ class TownsNativeDICROMAccess : public TownsMemAccess
 public:
 	virtual unsigned int FetchByte(unsigned int physAddr) const;
 	virtual void StoreByte(unsigned int physAddr,unsigned char data);
+
+	virtual ConstMemoryWindow GetConstMemoryWindow(unsigned int physAddr) const;
 };
 
 class TownsNativeCMOSRAMAccess : public TownsMemAccess
@@ -121,8 +125,13 @@ public:
 	virtual void StoreByte(unsigned int physAddr,unsigned char data);
 	virtual void StoreWord(unsigned int physAddr,unsigned int data);
 	virtual void StoreDword(unsigned int physAddr,unsigned int data);
+
+	virtual ConstMemoryWindow GetConstMemoryWindow(unsigned int physAddr) const;
+	virtual MemoryWindow GetMemoryWindow(unsigned int physAddr);
 };
 
+/*! Used while the VRAM mask is not all ones.  It gives a window for reading, but not for writing.
+*/
 template <const uint32_t DISPLACEMENT>
 class TownsVRAMAccessWithMaskTemplate : public TownsVRAMAccessTemplate <DISPLACEMENT>
 {
@@ -130,6 +139,8 @@ public:
 	virtual void StoreByte(unsigned int physAddr,unsigned char data);
 	virtual void StoreWord(unsigned int physAddr,unsigned int data);
 	virtual void StoreDword(unsigned int physAddr,unsigned int data);
+
+	virtual MemoryAccess::MemoryWindow GetMemoryWindow(unsigned int physAddr);
 };
 
 class TownsSinglePageVRAMAddressTransform
@@ -171,6 +182,24 @@ public:
 	virtual void StoreDword(unsigned int physAddr,unsigned int data);
 };
 
+/*! Placed in the VRAM slots that a device-thread job is writing.
+    The first access waits for the job, puts the original VRAM-access objects back, and then forwards the access.
+*/
+class TownsVRAMFenceAccess : public TownsMemAccess
+{
+private:
+	/*! Waits for the job, and returns the original memory-access object of the slot.
+	*/
+	MemoryAccess *Release(unsigned int physAddr) const;
+public:
+	virtual unsigned int FetchByte(unsigned int physAddr) const;
+	virtual unsigned int FetchWord(unsigned int physAddr) const;
+	virtual unsigned int FetchDword(unsigned int physAddr) const;
+	virtual void StoreByte(unsigned int physAddr,unsigned char data);
+	virtual void StoreWord(unsigned int physAddr,unsigned int data);
+	virtual void StoreDword(unsigned int physAddr,unsigned int data);
+};
+
 class TownsSpriteRAMAccess : public TownsMemAccess
 {
 public:
@@ -180,6 +209,9 @@ public:
 	virtual void StoreByte(unsigned int physAddr,unsigned char data);
 	virtual void StoreWord(unsigned int physAddr,unsigned int data);
 	virtual void StoreDword(unsigned int physAddr,unsigned int data);
+
+	virtual ConstMemoryWindow GetConstMemoryWindow(unsigned int physAddr) const;
+	virtual MemoryWindow GetMemoryWindow(unsigned int physAddr);
 };
 
 class TownsOldMemCardAccess : public TownsMemAccess
@@ -215,6 +247,8 @@ public:
 	virtual unsigned int FetchWord(unsigned int physAddr) const;
 	virtual unsigned int FetchDword(unsigned int physAddr) const;
 	virtual void StoreByte(unsigned int physAddr,unsigned char data);
+
+	virtual ConstMemoryWindow GetConstMemoryWindow(unsigned int physAddr) const;
 };
 
 class TownsFontROMAccess : public TownsMemAccess
@@ -222,6 +256,8 @@ class TownsFontROMAccess : public TownsMemAccess
 public:
 	virtual unsigned int FetchByte(unsigned int physAddr) const;
 	virtual void StoreByte(unsigned int physAddr,unsigned char data);
+
+	virtual ConstMemoryWindow GetConstMemoryWindow(unsigned int physAddr) const;
 };
 
 class TownsFont20ROMAccess : public TownsMemAccess
@@ -229,6 +265,8 @@ class TownsFont20ROMAccess : public TownsMemAccess
 public:
 	virtual unsigned int FetchByte(unsigned int physAddr) const;
 	virtual void StoreByte(unsigned int physAddr,unsigned char data);
+
+	virtual ConstMemoryWindow GetConstMemoryWindow(unsigned int physAddr) const;
 };
 
 class TownsWaveRAMAccess : public TownsMemAccess
@@ -261,65 +299,6 @@ public:
 };
 
 
-template <class MemAccessClass>
-class TownsMemAccessDebug : public MemAccessClass
-{
-public:
-	bool breakOnWrite=false;
-	bool breakOnRead=false;
-
-	virtual unsigned int FetchByte(unsigned int physAddr) const
-	{
-		if(true==breakOnRead && nullptr!=this->cpuPtr->debuggerPtr)
-		{
-			this->cpuPtr->debuggerPtr->ExternalBreak("Memory Read");
-		}
-		return MemAccessClass::FetchByte(physAddr);
-	}
-	virtual unsigned int FetchWord(unsigned int physAddr) const
-	{
-		if(true==breakOnRead && nullptr!=this->cpuPtr->debuggerPtr)
-		{
-			this->cpuPtr->debuggerPtr->ExternalBreak("Memory Read");
-		}
-		return MemAccessClass::FetchWord(physAddr);
-	}
-	virtual unsigned int FetchDword(unsigned int physAddr) const
-	{
-		if(true==breakOnRead && nullptr!=this->cpuPtr->debuggerPtr)
-		{
-			this->cpuPtr->debuggerPtr->ExternalBreak("Memory Read");
-		}
-		return MemAccessClass::FetchDword(physAddr);
-	}
-	virtual void StoreByte(unsigned int physAddr,unsigned char data)
-	{
-		if(true==breakOnWrite && nullptr!=this->cpuPtr->debuggerPtr)
-		{
-			this->cpuPtr->debuggerPtr->ExternalBreak("Memory Write");
-		}
-		MemAccessClass::StoreByte(physAddr,data);
-	}
-	virtual void StoreWord(unsigned int physAddr,unsigned int data)
-	{
-		if(true==breakOnWrite && nullptr!=this->cpuPtr->debuggerPtr)
-		{
-			this->cpuPtr->debuggerPtr->ExternalBreak("Memory Write");
-		}
-		MemAccessClass::StoreWord(physAddr,data);
-	}
-	virtual void StoreDword(unsigned int physAddr,unsigned int data)
-	{
-		if(true==breakOnWrite && nullptr!=this->cpuPtr->debuggerPtr)
-		{
-			this->cpuPtr->debuggerPtr->ExternalBreak("Memory Write");
-		}
-		MemAccessClass::StoreDword(physAddr,data);
-	}
-};
-
-
-
 class TownsPhysicalMemory : public Device
 {
 public:
@@ -380,8 +359,9 @@ public:
 		unsigned int nativeVRAMMaskRegisterLatch=0;
 		unsigned char nativeVRAMMask[8]={0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff}; // Repeat twice for faster access.
 
-		std::vector <unsigned char> RAM;
-		unsigned char VRAM[TOWNS_VRAM_SIZE];
+		// RAM and VRAM are committed on the first write so that the memory use follows what the guest actually uses.
+		cpputil::AnonymousMemory RAM;
+		cpputil::AnonymousMemory VRAM;  // Always TOWNS_VRAM_SIZE bytes.
 		std::vector <unsigned char> CVRAM;
 		unsigned char spriteRAM[TOWNS_SPRITERAM_SIZE];
 		std::vector <unsigned char> notUsed;
@@ -435,13 +415,8 @@ public:
 	TownsVRAMAccessWithMaskTemplate           <0x80000> VRAMAccessWithMaskHighRes1;
 	TownsSinglePageVRAMAccessWithMaskTemplate <0,TownsSinglePageHighResVRAMAddressTransform> VRAMAccessWithMaskHighRes2;
 
-	TownsMemAccessDebug <TownsVRAMAccessTemplate           <0> > VRAMAccess0Debug;
-	TownsMemAccessDebug <TownsSinglePageVRAMAccessTemplate <0,TownsSinglePageVRAMAddressTransform> > VRAMAccess1Debug;
-	TownsMemAccessDebug <TownsVRAMAccessTemplate           <0> > VRAMAccessHighRes0Debug;
-	TownsMemAccessDebug <TownsVRAMAccessTemplate           <0x80000> > VRAMAccessHighRes1Debug;
-	TownsMemAccessDebug <TownsSinglePageVRAMAccessTemplate <0,TownsSinglePageHighResVRAMAddressTransform> > VRAMAccessHighRes2Debug;
-
 
+	TownsVRAMFenceAccess VRAMFenceAccess;
 	TownsSpriteRAMAccess spriteRAMAccess;
 	TownsOldMemCardAccess oldMemCardAccess;
 	TownsJEIDA4MemCardAccess JEIDA4MemCardAccess;
@@ -528,6 +503,31 @@ public:
 	*/
 	void EnableOrDisableNativeVRAMMask(void);
 
+	/*! Device-thread job that is writing VRAM, and the VRAM slots replaced with VRAMFenceAccess.
+	*/
+	uint64_t VRAMWriterTicket=0;
+	std::vector <std::pair <uint32_t,MemoryAccess *> > VRAMFenceSaved;
+
+	/*! Replaces the VRAM slots that can reach the sprite page with VRAMFenceAccess until the job of the ticket is done.
+	    If the ticket is 0 (the job is already done), nothing is changed.
+	*/
+	void FenceSpritePage(uint64_t ticket,unsigned int spritePage);
+
+	/*! Waits for the device-thread job writing VRAM, and puts the original VRAM-access objects back.
+	    Must be called before VRAM is read or written outside of the memory-access objects.
+	*/
+	inline void WaitVRAMWriter(void)
+	{
+		if(0!=VRAMWriterTicket)
+		{
+			ReleaseVRAMFence();
+		}
+	}
+	void ReleaseVRAMFence(void);
+private:
+	void FenceVRAMSlots(uint32_t physAddrLow,uint32_t length);
+public:
+
 	virtual void IOWriteByte(unsigned int ioport,unsigned int data);
 	virtual void IOWriteWord(unsigned int ioport, unsigned int data);
 	virtual unsigned int IOReadByte(unsigned int ioport);
@@ -536,18 +536,10 @@ public:
 
 
 
-	class MemoryFilter
-	{
-	public:
-		std::vector <bool> RAMFilter;
-		std::vector <unsigned char> prevRAM;
-		std::vector <bool> spriteRAMFilter;
-		std::vector <unsigned char> prevSpriteRAM;
-		unsigned int unit=1; // Unit number of bytes
-	};
-	MemoryFilter memFilter;
+	TownsMemorySearch memFilter;
+	bool memFilterIncludeVRAM=false;
 
-	/*!
+	/*! Starts a memory filter of unit-byte values over the main RAM and sprite RAM, plus VRAM if memFilterIncludeVRAM is true.
 	*/
 	void BeginMemFilter(unsigned int unit);
 	unsigned int ApplyMemFilter(uint32_t currentValue);
@@ -556,8 +548,9 @@ public:
 	unsigned int ApplyMemFilterDifferent(void);
 	unsigned int ApplyMemFilterEqual(void);
 	void PrintMemFilter(void);
-
-	template <class MemFilterHelper> class MemFilterTemplate;
+private:
+	unsigned int ApplyMemFilterPredicate(unsigned int predicate,uint32_t value);
+public:
 
 
 
@@ -567,6 +560,13 @@ public:
 	virtual uint32_t SerializeVersion(void) const;
 	virtual void SpecificSerialize(std::vector <unsigned char> &data,std::string stateFName) const;
 	virtual bool SpecificDeserialize(const unsigned char *&data,std::string stateFName,uint32_t version);
+private:
+	/*! Saves only the pages that are not all zero.
+	*/
+	static void PushSparseMemory(std::vector <unsigned char> &data,const cpputil::AnonymousMemory &mem);
+	/*! If resize is false, the size of mem is kept, and the pages beyond the size are ignored.
+	*/
+	static void ReadSparseMemory(const unsigned char *&data,cpputil::AnonymousMemory &mem,bool resize);
 };
 
 
@@ -606,6 +606,22 @@ void TownsVRAMAccessTemplate <DISPLACEMENT>::StoreDword(unsigned int physAddr,un
 	auto &state=physMemPtr->state;
 	cpputil::PutDword(state.VRAM+((physAddr+DISPLACEMENT)&TOWNSADDR_VRAM_AND),data);
 }
+template <const uint32_t DISPLACEMENT>
+MemoryAccess::ConstMemoryWindow TownsVRAMAccessTemplate <DISPLACEMENT>::GetConstMemoryWindow(unsigned int physAddr) const
+{
+	auto &state=physMemPtr->state;
+	MemoryAccess::ConstMemoryWindow memWin;
+	memWin.ptr=state.VRAM+(((physAddr&(~0xfff))+DISPLACEMENT)&TOWNSADDR_VRAM_AND);
+	return memWin;
+}
+template <const uint32_t DISPLACEMENT>
+MemoryAccess::MemoryWindow TownsVRAMAccessTemplate <DISPLACEMENT>::GetMemoryWindow(unsigned int physAddr)
+{
+	auto &state=physMemPtr->state;
+	MemoryAccess::MemoryWindow memWin;
+	memWin.ptr=state.VRAM+(((physAddr&(~0xfff))+DISPLACEMENT)&TOWNSADDR_VRAM_AND);
+	return memWin;
+}
 
 
 
@@ -636,6 +652,13 @@ void TownsVRAMAccessWithMaskTemplate<DISPLACEMENT>::StoreDword(unsigned int phys
 	unsigned int vram=cpputil::GetDword(state.VRAM+((physAddr+DISPLACEMENT)&TOWNSADDR_VRAM_AND));
 	cpputil::PutDword(state.VRAM+((physAddr+DISPLACEMENT)&TOWNSADDR_VRAM_AND),(vram&nega)|(data&mask));
 }
+template <const uint32_t DISPLACEMENT>
+MemoryAccess::MemoryWindow TownsVRAMAccessWithMaskTemplate<DISPLACEMENT>::GetMemoryWindow(unsigned int physAddr)
+{
+	// Writes must go through StoreByte/Word/Dword to apply the mask.
+	MemoryAccess::MemoryWindow memWin;
+	return memWin;
+}
 
 ////////////////////////////////////////////////////////////
 
@@ -252,6 +252,7 @@ void Outside_World::UpdateStatusBarInfo(class FMTownsCommon &towns)
 
 Outside_World::WindowInterface::WindowInterface()
 {
+	shared.renderer.SetFrameBufferPool(&frameBufferPool);
 	winThr.statusBitmap=new unsigned char [STATUS_WID*STATUS_HEI*4];
 	for(int i=0; i<STATUS_WID*STATUS_HEI*4; ++i)
 	{
@@ -286,6 +287,7 @@ void Outside_World::WindowInterface::BaseInterval(void)
 
 		auto img=shared.renderer.MoveImage();
 		std::swap(winThr.mostRecentImage,img);
+		frameBufferPool.Return(img);
 	}
 	else
 	{
@@ -272,6 +272,9 @@ public:
 			unsigned char *statusBitmap;
 		};
 		SharedVariables shared;
+
+		// shared.renderer takes bitmaps from here, and the Window thread returns replaced winThr.mostRecentImage.
+		TownsRender::FrameBufferPool frameBufferPool;
 		VMThreadVariables VMThr;
 		WindowThreadVariables winThr;
 
@@ -286,7 +289,7 @@ public:
 
 
 		WindowInterface();
-		~WindowInterface();
+		virtual ~WindowInterface();
 
 		virtual void Start(void)=0;
 		virtual void Stop(void)=0;
@@ -348,6 +351,8 @@ public:
 	class Sound
 	{
 	public:
+		virtual ~Sound(){}
+
 		virtual void Start(void)=0;
 		virtual void Stop(void)=0;
 
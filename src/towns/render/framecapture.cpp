@@ -0,0 +1,373 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <stdio.h>
+
+#include "cpputil.h"
+#include "yspngenc.h"
+#include "framecapture.h"
+
+
+
+TownsFrameCapture::TownsFrameCapture()
+{
+}
+TownsFrameCapture::~TownsFrameCapture()
+{
+	Stop();
+}
+
+bool TownsFrameCapture::Start(const std::string &outputPrefix,unsigned int format,unsigned int interval,unsigned int numWorkers,unsigned int queueLength)
+{
+	if(true==capturing)
+	{
+		return false;
+	}
+
+	if(FORMAT_RAW==format)
+	{
+		auto fName=outputPrefix+".frames";
+		rawFp=fopen(fName.c_str(),"wb");
+		if(nullptr==rawFp)
+		{
+			return false;
+		}
+		unsigned char header[RAW_FILE_HEADER_SIZE];
+		memset(header,0,sizeof(header));
+		memcpy(header,"TSUGARU_FRAMES",14);
+		fwrite(header,1,RAW_FILE_HEADER_SIZE,rawFp);
+	}
+
+	if(0==numWorkers)
+	{
+		numWorkers=std::max<unsigned int>(1,std::thread::hardware_concurrency());
+	}
+	numWorkers=std::min<unsigned int>(numWorkers,MAX_NUM_WORKERS);
+
+	this->outputPrefix=outputPrefix;
+	this->format=format;
+	this->interval=std::max<unsigned int>(1,interval);
+	this->queueLength=std::max<unsigned int>(1,queueLength);
+	frameCounter=0;
+
+	queue.clear();
+	freeFrames.clear();
+	for(unsigned int i=0; i<this->queueLength; ++i)
+	{
+		freeFrames.push_back(std::unique_ptr <Frame>(new Frame));
+	}
+	nextSequence=0;
+	nextSequenceToCheck=0;
+	lastHashValid=false;
+	quit=false;
+	{
+		std::lock_guard <std::mutex> lock(statLock);
+		stat=Statistics();
+	}
+
+	for(unsigned int i=0; i<numWorkers; ++i)
+	{
+		workers.push_back(std::thread([this]{WorkerThread();}));
+	}
+	capturing=true;
+	return true;
+}
+
+void TownsFrameCapture::Stop(void)
+{
+	if(true!=capturing)
+	{
+		return;
+	}
+	{
+		std::lock_guard <std::mutex> lock(queueLock);
+		quit=true;
+	}
+	queueCond.notify_all();
+	for(auto &w : workers)
+	{
+		w.join();
+	}
+	workers.clear();
+	if(nullptr!=rawFp)
+	{
+		fclose(rawFp);
+		rawFp=nullptr;
+	}
+	capturing=false;
+}
+
+bool TownsFrameCapture::IsCapturing(void) const
+{
+	return capturing;
+}
+
+void TownsFrameCapture::NextFrame(const TownsCRTC &crtc,const unsigned char VRAM[],bool damperWireLine,bool scanLineEffectIn15KHz,bool imageNeedsFlip,uint64_t townsTime)
+{
+	if(true!=capturing)
+	{
+		return;
+	}
+
+	auto frameNumber=frameCounter++;
+	if(0!=frameNumber%interval)
+	{
+		return;
+	}
+
+	std::unique_ptr <Frame> frame;
+	{
+		std::lock_guard <std::mutex> lock(queueLock);
+		if(true!=freeFrames.empty())
+		{
+			frame=std::move(freeFrames.back());
+			freeFrames.pop_back();
+		}
+	}
+	if(nullptr==frame)
+	{
+		std::lock_guard <std::mutex> lock(statLock);
+		++stat.framesSeen;
+		++stat.framesDropped;
+		return;
+	}
+
+	frame->frameNumber=frameNumber;
+	frame->townsTime=townsTime;
+	frame->imageNeedsFlip=imageNeedsFlip;
+	frame->renderer.Prepare(crtc);
+	frame->renderer.damperWireLine=damperWireLine;
+	frame->renderer.scanLineEffectIn15KHz=scanLineEffectIn15KHz;
+	frame->VRAM.resize(TOWNS_VRAM_SIZE);
+	CopyShownPages(frame->VRAM.data(),crtc,VRAM);
+	frame->palette=crtc.GetPalette();
+	frame->chaseHQPalette=crtc.chaseHQPalette;
+
+	uint64_t depth;
+	{
+		std::lock_guard <std::mutex> lock(queueLock);
+		frame->sequence=nextSequence++;
+		queue.push_back(std::move(frame));
+		depth=queue.size();
+	}
+	queueCond.notify_one();
+
+	std::lock_guard <std::mutex> lock(statLock);
+	++stat.framesSeen;
+	++stat.framesQueued;
+	stat.maxQueueDepth=std::max(stat.maxQueueDepth,depth);
+}
+
+/* static */ void TownsFrameCapture::CopyShownPages(unsigned char copy[],const TownsCRTC &crtc,const unsigned char VRAM[])
+{
+	auto VRAMSize=crtc.GetEffectiveVRAMSize();
+	if(true==crtc.rasterLog.enabled && true!=crtc.state.highResCRTCEnabled && true!=crtc.rasterLog.last.events.empty())
+	{
+		// Pages may be turned on and off in the middle of the frame.
+		memcpy(copy,VRAM,VRAMSize);
+	}
+	else if(true==crtc.InSinglePageMode())
+	{
+		if(true==crtc.state.ShowPage(0))
+		{
+			memcpy(copy,VRAM,VRAMSize);
+		}
+	}
+	else
+	{
+		auto pageSize=VRAMSize/2;
+		for(unsigned int page=0; page<2; ++page)
+		{
+			if(true==crtc.state.ShowPage(page))
+			{
+				memcpy(copy+pageSize*page,VRAM+pageSize*page,pageSize);
+			}
+		}
+	}
+}
+
+TownsFrameCapture::Statistics TownsFrameCapture::GetStatistics(void) const
+{
+	std::lock_guard <std::mutex> lock(statLock);
+	return stat;
+}
+
+std::vector <std::string> TownsFrameCapture::GetStatusText(void) const
+{
+	auto s=GetStatistics();
+	std::vector <std::string> text;
+	text.push_back(std::string("Frame Capture:")+(true==capturing ? "Capturing" : "Stopped"));
+	text.push_back("Seen:"+std::to_string(s.framesSeen)+" Queued:"+std::to_string(s.framesQueued)+" Dropped(Queue Full):"+std::to_string(s.framesDropped));
+	text.push_back("Written:"+std::to_string(s.framesWritten)+" Duplicate:"+std::to_string(s.framesDuplicate)+" Errors:"+std::to_string(s.writeErrors));
+	text.push_back("Bytes:"+std::to_string(s.bytesWritten)+" Max Queue Depth:"+std::to_string(s.maxQueueDepth)+"/"+std::to_string(queueLength));
+	if(0<s.framesQueued)
+	{
+		text.push_back("Average Worker Time per Frame:"+std::to_string(s.encodeNanoseconds/s.framesQueued/1000)+"us");
+	}
+	return text;
+}
+
+/* static */ uint64_t TownsFrameCapture::HashImage(unsigned int wid,unsigned int hei,const unsigned char rgba[])
+{
+	uint64_t hash=0xcbf29ce484222325ULL;
+	auto mix=[&](uint64_t v)
+	{
+		hash^=v;
+		hash*=0x100000001b3ULL;
+	};
+	mix(wid);
+	mix(hei);
+
+	// Taking 8 bytes at a time.
+	size_t len=(size_t)wid*hei*4;
+	size_t i=0;
+	for(; i+8<=len; i+=8)
+	{
+		uint64_t v;
+		memcpy(&v,rgba+i,8);
+		mix(v);
+	}
+	for(; i<len; ++i)
+	{
+		mix(rgba[i]);
+	}
+	return hash;
+}
+
+/* static */ std::string TownsFrameCapture::MakePNGFileName(const std::string &outputPrefix,uint64_t frameNumber)
+{
+	char num[32];
+	sprintf(num,"%06llu",(unsigned long long)frameNumber);
+	return outputPrefix+num+".png";
+}
+
+void TownsFrameCapture::WorkerThread(void)
+{
+	for(;;)
+	{
+		std::unique_ptr <Frame> frame;
+		{
+			std::unique_lock <std::mutex> lock(queueLock);
+			queueCond.wait(lock,[this]{return true==quit || true!=queue.empty();});
+			if(true==queue.empty())
+			{
+				// quit must be true here.  Queued frames are all written before quitting.
+				break;
+			}
+			frame=std::move(queue.front());
+			queue.pop_front();
+		}
+
+		auto t0=std::chrono::high_resolution_clock::now();
+		ProcessFrame(*frame);
+		auto t=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now()-t0).count();
+		{
+			std::lock_guard <std::mutex> lock(statLock);
+			stat.encodeNanoseconds+=t;
+		}
+
+		std::lock_guard <std::mutex> lock(queueLock);
+		freeFrames.push_back(std::move(frame));
+	}
+}
+
+void TownsFrameCapture::ProcessFrame(Frame &frame)
+{
+	frame.renderer.BuildImage(frame.VRAM.data(),frame.palette,frame.chaseHQPalette);
+	if(true==frame.imageNeedsFlip)
+	{
+		frame.renderer.FlipUpsideDown();
+	}
+	frame.renderer.MakeOpaque();
+	auto img=frame.renderer.GetImage();
+
+	bool writeError=false;
+	if(true==CheckDuplicateInOrder(frame,img,writeError))
+	{
+		std::lock_guard <std::mutex> lock(statLock);
+		++stat.framesDuplicate;
+		return;
+	}
+
+	uint64_t bytes=0;
+	if(FORMAT_PNG==format && true!=writeError)
+	{
+		auto fName=MakePNGFileName(outputPrefix,frame.frameNumber);
+		auto fNameTmp=fName+".tmp";
+		YsRawPngEncoder encoder;
+		if(YSOK==encoder.EncodeToFile(fNameTmp.c_str(),img.wid,img.hei,8,6,img.rgba))
+		{
+			remove(fName.c_str());
+			rename(fNameTmp.c_str(),fName.c_str());
+			bytes=cpputil::FileSize(fName);
+		}
+		else
+		{
+			writeError=true;
+		}
+	}
+	else if(FORMAT_RAW==format)
+	{
+		bytes=RAW_FRAME_HEADER_SIZE+(uint64_t)img.wid*img.hei*4;
+	}
+
+	std::lock_guard <std::mutex> lock(statLock);
+	if(true==writeError)
+	{
+		++stat.writeErrors;
+	}
+	else
+	{
+		++stat.framesWritten;
+		stat.bytesWritten+=bytes;
+	}
+}
+
+bool TownsFrameCapture::CheckDuplicateInOrder(const Frame &frame,const TownsRender::Image &img,bool &writeError)
+{
+	auto hash=HashImage(img.wid,img.hei,img.rgba);
+
+	std::unique_lock <std::mutex> lock(orderLock);
+	orderCond.wait(lock,[&]{return nextSequenceToCheck==frame.sequence;});
+
+	bool duplicate=(true==lastHashValid && lastHash==hash);
+	lastHash=hash;
+	lastHashValid=true;
+
+	if(true!=duplicate && FORMAT_RAW==format)
+	{
+		unsigned char header[RAW_FRAME_HEADER_SIZE];
+		cpputil::PutDword(header,(unsigned int)frame.frameNumber);
+		cpputil::PutDword(header+4,img.wid);
+		cpputil::PutDword(header+8,img.hei);
+		cpputil::PutDword(header+12,(unsigned int)frame.townsTime);
+		cpputil::PutDword(header+16,(unsigned int)(frame.townsTime>>32));
+		size_t len=(size_t)img.wid*img.hei*4;
+		if(RAW_FRAME_HEADER_SIZE!=fwrite(header,1,RAW_FRAME_HEADER_SIZE,rawFp) ||
+		   len!=fwrite(img.rgba,1,len,rawFp))
+		{
+			writeError=true;
+		}
+	}
+
+	++nextSequenceToCheck;
+	lock.unlock();
+	orderCond.notify_all();
+
+	return duplicate;
+}
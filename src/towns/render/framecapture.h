@@ -0,0 +1,165 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#ifndef FRAMECAPTURE_IS_INCLUDED
+#define FRAMECAPTURE_IS_INCLUDED
+/* { */
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <stdio.h>
+
+#include "render.h"
+
+/*! Continuous frame capture.
+    The VM thread copies every Nth frame (VRAM, palette, and CRTC layers) into a bounded queue.
+    Worker threads render the copies, skip frames identical to the previous captured frame, and
+    write numbered PNGs or append raw RGBA frames to one dump file.
+    When the queue is full, the frame is dropped and counted instead of stalling the VM.
+*/
+class TownsFrameCapture
+{
+public:
+	enum
+	{
+		FORMAT_PNG,
+		FORMAT_RAW,
+	};
+	enum
+	{
+		DEFAULT_INTERVAL=1,
+		DEFAULT_QUEUE_LENGTH=8,
+		MAX_NUM_WORKERS=16,
+	};
+
+	/*! Raw dump file begins with RAW_FILE_HEADER_SIZE bytes, "TSUGARU_FRAMES\0\0",
+	    followed by frames.  Each frame is a RAW_FRAME_HEADER_SIZE-byte header,
+	    frame number (dword), width (dword), height (dword), townsTime low dword, townsTime high dword,
+	    all in little endian, followed by width*height*4 bytes of RGBA.
+	*/
+	enum
+	{
+		RAW_FILE_HEADER_SIZE=16,
+		RAW_FRAME_HEADER_SIZE=20,
+	};
+
+	class Statistics
+	{
+	public:
+		uint64_t framesSeen=0;       // Frames the VM thread offered while capturing.
+		uint64_t framesQueued=0;
+		uint64_t framesDropped=0;    // Queue was full.
+		uint64_t framesDuplicate=0;  // Same image as the previous captured frame.
+		uint64_t framesWritten=0;
+		uint64_t writeErrors=0;
+		uint64_t bytesWritten=0;
+		uint64_t maxQueueDepth=0;
+		uint64_t encodeNanoseconds=0; // Total time spent by the workers rendering and encoding.
+	};
+
+private:
+	class Frame
+	{
+	public:
+		uint64_t sequence=0;     // Order in the queue.  Duplicate check is done in this order.
+		uint64_t frameNumber=0;  // Counted in rendered frames since Start.
+		uint64_t townsTime=0;
+		bool imageNeedsFlip=false;
+		TownsRender renderer;
+		std::vector <unsigned char> VRAM;
+		TownsCRTC::AnalogPalette palette;
+		TownsCRTC::ChaseHQPalette chaseHQPalette;
+	};
+
+	bool capturing=false;
+	unsigned int format=FORMAT_PNG;
+	unsigned int interval=DEFAULT_INTERVAL;
+	unsigned int queueLength=DEFAULT_QUEUE_LENGTH;
+	std::string outputPrefix;
+	uint64_t frameCounter=0;
+
+	std::vector <std::thread> workers;
+	mutable std::mutex queueLock;
+	std::condition_variable queueCond;
+	std::deque <std::unique_ptr <Frame> > queue,freeFrames;
+	uint64_t nextSequence=0;
+	bool quit=false;
+
+	std::mutex orderLock;
+	std::condition_variable orderCond;
+	uint64_t nextSequenceToCheck=0;
+	uint64_t lastHash=0;
+	bool lastHashValid=false;
+	FILE *rawFp=nullptr;
+
+	mutable std::mutex statLock;
+	Statistics stat;
+
+public:
+	TownsFrameCapture();
+	~TownsFrameCapture();
+
+	/*! Starts capturing.  PNG files are named outputPrefix followed by a 6-digit frame number,
+	    and the raw dump is written to outputPrefix followed by ".frames".
+	    numWorkers=0 uses the number of hardware threads.
+	    Returns false if already capturing or the raw dump file cannot be opened.
+	*/
+	bool Start(const std::string &outputPrefix,unsigned int format,unsigned int interval,unsigned int numWorkers,unsigned int queueLength=DEFAULT_QUEUE_LENGTH);
+
+	/*! Writes all queued frames and stops the workers.
+	*/
+	void Stop(void);
+
+	bool IsCapturing(void) const;
+
+	/*! Called from the VM thread every time a frame is rendered.
+	    It copies the frame only if it is the Nth frame and a queue slot is available.
+	*/
+	void NextFrame(const TownsCRTC &crtc,const unsigned char VRAM[],bool damperWireLine,bool scanLineEffectIn15KHz,bool imageNeedsFlip,uint64_t townsTime);
+
+	Statistics GetStatistics(void) const;
+	std::vector <std::string> GetStatusText(void) const;
+
+	/*! FNV-1a-style hash of the RGBA bitmap that mixes in 8 bytes per round instead of 1.
+	    Not compatible with FNV-1a, but good enough for skipping duplicate frames.
+	*/
+	static uint64_t HashImage(unsigned int wid,unsigned int hei,const unsigned char rgba[]);
+
+	/*! Returns the file name of a PNG frame.
+	*/
+	static std::string MakePNGFileName(const std::string &outputPrefix,uint64_t frameNumber);
+
+private:
+	/*! Copies only the VRAM pages that are shown.  The renderer does not read hidden pages.
+	*/
+	static void CopyShownPages(unsigned char copy[],const TownsCRTC &crtc,const unsigned char VRAM[]);
+
+	void WorkerThread(void);
+	void ProcessFrame(Frame &frame);
+
+	/*! Waits for the frames queued before this one, and returns true if the image is the same as the
+	    previous captured frame.  Raw frames are appended inside the same turn so that the dump stays in order.
+	*/
+	bool CheckDuplicateInOrder(const Frame &frame,const TownsRender::Image &img,bool &writeError);
+};
+
+/* } */
+#endif
@@ -13,6 +13,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 << LICENSE */
 #include <cstring>
+#include <algorithm>
 #include "cpputil.h"
 #include "render.h"
 
@@ -23,11 +24,60 @@ TownsRender::TownsRender()
 	wid=0;
 	hei=0;
 }
+TownsRender::FrameBufferPool::FrameBufferPool()
+{
+	freeBuffers.Resize(POOL_SIZE);
+}
+void TownsRender::FrameBufferPool::Return(ImageCopy &img)
+{
+	if(0<img.rgba.capacity())
+	{
+		if(true==freeBuffers.Push(std::move(img.rgba)))
+		{
+			++numReturned;
+		}
+		else
+		{
+			++numDropped;
+		}
+	}
+	img.rgba.clear();
+	img.wid=0;
+	img.hei=0;
+}
+bool TownsRender::FrameBufferPool::Take(std::vector <unsigned char> &rgba)
+{
+	if(true==freeBuffers.Pop(rgba))
+	{
+		++numTaken;
+		return true;
+	}
+	return false;
+}
+
+void TownsRender::SetFrameBufferPool(FrameBufferPool *pool)
+{
+	frameBufferPool=pool;
+}
 void TownsRender::Create(int wid,int hei)
 {
 	this->wid=wid;
 	this->hei=hei;
-	rgba.resize(4*wid*hei);
+
+	const size_t size=4*wid*hei;
+	if(rgba.capacity()<size && nullptr!=frameBufferPool)
+	{
+		std::vector <unsigned char> recycled;
+		if(true==frameBufferPool->Take(recycled) && rgba.capacity()<recycled.capacity())
+		{
+			std::swap(rgba,recycled);
+		}
+		if(rgba.capacity()<size)
+		{
+			++frameBufferPool->numAllocated;
+		}
+	}
+	rgba.resize(size);
 }
 
 void TownsRender::Crop(unsigned int x0,unsigned int y0,unsigned int newWid,unsigned int newHei)
@@ -91,10 +141,18 @@ void TownsRender::Prepare(const TownsCRTC &crtc)
 	}
 	crtcPriorityPage=crtc.GetPriorityPage();
 	crtcRenderSize=crtc.GetRenderSize();
+
+	useRasterFrame=false;
+	if(true==crtc.rasterLog.enabled && true!=highResCRTC && true!=crtc.rasterLog.last.events.empty())
+	{
+		rasterFrame=crtc.rasterLog.last;
+		useRasterFrame=true;
+	}
 }
 
 void TownsRender::PrepareEntireVRAMLayer(const TownsCRTC &crtc,int layer)
 {
+	useRasterFrame=false;
 	highResCRTC=crtc.state.highResCRTCEnabled;
 	if(true==highResCRTC)
 	{
@@ -145,6 +203,7 @@ void TownsRender::OerrideShowPage(bool layer0,bool layer1)
 {
 	crtcShowPage[0]=layer0;
 	crtcShowPage[1]=layer1;
+	useRasterFrame=false;
 }
 
 void TownsRender::BuildImage(const unsigned char VRAM[],const TownsCRTC::AnalogPalette &palette,const TownsCRTC::ChaseHQPalette &chaseHQPalette)
@@ -153,7 +212,11 @@ void TownsRender::BuildImage(const unsigned char VRAM[],const TownsCRTC::AnalogP
 
 	std::memset(rgba.data(),0,rgba.size());
 
-	if(true==crtcIsSinglePageMode)
+	if(true==useRasterFrame)
+	{
+		BuildImageByRasterBand(VRAM);
+	}
+	else if(true==crtcIsSinglePageMode)
 	{
 		if(true==crtcShowPage[0])
 		{
@@ -251,6 +314,94 @@ void TownsRender::BuildImage(const unsigned char VRAM[],const TownsCRTC::AnalogP
 	}
 }
 
+void TownsRender::BuildImageByRasterBand(const unsigned char VRAM[])
+{
+	TownsCRTC::State regs=rasterFrame.startState;
+	auto layerState=TownsCRTC::MakeRasterLayerState(regs,rasterFrame.spriteVRAMOffset);
+
+	const auto &events=rasterFrame.events;
+	size_t eventPtr=0;
+	int y0=0;
+	while(y0<(int)hei)
+	{
+		bool layerChanged=false;
+		while(eventPtr<events.size() && RasterEventLine(events[eventPtr].timeInCycle)<=y0)
+		{
+			auto &e=events[eventPtr++];
+			TownsCRTC::ApplyRasterEvent(regs,e);
+			layerChanged=(layerChanged || TownsCRTC::RasterEvent::TYPE_PALETTE!=e.type);
+		}
+		if(true==layerChanged)
+		{
+			layerState=TownsCRTC::MakeRasterLayerState(regs,rasterFrame.spriteVRAMOffset);
+		}
+
+		int y1=(eventPtr<events.size() ? RasterEventLine(events[eventPtr].timeInCycle) : (int)hei);
+		RenderRasterBand(VRAM,regs.palette,layerState,y0,y1);
+		y0=y1;
+	}
+}
+
+void TownsRender::RenderRasterBand(const unsigned char VRAM[],const TownsCRTC::AnalogPalette &palette,const TownsCRTC::RasterLayerState &layerState,int y0,int y1)
+{
+	// Mid-frame palette changes are drawn by the band.  ChaseHQ special must not kick in.
+	static const TownsCRTC::ChaseHQPalette noChaseHQPalette=TownsCRTC::ChaseHQPalette();
+
+	if(true==layerState.singlePage)
+	{
+		TownsCRTC::Layer layer=layerState.layer[0];
+		if(true==layerState.showPage[0] && true==ClipLayerToRasterBand(layer,y0,y1))
+		{
+			Render<VRAM1Trans>(0,layer,palette,noChaseHQPalette,VRAM,false);
+		}
+	}
+	else
+	{
+		auto priorityPage=(layerState.priorityPage&1);
+		TownsCRTC::Layer layer=layerState.layer[1-priorityPage];
+		if(true==layerState.showPage[1-priorityPage] && true==ClipLayerToRasterBand(layer,y0,y1))
+		{
+			Render<VRAM0Trans>(1-priorityPage,layer,palette,noChaseHQPalette,VRAM,false);
+		}
+		layer=layerState.layer[priorityPage];
+		if(true==layerState.showPage[priorityPage] && true==ClipLayerToRasterBand(layer,y0,y1))
+		{
+			Render<VRAM0Trans>(priorityPage,layer,palette,noChaseHQPalette,VRAM,true);
+		}
+	}
+}
+
+int TownsRender::RasterEventLine(uint32_t timeInCycle) const
+{
+	// Writes during VSYNC are made before the CRTC starts drawing the frame.
+	if(TownsCRTC::CRT_VERTICAL_DURATION<=timeInCycle)
+	{
+		return 0;
+	}
+	return (int)((uint64_t)timeInCycle*hei/TownsCRTC::CRT_VERTICAL_DURATION);
+}
+
+/* static */ bool TownsRender::ClipLayerToRasterBand(TownsCRTC::Layer &layer,int y0,int y1)
+{
+	const int ZV=std::max(1,layer.zoom2x.y()/2);
+	const int top=layer.originOnMonitor.y();
+	const int bottom=top+layer.sizeOnMonitor.y();
+	int yStart=std::max(top,y0);
+	int yEnd=std::min(bottom,y1);
+	if(yEnd<=yStart)
+	{
+		return false;
+	}
+
+	// Start from the first monitor line of a VRAM line so that the vertical zoom stays in phase.
+	const int skipVRAMLines=(yStart-top)/ZV;
+	yStart=top+skipVRAMLines*ZV;
+	layer.VRAMOffset+=skipVRAMLines*layer.bytesPerLine;
+	layer.originOnMonitor.y()=yStart;
+	layer.sizeOnMonitor.y()=yEnd-yStart;
+	return true;
+}
+
 void TownsRender::FlipUpsideDown(void)
 {
 	std::vector <unsigned char> flip;
@@ -294,6 +445,17 @@ TownsRender::ImageCopy TownsRender::MoveImage(void)
 	this->rgba.clear();
 	return img;
 }
+void TownsRender::RecycleImage(ImageCopy &img)
+{
+	if(rgba.capacity()<img.rgba.capacity())
+	{
+		std::swap(rgba,img.rgba);
+		rgba.clear();
+	}
+	img.rgba.clear();
+	img.wid=0;
+	img.hei=0;
+}
 
 template <class OFFSETTRANS>
 void TownsRender::Render(
@@ -17,7 +17,10 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 /* { */
 
 #include <vector>
+#include <atomic>
+#include <cstdint>
 
+#include "spscringbuffer.h"
 #include "physmem.h"
 #include "crtc.h"
 
@@ -40,6 +43,15 @@ private:
 	int scanLineCounter=0;
 	int frequency=0;
 
+public:
+	class FrameBufferPool;
+private:
+	FrameBufferPool *frameBufferPool=nullptr;
+
+	// Copy of TownsCRTC::rasterLog.last.  Used if the last frame changed palette or layers mid-frame.
+	bool useRasterFrame=false;
+	TownsCRTC::RasterFrame rasterFrame;
+
 public:
 	bool damperWireLine=false;
 	bool scanLineEffectIn15KHz=false;
@@ -57,8 +69,39 @@ public:
 		std::vector <unsigned char> rgba;
 	};
 
+	/*! Bitmaps handed back after a newer image replaced them.
+	    TownsRender takes one when it needs a bitmap, so that steady-state rendering does not allocate.
+	    Return must be called from the thread that shows images, and Take from the thread that renders.
+	    Counters are for measuring the memory traffic.
+	*/
+	class FrameBufferPool
+	{
+	private:
+		cpputil::SPSCRingBuffer <std::vector <unsigned char> > freeBuffers;
+	public:
+		enum
+		{
+			POOL_SIZE=3
+		};
+		std::atomic <uint64_t> numReturned{0},numDropped{0},numTaken{0},numAllocated{0};
+
+		FrameBufferPool();
+
+		/*! Takes the bitmap of img.  Bitmap is freed if the pool is full.
+		*/
+		void Return(ImageCopy &img);
+
+		/*! Returns false if no bitmap is available.
+		*/
+		bool Take(std::vector <unsigned char> &rgba);
+	};
+
 	TownsRender();
 
+	/*! Bitmaps are taken from the pool when this TownsRender does not have one large enough.
+	*/
+	void SetFrameBufferPool(FrameBufferPool *pool);
+
 	/*! Create a bitmap image.
 	*/
 	void Create(int wid,int hei);
@@ -91,6 +134,21 @@ public:
 private:
 	void SetResolution(int wid,int hei);
 
+	/*! Draws the layers band by band, each band with the palette and layers at the time of the band
+	    recorded in rasterFrame.
+	*/
+	void BuildImageByRasterBand(const unsigned char VRAM[]);
+	void RenderRasterBand(const unsigned char VRAM[],const TownsCRTC::AnalogPalette &palette,const TownsCRTC::RasterLayerState &layerState,int y0,int y1);
+
+	/*! Returns the line on the monitor for the time in the VSYNC cycle.
+	*/
+	int RasterEventLine(uint32_t timeInCycle) const;
+
+	/*! Makes the layer cover lines y0 to y1-1 on the monitor.
+	    Returns false if the layer does not overlap the band.
+	*/
+	static bool ClipLayerToRasterBand(TownsCRTC::Layer &layer,int y0,int y1);
+
 public:
 	/*!
 	*/
@@ -108,6 +166,11 @@ public:
 	*/
 	ImageCopy MoveImage(void);
 
+	/*! Takes the bitmap of an image that is no longer shown, if this TownsRender does not have a bitmap.
+	    For the case the image is returned to the same thread.
+	*/
+	void RecycleImage(ImageCopy &img);
+
 	class VRAM0Trans // 80000000H to 80080000H
 	{
 	public:
@@ -351,8 +351,11 @@ TownsSerialPort::TownsSerialPort(class FMTownsCommon *townsPtr) : Device(townsPt
 }
 bool TownsSerialPort::ConnectSocketClient(std::string serverAddr)
 {
-	if(YSTRUE!=socketClient.IsConnected())
+	if(true!=socketClient.SocketConnected())
 	{
+		// Clean up if the server closed the previous connection.
+		DisconnectSocketClient();
+
 		std::string ipAddr,portStr;
 		bool colon=false;
 		for(auto c : serverAddr)
@@ -376,6 +379,7 @@ bool TownsSerialPort::ConnectSocketClient(std::string serverAddr)
 		if(YSOK==socketClient.Start(port) &&
 		   YSTRUE==socketClient.Connect(ipAddr.c_str()))
 		{
+			socketClient.StartIOThread();
 			state.intel8251.clientPtr=&socketClient;
 			return true;
 		}
@@ -384,9 +388,14 @@ bool TownsSerialPort::ConnectSocketClient(std::string serverAddr)
 }
 void TownsSerialPort::DisconnectSocketClient(void)
 {
-	if(YSTRUE==socketClient.IsConnected())
+	// The server may have closed the connection already.  The I/O thread must be stopped regardless.
+	if(true==socketClient.IOThreadRunning())
 	{
-		socketClient.Disconnect();
+		socketClient.StopIOThread();
+		if(YSTRUE==socketClient.IsConnected())
+		{
+			socketClient.Disconnect();
+		}
 		socketClient.Terminate();
 		state.intel8251.clientPtr=&defaultClient;
 	}
@@ -0,0 +1,261 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include "sound.h"
+
+
+
+TownsSound::FMSynthesisThread::FMSynthesisThread()
+{
+	cmdQueue.Resize(COMMAND_QUEUE_SIZE);
+	segmentQueue.Resize(SEGMENT_QUEUE_SIZE);
+}
+TownsSound::FMSynthesisThread::~FMSynthesisThread()
+{
+	Stop();
+}
+void TownsSound::FMSynthesisThread::Start(const YM2612 &vmYM2612)
+{
+	if(true==running)
+	{
+		Sync(vmYM2612);
+		return;
+	}
+	cmdQueue.Clear();
+	segmentQueue.Clear();
+	drainedSegments.clear();
+	numRenderPending=0;
+	quitting=false;
+	ym2612.reset(new YM2612(vmYM2612));
+	ym2612->regWriteSched.clear();
+	ym2612->useScheduling=true;
+	running=true;
+	std::thread t(&TownsSound::FMSynthesisThread::ThreadFunc,this);
+	std::swap(t,thr);
+}
+void TownsSound::FMSynthesisThread::Stop(void)
+{
+	if(true==running)
+	{
+		// Worker may be waiting for room in the segment queue.  Segments rendered from now on are discarded.
+		quitting=true;
+		Command cmd;
+		cmd.cmd=CMD_QUIT;
+		PushCommand(cmd);
+		{
+			std::unique_lock <std::mutex> lock(mutex);
+		}
+		cond.notify_all();
+		thr.join();
+		running=false;
+		segmentQueue.Clear();
+		drainedSegments.clear();
+		numRenderPending=0;
+	}
+}
+void TownsSound::FMSynthesisThread::Sync(const YM2612 &vmYM2612)
+{
+	WaitIdle();
+	Segment seg;
+	while(true==segmentQueue.Pop(seg))
+	{
+	}
+	drainedSegments.clear();
+	numRenderPending=0;
+	ym2612.reset(new YM2612(vmYM2612));
+	ym2612->regWriteSched.clear();
+	ym2612->useScheduling=true;
+}
+void TownsSound::FMSynthesisThread::CopyWaveGenerationState(YM2612 &ym) const
+{
+	WaitIdle();
+	for(unsigned int chNum=0; chNum<YM2612::NUM_CHANNELS; ++chNum)
+	{
+		ym.state.channels[chNum]=ym2612->state.channels[chNum];
+	}
+	ym.state.playingCh=ym2612->state.playingCh;
+}
+void TownsSound::FMSynthesisThread::SendRegisterWrite(unsigned int chBase,unsigned int reg,unsigned int data,uint64_t townsTime)
+{
+	Command cmd;
+	cmd.cmd=CMD_REGISTER_WRITE;
+	cmd.chBase=chBase;
+	cmd.reg=reg;
+	cmd.data=data;
+	cmd.townsTime=townsTime;
+	PushCommand(cmd);
+}
+void TownsSound::FMSynthesisThread::RequestRender(unsigned int numSamples,uint64_t lastWaveGenTime,int volume,const bool channelMute[YM2612::NUM_CHANNELS])
+{
+	Command cmd;
+	cmd.cmd=CMD_RENDER;
+	cmd.numSamples=numSamples;
+	cmd.townsTime=lastWaveGenTime;
+	cmd.volume=volume;
+	for(unsigned int chNum=0; chNum<YM2612::NUM_CHANNELS; ++chNum)
+	{
+		if(true==channelMute[chNum])
+		{
+			cmd.channelMute|=(1<<chNum);
+		}
+	}
+	++numRenderPending;
+	PushCommand(cmd);
+
+	// Register writes are not notified.  The worker wakes up only for render requests.
+	// Taking the lock before notifying makes sure the worker is either waiting or yet to check the queue.
+	{
+		std::unique_lock <std::mutex> lock(mutex);
+	}
+	cond.notify_all();
+}
+bool TownsSound::FMSynthesisThread::WaitSegment(Segment &seg)
+{
+	if(0==numRenderPending)
+	{
+		return false;
+	}
+	if(true!=PopSegment(seg))
+	{
+		std::unique_lock <std::mutex> lock(mutex);
+		cond.wait(lock,[this]{return true!=segmentQueue.Empty();});
+		lock.unlock();
+		PopSegment(seg);
+	}
+	--numRenderPending;
+	return true;
+}
+bool TownsSound::FMSynthesisThread::TryGetSegment(Segment &seg)
+{
+	if(0<numRenderPending && true==PopSegment(seg))
+	{
+		--numRenderPending;
+		return true;
+	}
+	return false;
+}
+bool TownsSound::FMSynthesisThread::PopSegment(Segment &seg) const
+{
+	if(true!=drainedSegments.empty())
+	{
+		seg=std::move(drainedSegments.front());
+		drainedSegments.pop_front();
+		return true;
+	}
+	if(true==segmentQueue.Pop(seg))
+	{
+		// Worker may be waiting for room in the queue.
+		{
+			std::unique_lock <std::mutex> lock(mutex);
+		}
+		cond.notify_all();
+		return true;
+	}
+	return false;
+}
+void TownsSound::FMSynthesisThread::PushCommand(const Command &cmd)
+{
+	while(true!=cmdQueue.Push(cmd))
+	{
+		// Queue full.  Can happen only if the VM writes a huge number of registers without rendering.
+		// Let the worker apply the writes to its register schedule.
+		{
+			std::unique_lock <std::mutex> lock(mutex);
+		}
+		cond.notify_all();
+		std::this_thread::yield();
+	}
+}
+void TownsSound::FMSynthesisThread::WaitIdle(void) const
+{
+	if(true==running)
+	{
+		std::unique_lock <std::mutex> lock(mutex);
+		for(;;)
+		{
+			cond.wait(lock,[this]{return (true!=busy && true==cmdQueue.Empty()) || true!=segmentQueue.Empty();});
+			Segment seg;
+			bool drained=false;
+			while(true==segmentQueue.Pop(seg))
+			{
+				drainedSegments.push_back(std::move(seg));
+				drained=true;
+			}
+			if(true==drained)
+			{
+				cond.notify_all();  // Worker may be waiting for room in the queue.
+				continue;
+			}
+			break;
+		}
+	}
+}
+void TownsSound::FMSynthesisThread::ThreadFunc(void)
+{
+	for(;;)
+	{
+		{
+			std::unique_lock <std::mutex> lock(mutex);
+			cond.wait(lock,[this]{return true!=cmdQueue.Empty();});
+			busy=true;
+		}
+
+		Command cmd;
+		while(true==cmdQueue.Pop(cmd))
+		{
+			if(CMD_REGISTER_WRITE==cmd.cmd)
+			{
+				ym2612->WriteRegister(cmd.chBase,cmd.reg,cmd.data,cmd.townsTime);
+			}
+			else if(CMD_RENDER==cmd.cmd)
+			{
+				ym2612->state.volume=cmd.volume;
+				for(unsigned int chNum=0; chNum<YM2612::NUM_CHANNELS; ++chNum)
+				{
+					ym2612->channelMute[chNum]=(0!=(cmd.channelMute&(1<<chNum)));
+				}
+
+				Segment seg;
+				seg.wave.resize(cmd.numSamples*4);
+				ym2612->MakeWaveForNSamples(seg.wave.data(),cmd.numSamples,cmd.townsTime);
+				ym2612->CheckToneDoneAllChannels();
+				seg.playingCh=ym2612->state.playingCh;
+
+				{
+					// Render ahead until the segment queue is full.  Then wait for the VM thread to take one.
+					std::unique_lock <std::mutex> lock(mutex);
+					cond.wait(lock,[this]{return true==quitting || segmentQueue.Size()<segmentQueue.Capacity();});
+					if(true!=quitting)
+					{
+						segmentQueue.Push(std::move(seg));
+					}
+				}
+				cond.notify_all();
+			}
+			else if(CMD_QUIT==cmd.cmd)
+			{
+				std::unique_lock <std::mutex> lock(mutex);
+				busy=false;
+				cond.notify_all();
+				return;
+			}
+		}
+
+		{
+			std::unique_lock <std::mutex> lock(mutex);
+			busy=false;
+		}
+		cond.notify_all();
+	}
+}
@@ -0,0 +1,229 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include "mixer.h"
+#include "cpputil.h"
+
+#if defined(YS_LITTLE_ENDIAN) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2<=_M_IX86_FP))
+	#define TOWNSSOUNDMIXER_USE_SSE2
+	#include <emmintrin.h>
+#endif
+
+
+
+void TownsSoundMixer::Begin(unsigned int numSamples)
+{
+	this->numSamples=numSamples;
+	for(auto &b : bus)
+	{
+		b.active=false;
+		b.peakL=0;
+		b.peakR=0;
+	}
+}
+
+unsigned char *TownsSoundMixer::Stage16(void)
+{
+	stage.resize(numSamples*4);
+	memset(stage.data(),0,stage.size());
+	return stage.data();
+}
+
+void TownsSoundMixer::Accumulate16(unsigned int source,const unsigned char wave16[])
+{
+	auto &b=bus[source];
+	const unsigned int numWords=numSamples*2;
+	if(b.sample.size()<numWords)
+	{
+		b.sample.resize(numWords);
+	}
+	if(true!=b.active)
+	{
+		memset(b.sample.data(),0,numWords*sizeof(int32_t));
+		b.active=true;
+	}
+
+	int32_t *dst=b.sample.data();
+	unsigned int i=0;
+	int peakL=b.peakL,peakR=b.peakR;
+#ifdef TOWNSSOUNDMIXER_USE_SSE2
+	// madd of (s,0) and (gain,0) gives s*gain in 32 bits.
+	const __m128i gain=_mm_set1_epi32(b.gain);
+	const __m128i zero=_mm_setzero_si128();
+	__m128i peak=zero;
+	for(; i+8<=numWords; i+=8)
+	{
+		__m128i s=_mm_loadu_si128((const __m128i *)(wave16+i*2));
+		// Saturating negate so that -32768 counts as 32767, same as the scalar tail.
+		peak=_mm_max_epi16(peak,_mm_max_epi16(s,_mm_subs_epi16(zero,s)));
+		__m128i lo=_mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(s,zero),gain),GAIN_SHIFT);
+		__m128i hi=_mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(s,zero),gain),GAIN_SHIFT);
+		__m128i d0=_mm_loadu_si128((const __m128i *)(dst+i));
+		__m128i d1=_mm_loadu_si128((const __m128i *)(dst+i+4));
+		_mm_storeu_si128((__m128i *)(dst+i),_mm_add_epi32(d0,lo));
+		_mm_storeu_si128((__m128i *)(dst+i+4),_mm_add_epi32(d1,hi));
+	}
+	int16_t peakLane[8];
+	_mm_storeu_si128((__m128i *)peakLane,peak);
+	for(unsigned int lane=0; lane<8; lane+=2)
+	{
+		peakL=std::max<int>(peakL,peakLane[lane]);
+		peakR=std::max<int>(peakR,peakLane[lane+1]);
+	}
+#endif
+	for(; i<numWords; i+=2)
+	{
+		int L=cpputil::GetSignedWord(wave16+i*2);
+		int R=cpputil::GetSignedWord(wave16+i*2+2);
+		peakL=std::max(peakL,std::min(32767,std::abs(L)));
+		peakR=std::max(peakR,std::min(32767,std::abs(R)));
+		dst[i  ]+=(L*b.gain)>>GAIN_SHIFT;
+		dst[i+1]+=(R*b.gain)>>GAIN_SHIFT;
+	}
+	b.peakL=peakL;
+	b.peakR=peakR;
+}
+
+void TownsSoundMixer::Mix(unsigned char out[]) const
+{
+	const int32_t *src[NUM_SOURCES];
+	unsigned int numActive=0;
+	for(auto &b : bus)
+	{
+		if(true==b.active)
+		{
+			src[numActive++]=b.sample.data();
+		}
+	}
+
+	const unsigned int numWords=numSamples*2;
+	if(0==numActive)
+	{
+		memset(out,0,numWords*2);
+		return;
+	}
+
+	// Sum of the buses fits in 24 bits even at MAX_GAIN, therefore single-precision scaling is exact enough.
+	// Vector and scalar paths round the same way.
+	const bool scaleMaster=(UNITY_GAIN!=masterGain);
+	const float masterScale=(float)masterGain/(float)UNITY_GAIN;
+
+	unsigned int i=0;
+#ifdef TOWNSSOUNDMIXER_USE_SSE2
+	const __m128 masterScale4=_mm_set1_ps(masterScale);
+	for(; i+8<=numWords; i+=8)
+	{
+		__m128i lo=_mm_loadu_si128((const __m128i *)(src[0]+i));
+		__m128i hi=_mm_loadu_si128((const __m128i *)(src[0]+i+4));
+		for(unsigned int j=1; j<numActive; ++j)
+		{
+			lo=_mm_add_epi32(lo,_mm_loadu_si128((const __m128i *)(src[j]+i)));
+			hi=_mm_add_epi32(hi,_mm_loadu_si128((const __m128i *)(src[j]+i+4)));
+		}
+		if(true==scaleMaster)
+		{
+			lo=_mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(lo),masterScale4));
+			hi=_mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(hi),masterScale4));
+		}
+		_mm_storeu_si128((__m128i *)(out+i*2),_mm_packs_epi32(lo,hi));
+	}
+#endif
+	for(; i<numWords; ++i)
+	{
+		int32_t sum=0;
+		for(unsigned int j=0; j<numActive; ++j)
+		{
+			sum+=src[j][i];
+		}
+		if(true==scaleMaster)
+		{
+			sum=(int32_t)std::lrint((float)sum*masterScale);
+		}
+		sum=std::max<int32_t>(-32768,std::min<int32_t>(32767,sum));
+		cpputil::PutWord(out+i*2,(unsigned short)(sum&0xFFFF));
+	}
+}
+
+void TownsSoundMixer::SetGain(unsigned int source,int gain)
+{
+	if(source<NUM_SOURCES)
+	{
+		bus[source].gain=std::max(0,std::min<int>(MAX_GAIN,gain));
+	}
+}
+
+void TownsSoundMixer::SetMasterGain(int gain)
+{
+	masterGain=std::max(0,std::min<int>(MAX_GAIN,gain));
+}
+
+/* static */ const char *TownsSoundMixer::SourceToStr(unsigned int source)
+{
+	switch(source)
+	{
+	case SOURCE_FM:
+		return "FM";
+	case SOURCE_PCM:
+		return "PCM";
+	case SOURCE_HIGHRES_PCM:
+		return "HIRES";
+	case SOURCE_CDDA:
+		return "CDDA";
+	case SOURCE_WAVE_INPUT:
+		return "WAVIN";
+	}
+	return "?";
+}
+
+/* static */ unsigned int TownsSoundMixer::StrToSource(std::string str)
+{
+	cpputil::Capitalize(str);
+	for(unsigned int source=0; source<NUM_SOURCES; ++source)
+	{
+		if(str==SourceToStr(source))
+		{
+			return source;
+		}
+	}
+	return NUM_SOURCES;
+}
+
+std::vector <std::string> TownsSoundMixer::GetStatusText(void) const
+{
+	std::vector <std::string> text;
+	text.push_back("MIXER GAIN MASTER=");
+	text.back()+=cpputil::Itoa(masterGain);
+	for(unsigned int source=0; source<NUM_SOURCES; ++source)
+	{
+		text.back()+=" ";
+		text.back()+=SourceToStr(source);
+		text.back()+="=";
+		text.back()+=cpputil::Itoa(bus[source].gain);
+	}
+	text.push_back("MIXER PEAK");
+	for(unsigned int source=0; source<NUM_SOURCES; ++source)
+	{
+		text.back()+=" ";
+		text.back()+=SourceToStr(source);
+		text.back()+="=";
+		text.back()+=cpputil::Itoa(bus[source].peakL);
+		text.back()+="/";
+		text.back()+=cpputil::Itoa(bus[source].peakR);
+	}
+	return text;
+}
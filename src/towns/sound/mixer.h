@@ -0,0 +1,110 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#ifndef MIXER_IS_INCLUDED
+#define MIXER_IS_INCLUDED
+/* { */
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+/*! Mixing stage of TownsSound.
+    Each sound source renders 16-bit stereo into the staging buffer, which is widened to the source's own 32-bit bus
+    with the source gain applied.  Then, Mix sums the active buses, applies the master gain, and saturates to 16-bit in one pass.
+*/
+class TownsSoundMixer
+{
+public:
+	enum
+	{
+		SOURCE_FM,
+		SOURCE_PCM,
+		SOURCE_HIGHRES_PCM,
+		SOURCE_CDDA,
+		SOURCE_WAVE_INPUT,  // Wave sent to the PCM sampling register.
+		NUM_SOURCES
+	};
+	enum
+	{
+		GAIN_SHIFT=12,
+		UNITY_GAIN=(1<<GAIN_SHIFT),
+		MAX_GAIN=32767,
+	};
+
+	class Bus
+	{
+	public:
+		std::vector <int32_t> sample;  // Interleaved L,R
+		bool active=false;
+		int gain=UNITY_GAIN;
+
+		// Peak level of the 16-bit input in the current wave.
+		int peakL=0,peakR=0;
+	};
+
+	Bus bus[NUM_SOURCES];
+	int masterGain=UNITY_GAIN;
+
+private:
+	unsigned int numSamples=0;
+	std::vector <unsigned char> stage;
+
+public:
+	/*! Starts a new wave of numSamples stereo samples.  All buses become inactive.
+	*/
+	void Begin(unsigned int numSamples);
+
+	inline unsigned int GetNumSamples(void) const
+	{
+		return numSamples;
+	}
+
+	/*! Returns a zero-cleared 16-bit interleaved stereo buffer of numSamples samples.
+	    Pass it to Accumulate16 after a source renders into it.
+	*/
+	unsigned char *Stage16(void);
+
+	/*! Widens 16-bit interleaved stereo wave of numSamples samples to the source bus applying the source gain.
+	    If the bus is already active, the wave is added.
+	*/
+	void Accumulate16(unsigned int source,const unsigned char wave16[]);
+
+	/*! Sums all active buses, scales by the master gain, saturates to signed 16-bit, and writes numSamples*4 bytes to out.
+	*/
+	void Mix(unsigned char out[]) const;
+
+	/*! Sets the source gain.  UNITY_GAIN is 1.0.
+	*/
+	void SetGain(unsigned int source,int gain);
+
+	/*! Sets the gain applied to the sum of all sources.  UNITY_GAIN is 1.0.
+	*/
+	void SetMasterGain(int gain);
+
+	/*! Returns the label of the source (FM, PCM, HIRES, CDDA, or WAVIN).
+	*/
+	static const char *SourceToStr(unsigned int source);
+
+	/*! Returns the source from the label.  Not case sensitive.  Returns NUM_SOURCES if the label is not a source.
+	*/
+	static unsigned int StrToSource(std::string str);
+
+	/*! Returns gains and peak levels of the last wave.
+	*/
+	std::vector <std::string> GetStatusText(void) const;
+};
+
+/* } */
+#endif
@@ -13,6 +13,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 << LICENSE */
 #include <cstring>
+#include <algorithm>
 #include "townsdef.h"
 #include "sound.h"
 #include "towns.h"
@@ -67,11 +68,13 @@ void TownsSound::SetCDROMPointer(class TownsCDROM *cdrom)
 /* virtual */ void TownsSound::PowerOn(void)
 {
 	state.PowerOn();
+	FMThreadNeedsSync=true;
 }
 /* virtual */ void TownsSound::Reset(void)
 {
 	state.Reset();
 	nextFMPCMWave.clear();
+	FMThreadNeedsSync=true;
 }
 /* virtual */ void TownsSound::IOWriteByte(unsigned int ioport,unsigned int data)
 {
@@ -332,6 +335,9 @@ std::vector <std::string> TownsSound::GetStatusText(void) const
 	text.insert(text.end(),pcmText.begin(),pcmText.end());
 	text.insert(text.end(),fmText.begin(),fmText.end());
 
+	auto mixerText=mixer.GetStatusText();
+	text.insert(text.end(),mixerText.begin(),mixerText.end());
+
 	return text;
 }
 
@@ -342,6 +348,16 @@ inline bool TownsSound::IsHighResPCMPlaying(void) const
 
 void TownsSound::ProcessSound(void)
 {
+	if(true==FMThreadNeedsSync)
+	{
+		if(true==FMThread.IsRunning())
+		{
+			FMThread.Sync(state.ym2612);
+		}
+		FMSegmentRequested=false;
+		FMThreadNeedsSync=false;
+	}
+
 	if((true==IsFMPlaying() ||
 	    true==IsPCMPlaying() ||
 	    true==IsPCMRecording() ||
@@ -355,13 +371,31 @@ void TownsSound::ProcessSound(void)
 			const unsigned int WAVE_OUT_SAMPLING_RATE=YM2612::WAVE_SAMPLING_RATE; // Align with YM2612.
 			const uint32_t numSamplesPerWave=FM_PCM_MILLISEC_PER_WAVE*WAVE_OUT_SAMPLING_RATE/1000;
 
+			// nextFMPCMWave is filled by the mixer when it is sent to the outside world.
 			nextFMPCMWave.resize(numSamplesPerWave*4);
-			memset(nextFMPCMWave.data(),0,nextFMPCMWave.size());
+			mixer.Begin(numSamplesPerWave);
 
 			bool wavGenerated=false;
 			if(true==IsFMPlaying() && 0!=(state.muteFlag&2) && 0!=(state.audioFlag&64))
 			{
-				state.ym2612.MakeWaveForNSamples(nextFMPCMWave.data(),numSamplesPerWave,lastFMPCMWaveGenTime);
+				if(true==FMThread.IsRunning())
+				{
+					// Worker applies the same register writes at the same timing as MakeWaveForNSamples would.
+					// VM-side YM2612 only needs to catch up the registers.
+					for(auto &sched : state.ym2612.regWriteSched)
+					{
+						FMThread.SendRegisterWrite(sched.chBase,sched.reg,sched.data,sched.systemTimeInNS);
+					}
+					FMThread.RequestRender(numSamplesPerWave,lastFMPCMWaveGenTime,state.ym2612.state.volume,state.ym2612.channelMute);
+					state.ym2612.FlushRegisterSchedule();
+					FMSegmentRequested=true;
+				}
+				else
+				{
+					auto wave=mixer.Stage16();
+					state.ym2612.MakeWaveForNSamples(wave,numSamplesPerWave,lastFMPCMWaveGenTime);
+					mixer.Accumulate16(TownsSoundMixer::SOURCE_FM,wave);
+				}
 				wavGenerated=true;
 			}
 			if(true==IsPCMPlaying())
@@ -370,16 +404,12 @@ void TownsSound::ProcessSound(void)
 
 				// Brandish expects PCM interrupt even when muted.
 				// Therefore, PCM wave must be generated and played for making IRQ.
+				// AddWaveForNumSamples will set IRQAfterThisPlayBack flag.
+				auto wave=mixer.Stage16();
+				state.rf5c68.AddWaveForNumSamples(wave,numSamplesPerWave,WAVE_OUT_SAMPLING_RATE,lastFMPCMWaveGenTime);
 				if(0!=(state.muteFlag&1) && 0!=(state.audioFlag&64))
 				{
-					state.rf5c68.AddWaveForNumSamples(nextFMPCMWave.data(),numSamplesPerWave,WAVE_OUT_SAMPLING_RATE,lastFMPCMWaveGenTime);
-				}
-				else
-				{
-					// AddWaveForNumSamples will set IRQAfterThisPlayBack flag.
-					std::vector <unsigned char> dummy;
-					dummy.resize(numSamplesPerWave*4);
-					state.rf5c68.AddWaveForNumSamples(dummy.data(),numSamplesPerWave,WAVE_OUT_SAMPLING_RATE,lastFMPCMWaveGenTime);
+					mixer.Accumulate16(TownsSoundMixer::SOURCE_PCM,wave);
 				}
 
 				for(unsigned int chNum=0; chNum<RF5C68::NUM_CHANNELS; ++chNum)
@@ -402,18 +432,23 @@ void TownsSound::ProcessSound(void)
 				}
 				else
 				{
-					highResPCM.AddWaveForNumSamples(nextFMPCMWave.data(),numSamplesPerWave,WAVE_OUT_SAMPLING_RATE);
+					auto wave=mixer.Stage16();
+					highResPCM.AddWaveForNumSamples(wave,numSamplesPerWave,WAVE_OUT_SAMPLING_RATE);
+					mixer.Accumulate16(TownsSoundMixer::SOURCE_HIGHRES_PCM,wave);
 				}
 				wavGenerated=true;
 			}
 			if(true==cdrom->CDDAIsPlaying() && 0!=(state.audioFlag&64))
 			{
-				cdrom->AddWaveForNumSamples(nextFMPCMWave.data(),numSamplesPerWave,WAVE_OUT_SAMPLING_RATE);
+				auto wave=mixer.Stage16();
+				cdrom->AddWaveForNumSamples(wave,numSamplesPerWave,WAVE_OUT_SAMPLING_RATE);
+				mixer.Accumulate16(TownsSoundMixer::SOURCE_CDDA,wave);
 				wavGenerated=true;
 			}
 			if(true==IsPCMRecording())
 			{
 				int balance=0;
+				auto wave=mixer.Stage16();
 				for(int fill=0; fill<numSamplesPerWave; ++fill)
 				{
 					int sum=0;
@@ -425,20 +460,8 @@ void TownsSound::ProcessSound(void)
 						}
 						sum/=var.waveToBeSentToVM.GetNumChannel();
 					}
-					int32_t L=cpputil::GetSignedWord(nextFMPCMWave.data()+fill*4);
-					int32_t R=cpputil::GetSignedWord(nextFMPCMWave.data()+fill*4+2);
-					L+=sum;
-					R+=sum;
-					if(L<0)
-					{
-						L+=65536;
-					}
-					if(R<0)
-					{
-						R+=65536;
-					}
-					cpputil::PutWord(nextFMPCMWave.data()+fill*4,L);
-					cpputil::PutWord(nextFMPCMWave.data()+fill*4+2,R);
+					cpputil::PutWord(wave+fill*4,(sum&0xFFFF));
+					cpputil::PutWord(wave+fill*4+2,(sum&0xFFFF));
 
 					balance+=var.waveToBeSentToVM.PlayBackRate();
 					while(YM2612::WAVE_SAMPLING_RATE<=balance)
@@ -447,6 +470,7 @@ void TownsSound::ProcessSound(void)
 						balance-=YM2612::WAVE_SAMPLING_RATE;
 					}
 				}
+				mixer.Accumulate16(TownsSoundMixer::SOURCE_WAVE_INPUT,wave);
 				wavGenerated=true;
 			}
 			if(true==wavGenerated)
@@ -456,16 +480,29 @@ void TownsSound::ProcessSound(void)
 		}
 	}
 
-	if(true!=outside_world->FMPCMChannelPlaying() && true!=nextFMPCMWave.empty())
+	if(true!=outside_world->FMPCMChannelPlaying() && true!=nextFMPCMWave.empty() && true==TakeFMSegment())
 	{
 		// Hopefully FMPCM channel finishes play back previous wave piece before nextFMPCMWaveGenTime.
+		if(mixer.GetNumSamples()*4==nextFMPCMWave.size())
+		{
+			mixer.Mix(nextFMPCMWave.data());
+		}
+		else
+		{
+			memset(nextFMPCMWave.data(),0,nextFMPCMWave.size());
+		}
 		if(true==recordFMandPCM)
 		{
 			FMPCMrecording.insert(FMPCMrecording.end(),nextFMPCMWave.begin(),nextFMPCMWave.end());
 		}
 		outside_world->FMPCMPlay(nextFMPCMWave);
+		CountUnderrun();
 		nextFMPCMWave.clear(); // It was supposed to be cleared in FMPlay.  Just in case.
-		state.ym2612.CheckToneDoneAllChannels();
+		if(true!=FMThread.IsRunning())
+		{
+			// Worker checks tone-done after each segment, and the VM copies playingCh from the segment.
+			state.ym2612.CheckToneDoneAllChannels();
+		}
 	}
 
 	if (townsPtr->timer.IsBuzzerPlaying()) {
@@ -476,8 +513,60 @@ void TownsSound::ProcessSound(void)
 	}
 }
 
+bool TownsSound::TakeFMSegment(void)
+{
+	if(true!=FMSegmentRequested)
+	{
+		return true;
+	}
+
+	FMSynthesisThread::Segment seg;
+	bool segReady=FMThread.TryGetSegment(seg);
+	if(true!=segReady)
+	{
+		// If the host is still playing the previous piece, keep running the VM and try again next time
+		// rather than waiting for the worker.
+		auto sincePlay=std::chrono::high_resolution_clock::now()-var.lastFMPCMPlayTime;
+		if(true==var.FMPCMPlayedOnce && sincePlay<std::chrono::milliseconds(FM_PCM_MILLISEC_PER_WAVE))
+		{
+			return false;
+		}
+		segReady=FMThread.WaitSegment(seg);
+	}
+	if(true==segReady)
+	{
+		if(mixer.GetNumSamples()*4<=seg.wave.size())
+		{
+			mixer.Accumulate16(TownsSoundMixer::SOURCE_FM,seg.wave.data());
+		}
+		state.ym2612.state.playingCh=seg.playingCh;
+	}
+	FMSegmentRequested=false;
+	return true;
+}
+
+void TownsSound::CountUnderrun(void)
+{
+	auto now=std::chrono::high_resolution_clock::now();
+	if(true==var.FMPCMPlayedOnce)
+	{
+		auto passed=std::chrono::duration_cast<std::chrono::milliseconds>(now-var.lastFMPCMPlayTime).count();
+		// A long gap counts every piece that should have been played in between.
+		if(FM_PCM_MILLISEC_PER_WAVE+UNDERRUN_TOLERANCE_MILLISEC<passed)
+		{
+			auto missed=passed/FM_PCM_MILLISEC_PER_WAVE-1;
+			var.numUnderruns+=(0<missed ? missed : 1);
+		}
+	}
+	var.lastFMPCMPlayTime=now;
+	var.FMPCMPlayedOnce=true;
+}
+
 void TownsSound::ProcessSilence(void)
 {
+	// Paused.  The gap until the next piece after resuming is not an underrun.
+	var.FMPCMPlayedOnce=false;
+
 	std::vector <unsigned char> silence;
 	if(true!=outside_world->FMPCMChannelPlaying())
 	{
@@ -497,6 +586,38 @@ void TownsSound::ProcessSilence(void)
 	}
 }
 
+void TownsSound::EnableFMSynthesisThread(bool enable)
+{
+	if(true==enable)
+	{
+		FMThread.Start(state.ym2612);
+	}
+	else if(true==FMThread.IsRunning())
+	{
+		FMThread.CopyWaveGenerationState(state.ym2612);
+		FMThread.Stop();
+	}
+	FMSegmentRequested=false;
+	FMThreadNeedsSync=false;
+}
+
+bool TownsSound::SetMixerGain(std::string source,int gain)
+{
+	cpputil::Capitalize(source);
+	if("MASTER"==source)
+	{
+		mixer.SetMasterGain(gain);
+		return true;
+	}
+	auto sourceIdx=TownsSoundMixer::StrToSource(source);
+	if(TownsSoundMixer::NUM_SOURCES<=sourceIdx)
+	{
+		return false;
+	}
+	mixer.SetGain(sourceIdx,gain);
+	return true;
+}
+
 bool TownsSound::LoadWav(std::string fName)
 {
 	if(YSOK==var.waveToBeSentToVM.LoadWav(fName.c_str()))
@@ -566,6 +687,12 @@ void TownsSound::SerializeYM2612(std::vector <unsigned char> &data) const
 {
 	auto ym2612=state.ym2612;  // Make a copy to flush register schedule.
 
+	if(true==FMThread.IsRunning())
+	{
+		// VM-side YM2612 does not generate waves while the FM synthesis thread is running.
+		// Envelope and phase are in the worker.
+		FMThread.CopyWaveGenerationState(ym2612);
+	}
 	ym2612.FlushRegisterSchedule();
 
 	PushBool(data,ym2612.state.LFO);
@@ -828,5 +955,6 @@ void TownsSound::DeserializeRF5C68(const unsigned char *&data)
 	DeserializeYM2612(data,version);
 	DeserializeRF5C68(data);
 	var.nextPCMSampleReadyTime=0;
+	FMThreadNeedsSync=true;
 	return true;
 }
@@ -18,17 +18,26 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 #include <vector>
 #include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <deque>
 
 #include "vgmrecorder.h"
 
 #include "device.h"
 #include "townsdef.h"
 #include "cpputil.h"
+#include "spscringbuffer.h"
 #include "ym2612.h"
 #include "rf5c68.h"
 #include "yssimplesound.h"
 #include "outside_world.h"
 #include "cdrom.h"
+#include "mixer.h"
 
 class TownsSound : public Device
 {
@@ -47,6 +56,8 @@ public:
 		WAVE_STREAMING_SAFETY_BUFFER=10,
 #endif
 
+		UNDERRUN_TOLERANCE_MILLISEC=5,
+
 		RINGBUFFER_CLEAR_TIME=2000000000,  // Run 2 seconds after last wave generation to clear the ring buffer.  1 second should be enough, but just to be absolutely sure.
 	};
 
@@ -78,10 +89,129 @@ public:
 		VGMRecorder vgmRecorder;
 
 		bool maximumDoubleBuffering=false;
+
+		/*! Counted when the FM/PCM piece is handed to the host later than UNDERRUN_TOLERANCE_MILLISEC after the previous piece ended.
+		    The pacer uses it for shortening the time slice.
+		*/
+		uint64_t numUnderruns=0;
+		std::chrono::time_point<std::chrono::high_resolution_clock> lastFMPCMPlayTime;
+		bool FMPCMPlayedOnce=false;
+	};
+
+	/*! FM synthesis worker thread.
+	    The VM thread only forwards YM2612 register writes with townsTime and render requests through a lock-free queue.
+	    The worker owns its own copy of YM2612, and renders the FM wave segment while the previous segment is played back.
+	    The VM thread mixes the segment with PCM, high-res PCM, and CDDA when the segment is sent to Outside_World::Sound.
+	    RF5C68 is still stepped on the VM thread, since PCM IRQ timing must be deterministic.
+	*/
+	class FMSynthesisThread
+	{
+	public:
+		enum
+		{
+			CMD_REGISTER_WRITE,
+			CMD_RENDER,
+			CMD_QUIT,
+		};
+		enum
+		{
+			COMMAND_QUEUE_SIZE=32768,
+			SEGMENT_QUEUE_SIZE=8,
+		};
+		class Command
+		{
+		public:
+			uint8_t cmd=CMD_REGISTER_WRITE;
+			uint8_t chBase=0,reg=0,data=0;
+			uint32_t numSamples=0;
+			int32_t volume=0;
+			uint32_t channelMute=0;
+			uint64_t townsTime=0;
+		};
+		class Segment
+		{
+		public:
+			std::vector <unsigned char> wave;
+			unsigned int playingCh=0;
+		};
+
+	private:
+		// Accessed only from the worker thread while running, or while the worker is idle.
+		// YM2612 is copy-constructible, but not assignable.  Re-created on every sync.
+		std::unique_ptr <YM2612> ym2612;
+		cpputil::SPSCRingBuffer <Command> cmdQueue;
+		mutable cpputil::SPSCRingBuffer <Segment> segmentQueue;  // Popped also by const WaitIdle.
+
+		// Segments taken out of segmentQueue by WaitIdle so that the worker never waits for a full queue
+		// while the VM thread waits for the worker.  Accessed only from the VM thread.
+		mutable std::deque <Segment> drainedSegments;
+
+		mutable std::mutex mutex;
+		mutable std::condition_variable cond;
+		std::thread thr;
+		bool running=false;
+		bool busy=false;  // Protected by mutex.
+		std::atomic <bool> quitting{false};
+		std::atomic <unsigned int> numRenderPending{0};
+
+	public:
+		FMSynthesisThread();
+		~FMSynthesisThread();
+
+		/*! Starts the worker with a copy of the VM's YM2612.
+		*/
+		void Start(const YM2612 &vmYM2612);
+		void Stop(void);
+		inline bool IsRunning(void) const
+		{
+			return running;
+		}
+
+		/*! Waits until the worker consumes all commands, drops rendered segments, and replaces the worker's YM2612 with the VM's YM2612.
+		    Called after reset or state load.
+		*/
+		void Sync(const YM2612 &vmYM2612);
+
+		/*! Waits until the worker consumes all commands, and copies wave-generation state of the worker's YM2612
+		    (channels and playing-channel flags) to ym2612.
+		*/
+		void CopyWaveGenerationState(YM2612 &ym2612) const;
+
+		/*! Called from the VM thread.
+		*/
+		void SendRegisterWrite(unsigned int chBase,unsigned int reg,unsigned int data,uint64_t townsTime);
+
+		/*! Called from the VM thread.  Worker renders numSamples samples starting at lastWaveGenTime.
+		*/
+		void RequestRender(unsigned int numSamples,uint64_t lastWaveGenTime,int volume,const bool channelMute[YM2612::NUM_CHANNELS]);
+
+		/*! Called from the VM thread.  Returns false if no render is pending.
+		    Otherwise, blocks until the oldest requested segment is ready.
+		*/
+		bool WaitSegment(Segment &seg);
+
+		/*! Called from the VM thread.  Takes the oldest requested segment if it is already rendered.
+		    Returns false without waiting if no segment is ready.
+		    The worker renders each request as soon as it arrives, up to SEGMENT_QUEUE_SIZE segments ahead of the VM.
+		*/
+		bool TryGetSegment(Segment &seg);
+
+	private:
+		void PushCommand(const Command &cmd);
+		bool PopSegment(Segment &seg) const;
+
+		/*! Waits until the worker consumes all commands.
+		    Rendered segments are moved to drainedSegments while waiting so that the worker never blocks on a full segment queue.
+		*/
+		void WaitIdle(void) const;
+		void ThreadFunc(void);
 	};
 
 	State state;
 	Variable var;
+	FMSynthesisThread FMThread;
+	bool FMThreadNeedsSync=false;
+	bool FMSegmentRequested=false;
 	class Outside_World::Sound *outside_world=nullptr;
 	class TownsCDROM *cdrom=nullptr;
 
@@ -92,6 +222,7 @@ public:
 
 	uint64_t lastFMPCMWaveGenTime=0;
 	std::vector <unsigned char> nextFMPCMWave;
+	TownsSoundMixer mixer;
 
 	inline bool IsFMPlaying(void) const
 	{
@@ -130,11 +261,28 @@ public:
 	/*! Call this function periodically to continue sound playback.
 	*/
 	void ProcessSound(void);
+private:
+	/*! Mixes the FM segment rendered by the worker, if requested.
+	    Returns false if the segment is not ready yet and the host still has the previous piece to play.
+	    Then the piece is played in the next ProcessSound instead of waiting for the worker.
+	*/
+	bool TakeFMSegment(void);
+	void CountUnderrun(void);
+public:
 
 	/*! Call this function periodically while VM is paused.
 	*/
 	void ProcessSilence(void);
 
+	/*! Moves FM synthesis to the worker thread, or brings it back to the VM thread.
+	*/
+	void EnableFMSynthesisThread(bool enable);
+
+	/*! Sets the mixer gain of the source (FM, PCM, HIRES, CDDA, WAVIN), or the master gain if source is MASTER.
+	    TownsSoundMixer::UNITY_GAIN is 1.0.  Returns false if the source is unknown.
+	*/
+	bool SetMixerGain(std::string source,int gain);
+
 	/*! Loads .WAV file to be sent to PCM sampling register.
 	*/
 	bool LoadWav(std::string wav);
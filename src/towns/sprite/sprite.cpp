@@ -12,6 +12,9 @@ Redistribution and use in source and binary forms, with or without modification,
 THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 << LICENSE */
+#include <cstring>
+#include <algorithm>
+
 #include "towns.h"
 #include "townsdef.h"
 #include "cpputil.h"
@@ -41,6 +44,7 @@ TownsSprite::TownsSprite(class FMTownsCommon *townsPtr,TownsPhysicalMemory *phys
 {
 	this->townsPtr=townsPtr;
 	this->physMemPtr=physMemPtr;
+	InvalidateSpritePageRows();
 }
 
 unsigned int TownsSprite::NumSpritesActuallyDrawn(void) const
@@ -87,11 +91,15 @@ unsigned int TownsSprite::NumSpritesActuallyDrawn(void) const
 
 /* virtual */ void TownsSprite::PowerOn(void)
 {
+	WaitRender();
 	state.PowerOn();
+	InvalidateSpritePageRows();
 }
 /* virtual */ void TownsSprite::Reset(void)
 {
+	WaitRender();
 	state.Reset();
+	InvalidateSpritePageRows();
 }
 /* virtual */ void TownsSprite::IOWriteByte(unsigned int ioport,unsigned int data)
 {
@@ -125,8 +133,7 @@ unsigned int TownsSprite::NumSpritesActuallyDrawn(void) const
 				// If it happens, sprite needs to be immediately rendered, or will never be rendered.
 				if(true==prevSPEN && true!=SPEN() && true==prevBUSY)
 				{
-					Render(physMemPtr->state.VRAM + 0x40000,
-						physMemPtr->state.spriteRAM);
+					RenderToPhysicalMemory();
 				}
 				// For Shadow of the Beasts <<
 			}
@@ -173,20 +180,208 @@ unsigned int TownsSprite::NumSpritesActuallyDrawn(void) const
 	return data;
 }
 
-void TownsSprite::Render(unsigned char VRAMIn[],const unsigned char spriteRAM[]) const
+/*! Clips a span of a sprite on the 512x512 wrap-around sprite coordinate.
+    Visible range is lowLimit<=v<256.  Since a sprite is much smaller than the gap between 256 and 512,
+    the visible part of the span is always contiguous.
+*/
+static inline bool ClipSpriteSpan(int &dMin,int &dMax,unsigned int start,int len,unsigned int lowLimit)
+{
+	dMin=len;
+	dMax=-1;
+	for(int d=0; d<len; ++d)
+	{
+		unsigned int v=(start+d)&0x1ff;
+		if(lowLimit<=v && v<256)
+		{
+			dMin=std::min(dMin,d);
+			dMax=d;
+		}
+	}
+	return dMin<=dMax;
+}
+
+/* static */ bool TownsSprite::MakeSpriteRasterInfo(SpriteRasterInfo &info,unsigned int dstX,unsigned int dstY,unsigned int attrib)
 {
-	unsigned char *VRAMTop=VRAMIn + SPRITE_HALF_VRAM_SIZE * PAGE();
+	const unsigned int rot=((attrib&ATTR_ROT_MASK)>>ATTR_ROT_SHIFT);
+	const unsigned int sux=(0!=(attrib&ATTR_SUX) ? 1 : 0);
+	const unsigned int suy=(0!=(attrib&ATTR_SUY) ? 1 : 0);
+
+	if(true!=ClipSpriteSpan(info.dxMin,info.dxMax,dstX,SPRITE_DIMENSION>>sux,0) ||
+	   true!=ClipSpriteSpan(info.dyMin,info.dyMax,dstY,SPRITE_DIMENSION>>suy,2))
+	{
+		return false;
+	}
+	info.sx0=(dstX+info.dxMin)&0x1ff;
+	info.sy0=(dstY+info.dyMin)&0x1ff;
+
+	// Inverse of the rotation.  Un-shrunk destination (tx,ty) to pattern (px,py).
+	//   px=pxConst+pxPerTx*tx+pxPerTy*ty
+	//   py=pyConst+pyPerTx*tx+pyPerTy*ty
+	static const int inverseRot[8][6]=
+	{
+		// pxConst,pxPerTx,pxPerTy, pyConst,pyPerTx,pyPerTy
+		{ 0, 1, 0,   0, 0, 1},  // dx=px     dy=py
+		{ 0, 1, 0,  15, 0,-1},  // dx=px     dy=15-py
+		{15,-1, 0,   0, 0, 1},  // dx=15-px  dy=py
+		{15,-1, 0,  15, 0,-1},  // dx=15-px  dy=15-py
+		{ 0, 0, 1,   0, 1, 0},  // dx=py     dy=px
+		{15, 0,-1,   0, 1, 0},  // dx=py     dy=15-px
+		{ 0, 0, 1,  15,-1, 0},  // dx=15-py  dy=px
+		{15, 0,-1,  15,-1, 0},  // dx=15-py  dy=15-px
+	};
+	const int *inv=inverseRot[rot];
+
+	info.rotated=(4<=rot);
+	info.pxPerDx=inv[1]*(1<<sux);
+	info.pxPerDy=inv[2]*(1<<suy);
+	info.pyPerDx=inv[4]*(1<<sux);
+	info.pyPerDy=inv[5]*(1<<suy);
+
+	// If shrunk, a destination pixel takes the last non-transparent pattern pixel in the drawing order,
+	// which is row by row, left to right.  Sub-samples are sorted in that order.
+	info.numSubSamples=0;
+	for(unsigned int j=0; j<=suy; ++j)
+	{
+		for(unsigned int i=0; i<=sux; ++i)
+		{
+			int px=inv[0]+inv[1]*i+inv[2]*j;
+			int py=inv[3]+inv[4]*i+inv[5]*j;
+			unsigned int k=info.numSubSamples++;
+			while(0<k && (py<info.subSamplePy0[k-1] || (py==info.subSamplePy0[k-1] && px<info.subSamplePx0[k-1])))
+			{
+				info.subSamplePx0[k]=info.subSamplePx0[k-1];
+				info.subSamplePy0[k]=info.subSamplePy0[k-1];
+				--k;
+			}
+			info.subSamplePx0[k]=px;
+			info.subSamplePy0[k]=py;
+		}
+	}
+	return true;
+}
 
+// Transparent pixels are resolved by masking instead of branching.  Opaque and transparent pixels
+// are mixed unpredictably, and branch mis-predictions used to be the major cost of sprite drawing.
+template <bool ROTATED>
+/* static */ void TownsSprite::Draw16ColorRow(unsigned char *dst,int n,const unsigned char ptnPtr[],const uint16_t palette[SPRITE_PALETTE_NUM_COLORS],int px,int py,int pxStep,int pyStep)
+{
+	if(true!=ROTATED)
+	{
+		// Row of the pattern.
+		auto src=ptnPtr+SPRITE_PTN16_BYTES_PER_LINE*py;
+		for(; 0<n; --n,dst+=2,px+=pxStep)
+		{
+			auto pix4bit=(src[px>>1]>>((px&1)<<2))&0x0f;
+			unsigned int mask=0-(unsigned int)(0!=pix4bit);  // [2] pp.371 Sprite BIOS.  4bit all zero means through.
+			cpputil::PutWord(dst,(unsigned short)((cpputil::GetWord(dst)&~mask)|(palette[pix4bit]&mask)));
+		}
+	}
+	else
+	{
+		// Column of the pattern.
+		auto src=ptnPtr+(px>>1);
+		const unsigned int shift=((px&1)<<2);
+		int offset=SPRITE_PTN16_BYTES_PER_LINE*py;
+		const int stride=SPRITE_PTN16_BYTES_PER_LINE*pyStep;
+		for(; 0<n; --n,dst+=2,offset+=stride)
+		{
+			auto pix4bit=(src[offset]>>shift)&0x0f;
+			unsigned int mask=0-(unsigned int)(0!=pix4bit);
+			cpputil::PutWord(dst,(unsigned short)((cpputil::GetWord(dst)&~mask)|(palette[pix4bit]&mask)));
+		}
+	}
+}
+
+template <bool ROTATED>
+/* static */ void TownsSprite::Draw32KColorRow(unsigned char *dst,int n,const unsigned char ptnPtr[],uint16_t spys,int px,int py,int pxStep,int pyStep)
+{
+	int offset=SPRITE_PTN32K_BYTES_PER_LINE*py+2*px;
+	const int stride=(true!=ROTATED ? 2*pxStep : SPRITE_PTN32K_BYTES_PER_LINE*pyStep);
+	for(; 0<n; --n,dst+=2,offset+=stride)
+	{
+		unsigned int col=cpputil::GetWord(ptnPtr+offset);
+		unsigned int mask=0-(unsigned int)(0==(col&0x8000));
+		cpputil::PutWord(dst,(unsigned short)((cpputil::GetWord(dst)&~mask)|((col|spys)&mask)));
+	}
+}
+
+void TownsSprite::InvalidateSpritePageRows(void)
+{
+	WaitRender();
+	for(auto &page : rowTouched)
+	{
+		for(auto &t : page)
+		{
+			t=true;
+		}
+	}
+}
+
+void TownsSprite::ClearSpritePage(unsigned char VRAMTop[],unsigned int page)
+{
 	// [2] pp.368 (Sprite BIOS AH=00H) tells, the top 2-lines of the VRAM page are VRAM-clear data.
 	//     So, apparently it is possible to clear the sprite page with non-0x8000 values.
-	for(unsigned int offset=SPRITE_VRAM_BYTES_PER_LINE*2; offset<0x20000; offset+=2)
+	// Rows that no sprite touched are most likely clear already.  Comparing is cheaper than writing,
+	// and still catches the rows that the CPU wrote directly or the clear data changed.
+	for(unsigned int y=SPRITE_VRAM_CLEAR_PATTERN_LINES; y<SPRITE_VRAM_NUM_LINES; ++y)
 	{
-		VRAMTop[offset  ]=VRAMTop[ offset   &(SPRITE_VRAM_BYTES_PER_LINE*2-1)];
-		VRAMTop[offset+1]=VRAMTop[(offset+1)&(SPRITE_VRAM_BYTES_PER_LINE*2-1)];
+		auto row=VRAMTop+SPRITE_VRAM_BYTES_PER_LINE*y;
+		auto clearData=VRAMTop+SPRITE_VRAM_BYTES_PER_LINE*(y&1);
+		if(true==rowTouched[page][y] || 0!=memcmp(row,clearData,SPRITE_VRAM_BYTES_PER_LINE))
+		{
+			memcpy(row,clearData,SPRITE_VRAM_BYTES_PER_LINE);
+		}
+		rowTouched[page][y]=false;
 	}
+}
 
-	auto xOffset=HOffset(),yOffset=VOffset();
-	for(unsigned int spriteIndex=state.firstSpriteIndexCapture; spriteIndex<MAX_NUM_SPRITE_INDEX; ++spriteIndex)
+void TownsSprite::Render(unsigned char VRAMIn[],const unsigned char spriteRAM[])
+{
+	WaitRender();
+	RenderPage(VRAMIn,spriteRAM,PAGE(),state.firstSpriteIndexCapture,HOffset(),VOffset());
+}
+
+void TownsSprite::RenderToPhysicalMemory(void)
+{
+	auto &deviceThread=townsPtr->deviceThread;
+	unsigned char *VRAMIn=physMemPtr->state.VRAM+0x40000;
+	if(true!=deviceThread.IsRunning())
+	{
+		Render(VRAMIn,physMemPtr->state.spriteRAM);
+		return;
+	}
+
+	// Previous job may still be reading the snapshot.
+	WaitRender();
+	spriteRAMSnapshot.resize(TOWNS_SPRITERAM_SIZE);
+	memcpy(spriteRAMSnapshot.data(),physMemPtr->state.spriteRAM,TOWNS_SPRITERAM_SIZE);
+
+	const unsigned int page=PAGE(),firstSpriteIndex=state.firstSpriteIndexCapture;
+	const unsigned int xOffset=HOffset(),yOffset=VOffset();
+	renderTicket=deviceThread.Push([this,VRAMIn,page,firstSpriteIndex,xOffset,yOffset]
+	{
+		RenderPage(VRAMIn,spriteRAMSnapshot.data(),page,firstSpriteIndex,xOffset,yOffset);
+	});
+	physMemPtr->FenceSpritePage(renderTicket,page);
+}
+
+void TownsSprite::WaitRender(void)
+{
+	if(0!=renderTicket)
+	{
+		townsPtr->deviceThread.Wait(renderTicket);
+		renderTicket=0;
+	}
+}
+
+void TownsSprite::RenderPage(unsigned char VRAMIn[],const unsigned char spriteRAM[],unsigned int page,unsigned int firstSpriteIndex,unsigned int xOffset,unsigned int yOffset)
+{
+	unsigned char *VRAMTop=VRAMIn + SPRITE_HALF_VRAM_SIZE * page;
+	auto *touched=rowTouched[page];
+
+	ClearSpritePage(VRAMTop,page);
+
+	for(unsigned int spriteIndex=firstSpriteIndex; spriteIndex<MAX_NUM_SPRITE_INDEX; ++spriteIndex)
 	{
 		auto indexPtr=spriteRAM+SPRITERAM_INDEX_OFFSET+(spriteIndex<<3);
 
@@ -213,109 +408,62 @@ void TownsSprite::Render(unsigned char VRAMIn[],const unsigned char spriteRAM[])
 			dstX+=xOffset;
 			dstY+=yOffset;
 		}
-		unsigned int patternIndex=attrib&ATTR_PAT_MASK;
 
-		const unsigned char rot = ((attrib & ATTR_ROT_MASK) >> ATTR_ROT_SHIFT);
-		const bool sux = (0 != (attrib & ATTR_SUX));
-		const bool suy = (0 != (attrib & ATTR_SUY));
-
-		uint8_t spys = (paletteInfo & PALETTE_SPYS) ? 0x80 : 0;
-
-		// pattern coordinate to drawing coordiante
-		auto transform = [rot, sux, suy](int& dx, int& dy, int px, int py)
+		SpriteRasterInfo info;
+		if(true!=MakeSpriteRasterInfo(info,dstX,dstY,attrib))
 		{
-			switch (rot)
-			{
-			default:
-			case 0:
-				// No transformation
-				dx = px;
-				dy = py;
-				break;
-			case 1:
-				dx = px;
-				dy = 15 - py;
-				break;
-			case 2:
-				dx = 15 - px;
-				dy = py;
-				break;
-			case 3:
-				dx = 15 - px;
-				dy = 15 - py;
-				break;
-			case 4:
-				dx = py;
-				dy = px;
-				break;
-			case 5:
-				dx = py;
-				dy = 15 - px;
-				break;
-			case 6:
-				dx = 15 - py;
-				dy = px;
-				break;
-			case 7:
-				dx = 15 - py;
-				dy = 15 - px;
-				break;
-			}
-			if (sux) dx >>= 1;
-			if (suy) dy >>= 1;
-		};
+			continue;
+		}
 
-		if (0 != (paletteInfo & PALETTE_CTEN))
+		unsigned int patternIndex=attrib&ATTR_PAT_MASK;
+		const uint16_t spys=(paletteInfo&PALETTE_SPYS) ? 0x8000 : 0;
+		const bool CTEN=(0!=(paletteInfo&PALETTE_CTEN));
+		uint16_t palette[SPRITE_PALETTE_NUM_COLORS];
+		if(true==CTEN)
 		{
 			// 16-color paletted sprite
-			const unsigned int paletteIndex = paletteInfo & PALETTE_INDEX_MASK;
-			auto palettePtr = spriteRAM + (paletteIndex << 5);
-			auto srcPtr = spriteRAM + (patternIndex << 7);
-
-			for (int patY = 0; patY < SPRITE_DIMENSION; ++patY) {
-				for (int patX = 0; patX < SPRITE_DIMENSION; ++patX) {
-					int dx, dy;
-					transform(dx, dy, patX, patY);
-
-					unsigned int sx = (dstX + dx) & 0x1ff;
-					unsigned int sy = (dstY + dy) & 0x1ff;
-
-					if (sx < 256 && 2 <= sy && sy < 256) {
-						auto src = srcPtr + SPRITE_PTN16_BYTES_PER_LINE * patY + (patX >> 1);
-						auto dst = VRAMTop + SPRITE_VRAM_BYTES_PER_LINE * sy + 2 * sx;
-
-						auto pix4bit = (src[0] >> ((patX & 1) ? 4 : 0)) & 0x0f;
-						if (pix4bit) {  // [2] pp.371 Sprite BIOS.  4bit all zero means through.
-							auto col = palettePtr + (pix4bit << 1);
-							dst[0] = col[0];
-							dst[1] = (col[1] & 0x7f) | spys;
-						}
-					}
-				}
+			auto palettePtr=spriteRAM+((paletteInfo&PALETTE_INDEX_MASK)<<5);
+			for(unsigned int i=0; i<SPRITE_PALETTE_NUM_COLORS; ++i)
+			{
+				palette[i]=(cpputil::GetWord(palettePtr+i*2)&0x7fff)|spys;
 			}
 		}
 		else
 		{
 			// 32768-color sprite
-			patternIndex &= (~3);
-			auto srcPtr = spriteRAM + (patternIndex << 7);
-
-			for (int patY = 0; patY < SPRITE_DIMENSION; ++patY) {
-				for (int patX = 0; patX < SPRITE_DIMENSION; ++patX) {
-					int dx, dy;
-					transform(dx, dy, patX, patY);
-
-					unsigned int sx = (dstX + dx) & 0x1ff;
-					unsigned int sy = (dstY + dy) & 0x1ff;
-
-					if (sx < 256 && 2 <= sy && sy < 256) {
-						auto src = srcPtr + SPRITE_PTN32K_BYTES_PER_LINE * patY + 2 * patX;
-						auto dst = VRAMTop + SPRITE_VRAM_BYTES_PER_LINE * sy + 2 * sx;
+			patternIndex&=(~3);
+		}
+		const unsigned char *ptnPtr=spriteRAM+(patternIndex<<7);
 
-						if ((src[1] & 0x80) == 0) {
-							dst[0] = src[0];
-							dst[1] = src[1] | spys;
-						}
+		const int n=info.dxMax-info.dxMin+1;
+		auto dstRow=VRAMTop+SPRITE_VRAM_BYTES_PER_LINE*info.sy0+2*info.sx0;
+		for(int dy=info.dyMin; dy<=info.dyMax; ++dy,dstRow+=SPRITE_VRAM_BYTES_PER_LINE)
+		{
+			touched[info.sy0+dy-info.dyMin]=true;
+			for(unsigned int k=0; k<info.numSubSamples; ++k)
+			{
+				const int px=info.subSamplePx0[k]+info.pxPerDx*info.dxMin+info.pxPerDy*dy;
+				const int py=info.subSamplePy0[k]+info.pyPerDx*info.dxMin+info.pyPerDy*dy;
+				if(true==CTEN)
+				{
+					if(true!=info.rotated)
+					{
+						Draw16ColorRow<false>(dstRow,n,ptnPtr,palette,px,py,info.pxPerDx,info.pyPerDx);
+					}
+					else
+					{
+						Draw16ColorRow<true>(dstRow,n,ptnPtr,palette,px,py,info.pxPerDx,info.pyPerDx);
+					}
+				}
+				else
+				{
+					if(true!=info.rotated)
+					{
+						Draw32KColorRow<false>(dstRow,n,ptnPtr,spys,px,py,info.pxPerDx,info.pyPerDx);
+					}
+					else
+					{
+						Draw32KColorRow<true>(dstRow,n,ptnPtr,spys,px,py,info.pxPerDx,info.pyPerDx);
 					}
 				}
 			}
@@ -348,8 +496,7 @@ void TownsSprite::RunScheduledTask(unsigned long long int townsTime)
 			// Pre-captured firstSpriteIndex is needed only if SPEN is cleared in the middle of
 			// sprite-busy cycle.
 
-			Render(physMemPtr->state.VRAM + 0x40000,
-				physMemPtr->state.spriteRAM);
+			RenderToPhysicalMemory();
 
 			auto nextVSync = townsPtr->crtc.NextVSYNCRisingEdge(townsTime);
 			townsPtr->ScheduleDeviceCallBack(*this, nextVSync);
@@ -597,6 +744,7 @@ std::vector <std::string> TownsSprite::GetPattern16BitText(unsigned int ptnIdx,c
 }
 /* virtual */ bool TownsSprite::SpecificDeserialize(const unsigned char *&data,std::string,uint32_t version)
 {
+	WaitRender();
 	state.transferTime=SPRITE_ONE_TRANSFER_TIME_FASTMODE;
 
 	state.addressLatch=ReadUint16(data);
@@ -635,5 +783,6 @@ std::vector <std::string> TownsSprite::GetPattern16BitText(unsigned int ptnIdx,c
 	{
 		state.firstSpriteIndexCapture=FirstSpriteIndex();
 	}
+	InvalidateSpritePageRows();
 	return true;
 }
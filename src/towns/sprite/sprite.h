@@ -2,6 +2,8 @@
 #define SPRITE_IS_INCLUDED
 /* { */
 
+#include <vector>
+#include <stdint.h>
 #include "device.h"
 class TownsSprite : public Device
 {
@@ -90,6 +92,51 @@ public:
 	State state;
 	class TownsPhysicalMemory *physMemPtr;
 
+	enum
+	{
+		SPRITE_VRAM_NUM_LINES=256,
+		SPRITE_VRAM_CLEAR_PATTERN_LINES=2,
+	};
+
+	/*! Rows of each sprite page written by the sprite engine since the page was cleared last time.
+	    Not part of the machine state.  Rows that are not flagged only need to be verified, not re-written,
+	    when the page is cleared for the next frame.
+	*/
+	bool rowTouched[2][SPRITE_VRAM_NUM_LINES];
+
+	/*! Device-thread job rendering the sprite page, and the copy of the sprite RAM the job reads.
+	    The CPU may re-write the sprite RAM for the next frame while the job is running.
+	*/
+	uint64_t renderTicket=0;
+	std::vector <unsigned char> spriteRAMSnapshot;
+
+	/*! Transformation and clipping of one sprite, calculated once per sprite before rasterization.
+	    Destination coordinate (dx,dy) is relative to the top-left corner of the sprite on the sprite page,
+	    and the pattern coordinate of (dx,dy) is
+	        px=px0+pxPerDx*dx+pxPerDy*dy
+	        py=py0+pyPerDx*dx+pyPerDy*dy
+	    One destination pixel may cover 2 or 4 pattern pixels if shrunk by SUX/SUY.
+	    Those are drawn as separate sub-samples in the order the hardware would overwrite them.
+	*/
+	class SpriteRasterInfo
+	{
+	public:
+		enum
+		{
+			MAX_NUM_SUBSAMPLES=4
+		};
+		int dxMin,dxMax,dyMin,dyMax; // Clipped range in the destination coordinate.  Inclusive.
+		unsigned int sx0,sy0;        // Sprite-page coordinate of (dxMin,dyMin).
+		int pxPerDx,pxPerDy,pyPerDx,pyPerDy;
+		unsigned int numSubSamples;
+		int subSamplePx0[MAX_NUM_SUBSAMPLES],subSamplePy0[MAX_NUM_SUBSAMPLES];
+		bool rotated;  // true if a destination row is a pattern column (ROT=4 to 7).
+	};
+
+	/*! Calculates transformation and clipping of one sprite.  Returns false if the sprite is entirely clipped.
+	*/
+	static bool MakeSpriteRasterInfo(SpriteRasterInfo &info,unsigned int dstX,unsigned int dstY,unsigned int attrib);
+
 	TownsSprite(class FMTownsCommon *townsPtr,class TownsPhysicalMemory *physMemPtr);
 
 	inline bool SPEN(void) const
@@ -133,7 +180,37 @@ public:
 
 	void RunScheduledTask(unsigned long long int townsTime);
 
-	void Render(unsigned char VRAM[],const unsigned char spriteRAM[]) const;
+	/*! Clears the sprite page and draws all sprites.
+	*/
+	void Render(unsigned char VRAM[],const unsigned char spriteRAM[]);
+
+	/*! Renders the sprite page in the physical memory.
+	    If the device thread is running, the rendering is pushed to the device thread,
+	    and the VRAM slots of the sprite page are fenced until the rendering is done.
+	*/
+	void RenderToPhysicalMemory(void);
+
+	/*! Waits for the rendering job on the device thread.
+	*/
+	void WaitRender(void);
+
+	/*! Forces all rows of both sprite pages to be re-written in the next clear.
+	*/
+	void InvalidateSpritePageRows(void);
+
+private:
+	void ClearSpritePage(unsigned char VRAMTop[],unsigned int page);
+
+	/*! Does not read the state, so that it can run on the device thread.
+	*/
+	void RenderPage(unsigned char VRAMIn[],const unsigned char spriteRAM[],unsigned int page,unsigned int firstSpriteIndex,unsigned int xOffset,unsigned int yOffset);
+
+	template <bool ROTATED>
+	static void Draw16ColorRow(unsigned char *dst,int n,const unsigned char ptnPtr[],const uint16_t palette[SPRITE_PALETTE_NUM_COLORS],int px,int py,int pxStep,int pyStep);
+	template <bool ROTATED>
+	static void Draw32KColorRow(unsigned char *dst,int n,const unsigned char ptnPtr[],uint16_t spys,int px,int py,int pxStep,int pyStep);
+
+public:
 
 	inline bool SPD0(void) const   // For CRTC I/O
 	{
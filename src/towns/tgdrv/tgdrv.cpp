@@ -13,6 +13,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 << LICENSE */
 #include <iostream>
+#include <algorithm>
 #include <cctype>
 #include "tgdrv.h"
 #include "towns.h"
@@ -30,14 +31,26 @@ void TownsTgDrv::State::Reset(void)
 TownsTgDrv::TownsTgDrv(class FMTownsCommon *townsPtr) : Device(townsPtr)
 {
 	this->townsPtr=townsPtr;
+	for(auto &c : hostDriveLetter)
+	{
+		c=0;
+	}
 }
 /* virtual */ void TownsTgDrv::PowerOn(void)
 {
 	state.PowerOn();
+	for(auto &c : hostDriveLetter)
+	{
+		c=0;
+	}
 }
 /* virtual */ void TownsTgDrv::Reset(void)
 {
 	state.Reset();
+	for(auto &c : hostDriveLetter)
+	{
+		c=0;
+	}
 }
 /* virtual */ void TownsTgDrv::IOWriteByte(unsigned int ioport,unsigned int data)
 {
@@ -246,22 +259,18 @@ bool TownsTgDrv::Int2F_1105_Chdir(void)
 
 		if(0==subPath.size() || "\\"==subPath || "/"==subPath)
 		{
-			for(int i=6; i<0x43; ++i)
-			{
-				StoreByte(CDSAddr+i,0);
-			}
+			unsigned char zero[0x43-6]={0};
+			StoreBlock(CDSAddr+6,sizeof(zero),zero);
 			townsPtr->CPU().SetCF(false);
 		}
 		else if(true==sharedDir[sharedDirIdx].SubPathIsDirectory(subPath) && subPath.size()<0x43-7)
 		{
+			unsigned char path[0x43-6]={0};
 			for(int i=0; i<subPath.size() && i+6<0x42; ++i)
 			{
-				StoreByte(CDSAddr+6+i,subPath[i]);
-			}
-			for(int i=subPath.size(); i+6<0x43; ++i)
-			{
-				StoreByte(CDSAddr+6+i,0);
+				path[i]=subPath[i];
 			}
+			StoreBlock(CDSAddr+6,sizeof(path),path);
 			townsPtr->CPU().SetCF(false);
 		}
 		else
@@ -347,11 +356,7 @@ bool TownsTgDrv::Int2F_1108_ReadFromRemoteFile(void)
 			sharedDir[sharedDirIdx].Seek(hostSFTIdx,position);
 
 			auto data=sharedDir[sharedDirIdx].sft[hostSFTIdx].Read(townsPtr->CPU().GetCX());
-			auto DTAAddr=GetDTAAddress();
-			for(auto d : data)
-			{
-				StoreByte(DTAAddr++,d);
-			}
+			StoreBlock(GetDTAAddress(),data.size(),data.data());
 			ReturnCX(data.size());
 
 			townsPtr->CPU().RedirectStoreDword(
@@ -395,10 +400,7 @@ bool TownsTgDrv::Int2F_1109_WriteToRemoteFile(void)
 				auto DMABuffer=GetDTAAddress();
 				std::vector <unsigned char> data;
 				data.resize(townsPtr->CPU().GetCX());
-				for(int i=0; i<townsPtr->CPU().GetCX(); ++i)
-				{
-					data[i]=FetchByte(DMABuffer+i);
-				}
+				FetchBlock(DMABuffer,data.size(),data.data());
 
 				auto position=FetchFilePositionFromSFT(townsPtr->CPU().state.ES(),townsPtr->CPU().state.DI());
 				sharedDir[sharedDirIdx].Seek(hostSFTIdx,position);
@@ -799,10 +801,7 @@ bool TownsTgDrv::Int2F_111B_FindFirst(void)
 		auto eleven=FilenameTo11Bytes(last);
 		std::cout << eleven << std::endl;
 
-		for(int i=0; i<11; ++i)
-		{
-			StoreByte(DTABuffer+1+i,eleven[i]);
-		}
+		StoreBlock(DTABuffer+1,11,(const unsigned char *)eleven.data());
 		StoreByte(DTABuffer+0x0C,(unsigned char)sAttr);
 		StoreWord(DTABuffer+0x0D,1);  // Entry Count? Always 1?
 		// townsPtr->mem.StoreWord(DTABuffer+0x0F,1);  // Cluster Number? Always 1?
@@ -890,10 +889,7 @@ bool TownsTgDrv::Int2F_111C_FindNext(void)
 	}
 
 	char templ11[11];
-	for(int i=0; i<11; ++i)
-	{
-		templ11[i]=FetchByte(DTABuffer+1+i);
-	}
+	FetchBlock(DTABuffer+1,11,(unsigned char *)templ11);
 	uint16_t sAttr=FetchByte(DTABuffer+0x0C);
 	sAttr&=(~TOWNS_DOS_DIRENT_ATTR_VOLLABEL);
 
@@ -1247,6 +1243,17 @@ int TownsTgDrv::DriveLetterToSharedDirIndex(char letter) const
 	}
 	return -1;
 }
+int TownsTgDrv::HostDriveLetterToSharedDirIndex(char letter) const
+{
+	for(int i=0; i<TOWNS_TGDRV_MAX_NUM_DRIVES; ++i)
+	{
+		if(letter==hostDriveLetter[i] && true==sharedDir[i].linked)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
 void TownsTgDrv::MakeVMSFT(const class i486DXCommon::SegmentRegister &seg,uint32_t offset,char driveLetter,int hostSFTIdx,FileSys::SystemFileTable &hostSFT)
 {
 	auto &cpu=townsPtr->CPU();
@@ -1297,10 +1304,7 @@ void TownsTgDrv::MakeDOSDirEnt(uint32_t DTABuffer,const FileSys::DirectoryEntry
 	{
 		fName11=FilenameTo11Bytes(dirent.fName);
 	}
-	for(int i=0; i<11; ++i)
-	{
-		StoreByte(DTABuffer+i,fName11[i]);
-	}
+	StoreBlock(DTABuffer,11,(const unsigned char *)fName11.data());
 	StoreByte(DTABuffer+0x0B,dirent.attr);
 	StoreByte(DTABuffer+0x0C,0);
 
@@ -1338,89 +1342,91 @@ unsigned int TownsTgDrv::FetchDeviceInfoFromSFT(const class i486DXCommon::Segmen
 		offset+0x05,
 		townsPtr->mem);
 }
-std::string TownsTgDrv::FetchCString(uint32_t physAddr) const
+std::string TownsTgDrv::FetchCString(uint32_t linearAddr) const
 {
 	std::string str;
-	for(;;)
-	{
-		auto c=FetchByte(physAddr++);
-		if(0==c)
-		{
-			break;
-		}
-		str.push_back(c);
-	}
+	townsPtr->CPU().ReadLinearCString(str,linearAddr,0xFFFFFFFF,townsPtr->mem);
 	return str;
 }
 std::string TownsTgDrv::FetchCString(const i486DXCommon::SegmentRegister &seg,uint32_t offset) const
 {
+	auto &cpu=townsPtr->CPU();
+	auto addressSize=cpu.state.CS().addressSize;
+	uint32_t offsetMask=(16==addressSize ? 0xFFFF : 0xFFFFFFFF);
+	auto type=seg.GetType();
+	bool expandDownData=(0x10==(type&0x18) && 0!=(type&0x04));
+
 	std::string str;
 	for(;;)
 	{
-		auto c=townsPtr->CPU().RedirectFetchByte(
-		    townsPtr->CPU().state.CS().addressSize,
-		    seg,
-		    offset++,
-			townsPtr->mem);
-		if(0==c)
+		offset&=offsetMask;
+		if(true==expandDownData || seg.limit<offset)
+		{
+			// Let the CPU apply the segment checks as it would for the instruction.
+			auto c=cpu.RedirectFetchByte(addressSize,seg,offset++,townsPtr->mem);
+			if(0==c)
+			{
+				break;
+			}
+			str.push_back(c);
+			continue;
+		}
+
+		// Bytes up to the segment limit or the 16-bit wrap-around are read without per-byte checks.
+		uint64_t len=std::min<uint64_t>((uint64_t)seg.limit-offset+1,(uint64_t)offsetMask-offset+1);
+		len=std::min<uint64_t>(len,0xFFFFFFFF);
+		auto sizeBefore=str.size();
+		auto exceptionBefore=cpu.state.exception;
+		if(true==cpu.ReadLinearCString(str,seg.baseLinearAddr+offset,(uint32_t)len,townsPtr->mem) ||
+		   (true!=exceptionBefore && true==cpu.state.exception))
 		{
 			break;
 		}
-		str.push_back(c);
+		offset+=(uint32_t)(str.size()-sizeBefore);
 	}
 	return str;
 }
 uint8_t TownsTgDrv::FetchByte(uint32_t linearAddr) const
 {
-	if(true==townsPtr->CPU().PagingEnabled())
-	{
-		auto physAddr=townsPtr->CPU().RedirectLinearAddressToPhysicalAddressRead(linearAddr,townsPtr->mem);
-		return townsPtr->mem.FetchByte(physAddr);
-	}
-	else
-	{
-		return townsPtr->mem.FetchByte(linearAddr);
-	}
+	uint8_t data=0;
+	FetchBlock(linearAddr,1,&data);
+	return data;
 }
 uint16_t TownsTgDrv::FetchWord(uint32_t linearAddr) const
 {
-	uint32_t data;
-	data=FetchByte(linearAddr+1);
-	data<<=8;
-	data|=FetchByte(linearAddr);
-	return data;
+	unsigned char data[2]={0,0};
+	FetchBlock(linearAddr,2,data);
+	return cpputil::GetWord(data);
 }
 uint32_t TownsTgDrv::FetchDword(uint32_t linearAddr) const
 {
-	uint32_t data;
-	data=FetchWord(linearAddr+2);
-	data<<=16;
-	data|=FetchWord(linearAddr);
-	return data;
+	unsigned char data[4]={0,0,0,0};
+	FetchBlock(linearAddr,4,data);
+	return cpputil::GetDword(data);
+}
+void TownsTgDrv::FetchBlock(uint32_t linearAddr,uint32_t len,unsigned char buf[]) const
+{
+	townsPtr->CPU().ReadLinearBlock(linearAddr,len,buf,townsPtr->mem);
+}
+void TownsTgDrv::StoreBlock(uint32_t linearAddr,uint32_t len,const unsigned char data[])
+{
+	townsPtr->CPU().WriteLinearBlock(linearAddr,len,data,townsPtr->mem);
 }
 void TownsTgDrv::StoreByte(uint32_t linearAddr,uint8_t data)
 {
-	if(true==townsPtr->CPU().PagingEnabled())
-	{
-		auto physAddr=townsPtr->CPU().RedirectLinearAddressToPhysicalAddressWrite(linearAddr,townsPtr->mem);
-		return townsPtr->mem.StoreByte(physAddr,data);
-	}
-	else
-	{
-		return townsPtr->mem.StoreByte(linearAddr,data);
-	}
+	StoreBlock(linearAddr,1,&data);
 }
 void TownsTgDrv::StoreWord(uint32_t linearAddr,uint16_t data)
 {
-	StoreByte(linearAddr  ,data&0xFF);
-	StoreByte(linearAddr+1,(data>>8)&0xFF);
+	unsigned char buf[2];
+	cpputil::PutWord(buf,data);
+	StoreBlock(linearAddr,2,buf);
 }
 void TownsTgDrv::StoreDword(uint32_t linearAddr,uint32_t data)
 {
-	StoreByte(linearAddr  ,data&0xFF);
-	StoreByte(linearAddr+1,(data>>8)&0xFF);
-	StoreByte(linearAddr+2,(data>>16)&0xFF);
-	StoreByte(linearAddr+3,(data>>24)&0xFF);
+	unsigned char buf[4];
+	cpputil::PutDword(buf,data);
+	StoreBlock(linearAddr,4,buf);
 }
 void TownsTgDrv::AddDPB(unsigned int lastDPBSEG,unsigned int lastDPBOFFSET,unsigned int newDPBSEG,unsigned int newDPBOFFSET)
 {
@@ -1621,6 +1627,7 @@ bool TownsTgDrv::Install(void)
 			    cpu.state.DS(),
 			    DRIVELETTER_BUFFER+I,
 			    letter);
+			hostDriveLetter[I]=letter;
 
 			char str[2]={letter,0};
 			std::cout << "Assign Drive " << str << std::endl;
@@ -1736,6 +1743,86 @@ bool TownsTgDrv::Install(void)
 	return false;
 }
 
+bool TownsTgDrv::HostReadFromHandle(std::vector <unsigned char> &data,unsigned int handle,unsigned int len,bool updateSFT)
+{
+	auto &mem=townsPtr->mem;
+	auto dosverMajor=townsPtr->state.DOSVER&0xFF;
+	if(0==dosverMajor || 0==townsPtr->state.DOSLOLSEG)
+	{
+		return false;
+	}
+
+	// DOS is in the conventional memory.  Read the structures by physical address as DUMP DOSINFO does.
+	const uint32_t DOSADDR=townsPtr->state.DOSLOLSEG*0x10;
+	uint32_t PSP;
+	unsigned int SFTLen;
+	if(dosverMajor<4)
+	{
+		PSP=mem.FetchWord(DOSADDR+0x2DE);
+		SFTLen=0x35;
+	}
+	else
+	{
+		PSP=mem.FetchWord(DOSADDR+0x330);
+		SFTLen=0x3B;
+	}
+	if(0==PSP || 0xFFFF==PSP || mem.FetchWord(PSP*0x10+TOWNS_DOS_PSP_FILE_TAB_SIZE)<=handle)
+	{
+		return false;
+	}
+
+	uint32_t JFTOfs=mem.FetchWord(PSP*0x10+TOWNS_DOS_PSP_FILE_TABLE_PTR);
+	uint32_t JFTSeg=mem.FetchWord(PSP*0x10+TOWNS_DOS_PSP_FILE_TABLE_PTR+2);
+	unsigned int SFTIdx=mem.FetchByte(JFTSeg*0x10+JFTOfs+handle);
+	if(0xFF==SFTIdx)
+	{
+		return false;
+	}
+
+	uint32_t ofs=mem.FetchWord(DOSADDR+TOWNS_DOS_SFT_PTR);
+	uint32_t seg=mem.FetchWord(DOSADDR+TOWNS_DOS_SFT_PTR+2);
+	for(int ctr=0; 0xFFFF!=ofs && ctr<256; ++ctr)
+	{
+		unsigned int nSF=mem.FetchWord(seg*0x10+ofs+4);
+		if(SFTIdx<nSF)
+		{
+			uint32_t sf=seg*0x10+ofs+6+SFTLen*SFTIdx;
+			unsigned int devInfo=mem.FetchWord(sf+0x05);
+			if(0==mem.FetchWord(sf) ||
+			   0==(devInfo&0x8000) ||
+			   TGDRV_ID!=mem.FetchDword(sf+0x07) ||
+			   1==(mem.FetchWord(sf+0x02)&3)) // Write only.  Let DOS return the error.
+			{
+				return false;
+			}
+
+			auto sharedDirIdx=HostDriveLetterToSharedDirIndex('A'+(devInfo&0x1F));
+			unsigned int hostSFTIdx=mem.FetchWord(sf+0x0B);
+			if(sharedDirIdx<0 ||
+			   FileSys::MAX_NUM_OPEN_FILE<=hostSFTIdx ||
+			   true!=sharedDir[sharedDirIdx].sft[hostSFTIdx].IsOpen())
+			{
+				return false;
+			}
+
+			sharedDir[sharedDirIdx].Seek(hostSFTIdx,mem.FetchDword(sf+0x15));
+			data=sharedDir[sharedDirIdx].sft[hostSFTIdx].Read(len);
+			if(true==updateSFT)
+			{
+				mem.StoreDword(sf+0x15,sharedDir[sharedDirIdx].sft[hostSFTIdx].GetFilePointer());
+			}
+			return true;
+		}
+		SFTIdx-=nSF;
+
+		auto nextOfs=mem.FetchWord(seg*0x10+ofs);
+		auto nextSeg=mem.FetchWord(seg*0x10+ofs+2);
+		ofs=nextOfs;
+		seg=nextSeg;
+	}
+	return false;
+}
+
 unsigned int TownsTgDrv::DriveLetterToDriveIndex(char drvLetter) const
 {
 	if('a'<=drvLetter && drvLetter<='z')
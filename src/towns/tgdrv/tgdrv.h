@@ -52,6 +52,12 @@ public:
 	bool useSlashSlash=false; // Keep it false for compatible ROM.
 	FileSys sharedDir[TOWNS_TGDRV_MAX_NUM_DRIVES];
 
+	/*! Copy of the drive-letter buffer at CS:0109H of the driver, made in Install.
+	    The host service of INT 21H runs outside of the driver, where CS:0109H cannot be used.
+	    0 means not assigned.
+	*/
+	char hostDriveLetter[TOWNS_TGDRV_MAX_NUM_DRIVES];
+
 	class State
 	{
 	public:
@@ -136,13 +142,14 @@ public:
 	int FullyQualifiedFileNameToSharedDirIndex(const std::string &fn) const;
 	char FullyQualifiedFileNameToDriveLetter(const std::string &fn) const;
 	int DriveLetterToSharedDirIndex(char letter) const;
+	int HostDriveLetterToSharedDirIndex(char letter) const;
 	void MakeDOSDirEnt(uint32_t DTABuffer,const FileSys::DirectoryEntry &dirent);
 	void MakeVMSFT(const class i486DXCommon::SegmentRegister &seg,uint32_t offset,char driveLetter,int hostSFTIdx,FileSys::SystemFileTable &hostSFT);
 	unsigned int FetchDriveCodeFromSFT(const class i486DXCommon::SegmentRegister &seg,uint32_t offset) const;
 	uint16_t FetchSFTReferenceCount(const class i486DXCommon::SegmentRegister &seg,uint32_t offset) const;
 	uint32_t FetchFilePositionFromSFT(const class i486DXCommon::SegmentRegister &seg,uint32_t offset) const;
 	unsigned int FetchDeviceInfoFromSFT(const class i486DXCommon::SegmentRegister &seg,uint32_t offset) const;
-	std::string FetchCString(uint32_t physAddr) const;
+	std::string FetchCString(uint32_t linearAddr) const;
 	std::string FetchCString(const class i486DXCommon::SegmentRegister &seg,uint32_t offset) const;
 
 	uint8_t FetchByte(uint32_t linearAddr) const;
@@ -152,6 +159,11 @@ public:
 	void StoreWord(uint32_t linearAddr,uint16_t data);
 	void StoreDword(uint32_t linearAddr,uint32_t data);
 
+	/*! Block copy between the VM memory and the host buffer.  See i486DXCommon::ReadLinearBlock.
+	*/
+	void FetchBlock(uint32_t linearAddr,uint32_t len,unsigned char buf[]) const;
+	void StoreBlock(uint32_t linearAddr,uint32_t len,const unsigned char data[]);
+
 	void AddDPB(unsigned int lastDPBSEG,unsigned int lastDPBOFFSET,unsigned int newDPBSEG,unsigned int newDPBOFFSET);
 	DOSDPB FetchDPB(unsigned int SEG,unsigned int OFFSET) const;
 	void StoreDPB(unsigned int SEG,unsigned int OFFSET,DOSDPB dpb);
@@ -159,6 +171,14 @@ public:
 
 	bool Install(void);
 
+	/*! Host service of INT 21H AH=3FH (read from file or device) for a file opened on a Tsugaru Drive.
+	    It follows the current PSP, job-file table, and the system-file table of DOS in the physical memory,
+	    and reads up to len bytes to data from the host file.  If updateSFT is true, the file pointer in
+	    the system-file table is advanced as Int2F_1108_ReadFromRemoteFile does.
+	    Returns false if the handle is not a readable Tsugaru Drive file, in which case DOS must take it.
+	*/
+	bool HostReadFromHandle(std::vector <unsigned char> &data,unsigned int handle,unsigned int len,bool updateSFT);
+
 	unsigned int DriveLetterToDriveIndex(char drvLetter) const;
 	char DriveIndexToDriveLetter(unsigned int driveIndex) const;
 	unsigned int GetCDSCount(void) const;
@@ -179,6 +179,10 @@ void FMTownsCommon::State::PowerOn(void)
 	{
 		if(true==towns.eventLog.LoadEventLog(argv.playbackEventLogFName))
 		{
+			if(true==argv.playbackEventLogInTownsTime)
+			{
+				towns.eventLog.ConvertToTownsTime();
+			}
 			towns.eventLog.BeginPlayback();
 		}
 	}
@@ -261,7 +265,39 @@ void FMTownsCommon::State::PowerOn(void)
 	{
 		towns.sound.state.rf5c68.state.volume=argv.pcmVol;
 	}
+	for(auto &srcGain : argv.mixerGain)
+	{
+		if(true!=towns.sound.SetMixerGain(srcGain.first,srcGain.second))
+		{
+			std::cout << "Unknown mixer source " << srcGain.first << std::endl;
+		}
+	}
 	towns.sound.var.maximumDoubleBuffering=argv.maximumSoundDoubleBuffering;
+	if(true==argv.FMSynthesisThread)
+	{
+		towns.sound.EnableFMSynthesisThread(true);
+	}
+	if(true==argv.deviceThread)
+	{
+		towns.EnableDeviceThread(true);
+	}
+	if(true==argv.verifyHostBlockOp)
+	{
+		towns.CPU().blockOpMode=i486DXCommon::BLOCKOP_VERIFY;
+	}
+	else if(true==argv.hostBlockOp)
+	{
+		towns.CPU().blockOpMode=i486DXCommon::BLOCKOP_ON;
+	}
+	if(true==argv.verifyHostService)
+	{
+		towns.var.hostServiceMode=FMTownsCommon::Variable::HOSTSVC_VERIFY;
+		towns.CPU().enableCallStack=true;
+	}
+	else if(true==argv.hostService)
+	{
+		towns.var.hostServiceMode=FMTownsCommon::Variable::HOSTSVC_ON;
+	}
 
 	if(true==argv.powerOffAtBreakPoint)
 	{
@@ -332,6 +368,7 @@ void FMTownsCommon::State::PowerOn(void)
 	}
 
 	towns.var.damperWireLine=argv.damperWireLine;
+	towns.crtc.rasterLog.enabled=argv.rasterLog;
 	towns.var.scanLineEffectIn15KHz=argv.scanLineEffectIn15KHz;
 	towns.var.forceQuitOnPowerOff=argv.forceQuitOnPowerOff;
 
@@ -364,6 +401,16 @@ void FMTownsCommon::State::PowerOn(void)
 	// It should be delayed.
 	towns.var.startUpStateFName=argv.startUpStateFName;
 
+	if(""!=argv.bootSnapshotDir)
+	{
+		towns.var.bootSnapshotFName=cpputil::MakeFullPathName(argv.bootSnapshotDir,"BOOT"+towns.MakeBootSnapshotKey(argv)+".TState");
+		towns.var.bootSnapshotAtKeyWait=("KEYWAIT"==argv.bootSnapshotAt);
+		if(true!=towns.var.bootSnapshotAtKeyWait)
+		{
+			towns.var.bootSnapshotAt.MakeFromString(argv.bootSnapshotAt);
+		}
+	}
+
 	towns.var.quickScrnShotDir=argv.quickScrnShotDir;
 	towns.var.scrnShotX0=argv.scrnShotX0;
 	towns.var.scrnShotY0=argv.scrnShotY0;
@@ -991,6 +1038,7 @@ bool FMTownsCommon::LoadROMImages(const char dirName[])
 
 void FMTownsCommon::PowerOn(void)
 {
+	SyncDeviceThread();
 	state.PowerOn();
 	CPU().PowerOn();
 	for(auto devPtr : allDevices)
@@ -1004,6 +1052,7 @@ void FMTownsCommon::PowerOn(void)
 void FMTownsCommon::Reset(void)
 {
 	auto &cpu=CPU();
+	SyncDeviceThread();
 	var.Reset();
 	state.Reset();
 	cpu.Reset();
@@ -1026,6 +1075,27 @@ void FMTownsCommon::Reset(unsigned int bootKey)
 	gameport.SetBootKeyCombination(bootKey);
 }
 
+void FMTownsCommon::EnableDeviceThread(bool enable)
+{
+	SyncDeviceThread();
+	if(true==enable)
+	{
+		deviceThread.Start();
+	}
+	else
+	{
+		deviceThread.Stop();
+	}
+}
+
+void FMTownsCommon::SyncDeviceThread(void)
+{
+	deviceThread.WaitAll();
+	physMem.WaitVRAMWriter();
+	sprite.WaitRender();
+	cdrom.DiscardPrefetch();
+}
+
 void FMTownsCommon::NotifyDiskRead(void)
 {
 	keyboard.BootSequenceStarted();
@@ -1136,6 +1206,102 @@ void FMTownsCommon::ProcessSound(Outside_World *outside_world)
 	}
 }
 
+/* virtual */ bool FMTownsCommon::HostINT21H(void)
+{
+	auto &cpu=CPU();
+	if(Variable::HOSTSVC_OFF==var.hostServiceMode || 0x3F!=cpu.GetAH())
+	{
+		return false;
+	}
+
+	// Real mode and 16-bit code use DS:DX, CX, and AX.  32-bit code of the DOS extender uses DS:EDX, ECX, and EAX.
+	bool use32=(true!=cpu.IsInRealMode() && 32==cpu.state.CS().addressSize);
+	uint32_t bufOffset=(true==use32 ? cpu.GetEDX() : cpu.GetDX());
+	uint32_t len=(true==use32 ? cpu.GetECX() : cpu.GetCX());
+	auto &DS=cpu.state.DS();
+	if(0==len || DS.limit<bufOffset || DS.limit-bufOffset<len-1)
+	{
+		return false;
+	}
+
+	// Leave it to DOS if the buffer is not all there.  DOS will raise the page fault.
+	uint32_t bufLinearAddr=DS.baseLinearAddr+bufOffset;
+	if(true==cpu.PagingEnabled())
+	{
+		for(uint64_t page=(bufLinearAddr&~4095); page<(uint64_t)bufLinearAddr+len; page+=4096)
+		{
+			unsigned int excType,excCode;
+			cpu.DebugLinearAddressToPhysicalAddress(excType,excCode,(uint32_t)page,mem);
+			if(i486DXCommon::EXCEPTION_NONE!=excType)
+			{
+				return false;
+			}
+		}
+	}
+
+	std::vector <unsigned char> data;
+	if(Variable::HOSTSVC_VERIFY==var.hostServiceMode)
+	{
+		// The SFT is not updated, so that DOS reads from the same position.
+		// A nested call (DOS extender to real-mode DOS) replaces the outer one.
+		auto &verify=var.hostServiceVerification;
+		verify.pending=tgdrv.HostReadFromHandle(data,cpu.GetBX(),len,false);
+		if(true==verify.pending)
+		{
+			verify.use32=use32;
+			verify.fromCS=cpu.state.CS().value;
+			verify.fromEIP=cpu.state.EIP;
+			verify.bufLinearAddr=bufLinearAddr;
+			verify.data.swap(data);
+		}
+		return false;
+	}
+
+	if(true==tgdrv.HostReadFromHandle(data,cpu.GetBX(),len,true))
+	{
+		cpu.WriteLinearBlock(bufLinearAddr,(unsigned int)data.size(),data.data(),mem);
+		if(true==use32)
+		{
+			cpu.SetEAX((unsigned int)data.size());
+		}
+		else
+		{
+			cpu.SetAX((unsigned int)data.size());
+		}
+		cpu.SetCF(false);
+		++var.hostServiceCount;
+		var.hostServiceBytes+=data.size();
+		return true;
+	}
+	return false;
+}
+
+/* virtual */ void FMTownsCommon::InterceptINT21HReturn(unsigned int fromCS,unsigned int fromEIP)
+{
+	auto &verify=var.hostServiceVerification;
+	if(true!=verify.pending || fromCS!=verify.fromCS || fromEIP!=verify.fromEIP)
+	{
+		return;
+	}
+	verify.pending=false;
+
+	auto &cpu=CPU();
+	unsigned int count=(true==verify.use32 ? cpu.GetEAX() : cpu.GetAX());
+	bool match=(true!=cpu.GetCF() && count==verify.data.size());
+	for(unsigned int i=0; true==match && i<verify.data.size(); ++i)
+	{
+		match=(verify.data[i]==cpu.DebugFetchByteByLinearAddress(mem,verify.bufLinearAddr+i));
+	}
+
+	++var.hostServiceVerified;
+	if(true!=match)
+	{
+		// DOS already has put its result.  Report and keep going.
+		++var.hostServiceMismatch;
+		std::cout << "INT 21H AH=3FH host service does not match at " << cpputil::Ustox(fromCS) << ":" << cpputil::Uitox(fromEIP) << std::endl;
+	}
+}
+
 void FMTownsCommon::RunFastDevicePollingInternal(void)
 {
 	timer.TimerPolling(state.townsTime);
@@ -1176,6 +1342,7 @@ void FMTownsCommon::SetMainRAMSize(long long int size)
 
 void FMTownsCommon::ForceRender(class TownsRender &render,class Outside_World &world,Outside_World::WindowInterface &windowInterface)
 {
+	deviceThread.WaitAll();
 	render.Prepare(crtc);
 	render.damperWireLine=var.damperWireLine;
 	render.BuildImage(physMem.state.VRAM,crtc.GetPalette(),crtc.chaseHQPalette);
@@ -1187,10 +1354,12 @@ void FMTownsCommon::ForceRender(class TownsRender &render,class Outside_World &w
 	windowInterface.Communicate(&world);
 	auto img=render.MoveImage();
 	windowInterface.UpdateImage(img);
+	render.RecycleImage(img); // UpdateImage gives back the previous image.
 }
 
 void FMTownsCommon::RenderQuiet(class TownsRender &render,bool layer0,bool layer1)
 {
+	deviceThread.WaitAll();
 	render.Prepare(crtc);
 	render.OerrideShowPage(layer0,layer1);
 
@@ -1202,6 +1371,7 @@ void FMTownsCommon::RenderQuiet(class TownsRender &render,bool layer0,bool layer
 
 void FMTownsCommon::RenderEntireVRAMLayerQuiet(class TownsRender &render,unsigned int layer)
 {
+	deviceThread.WaitAll();
 	render.PrepareEntireVRAMLayer(crtc,layer);
 	render.BuildImage(physMem.state.VRAM,crtc.GetPalette(),crtc.chaseHQPalette);
 }
@@ -1285,7 +1455,8 @@ void FMTownsCommon::DisableDebugger(void)
 	auto &cpu=CPU();
 	cpu.DetachDebugger();
 	debugger.stop=false;
-	cpu.enableCallStack=false;
+	// HOSTSVC_VERIFY needs the call stack to catch the return from INT 21H.
+	cpu.enableCallStack=(Variable::HOSTSVC_VERIFY==var.hostServiceMode);
 }
 
 std::vector <std::string> FMTownsCommon::GetStackText(unsigned int numBytes) const
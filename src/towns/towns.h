@@ -51,6 +51,9 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 #include "highrespcm.h"
 
 #include "eventlog.h"
+#include "framecapture.h"
+#include "townspacer.h"
+#include "townsdevicethread.h"
 
 #include "outside_world.h"
 
@@ -77,6 +80,7 @@ public:
 		FREQUENCY_SLOWMODE_DEFAULT=5,        // MHz
 		FAST_DEVICE_POLLING_INTERVAL=10000,  // Nano-seconds
 		DEVICE_POLLING_INTERVAL=   8000000,  // 8ms
+		BOOT_SNAPSHOT_KEYWAIT_POLL_COUNT=1000, // Consecutive keyboard-status reads with no key to take it as a key wait.
 
 		AUTOQSS_CHECK_INTERVAL=   25000000,  // 25ms
 
@@ -259,6 +263,10 @@ public:
 
 		uint64_t nextTimeSync; // Used from TownsThread.
 
+		/*! Number of instructions executed since power on.  Used for measuring guest MIPS.
+		*/
+		uint64_t instructionCount=0;
+
 		bool powerOff=false;
 		int returnCode=0;
 
@@ -309,6 +317,17 @@ public:
 		*/
 		std::string startUpStateFName;
 
+		/*! Boot snapshot.  If bootSnapshotFName is not "", TownsThread::VMStart resumes from it if exists.
+		    Otherwise, the state is saved to it when the boot reaches bootSnapshotAt, or the first keyboard wait
+		    if bootSnapshotAtKeyWait is true.
+		    The file name includes the hash of the start-up parameters, therefore any change in the parameters
+		    makes a different file name.
+		*/
+		std::string bootSnapshotFName;
+		bool bootSnapshotPending=false;
+		bool bootSnapshotAtKeyWait=true;
+		i486DXCommon::FarPointer bootSnapshotAt;
+
 		/*!
 		*/
 		std::string quickScrnShotDir;
@@ -338,6 +357,33 @@ public:
 
 		VMHostFileTransfer ftfr;
 
+		/*! Host service of DOS calls.  See HostINT21H.
+		*/
+		enum
+		{
+			HOSTSVC_OFF,
+			HOSTSVC_ON,
+			HOSTSVC_VERIFY, // Let DOS run, and compare the result with what the host service would have returned.  Mismatch is logged and counted.
+		};
+		unsigned int hostServiceMode=HOSTSVC_OFF;
+		uint64_t hostServiceCount=0;    // Number of calls serviced by the host.
+		uint64_t hostServiceBytes=0;    // Number of bytes read by the host service.
+		uint64_t hostServiceVerified=0; // Number of calls compared in HOSTSVC_VERIFY mode.
+		uint64_t hostServiceMismatch=0; // Number of calls that did not match in HOSTSVC_VERIFY mode.
+
+		/*! The call waiting for the return from DOS in HOSTSVC_VERIFY mode.
+		*/
+		class HostServiceVerification
+		{
+		public:
+			bool pending=false;
+			bool use32=false; // Count is returned in EAX instead of AX.
+			unsigned int fromCS=0,fromEIP=0;
+			uint32_t bufLinearAddr=0;
+			std::vector <unsigned char> data;
+		};
+		HostServiceVerification hostServiceVerification;
+
 		std::string CMOSFName;
 
 		/*! If this flag is true, VM thread pauses, not closes on power off.
@@ -418,6 +464,8 @@ public:
 	virtual const i486DXCommon &CPU(void) const=0;
 	i486Debugger debugger;
 	TownsEventLog eventLog;
+	TownsFrameCapture frameCapture;
+	TownsPacer pacer;
 	TownsPIC pic;
 	TownsRTC rtc;
 	TownsDMAC dmac;
@@ -443,6 +491,11 @@ public:
 	InOut io;
 	Memory mem;
 
+	/*! Runs sprite rendering and CD-ROM sector reads off the CPU thread.
+	    Declared after the devices so that it is stopped before they are destroyed.
+	*/
+	TownsDeviceThread deviceThread;
+
 	/*! Pointers of all devices (except *this) must be stored in allDevices.
 	*/
 	using VMBase::allDevices;
@@ -613,6 +666,15 @@ public:
 	*/
 	void Reset(unsigned int bootKey);
 
+	/*! Starts or stops the device thread.
+	*/
+	void EnableDeviceThread(bool enable);
+
+	/*! Waits for all device-thread jobs, and puts the original VRAM-access objects back.
+	    Must be called before the state is read or written outside of the regular device emulation.
+	*/
+	void SyncDeviceThread(void);
+
 	/*! This function is called when:
 	      Floppy-disk sector is read,
 	      CD-ROM sector is read, and
@@ -637,6 +699,18 @@ public:
 	*/
 	virtual void InterceptINT21H(unsigned int AX,const std::string fName);
 
+	/*! This function will be called from the CPU before INT 21H is dispatched.
+	    When var.hostServiceMode is HOSTSVC_ON, AH=3FH (read from file or device) on a Tsugaru Drive file
+	    is done by the host, directly to the buffer, and returns true.
+	    Otherwise returns false, and DOS takes the call.
+	*/
+	virtual bool HostINT21H(void);
+
+	/*! This function will be called from the CPU in PopCallStack when INT 21H returns.
+	    In HOSTSVC_VERIFY mode, the result of DOS is compared with the host service.
+	*/
+	virtual void InterceptINT21HReturn(unsigned int fromCS,unsigned int fromEIP);
+
 	/*! Run scheduled tasks.
 	*/
 	inline void RunScheduledTasks(void)
@@ -766,6 +840,22 @@ public:
 	bool SaveState(std::string fName) const;
 	bool LoadState(std::string fName);
 
+	/*! Returns a hash of ROM images, CMOS, media images, memory size, and other start-up parameters
+	    that affects the state after boot, and the serialization versions of the devices.
+	    Must be called after Setup.
+	*/
+	std::string MakeBootSnapshotKey(const TownsStartParameters &argv) const;
+
+	/*! Called from TownsThread::VMStart.
+	    Resumes from the boot snapshot if exists.  Otherwise, sets var.bootSnapshotPending.
+	*/
+	void StartBootSnapshot(void);
+
+	/*! Call after each instruction while var.bootSnapshotPending is true.
+	    Saves the boot snapshot when the boot reaches the snapshot point.
+	*/
+	void CheckBootSnapshot(void);
+
 	std::vector <uint8_t> SaveStateMem(void) const;
 	bool LoadStateMem(const std::vector <uint8_t> &state);
 
@@ -946,6 +1036,7 @@ public:
 	inline unsigned int RunOneInstruction(void)
 	{
 		auto clocksPassed=_cpu.RunOneInstruction(mem,io);
+		++var.instructionCount;
 		state.clockBalance+=clocksPassed*1000;
 
 		// Since last update, clockBalance*1000/freq nano seconds have passed.
@@ -0,0 +1,183 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include <iostream>
+#include <stdio.h>
+
+#include "towns.h"
+#include "cpputil.h"
+#include "filesys.h"
+
+
+// Boot snapshot
+// Saving the state at the end of the boot sequence so that the next launch with the same set up can skip
+// ROM BIOS boot and CD/FD boot.  Snapshot file name includes the hash of everything that affects the state
+// at the snapshot point.  Any change in ROM, CMOS, media images, memory size etc. makes a different file name
+// and the old snapshot is simply not used.
+
+
+std::string FMTownsCommon::MakeBootSnapshotKey(const TownsStartParameters &argv) const
+{
+	// FNV-1a 64
+	uint64_t hash=14695981039346656037ULL;
+	auto add=[&](const unsigned char data[],size_t len)
+	{
+		for(size_t i=0; i<len; ++i)
+		{
+			hash^=data[i];
+			hash*=1099511628211ULL;
+		}
+	};
+	auto addUint=[&](uint64_t value)
+	{
+		unsigned char buf[8];
+		for(int i=0; i<8; ++i)
+		{
+			buf[i]=(unsigned char)(value>>(i*8));
+		}
+		add(buf,8);
+	};
+	auto addStr=[&](const std::string &str)
+	{
+		addUint(str.size());
+		add((const unsigned char *)str.data(),str.size());
+	};
+	// Media images can be hundreds of mega bytes.  File name, size, and time stamp instead of the contents.
+	auto addFile=[&](const std::string &fName)
+	{
+		addStr(fName);
+		if(""!=fName)
+		{
+			addUint(cpputil::FileSize(fName));
+			long long int mtime=0;  // Stays 0 if too recent to trust.  Then the snapshot is just not reused.
+			FileSys::GetModificationTime(fName,mtime);
+			addUint(mtime);
+		}
+	};
+
+	for(auto romPtr : {&physMem.sysRom,&physMem.dosRom,&physMem.fontRom,&physMem.font20Rom,&physMem.dicRom,&physMem.martyRom})
+	{
+		addUint(romPtr->size());
+		add(romPtr->data(),romPtr->size());
+	}
+	add(physMem.state.CMOSRAM,TOWNS_CMOS_SIZE);
+
+	addUint(argv.townsType);
+	addUint(argv.memSizeInMB);
+	addUint(argv.CPUFidelityLevel);
+	addUint(argv.freq);
+	addUint(argv.pretend386DX);
+	addUint(argv.useFPU);
+	addUint(argv.bootKeyComb);
+	addUint(argv.alwaysBootToFASTMode);
+	addUint(argv.highResAvailable);
+	addUint(argv.highResPCM);
+	addUint(argv.nMidiCards);
+	addUint(argv.keyboardMode);
+	addUint(argv.appSpecificSetting);
+	for(auto gamePort : argv.gamePort)
+	{
+		addUint(gamePort);
+	}
+
+	for(int drv=0; drv<TownsStartParameters::NUM_FDDRIVES; ++drv)
+	{
+		addFile(var.ApplyAlias(argv.fdImgFName[drv]));
+		addUint(argv.fdImgWriteProtect[drv]);
+	}
+	addFile(var.ApplyAlias(argv.cdImgFName));
+	for(auto &bin : cdrom.state.GetDisc().binaries)
+	{
+		addFile(bin.fName);
+	}
+	for(auto &scsi : argv.scsiImg)
+	{
+		addUint(scsi.imageType);
+		addFile(var.ApplyAlias(scsi.imgFName));
+	}
+	addUint(argv.memCardType);
+	addFile(var.ApplyAlias(argv.memCardImgFName));
+	addUint(argv.memCardWriteProtected);
+	for(auto &dir : argv.sharedDir)
+	{
+		addStr(dir);
+	}
+
+	// Snapshot made by an older version must not be used if the state format has changed.
+	for(auto devPtr : DevicesToSaveState())
+	{
+		addStr(devPtr->DeviceName());
+		addUint(devPtr->GetSerializeVersion());
+	}
+
+	return cpputil::Uitox((unsigned int)(hash>>32))+cpputil::Uitox((unsigned int)hash);
+}
+
+void FMTownsCommon::StartBootSnapshot(void)
+{
+	var.bootSnapshotPending=false;
+	if(""==var.bootSnapshotFName)
+	{
+		return;
+	}
+
+	if(true==cpputil::FileExists(var.bootSnapshotFName))
+	{
+		if(true==LoadState(var.bootSnapshotFName))
+		{
+			std::cout << "Resumed from boot snapshot " << var.bootSnapshotFName << std::endl;
+			return;
+		}
+		std::cout << "Cannot load boot snapshot " << var.bootSnapshotFName << std::endl;
+		std::cout << "Discarded and booting normally." << std::endl;
+		remove(var.bootSnapshotFName.c_str());
+		Reset();
+	}
+
+	keyboard.emptyStatusPollCount=0;
+	var.bootSnapshotPending=true;
+}
+
+void FMTownsCommon::CheckBootSnapshot(void)
+{
+	bool reached=false;
+	if(true==var.bootSnapshotAtKeyWait)
+	{
+		reached=(BOOT_SNAPSHOT_KEYWAIT_POLL_COUNT<=keyboard.emptyStatusPollCount);
+	}
+	else
+	{
+		auto &cpu=CPU();
+		reached=(cpu.state.CS().value==var.bootSnapshotAt.SEG && cpu.state.EIP==var.bootSnapshotAt.OFFSET);
+	}
+
+	if(true==reached)
+	{
+		var.bootSnapshotPending=false;
+
+		// Write to a temporary file and then rename so that a half-written snapshot will never be loaded.
+		// Temporary file must be in the same directory for the relative paths of the images.
+		auto tmpFName=var.bootSnapshotFName+".tmp";
+		if(true==SaveState(tmpFName))
+		{
+			if(true==cpputil::RenameReplacing(tmpFName,var.bootSnapshotFName))
+			{
+				std::cout << "Saved boot snapshot " << var.bootSnapshotFName << std::endl;
+				return;
+			}
+		}
+		remove(tmpFName.c_str());
+		std::cout << "Cannot save boot snapshot " << var.bootSnapshotFName << std::endl;
+	}
+}
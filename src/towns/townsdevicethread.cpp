@@ -0,0 +1,111 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include "townsdevicethread.h"
+
+
+
+TownsDeviceThread::TownsDeviceThread()
+{
+}
+TownsDeviceThread::~TownsDeviceThread()
+{
+	Stop();
+}
+
+void TownsDeviceThread::Start(void)
+{
+	if(true!=running)
+	{
+		terminate=false;
+		running=true;
+		thr=std::thread(&TownsDeviceThread::ThreadFunc,this);
+	}
+}
+void TownsDeviceThread::Stop(void)
+{
+	if(true==running)
+	{
+		{
+			std::unique_lock <std::mutex> lock(mutex);
+			terminate=true;
+		}
+		jobCond.notify_one();
+		thr.join();
+		running=false;
+	}
+}
+
+void TownsDeviceThread::ThreadFunc(void)
+{
+	for(;;)
+	{
+		std::function <void(void)> job;
+		{
+			std::unique_lock <std::mutex> lock(mutex);
+			jobCond.wait(lock,[&]{return true==terminate || 0<jobQueue.size();});
+			if(0==jobQueue.size())
+			{
+				break; // Terminate after the queue is empty.
+			}
+			job=std::move(jobQueue.front());
+			jobQueue.pop_front();
+		}
+
+		job();
+
+		{
+			std::unique_lock <std::mutex> lock(mutex);
+			lastDone.fetch_add(1,std::memory_order_release);
+		}
+		doneCond.notify_all();
+	}
+}
+
+TownsDeviceThread::Ticket TownsDeviceThread::Push(std::function <void(void)> job)
+{
+	if(true!=running)
+	{
+		job();
+		return 0;
+	}
+
+	Ticket ticket;
+	{
+		std::unique_lock <std::mutex> lock(mutex);
+		jobQueue.push_back(std::move(job));
+		ticket=++lastPushed;
+	}
+	jobCond.notify_one();
+	return ticket;
+}
+
+void TownsDeviceThread::Wait(Ticket ticket)
+{
+	if(true!=IsDone(ticket))
+	{
+		std::unique_lock <std::mutex> lock(mutex);
+		doneCond.wait(lock,[&]{return true==IsDone(ticket);});
+	}
+}
+
+void TownsDeviceThread::WaitAll(void)
+{
+	Ticket ticket;
+	{
+		std::unique_lock <std::mutex> lock(mutex);
+		ticket=lastPushed;
+	}
+	Wait(ticket);
+}
@@ -0,0 +1,82 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#ifndef TOWNSDEVICETHREAD_IS_INCLUDED
+#define TOWNSDEVICETHREAD_IS_INCLUDED
+/* { */
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <atomic>
+#include <stdint.h>
+
+/*! Second thread for device emulation that is loosely coupled to the CPU.
+    The VM thread pushes a job, and receives a ticket.  Jobs are executed in the order pushed.
+    The VM thread must call Wait(ticket) before it reads or writes anything the job touches.
+    Devices make the deadline as late as possible, for example by fencing the VRAM slots
+    the job writes, so that the CPU keeps running until it actually needs the result.
+
+    If the thread is not running, Push executes the job immediately and returns 0.
+*/
+class TownsDeviceThread
+{
+public:
+	typedef uint64_t Ticket;
+
+private:
+	std::thread thr;
+	std::mutex mutex;
+	std::condition_variable jobCond,doneCond;
+	std::deque <std::function <void(void)> > jobQueue;
+	bool running=false;
+	bool terminate=false;
+	Ticket lastPushed=0;
+	std::atomic <Ticket> lastDone{0};
+
+	void ThreadFunc(void);
+
+public:
+	TownsDeviceThread();
+	~TownsDeviceThread();
+
+	void Start(void);
+	/*! Finishes all jobs and stops the thread.
+	*/
+	void Stop(void);
+	inline bool IsRunning(void) const
+	{
+		return running;
+	}
+
+	Ticket Push(std::function <void(void)> job);
+
+	inline bool IsDone(Ticket ticket) const
+	{
+		return ticket<=lastDone.load(std::memory_order_acquire);
+	}
+
+	/*! Blocks until the job of the ticket and all jobs before it are done.
+	*/
+	void Wait(Ticket ticket);
+
+	/*! Blocks until all jobs are done.
+	*/
+	void WaitAll(void);
+};
+
+/* } */
+#endif
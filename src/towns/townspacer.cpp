@@ -0,0 +1,96 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#include "townspacer.h"
+
+
+
+void TownsPacer::Reset(void)
+{
+	sliceLength=SLICE_MIN;
+	stat=Statistics();
+}
+
+int64_t TownsPacer::BeginSlice(int64_t timeDeficit)
+{
+	int64_t catchUp=0;
+	if(0<timeDeficit)
+	{
+		catchUp=timeDeficit;
+		if(MAX_CATCHUP_PER_SLICE<catchUp)
+		{
+			catchUp=MAX_CATCHUP_PER_SLICE;
+		}
+		if(sliceLength<catchUp)
+		{
+			catchUp=sliceLength;
+		}
+	}
+	stat.totalCatchUp+=catchUp;
+	return catchUp;
+}
+
+void TownsPacer::EndSlice(int64_t timeDeficit,int64_t sleepTime,uint64_t numUnderruns)
+{
+	++stat.numSlices;
+	stat.lag=timeDeficit;
+	if(stat.maxLag<timeDeficit)
+	{
+		stat.maxLag=timeDeficit;
+	}
+	stat.totalSleep+=sleepTime;
+
+	if(stat.numUnderruns!=numUnderruns)
+	{
+		// Sound is handed to the host only at slice boundaries.
+		stat.numUnderruns=numUnderruns;
+		sliceLength=SLICE_MIN;
+	}
+	else if(sliceLength<timeDeficit)
+	{
+		sliceLength*=2;
+		if(SLICE_MAX<sliceLength)
+		{
+			sliceLength=SLICE_MAX;
+		}
+	}
+	else if(0<sleepTime || timeDeficit<=0)
+	{
+		sliceLength/=2;
+		if(sliceLength<SLICE_MIN)
+		{
+			sliceLength=SLICE_MIN;
+		}
+	}
+}
+
+std::vector <std::string> TownsPacer::GetStatusText(void) const
+{
+	std::vector <std::string> text;
+	text.push_back("Slice Length(ns):");
+	text.back()+=std::to_string(sliceLength);
+	text.push_back("Number of Slices:");
+	text.back()+=std::to_string(stat.numSlices);
+	text.push_back("Lag(ns):");
+	text.back()+=std::to_string(stat.lag);
+	text.back()+="  Max Lag(ns):";
+	text.back()+=std::to_string(stat.maxLag);
+	text.push_back("Total Catch-Up(ms):");
+	text.back()+=std::to_string(stat.totalCatchUp/1000000);
+	text.push_back("Total Sleep(ms):");
+	text.back()+=std::to_string(stat.totalSleep/1000000);
+	text.push_back("Sound Underruns:");
+	text.back()+=std::to_string(stat.numUnderruns);
+	return text;
+}
@@ -0,0 +1,74 @@
+/* LICENSE>>
+Copyright 2020 Soji Yamakawa (CaptainYS, http://www.ysflight.com)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<< LICENSE */
+#ifndef TOWNSPACER_IS_INCLUDED
+#define TOWNSPACER_IS_INCLUDED
+/* { */
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+/*! Pacing of the VM against the host clock.
+    The VM thread runs the CPU in time slices.  The pacer decides how much VM time each slice covers,
+    and how much of the time deficit (VM lagging behind the real time) is caught up by skipping
+    VM time at the beginning of the slice.  Nothing is done per instruction.
+
+    The slice length adapts:
+      - It grows while the VM is lagging, so that less time is spent on per-slice host work.
+      - It shrinks back when the VM is waiting for the real time, or when the sound output ran dry.
+    SLICE_MAX is the input-latency target, since keyboard and mouse are polled at slice boundaries.
+*/
+class TownsPacer
+{
+public:
+	enum
+	{
+		SLICE_MIN=            1000000, // 1ms
+		SLICE_MAX=            4000000, // 4ms
+		MAX_CATCHUP_PER_SLICE=1000000, // VM time skipped in one slice is capped so that device events are not bunched up.
+	};
+
+	class Statistics
+	{
+	public:
+		uint64_t numSlices=0;
+		int64_t lag=0;           // Time deficit at the end of the last slice in nanoseconds.
+		int64_t maxLag=0;
+		int64_t totalCatchUp=0;  // VM time skipped for catching up with the real time.
+		int64_t totalSleep=0;    // Real time spent waiting for the real time to catch up with the VM.
+		uint64_t numUnderruns=0; // Sound underruns observed at slice boundaries.
+	};
+
+	int64_t sliceLength=SLICE_MIN;
+	Statistics stat;
+
+	void Reset(void);
+
+	/*! Returns the VM time to be skipped at the beginning of the slice for catching up with the real time.
+	    timeDeficit is the lag carried from the previous slice.
+	*/
+	int64_t BeginSlice(int64_t timeDeficit);
+
+	/*! Called after the VM is synchronized with the host clock.
+	    timeDeficit is the new lag, sleepTime is the real time the VM waited,
+	    and numUnderruns is the accumulated number of sound underruns.
+	*/
+	void EndSlice(int64_t timeDeficit,int64_t sleepTime,uint64_t numUnderruns);
+
+	std::vector <std::string> GetStatusText(void) const;
+};
+
+/* } */
+#endif
@@ -67,11 +67,18 @@ public:
 	bool catchUpRealTime=true;
 
 	bool damperWireLine=false;
+	bool rasterLog=false;
 	bool scanLineEffectIn15KHz=false;
 
 	// If not "", VM starts from this saved state.
 	std::string startUpStateFName;
 
+	// If not "", boot snapshots are saved in and resumed from this directory.
+	// Ignored if startUpStateFName is given.
+	std::string bootSnapshotDir;
+	// "KEYWAIT" for the first keyboard wait, or SEG:OFFSET.
+	std::string bootSnapshotAt="KEYWAIT";
+
 	std::string ROMPath;
 	std::string CMOSFName;
 	bool autoSaveCMOS=true; // If this flag is false, CMOSFName will not be copied to FMTownsCommon::Variable.
@@ -86,6 +93,7 @@ public:
 	std::string startUpScriptFName;
 	std::string symbolFName;
 	std::string playbackEventLogFName;
+	bool playbackEventLogInTownsTime=false;
 	std::string keyMapFName;
 	bool memCardWriteProtected=false;
 
@@ -101,7 +109,12 @@ public:
 	std::vector <HostShortCut> hostShortCutKeys;
 
 	int fmVol=-1,pcmVol=-1;
+	std::vector <std::pair <std::string,int> > mixerGain;  // Mixer source or MASTER, and gain.  4096 is 1.0.
 	bool maximumSoundDoubleBuffering=false;
+	bool FMSynthesisThread=false;
+	bool deviceThread=false;
+	bool hostBlockOp=false,verifyHostBlockOp=false;
+	bool hostService=false,verifyHostService=false;
 
 	bool mouseByFlightstickAvailable=false;
 	bool cyberStickAssignment=false;
@@ -31,9 +31,14 @@ bool FMTownsCommon::SaveState(std::string fName) const
 }
 bool FMTownsCommon::LoadState(std::string fName)
 {
+	SyncDeviceThread();
 	std::ifstream ifp(fName,std::ios::binary);
 	if(true==ifp.is_open())
 	{
+		ifp.seekg(0,std::ios::end);
+		uint64_t fSize=ifp.tellg();
+		ifp.seekg(0,std::ios::beg);
+
 		highResPCM.state.enabled=false; // If not read must be made by an old version, keep it disabled.
 		midi.Stop();
 		midi.EnableCards(0); // If no data, leave all disabled.
@@ -46,6 +51,10 @@ bool FMTownsCommon::LoadState(std::string fName)
 			{
 				break;
 			}
+			if(true!=ifp.good() || fSize-ifp.tellg()<len) // Broken or truncated.
+			{
+				return false;
+			}
 
 			std::vector <unsigned char> data;
 			data.resize(len);
@@ -88,6 +97,7 @@ std::vector <uint8_t> FMTownsCommon::SaveStateMem(void) const
 }
 bool FMTownsCommon::LoadStateMem(const std::vector <uint8_t> &state)
 {
+	SyncDeviceThread();
 	highResPCM.state.enabled=false; // If not read must be made by an old version, keep it disabled.
 	midi.Stop();
 	midi.EnableCards(0); // If no data, leave all disabled.
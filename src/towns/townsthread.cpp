@@ -27,6 +27,7 @@ TownsThread::TownsThread(void)
 void TownsThread::VMStart(FMTownsCommon *townsPtr,Outside_World *outside_world,class TownsUIThread *uiThread)
 {
 	this->townsPtr=townsPtr;
+	townsPtr->pacer.Reset();
 
 	outside_world->Start();
 
@@ -34,6 +35,10 @@ void TownsThread::VMStart(FMTownsCommon *townsPtr,Outside_World *outside_world,c
 	{
 		townsPtr->LoadState(townsPtr->var.startUpStateFName);
 	}
+	else
+	{
+		townsPtr->StartBootSnapshot();
+	}
 
 	switch(townsPtr->state.appSpecificSetting)
 	{
@@ -109,7 +114,9 @@ void TownsThread::VMMainLoopTemplate(
 		case RUNMODE_RUN:
 			clockTicking=true;
 			{
-				townsPtr->var.nextTimeSync=townsPtr->state.townsTime+NANOSECONDS_PER_TIME_SYNC;
+				// Catch-up is applied once per slice, not per instruction.
+				townsPtr->state.townsTime+=townsPtr->pacer.BeginSlice(townsPtr->state.timeDeficit);
+				townsPtr->var.nextTimeSync=townsPtr->state.townsTime+townsPtr->pacer.sliceLength;
 				townsPtr->debugger.ClearStopFlag();
 				if(true==townsPtr->CheckAbort())
 				{
@@ -121,10 +128,10 @@ void TownsThread::VMMainLoopTemplate(
 					townsPtr->pic.ProcessIRQ(townsPtr->CPU(),townsPtr->mem);
 					townsPtr->RunFastDevicePolling();
 					townsPtr->RunScheduledTasks();
-
-					auto payBack=std::min<long long int>(TIME_DEFICIT_PAYBACK_PER_INSTRUCTION,timeDeficit);
-					townsPtr->state.townsTime+=payBack;
-					timeDeficit-=payBack;
+					if(true==townsPtr->var.bootSnapshotPending)
+					{
+						townsPtr->CheckBootSnapshot();
+					}
 
 					if(true==townsPtr->debugger.stop)
 					{
@@ -301,13 +308,16 @@ void TownsThread::VMMainLoopTemplate(
 void TownsThread::VMEnd(FMTownsCommon *townsPtr,Outside_World *outside_world,class TownsUIThread *uiThread)
 {
 	townsPtr->cdrom.WaitUntilAsyncWaveReaderFinished();
+	townsPtr->EnableDeviceThread(false);
 
 	uiThread->uiLock.lock();
 	uiThread->vmTerminated=true;
 	uiThread->uiLock.unlock();
 
 	std::cout << "Ending Towns Thread." << std::endl;
+	townsPtr->frameCapture.Stop();
 	townsPtr->fdc.SaveModifiedDiskImages();
+	townsPtr->fdc.FlushDiskImageWriter();
 
 	if(0<townsPtr->var.CMOSFName.size())
 	{
@@ -343,9 +353,14 @@ void TownsThread::CheckRenderingTimer(FMTownsCommon &towns,class Outside_World::
 		}
 		if(true==isTiming)
 		{
+			towns.deviceThread.WaitAll(); // Sprite page may be being rendered.
 			if(true==window.SendNewImage(towns,imageNeedsFlip))
 			{
 				towns.state.nextRenderingTime=towns.state.townsTime+TOWNS_RENDERING_FREQUENCY;
+				if(true==towns.frameCapture.IsCapturing())
+				{
+					towns.frameCapture.NextFrame(towns.crtc,towns.physMem.state.VRAM,towns.var.damperWireLine,towns.var.scanLineEffectIn15KHz,imageNeedsFlip,towns.state.townsTime);
+				}
 			}
 		}
 	}
@@ -382,6 +397,7 @@ void TownsThread::AdjustRealTime(FMTownsCommon *townsPtr,long long int cpuTimePa
 	townsPtr->var.timeDeficitLog[townsPtr->var.timeAdjustLogPtr]=townsPtr->state.timeDeficit;
 	townsPtr->var.timeAdjustLogPtr=(townsPtr->var.timeAdjustLogPtr+1)&(FMTownsCommon::Variable::TIME_ADJUSTMENT_LOG_LEN-1);
 
+	int64_t sleepTime=0;
 	int64_t balance=cpuTimePassed-(townsPtr->state.timeDeficit+realTimePassed);
 	if(balance<0)  // Case 3
 	{
@@ -398,11 +414,13 @@ void TownsThread::AdjustRealTime(FMTownsCommon *townsPtr,long long int cpuTimePa
 	{
 		if(true!=townsPtr->state.noWait)
 		{
+			auto realTimeBeforeSleep=realTimePassed;
 			while(townsPtr->state.timeDeficit+realTimePassed<cpuTimePassed)
 			{
 				townsPtr->ProcessSound(outside_world);
 				realTimePassed=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now()-time0).count();
 			}
+			sleepTime=realTimePassed-realTimeBeforeSleep;
 			int64_t newBalance=cpuTimePassed-(townsPtr->state.timeDeficit+realTimePassed);
 			townsPtr->state.timeDeficit=-newBalance;
 		}
@@ -411,7 +429,7 @@ void TownsThread::AdjustRealTime(FMTownsCommon *townsPtr,long long int cpuTimePa
 			townsPtr->state.timeDeficit=0;
 		}
 	}
-	this->timeDeficit=townsPtr->state.timeDeficit;
+	townsPtr->pacer.EndSlice(townsPtr->state.timeDeficit,sleepTime,townsPtr->sound.var.numUnderruns);
 
 	if(FMTownsCommon::State::CATCHUP_DEFICIT_CUTOFF<townsPtr->state.timeDeficit)
 	{
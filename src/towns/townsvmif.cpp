@@ -13,6 +13,8 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 << LICENSE */
 #include <iostream>
+#include <cstring>
+#include <algorithm>
 
 #include "cpputil.h"
 #include "towns.h"
@@ -156,10 +158,7 @@ void FMTownsCommon::VMHostFileTransfer(void)
 			unsigned int sizeLeft=(unsigned int)file.bin.size()-file.offset;
 			unsigned int batchSize=(TOWNS_SPRITERAM_SIZE<sizeLeft ? TOWNS_SPRITERAM_SIZE : sizeLeft);
 
-			for(unsigned int i=0; i<batchSize; ++i)
-			{
-				physMem.state.spriteRAM[i]=file.bin[file.offset+i];
-			}
+			memcpy(physMem.state.spriteRAM,file.bin.data()+file.offset,batchSize);
 
 			file.offset+=batchSize;
 			if(file.bin.size()<=file.offset)
@@ -205,10 +204,8 @@ void FMTownsCommon::VMHostFileTransfer(void)
 			}
 
 			unsigned int batchSize=cpputil::GetDword(physMem.state.spriteRAM+4);
-			for(unsigned int i=0; i<batchSize; ++i)
-			{
-				file.bin.push_back(physMem.state.spriteRAM[8+i]);
-			}
+			batchSize=std::min<unsigned int>(batchSize,TOWNS_SPRITERAM_SIZE-8);
+			file.bin.insert(file.bin.end(),physMem.state.spriteRAM+8,physMem.state.spriteRAM+8+batchSize);
 
 			if(1==physMem.state.spriteRAM[0])
 			{